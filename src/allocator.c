@@ -0,0 +1,167 @@
+#include "allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#define CACHE_LINE_SIZE 64
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// Allocations at least this large are mapped directly from the kernel (zero-filled on demand)
+const size_t AllocatorHugePageSize = 2 * 1024 * 1024;
+
+struct allocator {
+    void *instance;
+    AllocatorInterface *interface;
+};
+
+void *
+allocator_AllocateAligned(size_t size)
+{
+    void *memory = NULL;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, size == 0 ? CACHE_LINE_SIZE : size) != 0) {
+        return NULL;
+    }
+    memset(memory, 0, size);
+    return memory;
+}
+
+void
+allocator_DeallocateAligned(void *memory)
+{
+    free(memory);
+}
+
+size_t
+allocator_RoundToHugePages(size_t size)
+{
+    return ((size + AllocatorHugePageSize - 1) / AllocatorHugePageSize) * AllocatorHugePageSize;
+}
+
+void *
+allocator_MapPages(size_t size, bool explicitHugePages)
+{
+    void *memory = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages come from the hugetlbfs pool and fail if it is exhausted
+    if (explicitHugePages) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(memory, size, MADV_HUGEPAGE);
+#endif
+    }
+
+    return memory;
+}
+
+void
+allocator_UnmapPages(void *memory, size_t size)
+{
+    munmap(memory, size);
+}
+
+// The system allocator: cache-line aligned heap memory, with large arrays advised onto transparent huge pages
+static void *
+_systemAllocator_Allocate(void *instance, size_t size)
+{
+    if (size >= AllocatorHugePageSize) {
+        return allocator_MapPages(allocator_RoundToHugePages(size), false);
+    }
+    return allocator_AllocateAligned(size);
+}
+
+static void
+_systemAllocator_Deallocate(void *instance, void *memory, size_t size)
+{
+    if (size >= AllocatorHugePageSize) {
+        allocator_UnmapPages(memory, allocator_RoundToHugePages(size));
+    } else {
+        allocator_DeallocateAligned(memory);
+    }
+}
+
+static void
+_systemAllocator_Destroy(void **instanceP)
+{
+    *instanceP = NULL;
+}
+
+static AllocatorInterface _systemAllocatorInterface = {
+        .Allocate = _systemAllocator_Allocate,
+        .Deallocate = _systemAllocator_Deallocate,
+        .Destroy = _systemAllocator_Destroy,
+};
+
+AllocatorInterface *SystemAllocatorAsAllocator = &_systemAllocatorInterface;
+
+static Allocator _systemAllocator = {
+        .instance = NULL,
+        .interface = &_systemAllocatorInterface,
+};
+
+static Allocator *_defaultAllocator = NULL;
+
+Allocator *
+allocator_Create(void *instance, AllocatorInterface *interface)
+{
+    Allocator *allocator = (Allocator *) malloc(sizeof(Allocator));
+    if (allocator != NULL) {
+        allocator->instance = instance;
+        allocator->interface = interface;
+    }
+    return allocator;
+}
+
+void
+allocator_Destroy(Allocator **allocatorP)
+{
+    Allocator *allocator = *allocatorP;
+    if (_defaultAllocator == allocator) {
+        _defaultAllocator = NULL;
+    }
+    allocator->interface->Destroy(&allocator->instance);
+    free(allocator);
+    *allocatorP = NULL;
+}
+
+void *
+allocator_Allocate(Allocator *allocator, size_t size)
+{
+    return allocator->interface->Allocate(allocator->instance, size);
+}
+
+void
+allocator_Deallocate(Allocator *allocator, void *memory, size_t size)
+{
+    if (memory != NULL) {
+        allocator->interface->Deallocate(allocator->instance, memory, size);
+    }
+}
+
+Allocator *
+allocator_GetDefault()
+{
+    if (_defaultAllocator == NULL) {
+        return &_systemAllocator;
+    }
+    return _defaultAllocator;
+}
+
+void
+allocator_SetDefault(Allocator *allocator)
+{
+    _defaultAllocator = allocator;
+}
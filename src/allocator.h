@@ -0,0 +1,57 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_ALLOCATOR_H
+#define FIB_PERF_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct allocator;
+typedef struct allocator Allocator;
+
+// Backing store for the large flat arrays (filter bitmaps, map buckets, trie node pools).
+// Allocate returns zeroed, cache-line aligned memory; Deallocate is given the same size.
+typedef struct {
+    void *(*Allocate)(void *allocator, size_t size);
+
+    void (*Deallocate)(void *allocator, void *memory, size_t size);
+
+    void (*Destroy)(void **instance);
+} AllocatorInterface;
+
+extern const size_t AllocatorHugePageSize;
+
+extern AllocatorInterface *SystemAllocatorAsAllocator;
+
+Allocator *allocator_Create(void *instance, AllocatorInterface *interface);
+
+void allocator_Destroy(Allocator **allocatorP);
+
+void *allocator_Allocate(Allocator *allocator, size_t size);
+
+void allocator_Deallocate(Allocator *allocator, void *memory, size_t size);
+
+// The allocator used by structures created from now on. Structures remember the allocator
+// they were created with, so it must outlive them. Passing NULL restores the system allocator.
+Allocator *allocator_GetDefault();
+
+void allocator_SetDefault(Allocator *allocator);
+
+// Helpers for allocator implementations
+void *allocator_AllocateAligned(size_t size);
+
+void allocator_DeallocateAligned(void *memory);
+
+size_t allocator_RoundToHugePages(size_t size);
+
+void *allocator_MapPages(size_t size, bool explicitHugePages);
+
+void allocator_UnmapPages(void *memory, size_t size);
+
+#endif //FIB_PERF_ALLOCATOR_H
+
+#ifdef __cplusplus
+}
+#endif
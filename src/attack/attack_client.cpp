@@ -5,11 +5,6 @@
 #include <vector>
 #include <iostream>
 #include <stdint.h>
-#include <sys/socket.h>
-#include <arpa/inet.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
 
 #include "../name.h"
 #include "../timer.h"
@@ -28,32 +23,26 @@ AttackClient::LoadNames(NameReader *reader)
 void
 AttackClient::Run()
 {
-    uint8_t sizeBuffer[2];
+    // Names go out batchSize at a time, each batch in as few system calls as it fits in
     int index = 0;
     for (std::vector<Name *>::iterator itr = names.begin(); itr != names.end(); itr++) {
         Name *name = *itr;
 
-        // Serialize and send the name
-        PARCBuffer *nameWireFormat = name_GetWireFormat(name, name_GetSegmentCount(name));
-        uint8_t *nameBuffer = (uint8_t *) parcBuffer_Overlay(nameWireFormat, 0);
-        size_t nameLength = parcBuffer_Remaining(nameWireFormat);
-
-        sizeBuffer[0] = (nameLength >> 8) & 0xFF;
-        sizeBuffer[1] = (nameLength >> 0) & 0xFF;
-
         // Record the time it was sent
         struct timespec start = timerStart();
         times.push_back(start);
 
-        // Send it
-        if (send(sockfd, (void *) sizeBuffer, sizeof(sizeBuffer), 0) != sizeof(sizeBuffer)) {
-//            std::cerr << "failed to send packet " << index << std::endl;
-        }
-        if (send(sockfd, (void *) nameBuffer, nameLength, 0) != nameLength) {
-//            std::cerr << "failed to send packet " << index << std::endl;
-//            perror("Error!");
+        if (!sender->WriteName(name)) {
+            std::cerr << "failed to send name " << index << std::endl;
         }
         index++;
+        if (index % batchSize == 0 && !sender->Flush()) {
+            std::cerr << "failed to send the batch ending at name " << index << std::endl;
+        }
+    }
+
+    if (!sender->Close()) {
+        std::cerr << "failed to close the stream of names" << std::endl;
     }
 }
 
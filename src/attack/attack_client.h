@@ -3,14 +3,16 @@
 
 #include <vector>
 #include "../name_reader.h"
+#include "framing.h"
 
 using namespace std;
 
 class AttackClient
 {
     public:
-    AttackClient(int sock) {
-        sockfd = sock;
+    AttackClient(FrameSender *theSender, int namesPerBatch = 1) {
+        sender = theSender;
+        batchSize = namesPerBatch;
     }
 
     int LoadNames(NameReader *reader);
@@ -19,7 +21,8 @@ class AttackClient
 
     std::vector<Name *> names;
     std::vector<struct timespec> times;
-    int sockfd;
+    FrameSender *sender;
+    int batchSize;
     int numNames;
     char *prefix;
 };
@@ -5,20 +5,24 @@ using namespace std;
 
 #include <vector>
 
+#include "framing.h"
+
 class AttackServer
 {
 public:
-    AttackServer(int sock) {
-        sockfd = sock;
+    AttackServer(FrameReceiver *theReceiver) {
+        receiver = theReceiver;
+        numberOfNames = -1;
     }
 
     void Run();
 
+    // Stop after num names rather than when the sender closes
     void SetNumberOfNames(int num) {
         numberOfNames = num;
     }
 
-    int sockfd;
+    FrameReceiver *receiver;
     int numberOfNames;
     std::vector<struct timespec> times;
 };
@@ -5,6 +5,9 @@
 #include "router.h"
 #include "attack_client.h"
 #include "attack_server.h"
+#include "framing.h"
+#include "ring.h"
+#include "uring_router.h"
 
 #include <parc/algol/parc_SafeMemory.h>
 #include <parc/algol/parc_BufferComposer.h>
@@ -17,7 +20,12 @@
 #include "../sha256hasher.h"
 
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
 #include <iostream>
 #include <pthread.h>
 
@@ -36,7 +44,235 @@ ProcessResults(Router *router)
 static void
 usage()
 {
-    std::cout << "usage: drive <load_file> <test_file>" << std::endl;
+    std::cout << "usage: drive <load_file> <test_file> [hashed] [stream|datagram|ring|uring] [batch_size] [sources]" << std::endl;
+    std::cout << "   - without a transport, the router looks up the test names in-process" << std::endl;
+    std::cout << "   - with one, a client sends them through the router to a server over socket pairs" << std::endl;
+    std::cout << "     or shared-memory rings, batch_size names per batch (default: 1)" << std::endl;
+    std::cout << "   - uring splits them over sources clients (default: 4), each with a TCP connection over" << std::endl;
+    std::cout << "     loopback to an io_uring router, which sends them on to a server per output port" << std::endl;
+}
+
+static int
+RunPipeline(Router *router, NameReader *reader, const char *transport, int batchSize)
+{
+    FrameSender *clientSender;
+    FrameReceiver *routerSource;
+    FrameSender *routerSink;
+    FrameReceiver *serverReceiver;
+    Ring *sourceRing = NULL;
+    Ring *sinkRing = NULL;
+    int sourcesockets[2] = {-1, -1};
+    int sinksockets[2] = {-1, -1};
+
+    if (strcmp(transport, "ring") == 0) {
+        sourceRing = new Ring();
+        sinkRing = new Ring();
+        clientSender = new RingWriter(sourceRing);
+        routerSource = new RingReader(sourceRing);
+        routerSink = new RingWriter(sinkRing);
+        serverReceiver = new RingReader(sinkRing);
+    } else {
+        bool datagram = strcmp(transport, "datagram") == 0;
+        int type = datagram ? SOCK_DGRAM : SOCK_STREAM;
+        if (socketpair(AF_UNIX, type, 0, sourcesockets) < 0 || socketpair(AF_UNIX, type, 0, sinksockets) < 0) {
+            std::cerr << "Failed to create the socket pairs" << std::endl;
+            return -1;
+        }
+        clientSender = new FrameWriter(sourcesockets[0], datagram);
+        routerSource = new FrameReader(sourcesockets[1], datagram);
+        routerSink = new FrameWriter(sinksockets[1], datagram);
+        serverReceiver = new FrameReader(sinksockets[0], datagram);
+    }
+
+    AttackClient *client = new AttackClient(clientSender, batchSize);
+    int numberOfNames = client->LoadNames(reader);
+    AttackServer *server = new AttackServer(serverReceiver);
+    router->ConnectSource(routerSource);
+    router->ConnectSink(routerSink);
+    std::cerr << "Sending " << numberOfNames << " names through the router over " << transport << ", "
+              << batchSize << " per batch" << std::endl;
+
+    // Each stage ends when the one before it closes its end
+    pthread_t serverThread;
+    pthread_t routerThread;
+    pthread_t clientThread;
+    if (pthread_create(&serverThread, NULL, runServer, server) != 0 ||
+        pthread_create(&routerThread, NULL, forwardRouter, router) != 0 ||
+        pthread_create(&clientThread, NULL, runClient, client) != 0) {
+        std::cerr << "Unable to create the pipeline threads" << std::endl;
+        return -1;
+    }
+
+    void *status;
+    pthread_join(clientThread, &status);
+    pthread_join(routerThread, &status);
+    pthread_join(serverThread, &status);
+
+    ProcessResults(router);
+
+    long elapsed = server->times.empty() ? 0 : timeDelta(client->times.front(), server->times.back());
+    std::cerr << server->times.size() << " names forwarded, " << router->numDropped << " dropped, in "
+              << elapsed << "ns (" << (elapsed / (double) numberOfNames) << "ns per name)" << std::endl;
+
+    // When nothing was dropped, the server's names line up with the client's
+    if (router->numDropped == 0 && server->times.size() == client->times.size()) {
+        double latency = 0;
+        for (size_t i = 0; i < server->times.size(); i++) {
+            latency += timeDelta(client->times.at(i), server->times.at(i));
+        }
+        std::cerr << "Mean client to server latency: " << (latency / server->times.size()) << "ns" << std::endl;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (sourcesockets[i] >= 0) {
+            close(sourcesockets[i]);
+            close(sinksockets[i]);
+        }
+    }
+    delete client;
+    delete server;
+    delete clientSender;
+    delete routerSource;
+    delete routerSink;
+    delete serverReceiver;
+    delete sourceRing;
+    delete sinkRing;
+    return 0;
+}
+
+// A connected pair of TCP sockets over loopback
+static bool
+_loopbackPair(int pair[2])
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, length) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (struct sockaddr *) &address, &length) < 0) {
+        perror("failed to listen on loopback");
+        return false;
+    }
+
+    pair[0] = socket(AF_INET, SOCK_STREAM, 0);
+    if (pair[0] < 0 || connect(pair[0], (struct sockaddr *) &address, length) < 0) {
+        perror("failed to connect over loopback");
+        return false;
+    }
+    pair[1] = accept(listener, NULL, NULL);
+    close(listener);
+
+    // Batches are already as large as they will get
+    int noDelay = 1;
+    setsockopt(pair[0], IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    setsockopt(pair[1], IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return pair[1] >= 0;
+}
+
+static int
+RunUringPipeline(Router *router, NameReader *reader, int batchSize, int numSources)
+{
+    UringRouter *uringRouter = new UringRouter(router);
+    std::vector<int> sockets;
+    std::vector<FrameSender *> senders;
+    std::vector<FrameReceiver *> receivers;
+    std::vector<AttackClient *> clients;
+    std::vector<AttackServer *> servers;
+
+    for (int i = 0; i < numSources; i++) {
+        int pair[2] = {-1, -1};
+        if (!_loopbackPair(pair)) {
+            return -1;
+        }
+        sockets.push_back(pair[0]);
+        sockets.push_back(pair[1]);
+        senders.push_back(new FrameWriter(pair[0], false));
+        clients.push_back(new AttackClient(senders.back(), batchSize));
+        uringRouter->AddSource(pair[1]);
+    }
+    for (int port = 0; port < ROUTER_NUM_PORTS; port++) {
+        int pair[2] = {-1, -1};
+        if (!_loopbackPair(pair)) {
+            return -1;
+        }
+        sockets.push_back(pair[0]);
+        sockets.push_back(pair[1]);
+        receivers.push_back(new FrameReader(pair[0], false));
+        servers.push_back(new AttackServer(receivers.back()));
+        uringRouter->AddSink(port, pair[1]);
+    }
+
+    // Deal the names out to the clients
+    int numberOfNames = 0;
+    while (nameReader_HasNext(reader)) {
+        clients[numberOfNames % numSources]->names.push_back(nameReader_Next(reader));
+        numberOfNames++;
+    }
+    std::cerr << "Sending " << numberOfNames << " names from " << numSources << " sources through the io_uring router to "
+              << ROUTER_NUM_PORTS << " ports, " << batchSize << " per batch" << std::endl;
+
+    std::vector<pthread_t> threads(numSources + ROUTER_NUM_PORTS + 1);
+    bool created = true;
+    for (int port = 0; port < ROUTER_NUM_PORTS; port++) {
+        created &= pthread_create(&threads[port], NULL, runServer, servers[port]) == 0;
+    }
+    created &= pthread_create(&threads[ROUTER_NUM_PORTS], NULL, runUringRouter, uringRouter) == 0;
+    for (int i = 0; i < numSources; i++) {
+        created &= pthread_create(&threads[ROUTER_NUM_PORTS + 1 + i], NULL, runClient, clients[i]) == 0;
+    }
+    if (!created) {
+        std::cerr << "Unable to create the pipeline threads" << std::endl;
+        return -1;
+    }
+
+    // Without io_uring nothing is forwarded, and the clients may never finish sending, so give up
+    void *status;
+    pthread_join(threads[ROUTER_NUM_PORTS], &status);
+    if (uringRouter->failed) {
+        std::cerr << "Unable to run the io_uring router; try the stream, datagram or ring pipeline" << std::endl;
+        return -1;
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (i != ROUTER_NUM_PORTS) {
+            pthread_join(threads[i], &status);
+        }
+    }
+
+    ProcessResults(router);
+
+    // From the first name sent to the last one received, by any client or server
+    struct timespec first = clients[0]->times.empty() ? timerStart() : clients[0]->times.front();
+    for (int i = 1; i < numSources; i++) {
+        if (!clients[i]->times.empty() && timeDelta(clients[i]->times.front(), first) > 0) {
+            first = clients[i]->times.front();
+        }
+    }
+    size_t numForwarded = 0;
+    long elapsed = 0;
+    for (int port = 0; port < ROUTER_NUM_PORTS; port++) {
+        numForwarded += servers[port]->times.size();
+        if (!servers[port]->times.empty() && timeDelta(first, servers[port]->times.back()) > elapsed) {
+            elapsed = timeDelta(first, servers[port]->times.back());
+        }
+    }
+    std::cerr << numForwarded << " names forwarded, " << router->numDropped << " dropped, in "
+              << elapsed << "ns (" << (elapsed / (double) numberOfNames) << "ns per name)" << std::endl;
+
+    for (size_t i = 0; i < sockets.size(); i++) {
+        close(sockets[i]);
+    }
+    for (int i = 0; i < numSources; i++) {
+        delete clients[i];
+        delete senders[i];
+    }
+    for (int port = 0; port < ROUTER_NUM_PORTS; port++) {
+        delete servers[port];
+        delete receivers[port];
+    }
+    delete uringRouter;
+    return 0;
 }
 
 int
@@ -64,7 +300,33 @@ main(int argc, char **argv)
     int fibSize = router->LoadHashedNames(loadReader, hasher);
     std::cerr << "Loaded " << fibSize << " prefixes into the FIB" << std::endl;
 
+    // Pick M from the loaded prefix-length distribution
+    int M = fibCisco_Tune(ciscoFIB);
+    std::cerr << "Using M = " << M << std::endl;
+
     NameReader *reader = nameReader_CreateFromFile(argv[2], NULL);
+    if (argc > 4) {
+        bool uring = strcmp(argv[4], "uring") == 0;
+        if (!uring && strcmp(argv[4], "stream") != 0 && strcmp(argv[4], "datagram") != 0 && strcmp(argv[4], "ring") != 0) {
+            usage();
+            exit(-1);
+        }
+        int batchSize = argc > 5 ? atoi(argv[5]) : 1;
+        if (batchSize < 1) {
+            usage();
+            exit(-1);
+        }
+        if (uring) {
+            int numSources = argc > 6 ? atoi(argv[6]) : 4;
+            if (numSources < 1) {
+                usage();
+                exit(-1);
+            }
+            return RunUringPipeline(router, reader, batchSize, numSources);
+        }
+        return RunPipeline(router, reader, argv[4], batchSize);
+    }
+
     int numberOfNames = router->LoadHashedTestNames(reader, hasher);
     std::cerr << "Processing " << numberOfNames << " through the pipe" << std::endl;
 
@@ -87,96 +349,5 @@ main(int argc, char **argv)
     // Compute the per-packet throughput
     ProcessResults(router);
 
-
-//    // Create the upstream socket pair
-//    int sinksockets[2] = {0};
-//    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sinksockets) < 0) {
-//        std::cerr << "Failed to create the sink socket pair" << std::endl;
-//        return -1;
-//    }
-//    int flags = fcntl(sinksockets[0], F_GETFL, 0);
-//    flags |= O_NONBLOCK;
-//    fcntl(sinksockets[0], F_SETFL, flags);
-//    flags = fcntl(sinksockets[1], F_GETFL, 0);
-//    flags |= O_NONBLOCK;
-//    fcntl(sinksockets[1], F_SETFL, flags);
-//
-//    // Create the server
-//    AttackServer *server = new AttackServer(sinksockets[0]);
-//
-//    // Create the BitVector corresponding to this socket
-//    // The size of the output bitmap is not important
-//    Bitmap *outputMap = bitmap_Create(16);
-//    bitmap_Set(outputMap, 1);
-//
-//    // Create the source socket
-//    int sourcesockets[2] = {0};
-//    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sourcesockets) < 0) {
-//        std::cerr << "Failed to create the source socket pair" << std::endl;
-//        return -1;
-//    }
-//    flags = fcntl(sourcesockets[0], F_GETFL, 0);
-//    flags |= O_NONBLOCK;
-//    fcntl(sourcesockets[0], F_SETFL, flags);
-//    flags = fcntl(sourcesockets[1], F_GETFL, 0);
-//    flags |= O_NONBLOCK;
-//    fcntl(sourcesockets[1], F_SETFL, flags);
-//
-//    // Create the client and build the name list
-//    AttackClient *client = new AttackClient(sourcesockets[0]);
-//
-//    // Connect the router to the sockets
-//    router->ConnectSource(sourcesockets[1]);
-//    router->ConnectSink(sinksockets[1]);
-//
-//    // Set the name limit on the router and server
-//    router->SetNumberOfNames(numberOfNames);
-//    server->SetNumberOfNames(numberOfNames);
-//
-//    std::cerr << "Routers loaded -- starting the threads" << std::endl;
-//
-//    // Create threads for the client, server, and router
-//    // TODO(cawood): maybe pass the run functions files that are used to write results when done?
-//    pthread_t serverThread;
-//    int result;
-//    result = pthread_create(&serverThread, NULL, runServer, server);
-//    if (result != 0) {
-//        std::cerr << "Unable to create the server thread" << std::endl;
-//    }
-//    pthread_t routerThread;
-//    result  = pthread_create(&routerThread, NULL, runRouter, router);
-//    if (result != 0) {
-//        std::cerr << "Unable to create the router thread" << std::endl;
-//    }
-//    pthread_t clientThread;
-//    result = pthread_create(&clientThread, NULL, runClient, client);
-//    if (result != 0) {
-//        std::cerr << "Unable to create the client thread" << std::endl;
-//    }
-//
-//    // Run the server to completion -- the server can't complete until both the client and router are done
-//    void *status;
-//    result = pthread_join(clientThread, &status);
-//    if (result != 0) {
-//        std::cerr << "Unable to join on the client thread" << std::endl;
-//    }
-//    std::cerr << "Client is done." << std::endl;
-//    result = pthread_join(routerThread, &status);
-//    if (result != 0) {
-//        std::cerr << "Unable to join on the router thread" << std::endl;
-//    }
-//    std::cerr << "Router is done." << std::endl;
-//    result = pthread_join(serverThread, &status);
-//    if (result != 0) {
-//        std::cerr << "Unable to join on the server thread" << std::endl;
-//    }
-//    std::cerr << "Server is done." << std::endl;
-//
-//    // Compute the per-packet throughput
-//    ProcessResults(client, server);
-
-//    // Cleanup and exit
-//    pthread_exit(NULL);
-
     return 0;
 }
@@ -0,0 +1,212 @@
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <iostream>
+
+#include <parc/algol/parc_Buffer.h>
+
+#include "framing.h"
+
+// Stream reads are large enough to always have room for a whole frame after the partial one
+#define FRAME_READ_SIZE (256 * 1024)
+
+FrameWriter::FrameWriter(int sock, bool isDatagram, int numSegments)
+    : sockfd(sock), datagram(isDatagram), maxSegments(numSegments), numSegments(0),
+      segments(numSegments), iovecs(numSegments), messages(numSegments)
+{
+    for (int i = 0; i < maxSegments; i++) {
+        segments[i].reserve(FRAME_SEGMENT_SIZE);
+    }
+}
+
+bool
+FrameWriter::Write(const uint8_t *data, size_t length)
+{
+    size_t frameLength = FRAME_HEADER_SIZE + length;
+    if (length > FRAME_MAX_LENGTH || (datagram && frameLength > FRAME_MAX_DATAGRAM)) {
+        std::cerr << "a " << length << "-byte name does not fit in a frame" << std::endl;
+        return false;
+    }
+
+    // Frames never straddle segments, but one too large for a segment gets one to itself
+    if (numSegments == 0 || (segments[numSegments - 1].size() > 0 &&
+                             segments[numSegments - 1].size() + frameLength > FRAME_SEGMENT_SIZE)) {
+        if (numSegments == maxSegments && !Flush()) {
+            return false;
+        }
+        segments[numSegments++].clear();
+    }
+
+    std::vector<uint8_t> &segment = segments[numSegments - 1];
+    segment.push_back((length >> 8) & 0xFF);
+    segment.push_back((length >> 0) & 0xFF);
+    segment.insert(segment.end(), data, data + length);
+    return true;
+}
+
+bool
+FrameSender::WriteName(const Name *name)
+{
+    PARCBuffer *nameWireFormat = name_GetWireFormat(name, name_GetSegmentCount(name));
+    bool written = Write((uint8_t *) parcBuffer_Overlay(nameWireFormat, 0), parcBuffer_Remaining(nameWireFormat));
+    parcBuffer_Release(&nameWireFormat);
+    return written;
+}
+
+bool
+FrameWriter::Flush()
+{
+    for (int i = 0; i < numSegments; i++) {
+        iovecs[i].iov_base = segments[i].data();
+        iovecs[i].iov_len = segments[i].size();
+    }
+
+    int done = 0;
+    while (done < numSegments) {
+        if (datagram) {
+            for (int i = done; i < numSegments; i++) {
+                memset(&messages[i], 0, sizeof(struct mmsghdr));
+                messages[i].msg_hdr.msg_iov = &iovecs[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int sent = sendmmsg(sockfd, &messages[done], numSegments - done, 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("failed to send the frames");
+                return false;
+            }
+            done += sent;
+        } else {
+            ssize_t written = writev(sockfd, &iovecs[done], numSegments - done);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("failed to write the frames");
+                return false;
+            }
+
+            // Resume a short write where it stopped, possibly inside a segment
+            while (done < numSegments && (size_t) written >= iovecs[done].iov_len) {
+                written -= iovecs[done].iov_len;
+                done++;
+            }
+            if (done < numSegments) {
+                iovecs[done].iov_base = (uint8_t *) iovecs[done].iov_base + written;
+                iovecs[done].iov_len -= written;
+            }
+        }
+    }
+
+    numSegments = 0;
+    return true;
+}
+
+bool
+FrameWriter::Close()
+{
+    if (!Flush()) {
+        return false;
+    }
+    if (datagram) {
+        return send(sockfd, NULL, 0, 0) == 0;
+    }
+    return shutdown(sockfd, SHUT_WR) == 0;
+}
+
+FrameReader::FrameReader(int sock, bool isDatagram, int numSegments)
+    : sockfd(sock), datagram(isDatagram), closed(false), start(0), end(0)
+{
+    if (datagram) {
+        datagrams.resize(numSegments, std::vector<uint8_t>(FRAME_MAX_DATAGRAM));
+        iovecs.resize(numSegments);
+        messages.resize(numSegments);
+        for (int i = 0; i < numSegments; i++) {
+            iovecs[i].iov_base = datagrams[i].data();
+            iovecs[i].iov_len = datagrams[i].size();
+            memset(&messages[i], 0, sizeof(struct mmsghdr));
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+    } else {
+        buffer.resize(FRAME_READ_SIZE);
+    }
+}
+
+size_t
+parseFrames(const uint8_t *data, size_t length, std::vector<Frame> &frames)
+{
+    size_t offset = 0;
+    while (length - offset >= FRAME_HEADER_SIZE) {
+        size_t frameLength = (((size_t) data[offset]) << 8) | (size_t) data[offset + 1];
+        if (length - offset - FRAME_HEADER_SIZE < frameLength) {
+            break;
+        }
+        Frame frame = { data + offset + FRAME_HEADER_SIZE, frameLength };
+        frames.push_back(frame);
+        offset += FRAME_HEADER_SIZE + frameLength;
+    }
+    return offset;
+}
+
+bool
+FrameReader::Read(std::vector<Frame> &frames)
+{
+    frames.clear();
+    if (closed) {
+        return false;
+    }
+
+    if (datagram) {
+        int received = -1;
+        while (received < 0) {
+            received = recvmmsg(sockfd, messages.data(), messages.size(), MSG_WAITFORONE, NULL);
+            if (received < 0 && errno != EINTR) {
+                perror("failed to receive the frames");
+                return false;
+            }
+        }
+
+        for (int i = 0; i < received; i++) {
+            if (messages[i].msg_len == 0) {
+                closed = true;
+                break;
+            }
+            size_t parsed = parseFrames(datagrams[i].data(), messages[i].msg_len, frames);
+            if (parsed != messages[i].msg_len || (messages[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+                std::cerr << "dropped a truncated frame" << std::endl;
+            }
+        }
+        return !closed || !frames.empty();
+    }
+
+    // The frames returned last time are done with, so move the partial frame after them to the front
+    memmove(buffer.data(), buffer.data() + start, end - start);
+    end -= start;
+    start = 0;
+
+    // Read until at least one frame is whole, however short the reads
+    while (frames.empty()) {
+        ssize_t bytesRead = read(sockfd, buffer.data() + end, buffer.size() - end);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("failed to read the frames");
+            return false;
+        }
+        if (bytesRead == 0) {
+            closed = true;
+            if (end > 0) {
+                std::cerr << "dropped a frame truncated by the end of the stream" << std::endl;
+            }
+            return false;
+        }
+        end += bytesRead;
+        start = parseFrames(buffer.data(), end, frames);
+    }
+    return true;
+}
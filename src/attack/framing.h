@@ -0,0 +1,107 @@
+#ifndef FRAMING_H_
+#define FRAMING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <vector>
+
+#include "../name.h"
+
+using namespace std;
+
+// Names travel as frames: a 2-byte big-endian length followed by the name's wire format. Frames
+// are packed back to back into segments, so one system call moves many names. On stream sockets
+// the segments are the iovecs of one writev and the reader parses frames out of large reads,
+// carrying partial frames over to the next read. On datagram sockets each segment is one
+// datagram, never splitting a frame, and up to numSegments datagrams go in one sendmmsg or
+// recvmmsg. Closing a writer shuts down a stream, or sends an empty datagram.
+
+#define FRAME_HEADER_SIZE 2
+#define FRAME_MAX_LENGTH UINT16_MAX
+
+// Datagrams stay under the UDP payload limit
+#define FRAME_SEGMENT_SIZE 8192
+#define FRAME_MAX_DATAGRAM 65507
+#define FRAME_NUM_SEGMENTS 64
+
+struct Frame {
+    const uint8_t *data;
+    size_t length;
+};
+
+// Append the whole frames at the front of data to frames, returning the bytes they took
+size_t parseFrames(const uint8_t *data, size_t length, std::vector<Frame> &frames);
+
+// The transports the client, router and server send and receive frames over
+class FrameSender
+{
+public:
+    virtual ~FrameSender() { }
+
+    // Queue a frame, sending the queued frames first if there is no room for it
+    virtual bool Write(const uint8_t *data, size_t length) = 0;
+    bool WriteName(const Name *name);
+
+    // Send every queued frame
+    virtual bool Flush() = 0;
+
+    // Flush, then signal the end of the frames to the receiver
+    virtual bool Close() = 0;
+};
+
+class FrameReceiver
+{
+public:
+    virtual ~FrameReceiver() { }
+
+    // The frames that arrived together, which stay valid until the next call. Returns false once
+    // the sender has closed and every frame was read, or on an error.
+    virtual bool Read(std::vector<Frame> &frames) = 0;
+};
+
+class FrameWriter : public FrameSender
+{
+public:
+    FrameWriter(int sock, bool isDatagram, int numSegments = FRAME_NUM_SEGMENTS);
+
+    bool Write(const uint8_t *data, size_t length);
+
+    // Resumes after short writes
+    bool Flush();
+    bool Close();
+
+    int sockfd;
+    bool datagram;
+    int maxSegments;
+    int numSegments;
+    std::vector<std::vector<uint8_t> > segments;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct mmsghdr> messages;
+};
+
+class FrameReader : public FrameReceiver
+{
+public:
+    FrameReader(int sock, bool isDatagram, int numSegments = FRAME_NUM_SEGMENTS);
+
+    // The frames of one read or recvmmsg
+    bool Read(std::vector<Frame> &frames);
+
+    int sockfd;
+    bool datagram;
+    bool closed;
+
+    // Stream sockets: bytes [start, end) of buffer are read but not yet returned
+    std::vector<uint8_t> buffer;
+    size_t start;
+    size_t end;
+
+    // Datagram sockets: one buffer per datagram received at once
+    std::vector<std::vector<uint8_t> > datagrams;
+    std::vector<struct iovec> iovecs;
+    std::vector<struct mmsghdr> messages;
+};
+
+#endif // FRAMING_H_
@@ -0,0 +1,164 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <iostream>
+
+#include "ring.h"
+
+// Record lengths past any frame's mark the rest of the buffer as unused, and the end of the frames
+#define RING_RECORD_WRAP UINT32_MAX
+#define RING_RECORD_END (UINT32_MAX - 1)
+#define RING_RECORD_HEADER_SIZE 4
+
+// A ring always has room for the largest record, even after skipping the end of the buffer
+#define RING_MIN_CAPACITY (4 * (FRAME_MAX_LENGTH + 1))
+
+// Waits spin for about a microsecond before giving up the core, so an end sharing its core with
+// the other does not hold it up for a whole time slice
+#define RING_SPINS 1024
+
+static size_t
+_recordLength(size_t length)
+{
+    return (RING_RECORD_HEADER_SIZE + length + 7) & ~((size_t) 7);
+}
+
+static void
+_ringWait(int *spins)
+{
+    if (*spins < RING_SPINS) {
+        (*spins)++;
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        sched_yield();
+    }
+}
+
+Ring::Ring(size_t ringCapacity)
+{
+    capacity = 1;
+    while (capacity < ringCapacity || capacity < RING_MIN_CAPACITY) {
+        capacity <<= 1;
+    }
+
+    mappedSize = sizeof(Control) + capacity;
+    void *memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        perror("failed to map the ring");
+        exit(EXIT_FAILURE);
+    }
+
+    // The mapping is zeroed, so both indexes start at 0
+    control = (Control *) memory;
+    buffer = (uint8_t *) memory + sizeof(Control);
+}
+
+Ring::~Ring()
+{
+    munmap(control, mappedSize);
+}
+
+RingWriter::RingWriter(Ring *theRing)
+    : ring(theRing), head(0), tail(0)
+{
+}
+
+uint8_t *
+RingWriter::Reserve(size_t length)
+{
+    size_t offset = head & (ring->capacity - 1);
+    size_t skipped = offset + length > ring->capacity ? ring->capacity - offset : 0;
+
+    // Only look at the reader's tail when the last one seen leaves too little room, publishing
+    // what is written so far so that the reader can make some
+    int spins = 0;
+    while (head + skipped + length - tail > ring->capacity) {
+        Flush();
+        tail = __atomic_load_n(&ring->control->tail, __ATOMIC_ACQUIRE);
+        if (head + skipped + length - tail > ring->capacity) {
+            _ringWait(&spins);
+        }
+    }
+
+    if (skipped > 0) {
+        *(uint32_t *) (ring->buffer + offset) = RING_RECORD_WRAP;
+        head += skipped;
+        offset = 0;
+    }
+    head += length;
+    return ring->buffer + offset;
+}
+
+bool
+RingWriter::Write(const uint8_t *data, size_t length)
+{
+    if (length > FRAME_MAX_LENGTH) {
+        std::cerr << "a " << length << "-byte name does not fit in a frame" << std::endl;
+        return false;
+    }
+
+    uint8_t *record = Reserve(_recordLength(length));
+    *(uint32_t *) record = (uint32_t) length;
+    memcpy(record + RING_RECORD_HEADER_SIZE, data, length);
+    return true;
+}
+
+bool
+RingWriter::Flush()
+{
+    __atomic_store_n(&ring->control->head, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool
+RingWriter::Close()
+{
+    uint8_t *record = Reserve(_recordLength(0));
+    *(uint32_t *) record = RING_RECORD_END;
+    return Flush();
+}
+
+RingReader::RingReader(Ring *theRing)
+    : ring(theRing), closed(false), tail(0), head(0)
+{
+}
+
+bool
+RingReader::Read(std::vector<Frame> &frames)
+{
+    frames.clear();
+    if (closed) {
+        return false;
+    }
+
+    // Give back the room of the frames returned last time, then wait for more if every published
+    // record has been read
+    __atomic_store_n(&ring->control->tail, tail, __ATOMIC_RELEASE);
+    int spins = 0;
+    while (head == tail) {
+        head = __atomic_load_n(&ring->control->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            _ringWait(&spins);
+        }
+    }
+
+    while (tail != head) {
+        size_t offset = tail & (ring->capacity - 1);
+        uint32_t length = *(uint32_t *) (ring->buffer + offset);
+        if (length == RING_RECORD_WRAP) {
+            tail += ring->capacity - offset;
+        } else if (length == RING_RECORD_END) {
+            tail += _recordLength(0);
+            closed = true;
+            break;
+        } else {
+            Frame frame = { ring->buffer + offset + RING_RECORD_HEADER_SIZE, length };
+            frames.push_back(frame);
+            tail += _recordLength(length);
+        }
+    }
+    return !closed || !frames.empty();
+}
@@ -0,0 +1,83 @@
+#ifndef RING_H_
+#define RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "framing.h"
+
+using namespace std;
+
+#define RING_CACHE_LINE 64
+#define RING_DEFAULT_CAPACITY (1 << 20)
+
+// A lock-free single-producer, single-consumer ring of frames in shared memory, for one hop of
+// the client -> router -> server pipeline without the kernel in the way. The mapping is shared,
+// so the two ends may be threads or processes forked after the ring is made.
+//
+// Records are a 4-byte length and the frame, padded to 8 bytes, and never wrap around the end of
+// the buffer. The producer copies frames straight into the ring and publishes them by moving the
+// head; the consumer reads them where they lie and gives the space back by moving the tail once
+// it asks for more. The head and tail each have a cache line, and each end keeps its own copy of
+// the other's index, so the ends only touch each other's line when one runs out of records or room.
+class Ring
+{
+public:
+    // capacity is rounded up to a power of two
+    Ring(size_t capacity = RING_DEFAULT_CAPACITY);
+    ~Ring();
+
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    struct Control {
+        alignas(RING_CACHE_LINE) uint64_t head;
+        alignas(RING_CACHE_LINE) uint64_t tail;
+    };
+
+    Control *control;
+    uint8_t *buffer;
+    size_t capacity;
+    size_t mappedSize;
+};
+
+class RingWriter : public FrameSender
+{
+public:
+    RingWriter(Ring *theRing);
+
+    // Waits for the reader to make room
+    bool Write(const uint8_t *data, size_t length);
+
+    // Publishes the frames written since the last flush
+    bool Flush();
+    bool Close();
+
+    // Room for a record of length bytes, skipping to the start of the buffer if it would wrap
+    uint8_t *Reserve(size_t length);
+
+    Ring *ring;
+
+    // head is ahead of the published head by the unflushed records
+    alignas(RING_CACHE_LINE) uint64_t head;
+    uint64_t tail;
+};
+
+class RingReader : public FrameReceiver
+{
+public:
+    RingReader(Ring *theRing);
+
+    // Every published frame, waiting for the writer if there are none
+    bool Read(std::vector<Frame> &frames);
+
+    Ring *ring;
+    bool closed;
+
+    // tail is ahead of the published tail by the records last returned, which stay in place
+    // until the next read
+    alignas(RING_CACHE_LINE) uint64_t tail;
+    uint64_t head;
+};
+
+#endif // RING_H_
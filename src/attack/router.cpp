@@ -4,6 +4,7 @@
 
 #include "router.h"
 #include "../timer.h"
+#include "../parallel.h"
 #include <iostream>
 #include <fcntl.h>
 #include <sys/socket.h>
@@ -15,15 +16,15 @@
 using namespace std;
 
 void
-Router::ConnectSink(int sock)
+Router::ConnectSink(FrameSender *sender)
 {
-    sinkfd = sock;
+    sink = sender;
 }
 
 void
-Router::ConnectSource(int sock)
+Router::ConnectSource(FrameReceiver *receiver)
 {
-    sourcefd = sock;
+    source = receiver;
 }
 
 #define MAX_NAME_SIZE 64000
@@ -40,26 +41,45 @@ Router::LoadTestNames(NameReader *reader)
     return LoadHashedTestNames(reader, NULL);
 }
 
+typedef struct {
+    Hasher *hasher;
+    Name **names;
+} HashLoadContext;
+
+static void
+hashLoadedName(void *context, size_t index)
+{
+    HashLoadContext *load = (HashLoadContext *) context;
+    Name *newName = name_Hash(load->names[index], load->hasher, 32);
+    name_Destroy(&load->names[index]);
+    load->names[index] = newName;
+}
+
 int
 Router::LoadHashedNames(NameReader *reader, Hasher *hasher)
 {
-    int index = 0;
-    int capacity = 10;
+    std::vector<Name *> loaded;
     while (nameReader_HasNext(reader)) {
-        Name *name = nameReader_Next(reader);
+        loaded.push_back(nameReader_Next(reader));
+    }
 
-        if (hasher != NULL) {
-            Name *newName = name_Hash(name, hasher, 32);
-            name_Destroy(&name);
-            name = newName;
-        }
+    // Hash on every core, then build the FIB tables in parallel too. Forwarded names are hashed
+    // the same way.
+    this->hasher = hasher;
+    if (hasher != NULL) {
+        HashLoadContext context = { hasher, loaded.data() };
+        parallel_For(0, loaded.size(), hashLoadedName, &context);
+    }
 
+    std::vector<Bitmap *> vectors;
+    for (size_t index = 0; index < loaded.size(); index++) {
         Bitmap *vector = bitmap_Create(32);
-        bitmap_Set(vector, index % capacity);
-        fib_Insert(fib, name, vector);
-        index++;
+        bitmap_Set(vector, index % ROUTER_NUM_PORTS);
+        vectors.push_back(vector);
     }
-    return index;
+
+    fib_BulkLoad(fib, loaded.data(), vectors.data(), loaded.size(), 0);
+    return loaded.size();
 }
 
 int
@@ -120,6 +140,56 @@ Router::ProcessInputs()
     }
 }
 
+Bitmap *
+Router::Lookup(const uint8_t *wireFormat, size_t length)
+{
+    // Reconstruct the name in place, in the receiver's buffer or ring
+    PARCBuffer *nameWireFormat = parcBuffer_Wrap((void *) wireFormat, length, 0, length);
+    Name *name = name_CreateFromBuffer(nameWireFormat);
+    parcBuffer_Release(&nameWireFormat);
+    if (hasher != NULL) {
+        Name *hashedName = name_Hash(name, hasher, 32);
+        name_Destroy(&name);
+        name = hashedName;
+    }
+
+    Bitmap *output = fib_LPM(fib, name);
+    name_Destroy(&name);
+    return output;
+}
+
+void
+Router::Forward()
+{
+    std::vector<Frame> frames;
+    while (source->Read(frames)) {
+        for (std::vector<Frame>::iterator itr = frames.begin(); itr != frames.end(); itr++) {
+            struct timespec start = timerStart();
+            inTimes.push_back(start);
+
+            // There is one sink, so any port in the output bitmap leads to it
+            Bitmap *output = Lookup(itr->data, itr->length);
+            if (output == NULL) {
+                numDropped++;
+            } else if (!sink->Write(itr->data, itr->length)) {
+                std::cerr << "failed to forward name " << inTimes.size() - 1 << std::endl;
+            }
+
+            struct timespec now = timerStart();
+            outTimes.push_back(now);
+        }
+
+        // Pass each batch on as it came in, rather than holding names back for a fuller one
+        if (!sink->Flush()) {
+            std::cerr << "failed to forward a batch of " << frames.size() << " names" << std::endl;
+        }
+    }
+
+    if (!sink->Close()) {
+        std::cerr << "failed to close the sink" << std::endl;
+    }
+}
+
 void *
 processInputs(void *arg)
 {
@@ -134,4 +204,12 @@ runRouter(void *arg)
     Router *router = (Router *) arg;
     router->Run();
     return NULL;
+}
+
+void *
+forwardRouter(void *arg)
+{
+    Router *router = (Router *) arg;
+    router->Forward();
+    return NULL;
 }
\ No newline at end of file
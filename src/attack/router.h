@@ -5,16 +5,22 @@
 #include "../name.h"
 #include "../bitmap.h"
 #include "../name_reader.h"
+#include "framing.h"
 
 #include <vector>
 
 using namespace std;
 
+// Loaded prefixes are spread over this many output ports
+#define ROUTER_NUM_PORTS 10
+
 class Router
 {
 public:
     Router(FIB *theFib) {
         fib = theFib;
+        hasher = NULL;
+        numDropped = 0;
     }
 
     int LoadNames(NameReader *reader);
@@ -23,8 +29,8 @@ public:
     int LoadHashedNames(NameReader *reader, Hasher *hasher);
     int LoadHashedTestNames(NameReader *reader, Hasher *hasher);
 
-    void ConnectSource(int sock);
-    void ConnectSink(int sock);
+    void ConnectSource(FrameReceiver *receiver);
+    void ConnectSink(FrameSender *sender);
 
     void SetNumberOfNames(int num) {
         numberOfNames = num;
@@ -33,17 +39,27 @@ public:
     void Run();
     void ProcessInputs();
 
+    // The output bitmap of the longest prefix of the name in wireFormat, or NULL
+    Bitmap *Lookup(const uint8_t *wireFormat, size_t length);
+
+    // Forward batches of names from the source to the sink until the source closes, dropping
+    // names without a match in the FIB
+    void Forward();
+
     std::vector<Name *> names;
     std::vector<struct timespec> inTimes;
     std::vector<struct timespec> outTimes;
 
     FIB *fib;
+    Hasher *hasher;
     int numberOfNames;
-    int sourcefd;
-    int sinkfd;
+    int numDropped;
+    FrameReceiver *source;
+    FrameSender *sink;
 };
 
 void *processInputs(void *arg);
 void *runRouter(void *arg);
+void *forwardRouter(void *arg);
 
 #endif // ROUTER_H_
\ No newline at end of file
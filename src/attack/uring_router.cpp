@@ -0,0 +1,411 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <iostream>
+
+#include "../timer.h"
+#include "uring_router.h"
+
+// Completions carry what they complete in the upper half of their user data, and whose in the lower
+#define URING_RECEIVE 1ULL
+#define URING_SEND 2ULL
+
+#define URING_MIN_ENTRIES 64
+
+static uint64_t
+_userData(uint64_t kind, int index)
+{
+    return (kind << 32) | (uint32_t) index;
+}
+
+static void *
+_map(size_t size, int fd, off_t offset)
+{
+    int flags = fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED | MAP_POPULATE;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, fd, offset);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+UringRouter::UringRouter(Router *theRouter)
+    : router(theRouter), numOpenSources(0), numSending(0), failed(false), ringfd(-1), numEntries(0),
+      sqMap(NULL), sqMapSize(0), cqMap(NULL), cqMapSize(0), sqes(NULL), sqesSize(0), sqLocalTail(0),
+      numQueued(0), bufferRing(NULL), bufferRingSize(0), buffers(NULL), bufferTail(0)
+{
+}
+
+UringRouter::~UringRouter()
+{
+    if (buffers != NULL) {
+        munmap(buffers, (size_t) URING_NUM_BUFFERS * URING_BUFFER_SIZE);
+    }
+    if (bufferRing != NULL) {
+        munmap(bufferRing, bufferRingSize);
+    }
+    if (sqes != NULL) {
+        munmap(sqes, sqesSize);
+    }
+    if (cqMap != NULL && cqMap != sqMap) {
+        munmap(cqMap, cqMapSize);
+    }
+    if (sqMap != NULL) {
+        munmap(sqMap, sqMapSize);
+    }
+    if (ringfd >= 0) {
+        close(ringfd);
+    }
+}
+
+void
+UringRouter::AddSource(int sock)
+{
+    Source source;
+    source.sockfd = sock;
+    source.open = true;
+    sources.push_back(source);
+}
+
+void
+UringRouter::AddSink(int port, int sock)
+{
+    Sink sink;
+    sink.sockfd = sock;
+    sink.sending = false;
+    sink.sent = 0;
+    sinks.push_back(sink);
+
+    if ((size_t) port >= portSinks.size()) {
+        portSinks.resize(port + 1, -1);
+    }
+    portSinks[port] = sinks.size() - 1;
+}
+
+bool
+UringRouter::Setup()
+{
+    // Room for a receive per source and a send per sink, twice over
+    unsigned entries = URING_MIN_ENTRIES;
+    while (entries < 2 * (sources.size() + sinks.size())) {
+        entries <<= 1;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringfd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ringfd < 0) {
+        perror("failed to set up io_uring");
+        return false;
+    }
+    numEntries = params.sq_entries;
+
+    sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqMapSize = cqMapSize = sqMapSize > cqMapSize ? sqMapSize : cqMapSize;
+    }
+    sqMap = _map(sqMapSize, ringfd, IORING_OFF_SQ_RING);
+    cqMap = (params.features & IORING_FEAT_SINGLE_MMAP) ? sqMap : _map(cqMapSize, ringfd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = (struct io_uring_sqe *) _map(sqesSize, ringfd, IORING_OFF_SQES);
+    if (sqMap == NULL || cqMap == NULL || sqes == NULL) {
+        perror("failed to map the io_uring queues");
+        return false;
+    }
+
+    uint8_t *sq = (uint8_t *) sqMap;
+    sqHead = (unsigned *) (sq + params.sq_off.head);
+    sqTail = (unsigned *) (sq + params.sq_off.tail);
+    sqMask = (unsigned *) (sq + params.sq_off.ring_mask);
+    sqArray = (unsigned *) (sq + params.sq_off.array);
+    sqLocalTail = *sqTail;
+
+    uint8_t *cq = (uint8_t *) cqMap;
+    cqHead = (unsigned *) (cq + params.cq_off.head);
+    cqTail = (unsigned *) (cq + params.cq_off.tail);
+    cqMask = (unsigned *) (cq + params.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+    // Register the ring of receive buffers, then hand it every buffer
+    bufferRingSize = URING_NUM_BUFFERS * sizeof(struct io_uring_buf);
+    bufferRing = (struct io_uring_buf_ring *) _map(bufferRingSize, -1, 0);
+    buffers = (uint8_t *) _map((size_t) URING_NUM_BUFFERS * URING_BUFFER_SIZE, -1, 0);
+    if (bufferRing == NULL || buffers == NULL) {
+        perror("failed to allocate the receive buffers");
+        return false;
+    }
+
+    struct io_uring_buf_reg registration;
+    memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = (uint64_t) (uintptr_t) bufferRing;
+    registration.ring_entries = URING_NUM_BUFFERS;
+    registration.bgid = 0;
+    if (syscall(__NR_io_uring_register, ringfd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        perror("failed to register the receive buffers");
+        return false;
+    }
+    for (int bid = 0; bid < URING_NUM_BUFFERS; bid++) {
+        RecycleBuffer(bid);
+    }
+    return true;
+}
+
+int
+UringRouter::Submit(unsigned waitFor)
+{
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    for (;;) {
+        int submitted = syscall(__NR_io_uring_enter, ringfd, numQueued, waitFor,
+                                waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (submitted >= 0) {
+            numQueued -= submitted;
+            return submitted;
+        }
+        if (errno != EINTR) {
+            perror("failed to enter io_uring");
+            return -1;
+        }
+    }
+}
+
+struct io_uring_sqe *
+UringRouter::NextEntry()
+{
+    // The queue only fills up if the kernel has yet to take earlier entries
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= numEntries) {
+        Submit(0);
+    }
+
+    unsigned index = sqLocalTail & *sqMask;
+    sqArray[index] = index;
+    struct io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqLocalTail++;
+    numQueued++;
+    return sqe;
+}
+
+void
+UringRouter::RecycleBuffer(unsigned short bid)
+{
+    // The ring is an array of io_uring_buf whose first one's last field is the tail. Its bufs member
+    // is not used, as C++ places it after the empty struct the kernel headers declare it with.
+    struct io_uring_buf *buffer = (struct io_uring_buf *) bufferRing + (bufferTail & (URING_NUM_BUFFERS - 1));
+    buffer->addr = (uint64_t) (uintptr_t) (buffers + (size_t) bid * URING_BUFFER_SIZE);
+    buffer->len = URING_BUFFER_SIZE;
+    buffer->bid = bid;
+    bufferTail++;
+    __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
+
+void
+UringRouter::ArmReceive(int source)
+{
+    struct io_uring_sqe *sqe = NextEntry();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sources[source].sockfd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = _userData(URING_RECEIVE, source);
+}
+
+void
+UringRouter::HandleReceive(int index, const struct io_uring_cqe *cqe)
+{
+    Source &source = sources[index];
+    if (cqe->res > 0) {
+        unsigned short bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        Receive(index, buffers + (size_t) bid * URING_BUFFER_SIZE, cqe->res);
+        RecycleBuffer(bid);
+    } else if (cqe->res != -ENOBUFS) {
+        if (cqe->res < 0) {
+            errno = -cqe->res;
+            perror("failed to receive from a source");
+            failed = true;
+        } else if (!source.partial.empty()) {
+            std::cerr << "dropped a frame truncated by the end of a source" << std::endl;
+        }
+        source.open = false;
+        numOpenSources--;
+        return;
+    }
+
+    // The kernel ends a multishot receive when it runs out of buffers, which are back by now
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        ArmReceive(index);
+    }
+}
+
+void
+UringRouter::Receive(int index, const uint8_t *data, size_t length)
+{
+    // Frames are looked up where they landed, unless one was split by the last receive
+    Source &source = sources[index];
+    if (source.partial.empty()) {
+        size_t used = ForwardFrames(data, length);
+        source.partial.assign(data + used, data + length);
+    } else {
+        source.partial.insert(source.partial.end(), data, data + length);
+        size_t used = ForwardFrames(source.partial.data(), source.partial.size());
+        source.partial.erase(source.partial.begin(), source.partial.begin() + used);
+    }
+}
+
+size_t
+UringRouter::ForwardFrames(const uint8_t *data, size_t length)
+{
+    frames.clear();
+    size_t used = parseFrames(data, length, frames);
+
+    for (std::vector<Frame>::iterator itr = frames.begin(); itr != frames.end(); itr++) {
+        struct timespec start = timerStart();
+        router->inTimes.push_back(start);
+
+        Bitmap *output = router->Lookup(itr->data, itr->length);
+        if (output == NULL) {
+            router->numDropped++;
+        } else {
+            // Ports are the set bits of the output bitmap, most significant bit first
+            uint64_t *words = bitmap_GetWords(output);
+            size_t numWords = bitmap_GetWordCount(output);
+            for (size_t w = 0; w < numWords; w++) {
+                for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    size_t port = w * 64 + 63 - __builtin_ctzll(word);
+                    if (port < portSinks.size() && portSinks[port] >= 0) {
+                        std::vector<uint8_t> &pending = sinks[portSinks[port]].pending;
+                        pending.push_back((itr->length >> 8) & 0xFF);
+                        pending.push_back((itr->length >> 0) & 0xFF);
+                        pending.insert(pending.end(), itr->data, itr->data + itr->length);
+                    }
+                }
+            }
+        }
+
+        struct timespec now = timerStart();
+        router->outTimes.push_back(now);
+    }
+    return used;
+}
+
+void
+UringRouter::SendPending(int index)
+{
+    Sink &sink = sinks[index];
+    if (sink.sending || sink.pending.empty()) {
+        return;
+    }
+
+    // Frames gathered while the last send was in flight go out together
+    sink.inflight.swap(sink.pending);
+    sink.pending.clear();
+    sink.sent = 0;
+    sink.sending = true;
+    numSending++;
+    QueueSend(index);
+}
+
+void
+UringRouter::QueueSend(int index)
+{
+    Sink &sink = sinks[index];
+    struct io_uring_sqe *sqe = NextEntry();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = sink.sockfd;
+    sqe->addr = (uint64_t) (uintptr_t) (sink.inflight.data() + sink.sent);
+    sqe->len = sink.inflight.size() - sink.sent;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = _userData(URING_SEND, index);
+}
+
+void
+UringRouter::HandleSend(int index, const struct io_uring_cqe *cqe)
+{
+    Sink &sink = sinks[index];
+    if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+        QueueSend(index);
+        return;
+    }
+    if (cqe->res < 0) {
+        errno = -cqe->res;
+        perror("failed to send to a sink");
+        failed = true;
+    } else {
+        // Resume a short send where it stopped
+        sink.sent += cqe->res;
+        if (sink.sent < sink.inflight.size()) {
+            QueueSend(index);
+            return;
+        }
+    }
+    sink.sending = false;
+    numSending--;
+}
+
+bool
+UringRouter::Run()
+{
+    if (!Setup()) {
+        failed = true;
+        ShutDown();
+        return false;
+    }
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        ArmReceive(i);
+    }
+    numOpenSources = sources.size();
+
+    while (numOpenSources > 0 || numSending > 0) {
+        if (Submit(1) < 0) {
+            failed = true;
+            break;
+        }
+
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+            int index = (int) (cqe->user_data & UINT32_MAX);
+            if ((cqe->user_data >> 32) == URING_RECEIVE) {
+                HandleReceive(index, cqe);
+            } else {
+                HandleSend(index, cqe);
+            }
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+        for (size_t i = 0; i < sinks.size(); i++) {
+            SendPending(i);
+        }
+    }
+
+    ShutDown();
+    return !failed;
+}
+
+void
+UringRouter::ShutDown()
+{
+    // The servers read until their sink closes, whether or not every source got through
+    for (size_t i = 0; i < sinks.size(); i++) {
+        shutdown(sinks[i].sockfd, SHUT_WR);
+    }
+    if (failed) {
+        for (size_t i = 0; i < sources.size(); i++) {
+            shutdown(sources[i].sockfd, SHUT_WR);
+        }
+    }
+}
+
+void *
+runUringRouter(void *arg)
+{
+    UringRouter *uringRouter = (UringRouter *) arg;
+    if (!uringRouter->Run()) {
+        std::cerr << "the io_uring router failed" << std::endl;
+    }
+    return NULL;
+}
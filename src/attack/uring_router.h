@@ -0,0 +1,115 @@
+#ifndef URING_ROUTER_H_
+#define URING_ROUTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+#include <vector>
+
+#include "framing.h"
+#include "router.h"
+
+using namespace std;
+
+#define URING_NUM_BUFFERS 256
+#define URING_BUFFER_SIZE (16 * 1024)
+
+// An io_uring event loop that forwards names for a Router between many stream connections, e.g.,
+// TCP over loopback. Sources send frames, as FrameWriter does; each name is looked up in the
+// router's FIB and its frame is sent to the sink of every port in the output bitmap.
+//
+// Every source has one multishot receive outstanding, which takes buffers from a ring of
+// URING_NUM_BUFFERS registered with the kernel. Names are looked up where they land in those
+// buffers, and only a frame split between two receives is copied to be put back together. Frames
+// bound for a sink are gathered while the completions at hand are handled, and then go out in one
+// send per sink, with at most one send in flight per sink so that they stay in order.
+class UringRouter
+{
+public:
+    UringRouter(Router *theRouter);
+    ~UringRouter();
+
+    void AddSource(int sock);
+
+    // Names whose output bitmap has port set go out on sock
+    void AddSink(int port, int sock);
+
+    // Forward until every source has closed, then shut the sinks down. Returns false if the
+    // kernel lacks io_uring, registered buffer rings or multishot receives, or on an error, after
+    // shutting down the sources as well; failed is then set.
+    bool Run();
+
+    struct Source {
+        int sockfd;
+        bool open;
+        std::vector<uint8_t> partial;
+    };
+
+    struct Sink {
+        int sockfd;
+        bool sending;
+        size_t sent;
+        std::vector<uint8_t> pending;
+        std::vector<uint8_t> inflight;
+    };
+
+    Router *router;
+    std::vector<Source> sources;
+    std::vector<Sink> sinks;
+    std::vector<int> portSinks;
+    int numOpenSources;
+    int numSending;
+    bool failed;
+    std::vector<Frame> frames;
+
+    // The submission and completion queues, mapped from the kernel
+    int ringfd;
+    unsigned numEntries;
+    void *sqMap;
+    size_t sqMapSize;
+    void *cqMap;
+    size_t cqMapSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+    unsigned sqLocalTail;
+    unsigned numQueued;
+
+    // The registered buffers the receives land in
+    struct io_uring_buf_ring *bufferRing;
+    size_t bufferRingSize;
+    uint8_t *buffers;
+    unsigned short bufferTail;
+
+    bool Setup();
+    int Submit(unsigned waitFor);
+    struct io_uring_sqe *NextEntry();
+    void RecycleBuffer(unsigned short bid);
+
+    void ArmReceive(int source);
+    void HandleReceive(int source, const struct io_uring_cqe *cqe);
+    void Receive(int source, const uint8_t *data, size_t length);
+
+    // Look up the whole frames at the front of data and queue them for their sinks, returning the
+    // bytes they took
+    size_t ForwardFrames(const uint8_t *data, size_t length);
+
+    void SendPending(int sink);
+    void QueueSend(int sink);
+    void HandleSend(int sink, const struct io_uring_cqe *cqe);
+
+    // Shut the sinks down, and the sources too if forwarding failed
+    void ShutDown();
+};
+
+void *runUringRouter(void *arg);
+
+#endif // URING_ROUTER_H_
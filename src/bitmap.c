@@ -6,27 +6,43 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 
 #include <LongBow/runtime.h>
 
-#define WORDSIZE 32
+#include "allocator.h"
+
+#define WORDSIZE 64
 
 struct bitmap {
-    uint32_t *map;
-    int bitSize;
-    int byteSize;
+    uint64_t *map;
+    uint64_t bitSize;
+    size_t numWords;
+    size_t byteSize;
+    Allocator *allocator;
 };
 
 Bitmap *
-bitmap_Create(int size)
+bitmap_Create(uint64_t size)
 {
-    // XXX: we should check that this is a multiple of 8
     Bitmap *map = (Bitmap *) malloc(sizeof(Bitmap));
     if (map != NULL) {
         map->bitSize = size;
-        map->byteSize = size / 8;
-        map->map = (uint32_t *) malloc(sizeof(uint32_t) * (map->byteSize / sizeof(uint32_t)));
-        memset(map->map, 0, sizeof(uint32_t) * (map->byteSize / sizeof(uint32_t)));
+
+        // Round up to whole words so that sizes which are not a multiple of the word size still fit
+        map->numWords = (size + WORDSIZE - 1) / WORDSIZE;
+        map->byteSize = map->numWords * sizeof(uint64_t);
+        if (map->byteSize == 0) {
+            map->byteSize = sizeof(uint64_t);
+        }
+
+        // Large filters are backed by (possibly huge-page, node-local) memory from the allocator
+        map->allocator = allocator_GetDefault();
+        map->map = (uint64_t *) allocator_Allocate(map->allocator, map->byteSize);
+        if (map->map == NULL) {
+            free(map);
+            return NULL;
+        }
     }
     return map;
 }
@@ -34,8 +50,8 @@ bitmap_Create(int size)
 void
 bitmap_Display(Bitmap *bitmap)
 {
-    for (int i = 0; i < (bitmap->byteSize / sizeof(uint32_t)); i++) {
-        printf("%08x", bitmap->map[i]);
+    for (size_t i = 0; i < bitmap->numWords; i++) {
+        printf("%016" PRIx64, bitmap->map[i]);
     }
     printf("\n");
 }
@@ -44,47 +60,48 @@ void
 bitmap_Destroy(Bitmap **bitmapP)
 {
     Bitmap *map = *bitmapP;
-    free(map->map);
+    allocator_Deallocate(map->allocator, map->map, map->byteSize);
     free(map);
     *bitmapP = NULL;
 }
 
-static int
-_bitToBlock(int bit)
+static size_t
+_bitToBlock(uint64_t bit)
 {
-    int byteOffset = bit / 8;
-    int wordOffset = byteOffset / 4;
-    return wordOffset;
+    return (size_t) (bit / WORDSIZE);
 }
 
-static uint32_t
-_bitToBlockMask(int bit)
+static uint64_t
+_bitToBlockMask(uint64_t bit)
 {
-    return (1 << (WORDSIZE - bit - 1));
+    return ((uint64_t) 1) << (WORDSIZE - (bit % WORDSIZE) - 1);
+}
+
+uint64_t
+bitmap_GetSize(Bitmap *bitmap)
+{
+    return bitmap->bitSize;
 }
 
 bool
-bitmap_Get(Bitmap *bitmap, int bit)
+bitmap_Get(Bitmap *bitmap, uint64_t bit)
 {
-    if (bit < 0 || bit > bitmap->bitSize) {
+    if (bit >= bitmap->bitSize) {
         return false;
     }
 
-    uint32_t block = bitmap->map[_bitToBlock(bit)];
-    uint32_t blockMask = _bitToBlockMask(bit % WORDSIZE);
-
-    return (block & blockMask) != 0;
+    uint64_t block = bitmap->map[_bitToBlock(bit)];
+    return (block & _bitToBlockMask(bit)) != 0;
 }
 
 void
-bitmap_Set(Bitmap *bitmap, int bit)
+bitmap_Set(Bitmap *bitmap, uint64_t bit)
 {
-    if (bit < 0 || bit > bitmap->bitSize) {
+    if (bit >= bitmap->bitSize) {
         return;
     }
 
-    uint32_t blockMask = _bitToBlockMask(bit % WORDSIZE);
-    bitmap->map[_bitToBlock(bit)] |= blockMask;
+    bitmap->map[_bitToBlock(bit)] |= _bitToBlockMask(bit);
 }
 
 void
@@ -92,8 +109,10 @@ bitmap_SetVector(Bitmap *bitmap, Bitmap *other) {
     if (bitmap->bitSize != other->bitSize) {
         assertFalse(true, "Fatal error. Bitmaps were not the same size.");
     }
-    for (int i = 0; i < bitmap->bitSize; i++) {
-        bitmap->map[_bitToBlock(i)] |= ((other->map[_bitToBlock(i)] & _bitToBlockMask(i % WORDSIZE)));
+
+    // Bits past bitSize are never set, so whole words can be combined
+    for (size_t i = 0; i < bitmap->numWords; i++) {
+        bitmap->map[i] |= other->map[i];
     }
 }
 
@@ -103,8 +122,8 @@ bitmap_Contains(Bitmap *bitmap, Bitmap *other)
     if (bitmap->bitSize != other->bitSize) {
         assertFalse(true, "Fatal error. Bitmaps were not the same size.");
     }
-    for (int i = 0; i < bitmap->bitSize; i++) {
-        if (!bitmap_Get(bitmap, i) && bitmap_Get(other, i)) {
+    for (size_t i = 0; i < bitmap->numWords; i++) {
+        if ((other->map[i] & ~bitmap->map[i]) != 0) {
             return false;
         }
     }
@@ -115,10 +134,10 @@ bool
 bitmap_Equals(Bitmap *bitmap, Bitmap *other)
 {
     if (bitmap->bitSize != other->bitSize) {
-        assertFalse(true, "Fatal error. Bitmaps were not the same size: %d and %d", bitmap->bitSize, other->bitSize);
+        assertFalse(true, "Fatal error. Bitmaps were not the same size: %" PRIu64 " and %" PRIu64, bitmap->bitSize, other->bitSize);
     }
-    for (int i = 0; i < bitmap->bitSize; i++) {
-        if (bitmap_Get(bitmap, i) != bitmap_Get(other, i)) {
+    for (size_t i = 0; i < bitmap->numWords; i++) {
+        if (bitmap->map[i] != other->map[i]) {
             return false;
         }
     }
@@ -126,10 +145,32 @@ bitmap_Equals(Bitmap *bitmap, Bitmap *other)
 }
 
 void
-bitmap_Clear(Bitmap *bitmap, int bit)
+bitmap_Clear(Bitmap *bitmap, uint64_t bit)
 {
-    if (bit < 0 || bit > bitmap->bitSize) {
+    if (bit >= bitmap->bitSize) {
         return;
     }
-    bitmap->map[_bitToBlock(bit)] &= ~(_bitToBlockMask(bit % WORDSIZE));
-}
\ No newline at end of file
+    bitmap->map[_bitToBlock(bit)] &= ~(_bitToBlockMask(bit));
+}
+
+uint64_t
+bitmap_Count(Bitmap *bitmap)
+{
+    uint64_t count = 0;
+    for (size_t i = 0; i < bitmap->numWords; i++) {
+        count += __builtin_popcountll(bitmap->map[i]);
+    }
+    return count;
+}
+
+uint64_t *
+bitmap_GetWords(Bitmap *bitmap)
+{
+    return bitmap->map;
+}
+
+size_t
+bitmap_GetWordCount(Bitmap *bitmap)
+{
+    return bitmap->numWords;
+}
@@ -12,27 +12,39 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 struct bitmap;
 typedef struct bitmap Bitmap;
 
-Bitmap *bitmap_Create(int size);
+// Bit sizes and indexes are 64-bit, so filters may exceed 2^31 bits.
+Bitmap *bitmap_Create(uint64_t size);
 
 void bitmap_Destroy(Bitmap **bitmapP);
 
 void bitmap_Display(Bitmap *bitmap);
 
-bool bitmap_Get(Bitmap *bitmap, int bit);
+uint64_t bitmap_GetSize(Bitmap *bitmap);
+
+bool bitmap_Get(Bitmap *bitmap, uint64_t bit);
 
 bool bitmap_Contains(Bitmap *bitmap, Bitmap *other);
 
 bool bitmap_Equals(Bitmap *bitmap, Bitmap *other);
 
-void bitmap_Set(Bitmap *bitmap, int bit);
+void bitmap_Set(Bitmap *bitmap, uint64_t bit);
 
 void bitmap_SetVector(Bitmap *bitmap, Bitmap *other);
 
-void bitmap_Clear(Bitmap *bitmap, int bit);
+void bitmap_Clear(Bitmap *bitmap, uint64_t bit);
+
+uint64_t bitmap_Count(Bitmap *bitmap);
+
+// The backing words, most significant bit first. Bits past the bitmap size are always clear,
+// so callers may combine whole words as long as they keep them that way.
+uint64_t *bitmap_GetWords(Bitmap *bitmap);
+
+size_t bitmap_GetWordCount(Bitmap *bitmap);
 
 #endif //FIB_PERF_BITMAP_H
 
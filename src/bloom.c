@@ -1,7 +1,9 @@
 #include <stdlib.h>
+#include <math.h>
 
 #include "bloom.h"
 #include "siphasher.h"
+#include "siphash24.h"
 
 #include <parc/algol/parc_Memory.h>
 #include <parc/algol/parc_BitVector.h>
@@ -10,21 +12,42 @@
 #include <stdio.h>
 #include "timer.h"
 
+// Growth stages double the expected capacity and halve the target FPR so that
+// the compounded false positive rate of the whole chain stays below 2 * targetFPR
+// (Almeida et al., "Scalable Bloom Filters").
+const int BloomGrowthFactor = 2;
+
+// An optimally sized filter is half full at its design capacity
+const double BloomDefaultMaxFillRatio = 0.5;
+
 struct bloom_filter {
-    int m;
+    size_t m;
     int ln2m;
     int k;
 
-    int **bitMatrix;
+    // Sizing and growth state
+    int numEntries;
+    int capacity;
+    int fillCheckInterval;
+    double targetFPR;
+    double maxFillRatio;
+    struct bloom_filter *next;
+
+    // The value hasher may be shared by many filters (and by all stages of one filter)
     SipHasher *hasher;
+    bool ownsHasher;
+
+    // Per-hash-function state for name (prefix vector) hashing, created on first use
+    size_t **bitMatrix;
     Hasher **vectorHashers;
-    Bitmap *array;
     PARCBuffer **keys;
+
+    Bitmap *array;
 };
 
 static int
-_log2(int x) {
-    int n = x;
+_log2(size_t x) {
+    size_t n = x;
     int bits = 0;
     while (n > 0) {
         n >>= 1;
@@ -43,8 +66,52 @@ _freeBitMatrix(BloomFilter *filter, int numCols)
     }
 }
 
+static PARCBuffer *
+_bloom_CreateKey(int index)
+{
+    PARCBuffer *key = parcBuffer_Allocate(SIPHASH_KEY_LENGTH);
+    memset(parcBuffer_Overlay(key, 0), 0, SIPHASH_KEY_LENGTH);
+    parcBuffer_PutUint32(key, index);
+    parcBuffer_Flip(key);
+    return key;
+}
+
+SipHasher *
+bloom_CreateHasher()
+{
+    PARCBuffer *key = _bloom_CreateKey(0);
+    SipHasher *hasher = siphasher_Create(key);
+    parcBuffer_Release(&key);
+    return hasher;
+}
+
+static void
+_bloom_CreateNameHashers(BloomFilter *bf)
+{
+    int k = bf->k;
+
+    bf->keys = parcMemory_Allocate(sizeof(PARCBuffer **) * k);
+    for (int i = 0; i < k; i++) {
+        bf->keys[i] = _bloom_CreateKey(i);
+    }
+
+    bf->vectorHashers = (Hasher **) malloc(k * sizeof(Hasher *));
+    for (int i = 0; i < k; i++) {
+        SipHasher *hasher = siphasher_Create(bf->keys[i]);
+        bf->vectorHashers[i] = hasher_Create(hasher, SipHashAsHasher);
+    }
+
+    bf->bitMatrix  = (size_t **) malloc(k * sizeof(size_t *));
+    for (int i = 0; i < k; i++) {
+        bf->bitMatrix[i] = (size_t *) malloc(1024 * sizeof(size_t));
+        for (int j = 0; j < 1024; j++) {
+            bf->bitMatrix[i][j] = 0;
+        }
+    }
+}
+
 BloomFilter *
-bloom_Create(int m, int k)
+bloom_CreateWithHasher(size_t m, int k, SipHasher *hasher)
 {
     BloomFilter *bf = (BloomFilter *) malloc(sizeof(BloomFilter));
     if (bf != NULL) {
@@ -53,29 +120,34 @@ bloom_Create(int m, int k)
         bf->k = k;
         bf->array = bitmap_Create(m);
 
-        bf->keys = parcMemory_Allocate(sizeof(PARCBuffer **) * k);
-        for (int i = 0; i < k; i++) {
-            bf->keys[i] = parcBuffer_Allocate(SIPHASH_KEY_LENGTH);
-            memset(parcBuffer_Overlay(bf->keys[i], 0), 0, SIPHASH_KEY_LENGTH);
-            parcBuffer_PutUint32(bf->keys[i], k);
-            parcBuffer_Flip(bf->keys[i]);
+        bf->hasher = hasher;
+        bf->ownsHasher = false;
+        bf->keys = NULL;
+        bf->vectorHashers = NULL;
+        bf->bitMatrix = NULL;
+
+        bf->numEntries = 0;
+        bf->capacity = 0;
+        bf->targetFPR = 0.0;
+        bf->maxFillRatio = 0.0;
+        bf->next = NULL;
+
+        // Only count the bits every so often -- roughly k words of popcount per insertion
+        bf->fillCheckInterval = (int) ((m / k) / 32);
+        if (bf->fillCheckInterval < 1) {
+            bf->fillCheckInterval = 1;
         }
 
-        bf->vectorHashers = (Hasher **) malloc(k * sizeof(Hasher *));
-        for (int i = 0; i < k; i++) {
-            SipHasher *hasher = siphasher_Create(bf->keys[i]);
-            bf->vectorHashers[i] = hasher_Create(hasher, SipHashAsHasher);
-        }
-
-        bf->hasher = siphasher_CreateWithKeys(k, bf->keys);
+    }
+    return bf;
+}
 
-        bf->bitMatrix  = (int **) malloc(k * sizeof(int *));
-        for (int i = 0; i < k; i++) {
-            bf->bitMatrix[i] = (int *) malloc(1024 * sizeof(int));
-            for (int j = 0; j < 1024; j++) {
-                bf->bitMatrix[i][j] = 0;
-            }
-        }
+BloomFilter *
+bloom_Create(size_t m, int k)
+{
+    BloomFilter *bf = bloom_CreateWithHasher(m, k, bloom_CreateHasher());
+    if (bf != NULL) {
+        bf->ownsHasher = true;
     }
     return bf;
 }
@@ -85,76 +157,276 @@ bloom_Destroy(BloomFilter **bfP)
 {
     BloomFilter *bf = *bfP;
 
-    for (int i = 0; i < bf->k; i++) {
-        parcBuffer_Release(&bf->keys[i]);
-        hasher_Destroy(&bf->vectorHashers[i]);
+    if (bf->vectorHashers != NULL) {
+        for (int i = 0; i < bf->k; i++) {
+            parcBuffer_Release(&bf->keys[i]);
+            hasher_Destroy(&bf->vectorHashers[i]);
+            free(bf->bitMatrix[i]);
+        }
+        parcMemory_Deallocate(&bf->keys);
+        free(bf->vectorHashers);
+        free(bf->bitMatrix);
     }
+
     bitmap_Destroy(&bf->array);
-    siphasher_Destroy(&bf->hasher);
-    parcMemory_Deallocate(&bf->keys);
-    free(bf->vectorHashers);
+    if (bf->ownsHasher) {
+        siphasher_Destroy(&bf->hasher);
+    }
 
-    for (int k = 0; k < bf->k; k++) {
-        free(bf->bitMatrix[k]);
+    if (bf->next != NULL) {
+        bloom_Destroy(&bf->next);
     }
-    free(bf->bitMatrix);
 
+    free(bf);
     *bfP = NULL;
 }
 
+static uint64_t
+_bloom_Mix64(uint64_t x)
+{
+    // SplitMix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+void
+bloom_DigestToHashPair(size_t length, uint8_t digest[], uint64_t *h1, uint64_t *h2)
+{
+    // Fold alternating 64-bit words of the digest into the two halves so that every byte contributes
+    uint64_t a = 0;
+    uint64_t b = 0;
+    for (size_t offset = 0, word = 0; offset < length; offset += sizeof(uint64_t), word++) {
+        uint64_t value = 0;
+        size_t remaining = length - offset;
+        memcpy(&value, digest + offset, remaining < sizeof(uint64_t) ? remaining : sizeof(uint64_t));
+        if (word % 2 == 0) {
+            a = _bloom_Mix64(a ^ value);
+        } else {
+            b = _bloom_Mix64(b ^ value);
+        }
+    }
+
+    // Short (e.g., 8-byte) digests only fill a, so h2 is derived from h1.
+    // h2 is forced odd so the probe sequence never degenerates to a single bit.
+    *h1 = _bloom_Mix64(a ^ length);
+    *h2 = _bloom_Mix64(b ^ *h1) | 1;
+}
+
+size_t
+bloom_HashIndex(uint64_t h1, uint64_t h2, int i, size_t m)
+{
+    // The cubic term keeps the sequence from cycling through a few indexes when h2 shares a factor with m
+    uint64_t j = (uint64_t) i;
+    return (size_t) ((h1 + j * h2 + (j * j * j - j) / 6) % (uint64_t) m);
+}
+
+static size_t
+_bloom_DigestToIndex(PARCBuffer *digest, size_t m)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_DigestToHashPair(parcBuffer_Remaining(digest), parcBuffer_Overlay(digest, 0), &h1, &h2);
+    return bloom_HashIndex(h1, h2, 0, m);
+}
+
+size_t
+bloom_OptimalSize(int expectedEntries, double targetFPR)
+{
+    // m = -n * ln(p) / ln(2)^2
+    double m = -((double) expectedEntries * log(targetFPR)) / (M_LN2 * M_LN2);
+    size_t size = (size_t) ceil(m);
+    return size < 1 ? 1 : size;
+}
+
+int
+bloom_OptimalHashCount(size_t m, int expectedEntries)
+{
+    // k = (m / n) * ln(2)
+    int k = (int) round(((double) m / (double) expectedEntries) * M_LN2);
+    return k < 1 ? 1 : k;
+}
+
+BloomFilter *
+bloom_CreateOptimalWithHasher(int expectedEntries, double targetFPR, SipHasher *hasher)
+{
+    assertTrue(expectedEntries > 0, "Expected a positive number of entries, got %d", expectedEntries);
+    assertTrue(targetFPR > 0.0 && targetFPR < 1.0, "Expected a target FPR in (0, 1), got %f", targetFPR);
+
+    size_t m = bloom_OptimalSize(expectedEntries, targetFPR);
+    int k = bloom_OptimalHashCount(m, expectedEntries);
+
+    BloomFilter *bf = bloom_CreateWithHasher(m, k, hasher);
+    if (bf != NULL) {
+        bf->capacity = expectedEntries;
+        bf->targetFPR = targetFPR;
+    }
+    return bf;
+}
+
+BloomFilter *
+bloom_CreateOptimal(int expectedEntries, double targetFPR)
+{
+    BloomFilter *bf = bloom_CreateOptimalWithHasher(expectedEntries, targetFPR, bloom_CreateHasher());
+    if (bf != NULL) {
+        bf->ownsHasher = true;
+    }
+    return bf;
+}
+
+void
+bloom_SetMaxFillRatio(BloomFilter *filter, double maxFillRatio)
+{
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        stage->maxFillRatio = maxFillRatio;
+    }
+}
+
+double
+bloom_FillRatio(BloomFilter *filter)
+{
+    double setBits = 0;
+    double totalBits = 0;
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        setBits += bitmap_Count(stage->array);
+        totalBits += stage->m;
+    }
+    return setBits / totalBits;
+}
+
+size_t
+bloom_GetSize(BloomFilter *filter)
+{
+    size_t size = 0;
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size += stage->m;
+    }
+    return size;
+}
+
+int
+bloom_GetHashCount(BloomFilter *filter)
+{
+    return filter->k;
+}
+
+static BloomFilter *
+_bloom_CreateNextStage(BloomFilter *stage)
+{
+    // Stages borrow the first stage's hasher, so a value is hashed once for the whole chain
+    BloomFilter *next = NULL;
+    if (stage->capacity > 0) {
+        next = bloom_CreateOptimalWithHasher(stage->capacity * BloomGrowthFactor, stage->targetFPR / BloomGrowthFactor, stage->hasher);
+    } else {
+        next = bloom_CreateWithHasher(stage->m * BloomGrowthFactor, stage->k, stage->hasher);
+    }
+    next->maxFillRatio = stage->maxFillRatio;
+    return next;
+}
+
+// Return the stage that should receive the next insertion, growing the filter
+// if the measured fill ratio of the current stage crossed the threshold.
+static BloomFilter *
+_bloom_GetInsertionStage(BloomFilter *filter)
+{
+    BloomFilter *stage = filter;
+    while (stage->next != NULL) {
+        stage = stage->next;
+    }
+
+    if (stage->maxFillRatio > 0 && stage->numEntries > 0 && (stage->numEntries % stage->fillCheckInterval) == 0) {
+        double fillRatio = (double) bitmap_Count(stage->array) / stage->m;
+        if (fillRatio >= stage->maxFillRatio) {
+            stage->next = _bloom_CreateNextStage(stage);
+            stage = stage->next;
+        }
+    }
+
+    stage->numEntries++;
+    return stage;
+}
+
+// Hash the first component of a hashed name under hash functions 1 to k - 1 together, one
+// SIMD lane per key. Entry i - 1 of firstHashes wraps the digest of hash function i.
+static void
+_bloom_HashFirstComponents(BloomFilter *filter, Name *hashedName, uint8_t digests[][SIPHASH_HASH_LENGTH],
+                           PARCBuffer *firstHashes[])
+{
+    int count = filter->k - 1;
+    if (count < 1) {
+        return;
+    }
+
+    uint8_t *outputs[count];
+    const uint8_t *inputs[count];
+    uint64_t lengths[count];
+    const uint8_t *keys[count];
+    for (int i = 0; i < count; i++) {
+        outputs[i] = digests[i];
+        inputs[i] = name_GetBuffer(hashedName);
+        lengths[i] = name_GetPrefixLength(hashedName, 1);
+        keys[i] = parcBuffer_Overlay(filter->keys[i + 1], 0);
+    }
+    siphash_many(count, outputs, inputs, lengths, keys);
+
+    for (int i = 0; i < count; i++) {
+        firstHashes[i] = parcBuffer_Wrap(digests[i], SIPHASH_HASH_LENGTH, 0, SIPHASH_HASH_LENGTH);
+    }
+}
+
 void
 bloom_AddName(BloomFilter *filter, Name *name)
 {
+    filter = _bloom_GetInsertionStage(filter);
+    if (filter->vectorHashers == NULL) {
+        _bloom_CreateNameHashers(filter);
+    }
+
     // compute the d hashes for the first (k = 0) hash
     Name *newName = name_Hash(name, filter->vectorHashers[0], 8);
 
     // compute the bit for the first hash (k = 0)
     PARCBuffer *segmentHash = name_GetWireFormat(newName, name_GetSegmentCount(name));
-    size_t checkSum = 0;
-    uint8_t *segmentHashOverlay = parcBuffer_Overlay(segmentHash, 0);
-    for (int b = 0; b < parcBuffer_Remaining(segmentHash); b++) {
-        checkSum += segmentHashOverlay[b];
-    }
 
     // set the target bit
-    checkSum %= filter->m;
-    bitmap_Set(filter->array, checkSum);
+    bitmap_Set(filter->array, _bloom_DigestToIndex(segmentHash, filter->m));
 
     parcBuffer_Release(&segmentHash);
 
+    // the first component for the other hashes is always fed through the hasher
+    uint8_t digests[filter->k][SIPHASH_HASH_LENGTH];
+    PARCBuffer *firstHashes[filter->k];
+    _bloom_HashFirstComponents(filter, newName, digests, firstHashes);
+
     // use XOR to seed out the remaining hash values for the d prefixes, for each other hash function
     for (int i = 1; i < filter->k; i++) {
-
-        // the first component for the other hashes is always fed through the hasher
-        PARCBuffer *firstComponent = name_GetWireFormat(newName, 1);
-        PARCBuffer *firstHash = hasher_Hash(filter->vectorHashers[i], firstComponent);
+        PARCBuffer *firstHash = firstHashes[i - 1];
 
         // the rest are derived by XORing this first segment with the d-th segment of the first hash function, i.e.,
         //    H_{i,j} = H_{i, 1} XOR H_{1, j}
         // where i = k and j = d
         PARCBuffer *segmentHash = name_XORSegment(newName, name_GetSegmentCount(name) - 1, firstHash);
 
-        size_t checkSum = 0;
-        uint8_t *segmentHashOverlay = parcBuffer_Overlay(segmentHash, 0);
-        for (int b = 0; b < parcBuffer_Remaining(segmentHash); b++) {
-            checkSum += segmentHashOverlay[b];
-        }
-        checkSum %= filter->m;
-
         // Finally, set the target bit.
-        bitmap_Set(filter->array, checkSum);
+        bitmap_Set(filter->array, _bloom_DigestToIndex(segmentHash, filter->m));
         parcBuffer_Release(&segmentHash);
 
-        parcBuffer_Release(&firstComponent);
         parcBuffer_Release(&firstHash);
     }
 
     name_Destroy(&newName);
 }
 
-int
-bloom_TestName(BloomFilter *filter, Name *name)
+static void
+_bloom_TestNameStage(BloomFilter *filter, Name *name, bool present[])
 {
+    if (filter->vectorHashers == NULL) {
+        _bloom_CreateNameHashers(filter);
+    }
+
     // compute the d hashes for the first (k = 0) hash
     Timestamp start = timerStart();
     Name *newName = name_Hash(name, filter->vectorHashers[0], 8);
@@ -165,26 +437,23 @@ bloom_TestName(BloomFilter *filter, Name *name)
     start = timerStart();
     for (int d = 0; d < name_GetSegmentCount(newName); d++) {
         PARCBuffer *segmentHash = name_GetWireFormat(newName, d + 1);
-        size_t checkSum = 0;
-        uint8_t *segmentHashOverlay = parcBuffer_Overlay(segmentHash, 0);
-        for (int b = 0; b < parcBuffer_Remaining(segmentHash); b++) {
-            checkSum += segmentHashOverlay[b];
-        }
-        checkSum %= filter->m;
-        filter->bitMatrix[0][d] = checkSum;
+        filter->bitMatrix[0][d] = _bloom_DigestToIndex(segmentHash, filter->m);
         parcBuffer_Release(&segmentHash);
     }
     elapsed = timerEnd(start);
 //    printf("First row: %ld\n", elapsed);
 
+    // the first component for the other hashes is always fed through the hasher
+    uint8_t digests[filter->k][SIPHASH_HASH_LENGTH];
+    PARCBuffer *firstHashes[filter->k];
+    _bloom_HashFirstComponents(filter, newName, digests, firstHashes);
+
     // use XOR to seed out the remaining hash values for the d prefixes, for each other hash function
     for (int i = 1; i < filter->k; i++) {
 
         start = timerStart();
 
-        // the first component for the other hashes is always fed through the hasher
-        PARCBuffer *firstComponent = name_GetWireFormat(newName, 1);
-        PARCBuffer *firstHash = hasher_Hash(filter->vectorHashers[i], firstComponent);
+        PARCBuffer *firstHash = firstHashes[i - 1];
 
         // the rest are derived by XORing this first segment with the d-th segment of the first hash function, i.e.,
         //    H_{i,j} = H_{i, 1} XOR H_{1, j}
@@ -192,27 +461,19 @@ bloom_TestName(BloomFilter *filter, Name *name)
         for (int d = 0; d < name_GetSegmentCount(newName); d++) {
             PARCBuffer *segmentHash = name_XORSegment(newName, d, firstHash);
 
-            size_t checkSum = 0;
-            uint8_t *segmentHashOverlay = parcBuffer_Overlay(segmentHash, 0);
-            for (int b = 0; b < parcBuffer_Remaining(segmentHash); b++) {
-                checkSum += segmentHashOverlay[b];
-            }
-            checkSum %= filter->m;
-
             // Finally, set the target bit in the matrix
-            filter->bitMatrix[i][d] = checkSum;
+            filter->bitMatrix[i][d] = _bloom_DigestToIndex(segmentHash, filter->m);
 
             parcBuffer_Release(&segmentHash);
         }
 
-        parcBuffer_Release(&firstComponent);
         parcBuffer_Release(&firstHash);
 
         elapsed = timerEnd(start);
 //        printf("%dth vector: %ld\n", i, elapsed);
     }
 
-    // Now do LPM on the bit matrix
+    // Now test every prefix against the bit matrix
     for (int d = name_GetSegmentCount(name) - 1; d >= 0; d--) {
         bool allMatch = true;
         for (int k = 0; k < filter->k; k++) {
@@ -221,104 +482,207 @@ bloom_TestName(BloomFilter *filter, Name *name)
                 break;
             }
         }
-
-        if (allMatch) {
-            _freeBitMatrix(filter, filter->k);
-            name_Destroy(&newName);
-            return d + 1;
-        }
+        present[d] = present[d] || allMatch;
     }
 
     _freeBitMatrix(filter, filter->k);
     name_Destroy(&newName);
+}
+
+int
+bloom_TestNamePrefixes(BloomFilter *filter, Name *name, bool present[])
+{
+    int numSegments = name_GetSegmentCount(name);
+    for (int d = 0; d < numSegments; d++) {
+        present[d] = false;
+    }
+
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        _bloom_TestNameStage(stage, name, present);
+    }
+
+    for (int d = numSegments - 1; d >= 0; d--) {
+        if (present[d]) {
+            return d + 1;
+        }
+    }
     return -1;
 }
 
+int
+bloom_TestName(BloomFilter *filter, Name *name)
+{
+    bool present[name_GetSegmentCount(name) + 1];
+    return bloom_TestNamePrefixes(filter, name, present);
+}
+
+// Hash the value once and derive the k bit indexes from the digest, rather than
+// materializing an m-bit vector per operation (which is prohibitive for large m).
+static void
+_bloom_HashPair(BloomFilter *filter, size_t length, uint8_t value[length], uint64_t *h1, uint64_t *h2)
+{
+    PARCBuffer *digest = siphasher_HashArray(filter->hasher, length, value);
+    bloom_DigestToHashPair(parcBuffer_Remaining(digest), parcBuffer_Overlay(digest, 0), h1, h2);
+    parcBuffer_Release(&digest);
+}
+
+static void
+_bloom_SetIndexes(BloomFilter *filter, uint64_t h1, uint64_t h2)
+{
+    for (int i = 0; i < filter->k; i++) {
+        bitmap_Set(filter->array, bloom_HashIndex(h1, h2, i, filter->m));
+    }
+}
+
+static bool
+_bloom_TestIndexes(BloomFilter *filter, uint64_t h1, uint64_t h2)
+{
+    for (int i = 0; i < filter->k; i++) {
+        if (!bitmap_Get(filter->array, bloom_HashIndex(h1, h2, i, filter->m))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void
 bloom_Add(BloomFilter *filter, PARCBuffer *value)
 {
-    Bitmap *hashVector = siphasher_HashToVector(filter->hasher, value, filter->m);
-    bitmap_SetVector(filter->array, hashVector);
-    bitmap_Destroy(&hashVector);
+    filter = _bloom_GetInsertionStage(filter);
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _bloom_HashPair(filter, parcBuffer_Remaining(value), parcBuffer_Overlay(value, 0), &h1, &h2);
+    _bloom_SetIndexes(filter, h1, h2);
 }
 
 void
-bloom_AddRaw(BloomFilter *filter, int length, uint8_t value[length])
+bloom_AddRaw(BloomFilter *filter, int length, uint8_t value[])
 {
-    Bitmap *hashVector = siphasher_HashArrayToVector(filter->hasher, length, value, filter->m);
-    bitmap_SetVector(filter->array, hashVector);
-    bitmap_Destroy(&hashVector);
+    filter = _bloom_GetInsertionStage(filter);
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _bloom_HashPair(filter, length, value, &h1, &h2);
+    _bloom_SetIndexes(filter, h1, h2);
 }
 
 void
 bloom_AddHashed(BloomFilter *filter, PARCBuffer *value)
 {
-    int numBytesRequired = (filter->k * filter->ln2m) / 8;
+    filter = _bloom_GetInsertionStage(filter);
+
     size_t inputSize = parcBuffer_Remaining(value);
-    if (inputSize < numBytesRequired) {
-        assertTrue(false, "Invalid bloom filter hash input -- expected at least %d bytes, got %zu", numBytesRequired, inputSize);
+    if (inputSize == 0) {
+        assertTrue(false, "Invalid bloom filter hash input -- expected a non-empty digest");
         return;
     }
 
-    // |B| = input size [bytes]
-    // k = number of blocks needed
-    // |B| / k = number of bytes to include in each block
-    int blockSize = inputSize / filter->k;
-    uint8_t *overlay = parcBuffer_Overlay(value, 0);
-    for (int i = 0; i < filter->k; i++) {
-        size_t checkSum = 0;
-        for (int b = 0; b < blockSize; b++) {
-            checkSum += overlay[(i * blockSize) + b];
-        }
-        checkSum %= filter->m;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_DigestToHashPair(inputSize, parcBuffer_Overlay(value, 0), &h1, &h2);
+    _bloom_SetIndexes(filter, h1, h2);
+}
 
-        // Set the target bit
-        bitmap_Set(filter->array, checkSum);
+static bool
+_bloom_TestStages(BloomFilter *filter, uint64_t h1, uint64_t h2)
+{
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        if (_bloom_TestIndexes(stage, h1, h2)) {
+            return true;
+        }
     }
+    return false;
 }
 
 bool
 bloom_Test(BloomFilter *filter, PARCBuffer *value)
 {
-    Bitmap *hashVector = siphasher_HashToVector(filter->hasher, value, filter->m);
-    bool contains = bitmap_Contains(filter->array, hashVector);
-    bitmap_Destroy(&hashVector);
-    return contains;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _bloom_HashPair(filter, parcBuffer_Remaining(value), parcBuffer_Overlay(value, 0), &h1, &h2);
+    return _bloom_TestStages(filter, h1, h2);
 }
 
 bool
-bloom_TestRaw(BloomFilter *filter, int length, uint8_t value[length])
+bloom_TestRaw(BloomFilter *filter, int length, uint8_t value[])
 {
-    Bitmap *hashVector = siphasher_HashArrayToVector(filter->hasher, length, value, filter->m);
-    bool contains = bitmap_Contains(filter->array, hashVector);
-    bitmap_Destroy(&hashVector);
-    return contains;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _bloom_HashPair(filter, length, value, &h1, &h2);
+    return _bloom_TestStages(filter, h1, h2);
 }
 
-bool
-bloom_TestHashed(BloomFilter *filter, PARCBuffer *value)
+static bool
+_bloom_TestHashedStage(BloomFilter *filter, PARCBuffer *value)
 {
-    int numBytesRequired = (filter->k * filter->ln2m) / 8;
     size_t inputSize = parcBuffer_Remaining(value);
-    if (inputSize < numBytesRequired) {
-        assertTrue(false, "Invalid bloom filter hash input -- expected at least %d bytes, got %zu", numBytesRequired, inputSize);
+    if (inputSize == 0) {
+        assertTrue(false, "Invalid bloom filter hash input -- expected a non-empty digest");
         return false;
     }
 
-    int blockSize = inputSize / filter->k;
-    uint8_t *overlay = parcBuffer_Overlay(value, 0);
-    for (int i = 0; i < filter->k; i++) {
-        size_t checkSum = 0;
-        for (int b = 0; b < blockSize; b++) {
-            checkSum += overlay[(i * blockSize) + b];
-        }
-        checkSum %= filter->m;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_DigestToHashPair(inputSize, parcBuffer_Overlay(value, 0), &h1, &h2);
+    return _bloom_TestIndexes(filter, h1, h2);
+}
 
-        // Query the target bit
-        if (!bitmap_Get(filter->array, checkSum)) {
-            return false;
+bool
+bloom_TestHashed(BloomFilter *filter, PARCBuffer *value)
+{
+    for (BloomFilter *stage = filter; stage != NULL; stage = stage->next) {
+        if (_bloom_TestHashedStage(stage, value)) {
+            return true;
         }
     }
+    return false;
+}
 
-    return true;
+// Fold the salt into the pair so that the same value under different salts maps to unrelated bits.
+// The salt is spread by an odd constant first: with salt 0, mixing h1 alone would repeat the
+// step that derived h2 from h1 for short digests, and every value would get the same h2.
+void
+bloom_SaltHashPair(uint32_t salt, uint64_t *h1, uint64_t *h2)
+{
+    *h1 = _bloom_Mix64(*h1 ^ (((uint64_t) salt + 1) * 0x9E3779B97F4A7C15ULL));
+    *h2 = _bloom_Mix64(*h2 ^ *h1) | 1;
+}
+
+void
+bloom_HashSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value, uint64_t *h1, uint64_t *h2)
+{
+    _bloom_HashPair(filter, parcBuffer_Remaining(value), parcBuffer_Overlay(value, 0), h1, h2);
+    bloom_SaltHashPair(salt, h1, h2);
+}
+
+bool
+bloom_TestHashPair(BloomFilter *filter, uint64_t h1, uint64_t h2)
+{
+    return _bloom_TestStages(filter, h1, h2);
+}
+
+void
+bloom_AddHashPair(BloomFilter *filter, uint64_t h1, uint64_t h2)
+{
+    filter = _bloom_GetInsertionStage(filter);
+    _bloom_SetIndexes(filter, h1, h2);
+}
+
+void
+bloom_AddSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_HashSalted(filter, salt, value, &h1, &h2);
+    bloom_AddHashPair(filter, h1, h2);
+}
+
+bool
+bloom_TestSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_HashSalted(filter, salt, value, &h1, &h2);
+    return _bloom_TestStages(filter, h1, h2);
 }
@@ -8,21 +8,59 @@ extern "C" {
 #include <parc/algol/parc_Buffer.h>
 
 #include "name.h"
+#include "siphasher.h"
 
 struct bloom_filter;
 typedef struct bloom_filter BloomFilter;
 
-BloomFilter *bloom_Create(int m, int k);
+extern const double BloomDefaultMaxFillRatio;
+
+// Each growth stage holds this many times the entries of the previous one
+extern const int BloomGrowthFactor;
+
+BloomFilter *bloom_Create(size_t m, int k);
+
+// The hasher bloom_Create filters use for values
+SipHasher *bloom_CreateHasher();
+
+// Create a filter that borrows a (possibly shared) value hasher. The hasher must outlive the filter.
+BloomFilter *bloom_CreateWithHasher(size_t m, int k, SipHasher *hasher);
+
+// Create a filter sized for the expected number of entries and the target
+// false positive rate, i.e., m = -n ln(p) / ln(2)^2 and k = (m / n) ln(2).
+BloomFilter *bloom_CreateOptimal(int expectedEntries, double targetFPR);
+
+BloomFilter *bloom_CreateOptimalWithHasher(int expectedEntries, double targetFPR, SipHasher *hasher);
+
+size_t bloom_OptimalSize(int expectedEntries, double targetFPR);
+
+int bloom_OptimalHashCount(size_t m, int expectedEntries);
+
+// Once the fill ratio of the filter crosses maxFillRatio, subsequent insertions
+// go to a new, larger filter stage. Tests check every stage. A ratio of 0 disables growth.
+void bloom_SetMaxFillRatio(BloomFilter *filter, double maxFillRatio);
+
+double bloom_FillRatio(BloomFilter *filter);
+
+size_t bloom_GetSize(BloomFilter *filter);
+
+int bloom_GetHashCount(BloomFilter *filter);
 
 void bloom_Destroy(BloomFilter **bfP);
 
+// Kirsch-Mitzenmacher (enhanced) double hashing: the k indexes of a digest are
+// g_i = h1 + i * h2 + (i^3 - i) / 6 mod m, where h1 and h2 are two 64-bit words derived from (all of) the digest bytes.
+void bloom_DigestToHashPair(size_t length, uint8_t digest[], uint64_t *h1, uint64_t *h2);
+
+size_t bloom_HashIndex(uint64_t h1, uint64_t h2, int i, size_t m);
+
 void bloom_Add(BloomFilter *filter, PARCBuffer *value);
 
 bool bloom_Test(BloomFilter *filter, PARCBuffer *value);
 
-void bloom_AddRaw(BloomFilter *filter, int length, uint8_t value[length]);
+void bloom_AddRaw(BloomFilter *filter, int length, uint8_t value[]);
 
-bool bloom_TestRaw(BloomFilter *filter, int length, uint8_t value[length]);
+bool bloom_TestRaw(BloomFilter *filter, int length, uint8_t value[]);
 
 void bloom_AddHashed(BloomFilter *filter, PARCBuffer *value);
 
@@ -30,8 +68,28 @@ bool bloom_TestHashed(BloomFilter *filter, PARCBuffer *value);
 
 void bloom_AddName(BloomFilter *filter, Name *name);
 
+// The length of the longest prefix of the name that is in the filter, or -1
 int bloom_TestName(BloomFilter *filter, Name *name);
 
+// Set present[d] for every prefix of d + 1 segments that is in the filter, and return the longest such length (or -1)
+int bloom_TestNamePrefixes(BloomFilter *filter, Name *name, bool present[]);
+
+// Salted values live in their own key space, e.g., one filter can hold suffixes of every length
+// by using the length as the salt. A salted value is only found when tested with the same salt.
+void bloom_AddSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value);
+
+bool bloom_TestSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value);
+
+// The (salted) hash pair of a value, so that callers can test it and then reuse it, e.g., as an exact-match key
+void bloom_HashSalted(BloomFilter *filter, uint32_t salt, PARCBuffer *value, uint64_t *h1, uint64_t *h2);
+
+// Move a hash pair into the key space of the salt
+void bloom_SaltHashPair(uint32_t salt, uint64_t *h1, uint64_t *h2);
+
+void bloom_AddHashPair(BloomFilter *filter, uint64_t h1, uint64_t h2);
+
+bool bloom_TestHashPair(BloomFilter *filter, uint64_t h1, uint64_t h2);
+
 #endif // bloom_h_
 
 #ifdef __cplusplus
@@ -0,0 +1,266 @@
+#include "component_dictionary.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "random.h"
+#include "wyhasher.h"
+
+const uint32_t ComponentDictionaryNoID = 0;
+
+// Entry chunk k holds 1024 << k entries, so 23 chunks cover the whole 32-bit ID space
+#define ENTRY_CHUNK_BITS 10
+#define MAX_ENTRY_CHUNKS 23
+
+// Component bytes are copied into blocks of at least this size
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+#define INITIAL_SLOTS 1024
+
+typedef struct {
+    uint64_t hash;
+    const uint8_t *bytes;
+    size_t length;
+} _Entry;
+
+// An open-addressed table of the IDs. A slot holds the upper half of the component hash above
+// the ID, and zero when empty. Outgrown tables stay allocated, since readers may still be in
+// them, and are released with the dictionary.
+typedef struct _slot_table {
+    size_t mask;
+    size_t byteSize;
+    uint64_t *slots;
+    struct _slot_table *retired;
+} _SlotTable;
+
+typedef struct _arena_block {
+    struct _arena_block *next;
+    size_t used;
+    size_t size;
+    uint8_t bytes[];
+} _ArenaBlock;
+
+struct component_dictionary {
+    WYHasher *hasher;
+    Allocator *allocator;
+
+    _SlotTable *table;
+    _Entry *chunks[MAX_ENTRY_CHUNKS];
+    size_t count;
+
+    _ArenaBlock *arena;
+
+    // Serializes interning; lookups only read the published table, entries and count
+    pthread_mutex_t lock;
+};
+
+static ComponentDictionary *_sharedDictionary = NULL;
+static pthread_once_t _sharedDictionaryOnce = PTHREAD_ONCE_INIT;
+
+static _SlotTable *
+_componentDictionary_CreateTable(ComponentDictionary *dictionary, size_t numSlots)
+{
+    _SlotTable *table = (_SlotTable *) malloc(sizeof(_SlotTable));
+    table->mask = numSlots - 1;
+    table->byteSize = numSlots * sizeof(uint64_t);
+    table->slots = (uint64_t *) allocator_Allocate(dictionary->allocator, table->byteSize);
+    table->retired = NULL;
+    return table;
+}
+
+ComponentDictionary *
+componentDictionary_Create(void)
+{
+    ComponentDictionary *dictionary = (ComponentDictionary *) malloc(sizeof(ComponentDictionary));
+    if (dictionary != NULL) {
+        PARCBuffer *seed = random_Bytes(parcBuffer_Allocate(sizeof(uint64_t)));
+        dictionary->hasher = wyhasher_Create(parcBuffer_GetUint64(seed));
+        parcBuffer_Release(&seed);
+
+        dictionary->allocator = allocator_GetDefault();
+        dictionary->table = _componentDictionary_CreateTable(dictionary, INITIAL_SLOTS);
+        memset(dictionary->chunks, 0, sizeof(dictionary->chunks));
+        dictionary->count = 0;
+        dictionary->arena = NULL;
+        pthread_mutex_init(&dictionary->lock, NULL);
+    }
+    return dictionary;
+}
+
+void
+componentDictionary_Destroy(ComponentDictionary **dictionaryP)
+{
+    ComponentDictionary *dictionary = *dictionaryP;
+
+    _SlotTable *table = dictionary->table;
+    while (table != NULL) {
+        _SlotTable *retired = table->retired;
+        allocator_Deallocate(dictionary->allocator, table->slots, table->byteSize);
+        free(table);
+        table = retired;
+    }
+    for (int k = 0; k < MAX_ENTRY_CHUNKS; k++) {
+        free(dictionary->chunks[k]);
+    }
+    while (dictionary->arena != NULL) {
+        _ArenaBlock *next = dictionary->arena->next;
+        free(dictionary->arena);
+        dictionary->arena = next;
+    }
+
+    wyhasher_Destroy(&dictionary->hasher);
+    pthread_mutex_destroy(&dictionary->lock);
+
+    free(dictionary);
+    *dictionaryP = NULL;
+}
+
+static void
+_componentDictionary_CreateShared(void)
+{
+    _sharedDictionary = componentDictionary_Create();
+}
+
+ComponentDictionary *
+componentDictionary_GetShared(void)
+{
+    pthread_once(&_sharedDictionaryOnce, _componentDictionary_CreateShared);
+    return _sharedDictionary;
+}
+
+static inline _Entry *
+_componentDictionary_GetEntry(ComponentDictionary *dictionary, uint32_t id)
+{
+    uint64_t index = (uint64_t) id - 1;
+    uint64_t chunk = (index >> ENTRY_CHUNK_BITS) + 1;
+    int k = 63 - __builtin_clzll(chunk);
+    return dictionary->chunks[k] + (index - (((uint64_t) 1 << (k + ENTRY_CHUNK_BITS)) - (1 << ENTRY_CHUNK_BITS)));
+}
+
+static uint32_t
+_componentDictionary_Probe(ComponentDictionary *dictionary, _SlotTable *table, uint64_t hash,
+                           size_t length, const uint8_t component[length])
+{
+    uint64_t tag = hash >> 32;
+    for (size_t i = hash & table->mask; ; i = (i + 1) & table->mask) {
+        // Acquiring the slot makes the entry it points to visible
+        uint64_t slot = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+        if (slot == 0) {
+            return ComponentDictionaryNoID;
+        }
+        if ((slot >> 32) == tag) {
+            uint32_t id = (uint32_t) slot;
+            _Entry *entry = _componentDictionary_GetEntry(dictionary, id);
+            if (entry->length == length && memcmp(entry->bytes, component, length) == 0) {
+                return id;
+            }
+        }
+    }
+}
+
+uint32_t
+componentDictionary_Find(ComponentDictionary *dictionary, size_t length, const uint8_t component[])
+{
+    uint64_t hash = wyhasher_Hash64(dictionary->hasher, length, component);
+    _SlotTable *table = __atomic_load_n(&dictionary->table, __ATOMIC_ACQUIRE);
+    return _componentDictionary_Probe(dictionary, table, hash, length, component);
+}
+
+static void
+_componentDictionary_Place(_SlotTable *table, uint64_t hash, uint32_t id)
+{
+    size_t i = hash & table->mask;
+    while (table->slots[i] != 0) {
+        i = (i + 1) & table->mask;
+    }
+    __atomic_store_n(&table->slots[i], ((hash >> 32) << 32) | id, __ATOMIC_RELEASE);
+}
+
+// Keep the table at most half full, publishing a rehashed copy twice the size when it would not be
+static void
+_componentDictionary_Reserve(ComponentDictionary *dictionary, size_t count)
+{
+    _SlotTable *table = dictionary->table;
+    if (count * 2 <= table->mask + 1) {
+        return;
+    }
+
+    _SlotTable *grown = _componentDictionary_CreateTable(dictionary, (table->mask + 1) * 2);
+    for (size_t id = 1; id <= dictionary->count; id++) {
+        _componentDictionary_Place(grown, _componentDictionary_GetEntry(dictionary, (uint32_t) id)->hash, (uint32_t) id);
+    }
+    grown->retired = table;
+    __atomic_store_n(&dictionary->table, grown, __ATOMIC_RELEASE);
+}
+
+static const uint8_t *
+_componentDictionary_Copy(ComponentDictionary *dictionary, size_t length, const uint8_t component[length])
+{
+    _ArenaBlock *block = dictionary->arena;
+    if (block == NULL || block->size - block->used < length) {
+        size_t size = length > ARENA_BLOCK_SIZE ? length : ARENA_BLOCK_SIZE;
+        block = (_ArenaBlock *) malloc(sizeof(_ArenaBlock) + size);
+        block->next = dictionary->arena;
+        block->used = 0;
+        block->size = size;
+        dictionary->arena = block;
+    }
+
+    uint8_t *bytes = block->bytes + block->used;
+    memcpy(bytes, component, length);
+    block->used += length;
+    return bytes;
+}
+
+uint32_t
+componentDictionary_Intern(ComponentDictionary *dictionary, size_t length, const uint8_t component[])
+{
+    uint64_t hash = wyhasher_Hash64(dictionary->hasher, length, component);
+    uint32_t id = _componentDictionary_Probe(dictionary, __atomic_load_n(&dictionary->table, __ATOMIC_ACQUIRE),
+                                             hash, length, component);
+    if (id != ComponentDictionaryNoID) {
+        return id;
+    }
+
+    pthread_mutex_lock(&dictionary->lock);
+
+    // Another thread may have interned it since the unlocked probe
+    id = _componentDictionary_Probe(dictionary, dictionary->table, hash, length, component);
+    if (id == ComponentDictionaryNoID && dictionary->count < UINT32_MAX) {
+        id = (uint32_t) (dictionary->count + 1);
+
+        uint64_t index = (uint64_t) id - 1;
+        int k = 63 - __builtin_clzll((index >> ENTRY_CHUNK_BITS) + 1);
+        if (dictionary->chunks[k] == NULL) {
+            dictionary->chunks[k] = (_Entry *) malloc(((size_t) 1 << (k + ENTRY_CHUNK_BITS)) * sizeof(_Entry));
+        }
+
+        _Entry *entry = _componentDictionary_GetEntry(dictionary, id);
+        entry->hash = hash;
+        entry->bytes = _componentDictionary_Copy(dictionary, length, component);
+        entry->length = length;
+
+        _componentDictionary_Reserve(dictionary, dictionary->count + 1);
+        _componentDictionary_Place(dictionary->table, hash, id);
+        __atomic_store_n(&dictionary->count, dictionary->count + 1, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&dictionary->lock);
+    return id;
+}
+
+const uint8_t *
+componentDictionary_GetComponent(ComponentDictionary *dictionary, uint32_t id, size_t *length)
+{
+    _Entry *entry = _componentDictionary_GetEntry(dictionary, id);
+    *length = entry->length;
+    return entry->bytes;
+}
+
+size_t
+componentDictionary_GetCount(ComponentDictionary *dictionary)
+{
+    return __atomic_load_n(&dictionary->count, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,46 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef component_dictionary_h_
+#define component_dictionary_h_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct component_dictionary;
+typedef struct component_dictionary ComponentDictionary;
+
+// The ID of no component: IDs handed out start at 1
+extern const uint32_t ComponentDictionaryNoID;
+
+// A dictionary from name component bytes to dense 32-bit IDs. IDs are never reused or taken back,
+// and the bytes of an interned component stay in place until the dictionary is destroyed.
+//
+// Lookups take no lock and may run concurrently with each other and with interning, which is
+// serialized by a mutex. A lookup racing the interning of the same component may miss it.
+ComponentDictionary *componentDictionary_Create(void);
+
+void componentDictionary_Destroy(ComponentDictionary **dictionaryP);
+
+// The dictionary shared across the library, created on first use and kept for the process lifetime
+ComponentDictionary *componentDictionary_GetShared(void);
+
+// The ID of the component, which is added if it is new. Returns ComponentDictionaryNoID once the
+// ID space is exhausted.
+uint32_t componentDictionary_Intern(ComponentDictionary *dictionary, size_t length, const uint8_t component[]);
+
+// The ID of the component, or ComponentDictionaryNoID if it was never interned
+uint32_t componentDictionary_Find(ComponentDictionary *dictionary, size_t length, const uint8_t component[]);
+
+// The bytes interned under id, whose length is stored in *length
+const uint8_t *componentDictionary_GetComponent(ComponentDictionary *dictionary, uint32_t id, size_t *length);
+
+size_t componentDictionary_GetCount(ComponentDictionary *dictionary);
+
+#endif // component_dictionary_h_
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,135 @@
+#include "crc32chasher.h"
+
+#include <string.h>
+
+// Reflected Castagnoli polynomial
+#define CRC32C_POLYNOMIAL 0x82F63B78
+
+struct crc32chasher {
+    uint32_t seed;
+    bool isHardwareAccelerated;
+};
+
+static uint32_t _crc32chasher_Table[256];
+static bool _crc32chasher_TableReady = false;
+
+static void
+_crc32chasher_InitializeTable()
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+        }
+        _crc32chasher_Table[i] = crc;
+    }
+    _crc32chasher_TableReady = true;
+}
+
+bool
+crc32chasher_IsHardwareAccelerated()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+CRC32CHasher *
+crc32chasher_Create(uint32_t seed)
+{
+    CRC32CHasher *hasher = (CRC32CHasher *) malloc(sizeof(CRC32CHasher));
+    if (hasher != NULL) {
+        hasher->seed = seed;
+        hasher->isHardwareAccelerated = crc32chasher_IsHardwareAccelerated();
+        if (!hasher->isHardwareAccelerated && !_crc32chasher_TableReady) {
+            _crc32chasher_InitializeTable();
+        }
+    }
+    return hasher;
+}
+
+void
+crc32chasher_Destroy(CRC32CHasher **hasherP)
+{
+    free(*hasherP);
+    *hasherP = NULL;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t
+_crc32chasher_UpdateHardware(uint32_t crc, size_t length, const uint8_t *p)
+{
+    uint64_t crc64 = crc;
+    for (; length >= sizeof(uint64_t); length -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        memcpy(&word, p, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+    crc = (uint32_t) crc64;
+    for (; length > 0; length--, p++) {
+        crc = __builtin_ia32_crc32qi(crc, *p);
+    }
+    return crc;
+}
+#endif
+
+static uint32_t
+_crc32chasher_UpdateSoftware(uint32_t crc, size_t length, const uint8_t *p)
+{
+    for (; length > 0; length--, p++) {
+        crc = _crc32chasher_Table[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t
+crc32chasher_Hash32(CRC32CHasher *hasher, size_t length, const uint8_t input[])
+{
+    uint32_t crc = ~hasher->seed;
+#if defined(__x86_64__)
+    if (hasher->isHardwareAccelerated) {
+        return ~_crc32chasher_UpdateHardware(crc, length, input);
+    }
+#endif
+    return ~_crc32chasher_UpdateSoftware(crc, length, input);
+}
+
+PARCBuffer *
+crc32chasher_HashArray(CRC32CHasher *hasher, size_t length, uint8_t input[])
+{
+    // Network byte order, to match parcBuffer_GetUint32
+    PARCBuffer *hashOutput = parcBuffer_Allocate(CRC32C_HASH_LENGTH);
+    parcBuffer_PutUint32(hashOutput, crc32chasher_Hash32(hasher, length, input));
+    return parcBuffer_Flip(hashOutput);
+}
+
+PARCBuffer *
+crc32chasher_Hash(CRC32CHasher *hasher, PARCBuffer *input)
+{
+    return crc32chasher_HashArray(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0));
+}
+
+Bitmap *
+crc32chasher_HashArrayToVector(CRC32CHasher *hasher, size_t length, uint8_t input[], int range)
+{
+    Bitmap *vector = bitmap_Create(range);
+    bitmap_Set(vector, crc32chasher_Hash32(hasher, length, input) % range);
+    return vector;
+}
+
+Bitmap *
+crc32chasher_HashToVector(CRC32CHasher *hasher, PARCBuffer *input, int range)
+{
+    return crc32chasher_HashArrayToVector(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0), range);
+}
+
+HasherInterface *CRC32CHashAsHasher = &(HasherInterface) {
+        .Hash = (PARCBuffer *(*)(void *, PARCBuffer *)) crc32chasher_Hash,
+        .HashArray = (PARCBuffer *(*)(void *hasher, size_t length, uint8_t *input)) crc32chasher_HashArray,
+        .HashToVector = (Bitmap *(*)(void*hasher, PARCBuffer *input, int range)) crc32chasher_HashToVector,
+        .HashArrayToVector = (Bitmap *(*)(void*hasher, size_t length, uint8_t *input, int range)) crc32chasher_HashArrayToVector,
+        .Destroy = (void (*)(void **instance)) crc32chasher_Destroy,
+};
@@ -0,0 +1,39 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_CRC32CHASHER_H
+#define FIB_PERF_CRC32CHASHER_H
+
+#include "hasher.h"
+
+#define CRC32C_HASH_LENGTH 4
+
+struct crc32chasher;
+typedef struct crc32chasher CRC32CHasher;
+
+extern HasherInterface *CRC32CHashAsHasher;
+
+// CRC32C (Castagnoli), using the SSE4.2 crc32 instruction when the CPU has it. The digest is
+// only 32 bits and linear in the input, so it suits table indexing in trusted fabrics only.
+CRC32CHasher *crc32chasher_Create(uint32_t seed);
+
+void crc32chasher_Destroy(CRC32CHasher **hasherP);
+
+bool crc32chasher_IsHardwareAccelerated();
+
+uint32_t crc32chasher_Hash32(CRC32CHasher *hasher, size_t length, const uint8_t input[]);
+
+PARCBuffer *crc32chasher_Hash(CRC32CHasher *hasher, PARCBuffer *input);
+
+PARCBuffer *crc32chasher_HashArray(CRC32CHasher *hasher, size_t length, uint8_t input[]);
+
+Bitmap *crc32chasher_HashToVector(CRC32CHasher *hasher, PARCBuffer *input, int range);
+
+Bitmap *crc32chasher_HashArrayToVector(CRC32CHasher *hasher, size_t length, uint8_t input[], int range);
+
+#endif //FIB_PERF_CRC32CHASHER_H
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,473 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <LongBow/runtime.h>
+
+#include "cuckoo_filter.h"
+#include "bloom.h"
+#include "allocator.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define CUCKOO_BUCKET_SIZE 4
+#define CUCKOO_MAX_KICKS 500
+
+const int CuckooFilterBucketSize = CUCKOO_BUCKET_SIZE;
+
+// Four-way buckets reach about 95% occupancy before insertions start to fail
+const double CuckooFilterMaxLoadFactor = 0.95;
+
+const int CuckooFilterMaxKicks = CUCKOO_MAX_KICKS;
+
+const int CuckooFilterMaxCopies = 2 * CUCKOO_BUCKET_SIZE;
+
+struct cuckoo_filter {
+    size_t numBuckets;
+    size_t numEntries;
+
+    // Entries this stage takes before the next stage is started
+    size_t capacity;
+
+    // Bucket i holds slots 4i to 4i + 3, and a zero fingerprint marks an empty slot.
+    // The payload of a slot, if any, is at the same index.
+    uint16_t *fingerprints;
+    uint16_t *payloads;
+    size_t byteSize;
+    Allocator *allocator;
+
+    // Picks the eviction victims
+    uint64_t randomState;
+
+    // The value hasher may be shared by many filters (and by all stages of one filter)
+    SipHasher *hasher;
+    bool ownsHasher;
+
+    struct cuckoo_filter *next;
+};
+
+static CuckooFilter *
+_cuckooFilter_CreateStage(size_t numBuckets, bool hasPayload, SipHasher *hasher)
+{
+    CuckooFilter *stage = (CuckooFilter *) malloc(sizeof(CuckooFilter));
+    if (stage != NULL) {
+        stage->numBuckets = numBuckets > 0 ? numBuckets : 1;
+        stage->numEntries = 0;
+        stage->capacity = (size_t) (stage->numBuckets * CUCKOO_BUCKET_SIZE * CuckooFilterMaxLoadFactor);
+        if (stage->capacity < 1) {
+            stage->capacity = 1;
+        }
+
+        size_t numSlots = stage->numBuckets * CUCKOO_BUCKET_SIZE;
+        stage->byteSize = numSlots * sizeof(uint16_t) * (hasPayload ? 2 : 1);
+        stage->allocator = allocator_GetDefault();
+        stage->fingerprints = (uint16_t *) allocator_Allocate(stage->allocator, stage->byteSize);
+        stage->payloads = hasPayload ? stage->fingerprints + numSlots : NULL;
+
+        stage->randomState = 0x9E3779B97F4A7C15ULL;
+        stage->hasher = hasher;
+        stage->ownsHasher = false;
+        stage->next = NULL;
+    }
+    return stage;
+}
+
+CuckooFilter *
+cuckooFilter_CreateWithHasher(size_t capacity, bool hasPayload, SipHasher *hasher)
+{
+    size_t numBuckets = (size_t) ((double) capacity / (CUCKOO_BUCKET_SIZE * CuckooFilterMaxLoadFactor)) + 1;
+    return _cuckooFilter_CreateStage(numBuckets, hasPayload, hasher);
+}
+
+CuckooFilter *
+cuckooFilter_Create(size_t capacity, bool hasPayload)
+{
+    CuckooFilter *filter = cuckooFilter_CreateWithHasher(capacity, hasPayload, bloom_CreateHasher());
+    if (filter != NULL) {
+        filter->ownsHasher = true;
+    }
+    return filter;
+}
+
+void
+cuckooFilter_Destroy(CuckooFilter **filterP)
+{
+    CuckooFilter *filter = *filterP;
+
+    if (filter->next != NULL) {
+        cuckooFilter_Destroy(&filter->next);
+    }
+    if (filter->ownsHasher) {
+        siphasher_Destroy(&filter->hasher);
+    }
+    allocator_Deallocate(filter->allocator, filter->fingerprints, filter->byteSize);
+
+    free(filter);
+    *filterP = NULL;
+}
+
+size_t
+cuckooFilter_GetCount(CuckooFilter *filter)
+{
+    size_t count = 0;
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        count += stage->numEntries;
+    }
+    return count;
+}
+
+double
+cuckooFilter_LoadFactor(CuckooFilter *filter)
+{
+    double numSlots = 0;
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        numSlots += stage->numBuckets * CUCKOO_BUCKET_SIZE;
+    }
+    return (double) cuckooFilter_GetCount(filter) / numSlots;
+}
+
+size_t
+cuckooFilter_GetSizeInBytes(CuckooFilter *filter)
+{
+    size_t size = 0;
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size += stage->byteSize;
+    }
+    return size;
+}
+
+static inline uint16_t
+_cuckooFilter_Fingerprint(uint64_t h2)
+{
+    // The low bit of h2 is forced odd, so the fingerprint comes from the top bits
+    uint16_t fingerprint = (uint16_t) (h2 >> 48);
+    return fingerprint != 0 ? fingerprint : 1;
+}
+
+// (h(f) - i) mod n is its own inverse for any n, so either bucket of a fingerprint leads to the
+// other without knowing the value, and the bucket count need not be a power of two.
+static inline size_t
+_cuckooFilter_AlternateIndex(CuckooFilter *stage, size_t index, uint16_t fingerprint)
+{
+    size_t offset = (size_t) ((fingerprint * 0xc6a4a7935bd1e995ULL) >> 17) % stage->numBuckets;
+    size_t alternate = offset + stage->numBuckets - index;
+    return alternate >= stage->numBuckets ? alternate - stage->numBuckets : alternate;
+}
+
+// Bit s is set if slot s of the two buckets (the first bucket's four slots, then the second's)
+// holds the fingerprint. Both buckets are compared at once.
+static inline unsigned
+_cuckooFilter_Match(const uint16_t *first, const uint16_t *second, uint16_t fingerprint)
+{
+#if defined(__SSE2__)
+    __m128i slots = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) first), _mm_loadl_epi64((const __m128i *) second));
+    __m128i equal = _mm_cmpeq_epi16(slots, _mm_set1_epi16((short) fingerprint));
+    return (unsigned) _mm_movemask_epi8(_mm_packs_epi16(equal, _mm_setzero_si128()));
+#else
+    const uint64_t low = 0x7FFF7FFF7FFF7FFFULL;
+    uint64_t pattern = fingerprint * 0x0001000100010001ULL;
+    unsigned mask = 0;
+    const uint16_t *buckets[2] = { first, second };
+    for (int b = 0; b < 2; b++) {
+        uint64_t word = 0;
+        memcpy(&word, buckets[b], sizeof(word));
+        uint64_t difference = word ^ pattern;
+
+        // The top bit of each all-zero lane, without borrows between lanes
+        uint64_t zero = ~(((difference & low) + low) | difference | low);
+        for (int s = 0; s < CUCKOO_BUCKET_SIZE; s++) {
+            mask |= (unsigned) ((zero >> (16 * s + 15)) & 1) << (b * CUCKOO_BUCKET_SIZE + s);
+        }
+    }
+    return mask;
+#endif
+}
+
+static inline size_t
+_cuckooFilter_MatchSlot(size_t first, size_t second, int s)
+{
+    return s < CUCKOO_BUCKET_SIZE ? first * CUCKOO_BUCKET_SIZE + s : second * CUCKOO_BUCKET_SIZE + s - CUCKOO_BUCKET_SIZE;
+}
+
+static uint64_t
+_cuckooFilter_NextRandom(CuckooFilter *stage)
+{
+    // xorshift64
+    uint64_t x = stage->randomState;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    stage->randomState = x;
+    return x;
+}
+
+static bool
+_cuckooFilter_PlaceInBucket(CuckooFilter *stage, size_t index, uint16_t fingerprint, uint16_t payload)
+{
+    uint16_t *bucket = stage->fingerprints + index * CUCKOO_BUCKET_SIZE;
+    for (int s = 0; s < CUCKOO_BUCKET_SIZE; s++) {
+        if (bucket[s] == 0) {
+            bucket[s] = fingerprint;
+            if (stage->payloads != NULL) {
+                stage->payloads[index * CUCKOO_BUCKET_SIZE + s] = payload;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+_cuckooFilter_SwapSlot(CuckooFilter *stage, size_t slot, uint16_t *fingerprint, uint16_t *payload)
+{
+    uint16_t resident = stage->fingerprints[slot];
+    stage->fingerprints[slot] = *fingerprint;
+    *fingerprint = resident;
+
+    if (stage->payloads != NULL) {
+        resident = stage->payloads[slot];
+        stage->payloads[slot] = *payload;
+        *payload = resident;
+    }
+}
+
+static bool
+_cuckooFilter_InsertStage(CuckooFilter *stage, uint64_t h1, uint16_t fingerprint, uint16_t payload)
+{
+    size_t first = h1 % stage->numBuckets;
+    size_t second = _cuckooFilter_AlternateIndex(stage, first, fingerprint);
+    if (_cuckooFilter_PlaceInBucket(stage, first, fingerprint, payload) ||
+        _cuckooFilter_PlaceInBucket(stage, second, fingerprint, payload)) {
+        stage->numEntries++;
+        return true;
+    }
+
+    // Both buckets are full, so evict residents to their other buckets. The path is recorded
+    // so that a failed insertion leaves the stage as it was.
+    size_t path[CUCKOO_MAX_KICKS];
+    size_t index = (_cuckooFilter_NextRandom(stage) & 1) ? first : second;
+    for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+        path[kick] = index * CUCKOO_BUCKET_SIZE + _cuckooFilter_NextRandom(stage) % CUCKOO_BUCKET_SIZE;
+        _cuckooFilter_SwapSlot(stage, path[kick], &fingerprint, &payload);
+
+        index = _cuckooFilter_AlternateIndex(stage, index, fingerprint);
+        if (_cuckooFilter_PlaceInBucket(stage, index, fingerprint, payload)) {
+            stage->numEntries++;
+            return true;
+        }
+    }
+
+    for (int kick = CUCKOO_MAX_KICKS - 1; kick >= 0; kick--) {
+        _cuckooFilter_SwapSlot(stage, path[kick], &fingerprint, &payload);
+    }
+    return false;
+}
+
+// The slots of every stage holding the fingerprint, and the payload if matchPayload
+static int
+_cuckooFilter_CountCopies(CuckooFilter *filter, uint64_t h1, uint16_t fingerprint, bool matchPayload, uint16_t payload)
+{
+    int count = 0;
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size_t first = h1 % stage->numBuckets;
+        size_t second = _cuckooFilter_AlternateIndex(stage, first, fingerprint);
+        unsigned mask = _cuckooFilter_Match(stage->fingerprints + first * CUCKOO_BUCKET_SIZE,
+                                            stage->fingerprints + second * CUCKOO_BUCKET_SIZE, fingerprint);
+        for (; mask != 0; mask &= mask - 1) {
+            if (!matchPayload || stage->payloads[_cuckooFilter_MatchSlot(first, second, __builtin_ctz(mask))] == payload) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static void
+_cuckooFilter_Insert(CuckooFilter *filter, uint64_t h1, uint64_t h2, bool hasPayload, uint16_t payload)
+{
+    uint16_t fingerprint = _cuckooFilter_Fingerprint(h2);
+
+    // One value fills its two buckets after 2b copies, and no further copy may grow the filter
+    int numCopies = _cuckooFilter_CountCopies(filter, h1, fingerprint, hasPayload, payload);
+    if (numCopies >= CuckooFilterMaxCopies) {
+        return;
+    }
+
+    CuckooFilter *stage = filter;
+    while (stage->next != NULL) {
+        stage = stage->next;
+    }
+
+    // Stages borrow the first stage's hasher, so a value is hashed once for the whole chain
+    if (stage->numEntries >= stage->capacity || !_cuckooFilter_InsertStage(stage, h1, fingerprint, payload)) {
+        if (numCopies > 0) {
+            return;
+        }
+        stage->next = _cuckooFilter_CreateStage(stage->numBuckets * BloomGrowthFactor, stage->payloads != NULL, stage->hasher);
+        stage = stage->next;
+
+        bool isInserted = _cuckooFilter_InsertStage(stage, h1, fingerprint, payload);
+        assertTrue(isInserted, "Expected an empty stage to take the value");
+    }
+}
+
+static bool
+_cuckooFilter_Delete(CuckooFilter *filter, uint64_t h1, uint64_t h2, bool matchPayload, uint16_t payload)
+{
+    uint16_t fingerprint = _cuckooFilter_Fingerprint(h2);
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size_t first = h1 % stage->numBuckets;
+        size_t second = _cuckooFilter_AlternateIndex(stage, first, fingerprint);
+        unsigned mask = _cuckooFilter_Match(stage->fingerprints + first * CUCKOO_BUCKET_SIZE,
+                                            stage->fingerprints + second * CUCKOO_BUCKET_SIZE, fingerprint);
+        for (; mask != 0; mask &= mask - 1) {
+            size_t slot = _cuckooFilter_MatchSlot(first, second, __builtin_ctz(mask));
+            if (!matchPayload || stage->payloads[slot] == payload) {
+                stage->fingerprints[slot] = 0;
+                stage->numEntries--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void
+cuckooFilter_AddHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2)
+{
+    _cuckooFilter_Insert(filter, h1, h2, false, 0);
+}
+
+bool
+cuckooFilter_TestHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2)
+{
+    uint16_t fingerprint = _cuckooFilter_Fingerprint(h2);
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size_t first = h1 % stage->numBuckets;
+        size_t second = _cuckooFilter_AlternateIndex(stage, first, fingerprint);
+        if (_cuckooFilter_Match(stage->fingerprints + first * CUCKOO_BUCKET_SIZE,
+                                stage->fingerprints + second * CUCKOO_BUCKET_SIZE, fingerprint) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+cuckooFilter_RemoveHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2)
+{
+    return _cuckooFilter_Delete(filter, h1, h2, false, 0);
+}
+
+void
+cuckooFilter_AddHashPairWithPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2, uint16_t payload)
+{
+    assertNotNull(filter->payloads, "Expected a filter created with payloads");
+    _cuckooFilter_Insert(filter, h1, h2, true, payload);
+}
+
+bool
+cuckooFilter_RemoveHashPairWithPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2, uint16_t payload)
+{
+    assertNotNull(filter->payloads, "Expected a filter created with payloads");
+    return _cuckooFilter_Delete(filter, h1, h2, true, payload);
+}
+
+int
+cuckooFilter_ForEachPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2,
+                            void (*visit)(void *context, uint16_t payload), void *context)
+{
+    assertNotNull(filter->payloads, "Expected a filter created with payloads");
+
+    int count = 0;
+    uint16_t fingerprint = _cuckooFilter_Fingerprint(h2);
+    for (CuckooFilter *stage = filter; stage != NULL; stage = stage->next) {
+        size_t first = h1 % stage->numBuckets;
+        size_t second = _cuckooFilter_AlternateIndex(stage, first, fingerprint);
+        unsigned mask = _cuckooFilter_Match(stage->fingerprints + first * CUCKOO_BUCKET_SIZE,
+                                            stage->fingerprints + second * CUCKOO_BUCKET_SIZE, fingerprint);
+        for (; mask != 0; mask &= mask - 1) {
+            visit(context, stage->payloads[_cuckooFilter_MatchSlot(first, second, __builtin_ctz(mask))]);
+            count++;
+        }
+    }
+    return count;
+}
+
+static void
+_cuckooFilter_HashValue(CuckooFilter *filter, PARCBuffer *value, uint64_t *h1, uint64_t *h2)
+{
+    uint8_t digest[SIPHASH_HASH_LENGTH];
+    siphasher_Digest(filter->hasher, parcBuffer_Remaining(value), parcBuffer_Overlay(value, 0), digest);
+    bloom_DigestToHashPair(SIPHASH_HASH_LENGTH, digest, h1, h2);
+}
+
+static void
+_cuckooFilter_DigestValue(PARCBuffer *value, uint64_t *h1, uint64_t *h2)
+{
+    size_t inputSize = parcBuffer_Remaining(value);
+    assertTrue(inputSize > 0, "Invalid cuckoo filter hash input -- expected a non-empty digest");
+    bloom_DigestToHashPair(inputSize, parcBuffer_Overlay(value, 0), h1, h2);
+}
+
+void
+cuckooFilter_HashSalted(CuckooFilter *filter, uint32_t salt, PARCBuffer *value, uint64_t *h1, uint64_t *h2)
+{
+    _cuckooFilter_HashValue(filter, value, h1, h2);
+    bloom_SaltHashPair(salt, h1, h2);
+}
+
+void
+cuckooFilter_Add(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_HashValue(filter, value, &h1, &h2);
+    cuckooFilter_AddHashPair(filter, h1, h2);
+}
+
+bool
+cuckooFilter_Test(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_HashValue(filter, value, &h1, &h2);
+    return cuckooFilter_TestHashPair(filter, h1, h2);
+}
+
+bool
+cuckooFilter_Remove(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_HashValue(filter, value, &h1, &h2);
+    return cuckooFilter_RemoveHashPair(filter, h1, h2);
+}
+
+void
+cuckooFilter_AddHashed(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_DigestValue(value, &h1, &h2);
+    cuckooFilter_AddHashPair(filter, h1, h2);
+}
+
+bool
+cuckooFilter_TestHashed(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_DigestValue(value, &h1, &h2);
+    return cuckooFilter_TestHashPair(filter, h1, h2);
+}
+
+bool
+cuckooFilter_RemoveHashed(CuckooFilter *filter, PARCBuffer *value)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _cuckooFilter_DigestValue(value, &h1, &h2);
+    return cuckooFilter_RemoveHashPair(filter, h1, h2);
+}
@@ -0,0 +1,101 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef cuckoo_filter_h_
+#define cuckoo_filter_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <parc/algol/parc_Buffer.h>
+
+#include "siphasher.h"
+
+// The membership filter a filter-based structure is built on
+typedef enum {
+    FilterType_Bloom,
+    FilterType_Cuckoo
+} FilterType;
+
+struct cuckoo_filter;
+typedef struct cuckoo_filter CuckooFilter;
+
+// Fingerprint slots per bucket
+extern const int CuckooFilterBucketSize;
+
+// Fraction of the slots a stage fills before insertions go to a new, larger stage
+extern const double CuckooFilterMaxLoadFactor;
+
+// Evictions tried before an insertion gives up on a stage
+extern const int CuckooFilterMaxKicks;
+
+// Copies of one value, or of one (value, payload) pair, that a filter stores
+extern const int CuckooFilterMaxCopies;
+
+// A cuckoo filter (Fan et al., "Cuckoo Filter: Practically Better Than Bloom") of 16-bit
+// fingerprints in buckets of four. A value may live in one of two buckets, which a lookup
+// compares at once, so each stage has a false positive rate of about 8 / 2^16 (1.2e-4) at
+// about 17 bits per entry, where a Bloom filter needs 19. Unlike a Bloom filter, values can be
+// removed, and each fingerprint can carry a 16-bit payload, e.g., a next-hop port.
+//
+// Values are counted: adding one twice stores it twice, and removing a value that was never
+// added may remove another value with the same fingerprint. A stage that cannot place a value
+// grows the filter by a stage with twice the buckets, and lookups check every stage. Repeats
+// never grow the filter: once a value is stored, a copy that does not fit the last stage, or any
+// copy past CuckooFilterMaxCopies, is dropped, and fewer removes take the value out.
+CuckooFilter *cuckooFilter_Create(size_t capacity, bool hasPayload);
+
+// Create a filter that borrows a (possibly shared) value hasher. The hasher must outlive the filter.
+CuckooFilter *cuckooFilter_CreateWithHasher(size_t capacity, bool hasPayload, SipHasher *hasher);
+
+void cuckooFilter_Destroy(CuckooFilter **filterP);
+
+// Number of values stored in every stage
+size_t cuckooFilter_GetCount(CuckooFilter *filter);
+
+// Fraction of the slots of every stage in use
+double cuckooFilter_LoadFactor(CuckooFilter *filter);
+
+// Bytes of fingerprint and payload slots in every stage
+size_t cuckooFilter_GetSizeInBytes(CuckooFilter *filter);
+
+void cuckooFilter_Add(CuckooFilter *filter, PARCBuffer *value);
+
+bool cuckooFilter_Test(CuckooFilter *filter, PARCBuffer *value);
+
+bool cuckooFilter_Remove(CuckooFilter *filter, PARCBuffer *value);
+
+// As above, for values that are already digests
+void cuckooFilter_AddHashed(CuckooFilter *filter, PARCBuffer *value);
+
+bool cuckooFilter_TestHashed(CuckooFilter *filter, PARCBuffer *value);
+
+bool cuckooFilter_RemoveHashed(CuckooFilter *filter, PARCBuffer *value);
+
+// The pair bloom_HashSalted would compute with the same hasher, so that one key space can be
+// tested with either filter and the pair reused, e.g., as an exact-match key
+void cuckooFilter_HashSalted(CuckooFilter *filter, uint32_t salt, PARCBuffer *value, uint64_t *h1, uint64_t *h2);
+
+// h1 selects the first bucket and h2 the fingerprint
+void cuckooFilter_AddHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2);
+
+bool cuckooFilter_TestHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2);
+
+bool cuckooFilter_RemoveHashPair(CuckooFilter *filter, uint64_t h1, uint64_t h2);
+
+// Store the fingerprint with a payload. The filter must have been created with hasPayload.
+void cuckooFilter_AddHashPairWithPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2, uint16_t payload);
+
+// Remove one copy of the fingerprint stored with this payload
+bool cuckooFilter_RemoveHashPairWithPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2, uint16_t payload);
+
+// Call visit with the payload of every slot holding the fingerprint, and return the number of slots
+int cuckooFilter_ForEachPayload(CuckooFilter *filter, uint64_t h1, uint64_t h2,
+                                void (*visit)(void *context, uint16_t payload), void *context);
+
+#endif // cuckoo_filter_h_
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <getopt.h>
+#include <inttypes.h>
 
 #include <parc/algol/parc_SafeMemory.h>
 #include <parc/algol/parc_BufferComposer.h>
@@ -12,15 +13,22 @@
 #include "fib_caesar.h"
 #include "fib_caesar_filter.h"
 #include "fib_merged_filter.h"
-#include "sha256hasher.h"
+#include "hasher.h"
 #include "timer.h"
 #include "bitmap.h"
 #include "fib_patricia.h"
 #include "fib_tbf.h"
+#include "fib_static.h"
+#include "fib_cached.h"
+#include "allocator.h"
+#include "hugepage_allocator.h"
+#include "numa_allocator.h"
+#include "parallel.h"
 
 #define DEFAULT_NUM_PORTS 256
 #define DEFAULT_NUM_FILTERS 2 // from Caesar paper
 #define DEFAULT_FILTER_SIZE 128
+#define DEFAULT_CISCO_M 3
 
 typedef struct timed_result {
     long time;
@@ -78,24 +86,178 @@ void usage() {
     fprintf(stderr, "   - test_file = A file that contains names to pump through and test the FIB\n");
     fprintf(stderr, "   - filters   = The number of filters to use for BF-based FIBs\n");
     fprintf(stderr, "   - n         = The maximum length prefix to use when inserting names into the FIB\n");
-    fprintf(stderr, "   - alg       = The FIB data structure to use: ['naive', 'cisco', 'caesar', 'caesar-filter', 'merged-bf']\n");
+    fprintf(stderr, "   - alg       = The FIB data structure to use: ['naive', 'cisco', 'caesar', 'caesar-filter', 'merged-filter', 'patricia', 'tbf', 'static']\n");
     fprintf(stderr, "   - ports     = The number of ports supported\n");
-    fprintf(stderr, "   - digest    = A flag to indicate that names should be hashed. Currently, SHA256 is used.\n");
+    fprintf(stderr, "   - digest    = Hash names into digests of this many bytes, using the hash function below (SHA256 by default)\n");
+    fprintf(stderr, "   - hash      = The hash function for name digests: ['sha256', 'siphash', 'siphash13', 'xxhash', 'wyhash', 'crc32c']\n");
+    fprintf(stderr, "   - target_fpr = Size BF-based FIBs for this false positive rate from the load file entry count (overrides filters and filter_size)\n");
+    fprintf(stderr, "   - filter    = The membership filter of the caesar-filter and tbf FIBs sized by target_fpr: ['bloom', 'cuckoo']\n");
+    fprintf(stderr, "   - allocator = The backing store for filters, maps and tries: ['system', 'hugepage', 'numa:<node>', 'numa-hugepage:<node>']\n");
+    fprintf(stderr, "   - cisco_m   = The M used by the cisco FIB, or 'auto' to pick it from the loaded prefix and test name lengths\n");
+    fprintf(stderr, "   - length_filter = A flag to prune the prefix lengths probed by the naive and cisco FIBs with per-length BFs (sized like the other BFs)\n");
+    fprintf(stderr, "   - intern    = A flag to key the naive FIB's tables on component IDs from the shared component dictionary\n");
+    fprintf(stderr, "   - frozen    = A flag to freeze the naive and cisco FIBs into minimal perfect hash tables once loaded\n");
+    fprintf(stderr, "   - multi_length = A flag to probe all prefix lengths up to 16 at once in the static FIB, and in the naive FIB when frozen\n");
+    fprintf(stderr, "   - threads   = Hash and bulk-load the whole load file with this many threads ('auto' for one per CPU) instead of inserting names one at a time\n");
+    fprintf(stderr, "   - cache     = Put an LPM result cache of this many entries in front of the FIB (not caesar-filter or merged-filter, whose lookups return new vectors)\n");
 }
 
 typedef struct {
     char *loadFile;
     char *testFile;
+    char *algorithm;
     FIB *fib;
+    FIBCisco *ciscoFIB;
+    FIBNaive *naiveFIB;
+    FIBCaesar *caesarFIB;
+    FIBStatic *staticFIB;
+    FIBCached *cachedFIB;
+    int ciscoM;
+    Allocator *allocator;
     Hasher *hasher;
+    char *hashName;
     int hashSize;
     int numPorts;
     int numFilters;
     int filterSize;
     int trieDepth;
+    double targetFPR;
+    FilterType filterType;
     uint32_t maxNameLength;
+    bool lengthFilter;
+    bool frozen;
+    bool intern;
+    bool multiLength;
+
+    // Zero inserts names one at a time
+    int numThreads;
+
+    // Zero disables the LPM result cache
+    size_t cacheEntries;
 } FIBOptions;
 
+static Name *_readNextNameFromFile(FILE *file);
+
+static Allocator *
+_createAllocator(char *backend)
+{
+    int node = 0;
+    if (strcmp(backend, "system") == 0) {
+        return NULL;
+    } else if (strcmp(backend, "hugepage") == 0) {
+        HugePageAllocator *allocator = hugePageAllocator_Create(HugePageAllocatorDefaultMinimumSize);
+        return allocator_Create(allocator, HugePageAsAllocator);
+    } else if (sscanf(backend, "numa-hugepage:%d", &node) == 1) {
+        NUMAAllocator *allocator = numaAllocator_Create(node, true);
+        return allocator_Create(allocator, NUMAAsAllocator);
+    } else if (sscanf(backend, "numa:%d", &node) == 1 || strcmp(backend, "numa") == 0) {
+        NUMAAllocator *allocator = numaAllocator_Create(node, false);
+        return allocator_Create(allocator, NUMAAsAllocator);
+    }
+
+    fprintf(stderr, "Invalid allocator specified: %s\n", backend);
+    usage();
+    exit(EXIT_FAILURE);
+}
+
+static int
+_countNamesInFile(char *fileName)
+{
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL) {
+        perror("Could not open load file");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    int count = 0;
+    Name *name = NULL;
+    while ((name = _readNextNameFromFile(file)) != NULL) {
+        count++;
+        name_Destroy(&name);
+    }
+    fclose(file);
+
+    return count;
+}
+
+static PrefixLengthFilter *
+_createLengthFilter(FIBOptions *options)
+{
+    if (options->targetFPR > 0) {
+        return prefixLengthFilter_CreateOptimal(options->targetFPR);
+    }
+    return prefixLengthFilter_Create(options->filterSize, options->numFilters);
+}
+
+static FIB *
+_createFIB(FIBOptions *options)
+{
+    char *alg = options->algorithm;
+    bool optimal = options->targetFPR > 0;
+    int expectedEntries = 0;
+    if (optimal) {
+        expectedEntries = _countNamesInFile(options->loadFile);
+        expectedEntries = expectedEntries > 0 ? expectedEntries : 1;
+    }
+
+    FIB *fib = NULL;
+    if (strcmp(alg, "cisco") == 0) {
+        // An automatic M is chosen once the FIB is loaded; start from the default
+        options->ciscoFIB = fibCisco_Create(options->ciscoM > 0 ? options->ciscoM : DEFAULT_CISCO_M);
+        if (options->lengthFilter) {
+            fibCisco_SetLengthFilter(options->ciscoFIB, _createLengthFilter(options));
+        }
+        fib = fib_Create(options->ciscoFIB, CiscoFIBAsFIB);
+    } else if (strcmp(alg, "naive") == 0) {
+        options->naiveFIB = fibNative_Create();
+        if (options->lengthFilter) {
+            fibNaive_SetLengthFilter(options->naiveFIB, _createLengthFilter(options));
+        }
+        if (options->intern) {
+            fibNaive_SetDictionary(options->naiveFIB, componentDictionary_GetShared());
+        }
+        if (options->multiLength) {
+            fibNaive_SetMultiLength(options->naiveFIB);
+        }
+        fib = fib_Create(options->naiveFIB, NativeFIBAsFIB);
+    } else if (strcmp(alg, "caesar") == 0) {
+        FIBCaesar *caesarFIB = optimal ?
+            fibCaesar_CreateOptimal(expectedEntries, options->targetFPR) :
+            fibCaesar_Create(options->filterSize, options->filterSize, options->numFilters);
+        options->caesarFIB = caesarFIB;
+        fib = fib_Create(caesarFIB, CaesarFIBAsFIB);
+    } else if (strcmp(alg, "caesar-filter") == 0) {
+        FIBCaesarFilter *filterFIB = optimal ?
+            fibCaesarFilter_CreateOptimalWithFilter(options->numPorts, expectedEntries, options->targetFPR, options->filterType) :
+            fibCaesarFilter_Create(options->numPorts, options->filterSize, options->filterSize, options->numFilters);
+        fib = fib_Create(filterFIB, CaesarFilterFIBAsFIB);
+    } else if (strcmp(alg, "merged-filter") == 0) {
+        FIBMergedFilter *filterFIB = optimal ?
+            fibMergedFilter_CreateOptimal(options->numPorts, expectedEntries, options->targetFPR) :
+            fibMergedFilter_Create(options->numPorts, options->filterSize, options->numFilters);
+        fib = fib_Create(filterFIB, MergedFilterFIBAsFIB);
+    } else if (strcmp(alg, "patricia") == 0) {
+        FIBPatricia *patriciaFIB = fibPatricia_Create();
+        fib = fib_Create(patriciaFIB, PatriciaFIBAsFIB);
+    } else if (strcmp(alg, "tbf") == 0) {
+        FIBTBF *tbf = optimal ?
+            fibTBF_CreateOptimalWithFilter(options->trieDepth, options->targetFPR, options->filterType) :
+            fibTBF_Create(options->trieDepth, options->filterSize, options->numFilters);
+        fib = fib_Create(tbf, TBFAsFIB);
+    } else if (strcmp(alg, "static") == 0) {
+        options->staticFIB = fibStatic_Create();
+        fibStatic_SetMultiLength(options->staticFIB, options->multiLength);
+        fib = fib_Create(options->staticFIB, StaticFIBAsFIB);
+    } else {
+        perror("Invalid algorithm specified\n");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    return fib;
+}
+
 FIBOptions *
 parseCommandLineOptions(int argc, char **argv)
 {
@@ -109,6 +271,17 @@ parseCommandLineOptions(int argc, char **argv)
             { "filter_size", required_argument,  NULL, 's' },
             { "num_ports",   required_argument,  NULL, 'p'},
             { "digest",      required_argument,  NULL, 'd'},
+            { "hash",        required_argument,  NULL, 'H'},
+            { "target_fpr",  required_argument,  NULL, 'r'},
+            { "filter",      required_argument,  NULL, 'F'},
+            { "allocator",   required_argument,  NULL, 'm'},
+            { "cisco_m",     required_argument,  NULL, 'c'},
+            { "length_filter", no_argument,      NULL, 'b'},
+            { "threads",     required_argument,  NULL, 'j'},
+            { "frozen",      no_argument,        NULL, 'z'},
+            { "cache",       required_argument,  NULL, 'C'},
+            { "intern",      no_argument,        NULL, 'I'},
+            { "multi_length", no_argument,       NULL, 'M'},
             { "help",        no_argument,        NULL, 'h'},
             { NULL,0,NULL,0}
     };
@@ -121,18 +294,35 @@ parseCommandLineOptions(int argc, char **argv)
     FIBOptions *options = malloc(sizeof(FIBOptions));
     options->loadFile = NULL;
     options->testFile = NULL;
+    options->algorithm = NULL;
     options->fib = NULL;
+    options->ciscoFIB = NULL;
+    options->naiveFIB = NULL;
+    options->caesarFIB = NULL;
+    options->staticFIB = NULL;
+    options->cachedFIB = NULL;
+    options->ciscoM = DEFAULT_CISCO_M;
+    options->allocator = NULL;
     options->maxNameLength = 0;
     options->hashSize = 0;
+    options->hashName = NULL;
     options->hasher = NULL;
     options->numPorts = DEFAULT_NUM_PORTS;
     options->numFilters = DEFAULT_NUM_FILTERS;
     options->filterSize = DEFAULT_FILTER_SIZE;
     options->trieDepth = 2;
+    options->targetFPR = 0.0;
+    options->filterType = FilterType_Bloom;
+    options->lengthFilter = false;
+    options->numThreads = 0;
+    options->frozen = false;
+    options->intern = false;
+    options->multiLength = false;
+    options->cacheEntries = 0;
 
     int c;
     while (optind < argc) {
-        if ((c = getopt_long(argc, argv, "hl:t:n:a:d:p:f:x:s:", longopts, NULL)) != -1) {
+        if ((c = getopt_long(argc, argv, "hbzIMl:t:n:a:d:H:p:f:x:s:r:F:m:c:j:C:", longopts, NULL)) != -1) {
             switch(c) {
                 case 'l':
                     options->loadFile = malloc(strlen(optarg) + 1);
@@ -154,46 +344,59 @@ parseCommandLineOptions(int argc, char **argv)
                 case 'n':
                     sscanf(optarg, "%u", &(options->maxNameLength));
                     break;
-                case 'a': {
-                    FIB *fib = NULL;
-                    if (strcmp(optarg, "cisco") == 0) {
-                        FIBCisco *ciscoFIB = fibCisco_Create(3);
-                        fib = fib_Create(ciscoFIB, CiscoFIBAsFIB);
-                    } else if (strcmp(optarg, "naive") == 0) {
-                        FIBNaive *nativeFIB = fibNative_Create();
-                        fib = fib_Create(nativeFIB, NativeFIBAsFIB);
-                    } else if (strcmp(optarg, "caesar") == 0) {
-                        FIBCaesar *caesarFIB = fibCaesar_Create(options->filterSize, options->filterSize, options->numFilters);
-                        fib = fib_Create(caesarFIB, CaesarFIBAsFIB);
-                    } else if (strcmp(optarg, "caesar-filter") == 0) {
-                        FIBCaesarFilter *filterFIB = fibCaesarFilter_Create(options->numPorts, options->filterSize, options->filterSize, options->numFilters);
-                        fib = fib_Create(filterFIB, CaesarFilterFIBAsFIB);
-                    } else if (strcmp(optarg, "merged-filter") == 0) {
-                        FIBMergedFilter *filterFIB = fibMergedFilter_Create(options->numPorts, options->filterSize, options->numFilters);
-                        fib = fib_Create(filterFIB, MergedFilterFIBAsFIB);
-                    } else if (strcmp(optarg, "patricia") == 0) {
-                        FIBPatricia *patriciaFIB = fibPatricia_Create();
-                        fib = fib_Create(patriciaFIB, PatriciaFIBAsFIB);
-                    } else if (strcmp(optarg, "tbf") == 0) {
-                        FIBTBF *tbf = fibTBF_Create(options->trieDepth, options->filterSize, options->numFilters);
-                        fib = fib_Create(tbf, TBFAsFIB);
-                    } else {
-                        perror("Invalid algorithm specified\n");
+                case 'a':
+                    options->algorithm = malloc(strlen(optarg) + 1);
+                    strcpy(options->algorithm, optarg);
+                    break;
+                case 'r':
+                    sscanf(optarg, "%lf", &(options->targetFPR));
+                    break;
+                case 'F':
+                    if (strcmp(optarg, "cuckoo") == 0) {
+                        options->filterType = FilterType_Cuckoo;
+                    } else if (strcmp(optarg, "bloom") != 0) {
+                        fprintf(stderr, "Invalid filter specified: %s\n", optarg);
                         usage();
                         exit(EXIT_FAILURE);
                     }
-                    options->fib = fib;
                     break;
-                }
+                case 'm':
+                    options->allocator = _createAllocator(optarg);
+                    allocator_SetDefault(options->allocator);
+                    break;
+                case 'c':
+                    // Zero selects M automatically
+                    options->ciscoM = strcmp(optarg, "auto") == 0 ? 0 : atoi(optarg);
+                    break;
+                case 'b':
+                    options->lengthFilter = true;
+                    break;
+                case 'z':
+                    options->frozen = true;
+                    break;
+                case 'I':
+                    options->intern = true;
+                    break;
+                case 'M':
+                    options->multiLength = true;
+                    break;
+                case 'C':
+                    sscanf(optarg, "%zu", &(options->cacheEntries));
+                    break;
+                case 'j':
+                    options->numThreads = strcmp(optarg, "auto") == 0 ? parallel_GetDefaultThreads() : atoi(optarg);
+                    break;
                 case 'p': {
                     options->numPorts = atoi(optarg);
+                    break;
                 }
-                case 'd': {
-                    SHA256Hasher *hasher = sha256hasher_Create();
-                    options->hasher = hasher_Create(hasher, SHA256HashAsHasher);
+                case 'd':
                     options->hashSize = atoi(optarg);
                     break;
-                }
+                case 'H':
+                    options->hashName = malloc(strlen(optarg) + 1);
+                    strcpy(options->hashName, optarg);
+                    break;
                 case 'h':
                     usage();
                     exit(EXIT_SUCCESS);
@@ -203,6 +406,35 @@ parseCommandLineOptions(int argc, char **argv)
         }
     }
 
+    // Either option turns on name digests; the digest size defaults to the full hash output
+    if (options->hashSize > 0 || options->hashName != NULL) {
+        options->hasher = hasher_CreateNamed(options->hashName != NULL ? options->hashName : "sha256");
+        if (options->hasher == NULL) {
+            fprintf(stderr, "Invalid hash function specified: %s\n", options->hashName);
+            usage();
+            exit(EXIT_FAILURE);
+        }
+        if (options->hashSize <= 0) {
+            options->hashSize = (int) hasher_GetDigestLength(options->hasher);
+        }
+    }
+
+    // Create the FIB once all options are known, since the filter sizes depend on them
+    if (options->algorithm == NULL || options->loadFile == NULL) {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+    options->fib = _createFIB(options);
+    if (options->cacheEntries > 0) {
+        options->cachedFIB = fibCached_Create(options->fib, options->cacheEntries);
+        if (options->cachedFIB == NULL) {
+            fprintf(stderr, "The %s FIB returns a new vector per lookup, which cannot be cached\n", options->algorithm);
+            usage();
+            exit(EXIT_FAILURE);
+        }
+        options->fib = fib_Create(options->cachedFIB, CachedFIBAsFIB);
+    }
+
     return options;
 }
 
@@ -226,6 +458,69 @@ _readNextNameFromFile(FILE *file)
     return name;
 }
 
+typedef struct {
+    FIBOptions *options;
+    Name **names;
+} _BulkHashContext;
+
+static void
+_hashLoadedName(void *context, size_t index)
+{
+    _BulkHashContext *bulk = (_BulkHashContext *) context;
+    Name *newName = name_Hash(bulk->names[index], bulk->options->hasher, bulk->options->hashSize);
+    name_Destroy(&bulk->names[index]);
+    bulk->names[index] = newName;
+}
+
+// Read the whole load file, then hash and insert it in one parallel bulk load. Each name is
+// charged its share of the total time, so the insert statistics stay per-name.
+static void
+_bulkLoadFIB(FIBOptions *options, FILE *file, TimedResultSet *timeResults)
+{
+    size_t numNames = 0;
+    size_t capacity = 1024;
+    Name **names = (Name **) malloc(capacity * sizeof(Name *));
+    Name *name = NULL;
+    while ((name = _readNextNameFromFile(file)) != NULL) {
+        if (numNames == capacity) {
+            capacity *= 2;
+            names = (Name **) realloc(names, capacity * sizeof(Name *));
+        }
+        names[numNames++] = name;
+    }
+
+    struct timespec start = timerStart();
+
+    if (options->hasher != NULL) {
+        _BulkHashContext context = { .options = options, .names = names };
+        parallel_For(options->numThreads, numNames, _hashLoadedName, &context);
+    }
+
+    size_t numLoaded = 0;
+    Bitmap **vectors = (Bitmap **) malloc(numNames * sizeof(Bitmap *));
+    for (size_t i = 0; i < numNames; i++) {
+        if (name_GetSegmentCount(names[i]) > 0) {
+            vectors[numLoaded] = bitmap_Create(options->numPorts);
+            assertNotNull(vectors[numLoaded], "Could not allocate a PARCBitVector");
+            bitmap_Set(vectors[numLoaded], numLoaded % options->numPorts);
+            names[numLoaded++] = names[i];
+        } else {
+            name_Destroy(&names[i]);
+        }
+    }
+
+    fib_BulkLoad(options->fib, names, vectors, numLoaded, options->numThreads);
+    long elapsedTime = timerEnd(start);
+
+    fprintf(stderr, "Bulk loaded %zu names with %d threads in %ld ns\n", numLoaded, options->numThreads, elapsedTime);
+    for (size_t i = 0; i < numLoaded; i++) {
+        _appendTimedResult(timeResults, elapsedTime / (long) numLoaded);
+    }
+
+    free(vectors);
+    free(names);
+}
+
 static TimedResultSet *
 _loadFIB(FIBOptions *options)
 {
@@ -242,6 +537,11 @@ _loadFIB(FIBOptions *options)
         exit(EXIT_FAILURE);
     }
 
+    if (options->numThreads > 0) {
+        _bulkLoadFIB(options, file, timeResults);
+        return timeResults;
+    }
+
     // This is the FIB to use
     FIB *fib = options->fib;
 
@@ -280,6 +580,51 @@ _loadFIB(FIBOptions *options)
     return timeResults;
 }
 
+static void
+_tuneCiscoFIB(FIBOptions *options)
+{
+    FILE *file = fopen(options->testFile, "r");
+    if (file == NULL) {
+        perror("Could not open test file");
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    // Histogram of the test name lengths, which is the query distribution the M is tuned for
+    int numLengths = 0;
+    double *distribution = NULL;
+    Name *name = NULL;
+    while ((name = _readNextNameFromFile(file)) != NULL) {
+        if (options->hasher != NULL) {
+            Name *newName = name_Hash(name, options->hasher, options->hashSize);
+            name_Destroy(&name);
+            name = newName;
+        }
+
+        int length = name_GetSegmentCount(name);
+        if (length > numLengths) {
+            distribution = (double *) realloc(distribution, length * sizeof(double));
+            for (int i = numLengths; i < length; i++) {
+                distribution[i] = 0;
+            }
+            numLengths = length;
+        }
+        if (length > 0) {
+            distribution[length - 1]++;
+        }
+        name_Destroy(&name);
+    }
+    fclose(file);
+
+    int M = fibCisco_OptimalM(options->ciscoFIB, numLengths, distribution);
+    fprintf(stderr, "Using M = %d (%f expected probes per lookup, %" PRIu64 " virtual entries)\n", M,
+        fibCisco_ExpectedProbes(options->ciscoFIB, M, numLengths, distribution),
+        fibCisco_CountVirtualEntries(options->ciscoFIB, M));
+    fibCisco_Rebuild(options->ciscoFIB, M);
+
+    free(distribution);
+}
+
 static TimedResultSet *
 _testFIB(FIBOptions *options)
 {
@@ -301,6 +646,10 @@ _testFIB(FIBOptions *options)
 
     int numFalsePositives = 0;
 
+    // Lookup times split by whether the cache answered them
+    PARCBasicStats *hitStats = parcBasicStats_Create();
+    PARCBasicStats *missStats = parcBasicStats_Create();
+
     int index = 0;
     do {
         Name *name = _readNextNameFromFile(file);
@@ -316,9 +665,13 @@ _testFIB(FIBOptions *options)
 
         if (name_GetSegmentCount(name) > 0) {
             // Look up the FIB and time it.
+            uint64_t numHits = options->cachedFIB != NULL ? fibCached_GetNumHits(options->cachedFIB) : 0;
             struct timespec start = timerStart();
             Bitmap *output = fib_LPM(fib, name);
             long elapsedTime = timerEnd(start);
+            if (options->cachedFIB != NULL) {
+                parcBasicStats_Update(fibCached_GetNumHits(options->cachedFIB) > numHits ? hitStats : missStats, (double) elapsedTime);
+            }
 
             if (output == NULL) {
                 numFalsePositives++;
@@ -333,6 +686,16 @@ _testFIB(FIBOptions *options)
 
     _addCount(timeResults, numFalsePositives);
 
+    if (options->cachedFIB != NULL) {
+        uint64_t numLookups = fibCached_GetNumLookups(options->cachedFIB);
+        uint64_t numHits = fibCached_GetNumHits(options->cachedFIB);
+        fprintf(stderr, "%" PRIu64 " cache hits in %" PRIu64 " lookups (%f hit ratio, %f ns per hit, %f ns per miss)\n",
+            numHits, numLookups, numLookups > 0 ? (double) numHits / numLookups : 0.0,
+            parcBasicStats_Mean(hitStats), parcBasicStats_Mean(missStats));
+    }
+    parcBasicStats_Release(&hitStats);
+    parcBasicStats_Release(&missStats);
+
     return timeResults;
 }
 
@@ -343,7 +706,49 @@ main(int argc, char **argv)
 
     // Run the test
     TimedResultSet *insertionResults = _loadFIB(options);
+    if (options->ciscoFIB != NULL && options->ciscoM == 0) {
+        _tuneCiscoFIB(options);
+    }
+    if (options->frozen && (options->naiveFIB != NULL || options->ciscoFIB != NULL)) {
+        struct timespec start = timerStart();
+        double bitsPerKey = 0.0;
+        if (options->naiveFIB != NULL) {
+            fibNaive_Freeze(options->naiveFIB);
+            bitsPerKey = fibNaive_GetFrozenBitsPerKey(options->naiveFIB);
+        } else {
+            fibCisco_Freeze(options->ciscoFIB);
+            bitsPerKey = fibCisco_GetFrozenBitsPerKey(options->ciscoFIB);
+        }
+        fprintf(stderr, "Froze the tables in %ld ns (%f bits of perfect hash per key)\n", timerEnd(start), bitsPerKey);
+    }
+    if (options->intern && options->naiveFIB != NULL) {
+        fprintf(stderr, "%zu distinct components interned\n", componentDictionary_GetCount(componentDictionary_GetShared()));
+    }
+    if (options->staticFIB != NULL) {
+        // Lookups need the inserted names compacted into the table first
+        fibStatic_Build(options->staticFIB);
+        size_t numPrefixes = fibStatic_GetNumPrefixes(options->staticFIB);
+        fprintf(stderr, "%zu prefixes in %zu bytes (%f bytes per prefix)\n", numPrefixes,
+            fibStatic_GetSizeInBytes(options->staticFIB),
+            numPrefixes > 0 ? (double) fibStatic_GetSizeInBytes(options->staticFIB) / numPrefixes : 0.0);
+    }
+    if (options->cachedFIB != NULL) {
+        // The steps above change the FIB underneath the cache
+        fibCached_Invalidate(options->cachedFIB);
+    }
     TimedResultSet *testResults = _testFIB(options);
+    if (options->caesarFIB != NULL) {
+        fprintf(stderr, "%" PRIu64 " false positives in %" PRIu64 " of %" PRIu64 " lookups\n",
+            fibCaesar_GetNumFalsePositives(options->caesarFIB),
+            fibCaesar_GetNumFalsePositiveLookups(options->caesarFIB),
+            fibCaesar_GetNumLookups(options->caesarFIB));
+    }
+    if (options->ciscoFIB != NULL || options->naiveFIB != NULL) {
+        uint64_t numProbes = options->ciscoFIB != NULL ?
+            fibCisco_GetNumProbes(options->ciscoFIB) :
+            fibNaive_GetNumProbes(options->naiveFIB);
+        fprintf(stderr, "%f probes per lookup\n", testResults->total > 0 ? (double) numProbes / testResults->total : 0.0);
+    }
 
     PARCBasicStats *insertStats = parcBasicStats_Create();
     TimedResult *curr = insertionResults->head;
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <vector>
+
+#include "fib_table.h"
+#include "name_reader.h"
+#include "timer.h"
+
+#define DEFAULT_NUM_PORTS 256
+#define DEFAULT_ROUNDS 5
+
+// Compares fib::Table's static dispatch against the FIBInterface function-pointer path into the
+// same engine instance
+
+void usage() {
+    fprintf(stderr, "usage: table_perf -l load_file -t test_file [-a alg]... [-r rounds]\n");
+    fprintf(stderr, "   - load_file = A file that contains names to load the FIBs\n");
+    fprintf(stderr, "   - test_file = A file that contains names to look up\n");
+    fprintf(stderr, "   - alg       = An engine to measure (default: all): ['naive', 'cisco', 'patricia', 'tbf', 'static']\n");
+    fprintf(stderr, "   - rounds    = Lookups of the whole test file per path, alternating between the paths\n");
+}
+
+static std::vector<Name *>
+_readNames(char *file)
+{
+    std::vector<Name *> names;
+    NameReader *reader = nameReader_CreateFromFile(file, NULL);
+    while (nameReader_HasNext(reader)) {
+        Name *name = nameReader_Next(reader);
+        if (name != NULL && name_GetSegmentCount(name) > 0) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+static std::vector<Bitmap *>
+_createVectors(size_t count)
+{
+    std::vector<Bitmap *> vectors;
+    for (size_t i = 0; i < count; i++) {
+        Bitmap *vector = bitmap_Create(DEFAULT_NUM_PORTS);
+        bitmap_Set(vector, i % DEFAULT_NUM_PORTS);
+        vectors.push_back(vector);
+    }
+    return vectors;
+}
+
+template <typename Engine>
+static void
+_compare(const char *alg, std::vector<Name *> &load, std::vector<Name *> &test, int rounds)
+{
+    // Both paths share one engine instance, since two identically loaded instances can differ
+    // by more than the dispatch costs, just from where their tables were allocated
+    std::vector<Bitmap *> vectors = _createVectors(load.size());
+    fib::Table<Engine> table;
+    table.bulkLoad(load.data(), vectors.data(), load.size(), 1);
+    FIB *dynamicFIB = fib_Create(table.get(), Engine::interface());
+
+    // The first pass checks that both paths agree, and builds lazily compacted engines
+    size_t numMismatches = 0;
+    for (Name *name : test) {
+        Bitmap *expected = fib_LPM(dynamicFIB, name);
+        Bitmap *actual = table.lpm(name);
+        if (expected != actual) {
+            numMismatches++;
+        }
+    }
+    if (numMismatches > 0) {
+        fprintf(stderr, "%s: %zu lookups differ between the paths\n", alg, numMismatches);
+        exit(EXIT_FAILURE);
+    }
+
+    // Sum the matches, so that neither loop can be dropped
+    size_t numMatches = 0;
+    auto timeDynamic = [&]() {
+        struct timespec start = timerStart();
+        for (Name *name : test) {
+            numMatches += fib_LPM(dynamicFIB, name) != NULL;
+        }
+        return timerEnd(start);
+    };
+    auto timeStatic = [&]() {
+        struct timespec start = timerStart();
+        for (Name *name : test) {
+            numMatches += table.lpm(name) != NULL;
+        }
+        return timerEnd(start);
+    };
+
+    // Alternate which path goes first, so neither always runs on the caches the other warmed
+    long dynamicTime = 0;
+    long staticTime = 0;
+    for (int round = 0; round < rounds; round++) {
+        if (round % 2 == 0) {
+            dynamicTime += timeDynamic();
+            staticTime += timeStatic();
+        } else {
+            staticTime += timeStatic();
+            dynamicTime += timeDynamic();
+        }
+    }
+
+    double numLookups = (double) rounds * test.size();
+    printf("%s,function-pointer,%f\n", alg, dynamicTime / numLookups);
+    printf("%s,template,%f\n", alg, staticTime / numLookups);
+    fprintf(stderr, "%s: %zu matches, %f%% faster through the template\n", alg, numMatches,
+        dynamicTime > 0 ? 100.0 * (dynamicTime - staticTime) / dynamicTime : 0.0);
+
+    // The FIB destroys the shared instance
+    table.release();
+    fib_Destroy(&dynamicFIB);
+    for (Bitmap *vector : vectors) {
+        bitmap_Destroy(&vector);
+    }
+}
+
+static bool
+_measure(const char *alg, std::vector<Name *> &load, std::vector<Name *> &test, int rounds)
+{
+    // Engine parameters are fixed here, at compile time, with fib-perf's defaults
+    if (strcmp(alg, "naive") == 0) {
+        _compare<fib::Naive>(alg, load, test, rounds);
+    } else if (strcmp(alg, "cisco") == 0) {
+        _compare<fib::Cisco<3>>(alg, load, test, rounds);
+    } else if (strcmp(alg, "patricia") == 0) {
+        _compare<fib::Patricia>(alg, load, test, rounds);
+    } else if (strcmp(alg, "tbf") == 0) {
+        _compare<fib::TBF<2, 1 << 20, 7>>(alg, load, test, rounds);
+    } else if (strcmp(alg, "static") == 0) {
+        _compare<fib::Static>(alg, load, test, rounds);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    static struct option longopts[] = {
+            { "load_file", required_argument, NULL, 'l' },
+            { "test_file", required_argument, NULL, 't' },
+            { "alg",       required_argument, NULL, 'a' },
+            { "rounds",    required_argument, NULL, 'r' },
+            { "help",      no_argument,       NULL, 'h' },
+            { NULL,0,NULL,0}
+    };
+
+    char *loadFile = NULL;
+    char *testFile = NULL;
+    std::vector<const char *> algorithms;
+    int rounds = DEFAULT_ROUNDS;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "hl:t:a:r:", longopts, NULL)) != -1) {
+        switch (c) {
+            case 'l':
+                loadFile = optarg;
+                break;
+            case 't':
+                testFile = optarg;
+                break;
+            case 'a':
+                algorithms.push_back(optarg);
+                break;
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (loadFile == NULL || testFile == NULL || rounds < 1) {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+    if (algorithms.empty()) {
+        algorithms = { "naive", "cisco", "patricia", "tbf", "static" };
+    }
+
+    std::vector<Name *> load = _readNames(loadFile);
+    std::vector<Name *> test = _readNames(testFile);
+
+    printf("alg,path,ns per lookup\n");
+    for (const char *alg : algorithms) {
+        if (!_measure(alg, load, test, rounds)) {
+            fprintf(stderr, "Invalid algorithm specified: %s\n", alg);
+            usage();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (Name *name : load) {
+        name_Destroy(&name);
+    }
+    for (Name *name : test) {
+        name_Destroy(&name);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,9 @@
 #include "fib.h"
 
-struct fib {
+#include <stdlib.h>
+#include <string.h>
+
+struct fib_dispatch {
     void *instance;
     FIBInterface *interface;
 };
@@ -38,3 +41,58 @@ fib_Insert(FIB *map, const Name *ccnxName, Bitmap *vector)
 {
     return map->interface->Insert(map->instance, ccnxName, vector);
 }
+
+bool
+fib_CallerOwnsResults(FIB *map)
+{
+    return map->interface->CallerOwnsResults;
+}
+
+bool
+fib_BulkLoad(FIB *map, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    if (map->interface->BulkLoad != NULL) {
+        return map->interface->BulkLoad(map->instance, names, vectors, n, threads);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        map->interface->Insert(map->instance, names[i], vectors[i]);
+    }
+    return true;
+}
+
+int
+fib_GroupByLength(Name *names[], size_t n, size_t **orderP, size_t **startsP)
+{
+    int maxLength = 0;
+    for (size_t i = 0; i < n; i++) {
+        int length = name_GetSegmentCount(names[i]);
+        maxLength = length > maxLength ? length : maxLength;
+    }
+
+    size_t *starts = (size_t *) calloc(maxLength + 1, sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        int length = name_GetSegmentCount(names[i]);
+        if (length > 0) {
+            starts[length]++;
+        }
+    }
+    for (int d = 1; d <= maxLength; d++) {
+        starts[d] += starts[d - 1];
+    }
+
+    size_t *order = (size_t *) malloc((n > 0 ? n : 1) * sizeof(size_t));
+    size_t *next = (size_t *) malloc((maxLength + 1) * sizeof(size_t));
+    memcpy(next, starts, (maxLength + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        int length = name_GetSegmentCount(names[i]);
+        if (length > 0) {
+            order[next[length - 1]++] = i;
+        }
+    }
+    free(next);
+
+    *orderP = order;
+    *startsP = starts;
+    return maxLength;
+}
@@ -24,8 +24,8 @@ typedef enum {
     FIBAlgorithm_Song
 } FIBAlgorithm;
 
-struct fib;
-typedef struct fib FIB;
+struct fib_dispatch;
+typedef struct fib_dispatch FIB;
 
 typedef struct {
     // Perform LPM to retrieve the name
@@ -34,7 +34,13 @@ typedef struct {
     // Insert a new name into the FIB
     bool (*Insert)(void *instance, const Name *ccnxName, Bitmap *vector);
 
+    // Insert many names at once on up to threads threads (optional: NULL inserts them one by one)
+    bool (*BulkLoad)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
     void (*Destroy)(void **instance);
+
+    // Whether LPM returns a new vector that the caller destroys, rather than one the FIB keeps
+    bool CallerOwnsResults;
 } FIBInterface;
 
 FIB *fib_Create(void *instance, FIBInterface *interface);
@@ -42,6 +48,19 @@ void fib_Destroy(FIB **fibP);
 Bitmap *fib_LPM(FIB *map, const Name *ccnxName);
 bool fib_Insert(FIB *map, const Name *ccnxName, Bitmap *vector);
 
+// As FIBInterface.CallerOwnsResults
+bool fib_CallerOwnsResults(FIB *map);
+
+// Insert names[i] with vectors[i] for every i, building the tables in parallel on up to threads
+// threads (0 for one per core) where the engine supports it. As with fib_Insert, the FIB keeps
+// the vectors themselves, and repeated names are merged into the first one's vector.
+bool fib_BulkLoad(FIB *map, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+// For engine bulk loads: the indices of names grouped by segment count, in batch order within a
+// length. Names of d segments are order[starts[d - 1]] to order[starts[d] - 1], and names without
+// segments are left out. Returns the longest length; the caller frees both arrays.
+int fib_GroupByLength(Name *names[], size_t n, size_t **orderP, size_t **startsP);
+
 
 #endif // fib_h_
 
@@ -0,0 +1,186 @@
+#include "fib_cached.h"
+
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "random.h"
+#include "wyhasher.h"
+
+#define CACHED_FIB_WAYS 4
+
+const int CachedFIBWays = CACHED_FIB_WAYS;
+
+// The tags and results of a set share one cache line. A zero tag marks an empty entry.
+typedef struct {
+    uint64_t tags[CACHED_FIB_WAYS];
+    Bitmap *results[CACHED_FIB_WAYS];
+} _CacheSet;
+
+struct fib_cached {
+    FIB *fib;
+
+    // A power of two
+    size_t numSets;
+    _CacheSet *sets;
+
+    // The CLOCK state of each set: one referenced bit per way, and the hand above them
+    uint8_t *clocks;
+
+    size_t byteSize;
+    Allocator *allocator;
+
+    uint64_t generation;
+    WYHasher *hasher;
+
+    uint64_t numLookups;
+    uint64_t numHits;
+};
+
+FIBCached *
+fibCached_Create(FIB *fib, size_t capacity)
+{
+    // A cached vector the caller owns would be destroyed by the first caller it was returned to
+    if (fib_CallerOwnsResults(fib)) {
+        return NULL;
+    }
+
+    FIBCached *cache = (FIBCached *) malloc(sizeof(FIBCached));
+    if (cache != NULL) {
+        cache->fib = fib;
+
+        size_t minSets = (capacity + CACHED_FIB_WAYS - 1) / CACHED_FIB_WAYS;
+        cache->numSets = 1;
+        while (cache->numSets < minSets) {
+            cache->numSets <<= 1;
+        }
+
+        cache->byteSize = cache->numSets * (sizeof(_CacheSet) + sizeof(uint8_t));
+        cache->allocator = allocator_GetDefault();
+        cache->sets = (_CacheSet *) allocator_Allocate(cache->allocator, cache->byteSize);
+        cache->clocks = (uint8_t *) (cache->sets + cache->numSets);
+
+        PARCBuffer *seed = random_Bytes(parcBuffer_Allocate(sizeof(uint64_t)));
+        cache->hasher = wyhasher_Create(parcBuffer_GetUint64(seed));
+        parcBuffer_Release(&seed);
+
+        cache->generation = 0;
+        cache->numLookups = 0;
+        cache->numHits = 0;
+    }
+    return cache;
+}
+
+void
+fibCached_Destroy(FIBCached **cacheP)
+{
+    FIBCached *cache = *cacheP;
+
+    fib_Destroy(&cache->fib);
+    allocator_Deallocate(cache->allocator, cache->sets, cache->byteSize);
+    wyhasher_Destroy(&cache->hasher);
+
+    free(cache);
+    *cacheP = NULL;
+}
+
+void
+fibCached_Invalidate(FIBCached *cache)
+{
+    // Old tags are left in place, since they cannot match under the new generation. Their
+    // referenced bits only cost them one more sweep of the hand, so insertions stay O(1).
+    cache->generation++;
+}
+
+// The name fingerprint under the current generation, never zero
+static inline uint64_t
+_fibCached_Tag(FIBCached *cache, const Name *name)
+{
+    uint64_t hash = wyhasher_Hash64(cache->hasher, name_GetPrefixLength(name, name_GetSegmentCount(name)), name_GetBuffer(name));
+    return (hash ^ (cache->generation * 0x9E3779B97F4A7C15ULL)) | 1;
+}
+
+static void
+_fibCached_Fill(FIBCached *cache, size_t index, uint64_t tag, Bitmap *result)
+{
+    _CacheSet *set = cache->sets + index;
+    uint8_t clock = cache->clocks[index];
+    int hand = clock >> CACHED_FIB_WAYS;
+
+    // Skip, and clear, referenced ways until the hand rests on one that is not
+    while (clock & (1 << hand)) {
+        clock &= ~(1 << hand);
+        hand = (hand + 1) % CACHED_FIB_WAYS;
+    }
+
+    set->tags[hand] = tag;
+    set->results[hand] = result;
+
+    hand = (hand + 1) % CACHED_FIB_WAYS;
+    cache->clocks[index] = (uint8_t) ((clock & ((1 << CACHED_FIB_WAYS) - 1)) | (hand << CACHED_FIB_WAYS));
+}
+
+Bitmap *
+fibCached_LPM(FIBCached *cache, const Name *name)
+{
+    if (name_GetSegmentCount(name) == 0) {
+        return fib_LPM(cache->fib, name);
+    }
+    cache->numLookups++;
+
+    // The low bits pick the set; the whole tag is compared
+    uint64_t tag = _fibCached_Tag(cache, name);
+    size_t index = (size_t) (tag >> 1) & (cache->numSets - 1);
+    _CacheSet *set = cache->sets + index;
+    for (int way = 0; way < CACHED_FIB_WAYS; way++) {
+        if (set->tags[way] == tag) {
+            cache->numHits++;
+            if (!(cache->clocks[index] & (1 << way))) {
+                cache->clocks[index] |= 1 << way;
+            }
+            return set->results[way];
+        }
+    }
+
+    Bitmap *result = fib_LPM(cache->fib, name);
+    _fibCached_Fill(cache, index, tag, result);
+    return result;
+}
+
+bool
+fibCached_Insert(FIBCached *cache, const Name *name, Bitmap *vector)
+{
+    fibCached_Invalidate(cache);
+    return fib_Insert(cache->fib, name, vector);
+}
+
+bool
+fibCached_BulkLoad(FIBCached *cache, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    fibCached_Invalidate(cache);
+    return fib_BulkLoad(cache->fib, names, vectors, n, threads);
+}
+
+size_t
+fibCached_GetCapacity(FIBCached *cache)
+{
+    return cache->numSets * CACHED_FIB_WAYS;
+}
+
+uint64_t
+fibCached_GetNumLookups(FIBCached *cache)
+{
+    return cache->numLookups;
+}
+
+uint64_t
+fibCached_GetNumHits(FIBCached *cache)
+{
+    return cache->numHits;
+}
+
+FIBInterface *CachedFIBAsFIB = &(FIBInterface) {
+        .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibCached_LPM,
+        .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibCached_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibCached_BulkLoad,
+        .Destroy = (void (*)(void **instance)) fibCached_Destroy,
+};
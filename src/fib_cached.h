@@ -0,0 +1,53 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef fib_cached_h_
+#define fib_cached_h_
+
+#include "fib.h"
+
+struct fib_cached;
+typedef struct fib_cached FIBCached;
+
+extern FIBInterface *CachedFIBAsFIB;
+
+// Entries per cache set
+extern const int CachedFIBWays;
+
+// An LPM result cache in front of any FIB. Lookups are keyed by a 64-bit fingerprint of the whole
+// name and land in one set of CachedFIBWays entries, which fills a cache line. A miss asks the
+// FIB and replaces an entry of the set by CLOCK: entries start unreferenced and survive one
+// sweep of the hand per hit. No-match results are cached too.
+//
+// Every insertion through the cache starts a new generation, which is folded into the tags, so
+// results cached before it are never returned again. Results are the FIB's own vectors, as
+// fib_LPM returns them, so a FIB whose lookups return vectors for the caller to destroy (see
+// fib_CallerOwnsResults) cannot be cached, and NULL is returned for it. Lookups update the cache
+// and its counters, so they must not run concurrently.
+FIBCached *fibCached_Create(FIB *fib, size_t capacity);
+
+// Also destroys the wrapped FIB
+void fibCached_Destroy(FIBCached **cacheP);
+
+bool fibCached_Insert(FIBCached *cache, const Name *name, Bitmap *vector);
+
+bool fibCached_BulkLoad(FIBCached *cache, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+Bitmap *fibCached_LPM(FIBCached *cache, const Name *name);
+
+// Drop every cached result, e.g., after the wrapped FIB was changed directly
+void fibCached_Invalidate(FIBCached *cache);
+
+// Number of entries (sets times ways)
+size_t fibCached_GetCapacity(FIBCached *cache);
+
+uint64_t fibCached_GetNumLookups(FIBCached *cache);
+
+uint64_t fibCached_GetNumHits(FIBCached *cache);
+
+#endif // fib_cached_h_
+
+#ifdef __cplusplus
+}
+#endif
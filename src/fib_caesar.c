@@ -1,12 +1,19 @@
 #include "fib_caesar.h"
 
 #include "map.h"
+#include "bloom.h"
+#include "parallel.h"
 #include "prefix_bloom.h"
 
 struct fib_caesar {
     int numMaps;
     PrefixBloomFilter *pbf;
     Map **maps;
+
+    // Lookup counters: filter-positive lengths the tables rejected, and lookups that hit at least one
+    uint64_t numLookups;
+    uint64_t numFalsePositives;
+    uint64_t numFalsePositiveLookups;
 };
 
 static Map *
@@ -30,19 +37,38 @@ fibCaesar_Destroy(FIBCaesar **fibP)
     *fibP = NULL;
 }
 
-FIBCaesar *
-fibCaesar_Create(int b, int m, int k)
+static FIBCaesar *
+_fibCaesar_CreateWithFilter(PrefixBloomFilter *pbf)
 {
     FIBCaesar *fib = (FIBCaesar *) malloc(sizeof(FIBCaesar));
     if (fib != NULL) {
-        fib->pbf = prefixBloomFilter_Create(b, m, k);
+        fib->pbf = pbf;
         fib->numMaps = 1;
         fib->maps = (Map **) malloc(sizeof(Map *));
         fib->maps[0] = _fibCaesar_CreateMap();
+        fib->numLookups = 0;
+        fib->numFalsePositives = 0;
+        fib->numFalsePositiveLookups = 0;
     }
     return fib;
 }
 
+FIBCaesar *
+fibCaesar_Create(int b, int m, int k)
+{
+    return _fibCaesar_CreateWithFilter(prefixBloomFilter_Create(b, m, k));
+}
+
+FIBCaesar *
+fibCaesar_CreateOptimal(int expectedEntries, double targetFPR)
+{
+    PrefixBloomFilter *pbf = prefixBloomFilter_CreateOptimal(expectedEntries, targetFPR);
+    prefixBloomFilter_SetMaxFillRatio(pbf, BloomDefaultMaxFillRatio);
+    return _fibCaesar_CreateWithFilter(pbf);
+}
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
 static void
 _fibCaesar_ExpandMapsToSize(FIBCaesar *fib, int number)
 {
@@ -55,31 +81,83 @@ _fibCaesar_ExpandMapsToSize(FIBCaesar *fib, int number)
     }
 }
 
-Bitmap *
-fibCaesar_LPM(FIBCaesar *fib, const Name *name)
+static Bitmap *
+_fibCaesar_GetPrefix(FIBCaesar *fib, const Name *name, int length)
 {
-    int numMatches = prefixBloomFilter_LPM(fib->pbf, name);
-    if (numMatches > 0 && numMatches <= fib->numMaps) {
-        Map *table = fib->maps[numMatches - 1];
+    Map *table = fib->maps[length - 1];
 
-        PARCBuffer *key = name_GetWireFormat(name, numMatches);
-        Bitmap *match = NULL;
-        if (name_IsHashed(name)) {
-            match = map_GetHashed(table, key);
-        } else {
-            match = map_Get(table, key);
-        }
+    PARCBuffer *key = name_GetWireFormat(name, length);
+    Bitmap *match = NULL;
+    if (name_IsHashed(name)) {
+        match = map_GetHashed(table, key);
+    } else {
+        match = map_Get(table, key);
+    }
 
-        parcBuffer_Release(&key);
-        return match;
+    parcBuffer_Release(&key);
+    return match;
+}
+
+// Walk down the filter-positive lengths until a table confirms one. Returns the
+// number of positive lengths that were false positives through numFalsePositives.
+static Bitmap *
+_fibCaesar_Lookup(FIBCaesar *fib, const Name *name, int *numFalsePositives)
+{
+    int numSegments = name_GetSegmentCount(name);
+    bool present[numSegments + 1];
+
+    *numFalsePositives = 0;
+    int longest = prefixBloomFilter_TestPrefixes(fib->pbf, name, present);
+    for (int length = MIN(longest, fib->numMaps); length > 0; length--) {
+        if (present[length - 1]) {
+            Bitmap *match = _fibCaesar_GetPrefix(fib, name, length);
+            if (match != NULL) {
+                return match;
+            }
+            (*numFalsePositives)++;
+        }
     }
     return NULL;
 }
 
+Bitmap *
+fibCaesar_LPM(FIBCaesar *fib, const Name *name)
+{
+    int numFalsePositives = 0;
+    Bitmap *match = _fibCaesar_Lookup(fib, name, &numFalsePositives);
+
+    fib->numLookups++;
+    fib->numFalsePositives += numFalsePositives;
+    if (numFalsePositives > 0) {
+        fib->numFalsePositiveLookups++;
+    }
+
+    return match;
+}
+
+uint64_t
+fibCaesar_GetNumLookups(FIBCaesar *fib)
+{
+    return fib->numLookups;
+}
+
+uint64_t
+fibCaesar_GetNumFalsePositives(FIBCaesar *fib)
+{
+    return fib->numFalsePositives;
+}
+
+uint64_t
+fibCaesar_GetNumFalsePositiveLookups(FIBCaesar *fib)
+{
+    return fib->numFalsePositiveLookups;
+}
+
 bool
 fibCaesar_Insert(FIBCaesar *fib, const Name *name, Bitmap *vector)
 {
-    Bitmap *match = fibCaesar_LPM(fib, name);
+    int numFalsePositives = 0;
+    Bitmap *match = _fibCaesar_Lookup(fib, name, &numFalsePositives);
     if (match != NULL) {
         bitmap_SetVector(match, vector);
     }
@@ -101,9 +179,107 @@ fibCaesar_Insert(FIBCaesar *fib, const Name *name, Bitmap *vector)
     return true;
 }
 
+// Repeated names are merged once every new one has been added to its ancestor
+static void
+_fibCaesar_KeepVector(void *existing, void *vector)
+{
+}
+
+typedef struct {
+    FIBCaesar *fib;
+    Name **names;
+    const size_t *group;
+    int length;
+    void **items;
+    void **results;
+    Bitmap **ancestors;
+} _FIBCaesarBulkGroup;
+
+// The filter's name test works in shared scratch space, so threads probe the tables directly
+static void
+_fibCaesar_FindAncestor(void *context, size_t i)
+{
+    _FIBCaesarBulkGroup *group = (_FIBCaesarBulkGroup *) context;
+    group->ancestors[i] = NULL;
+    if (group->results[i] == group->items[i]) {
+        for (int length = group->length - 1; length > 0 && group->ancestors[i] == NULL; length--) {
+            group->ancestors[i] = _fibCaesar_GetPrefix(group->fib, group->names[group->group[i]], length);
+        }
+    }
+}
+
+bool
+fibCaesar_BulkLoad(FIBCaesar *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    size_t *order = NULL;
+    size_t *starts = NULL;
+    int maxLength = fib_GroupByLength(names, n, &order, &starts);
+    _fibCaesar_ExpandMapsToSize(fib, maxLength);
+
+    size_t capacity = n > 0 ? n : 1;
+    PARCBuffer **keys = (PARCBuffer **) malloc(capacity * sizeof(PARCBuffer *));
+    void **items = (void **) malloc(capacity * sizeof(void *));
+    void **results = (void **) malloc(capacity * sizeof(void *));
+    Bitmap **ancestors = (Bitmap **) malloc(capacity * sizeof(Bitmap *));
+
+    // The filter is filled block by block, and the tables length by length and hash range by hash range
+    Name **loaded = (Name **) malloc(capacity * sizeof(Name *));
+    for (size_t i = 0; i < starts[maxLength]; i++) {
+        loaded[i] = names[order[i]];
+    }
+    prefixBloomFilter_AddMany(fib->pbf, starts[maxLength], loaded, threads);
+    free(loaded);
+
+    for (int length = 1; length <= maxLength; length++) {
+        size_t count = starts[length] - starts[length - 1];
+        if (count == 0) {
+            continue;
+        }
+
+        const size_t *group = order + starts[length - 1];
+        for (size_t i = 0; i < count; i++) {
+            keys[i] = name_GetWireFormat(names[group[i]], length);
+            items[i] = vectors[group[i]];
+        }
+        map_BulkInsert(fib->maps[length - 1], count, keys, items, name_IsHashed(names[group[0]]),
+                       _fibCaesar_KeepVector, results, threads);
+        for (size_t i = 0; i < count; i++) {
+            parcBuffer_Release(&keys[i]);
+        }
+
+        // As fibCaesar_Insert does for the names shortest first: a new name's vector is merged into
+        // its longest prefix already loaded, and a repeated name's into the first one's
+        _FIBCaesarBulkGroup ancestorGroup = {
+                .fib = fib,
+                .names = names,
+                .group = group,
+                .length = length,
+                .items = items,
+                .results = results,
+                .ancestors = ancestors,
+        };
+        parallel_For(threads, count, _fibCaesar_FindAncestor, &ancestorGroup);
+        for (size_t i = 0; i < count; i++) {
+            Bitmap *match = results[i] == items[i] ? ancestors[i] : (Bitmap *) results[i];
+            if (match != NULL) {
+                bitmap_SetVector(match, (Bitmap *) items[i]);
+            }
+        }
+    }
+
+    free(ancestors);
+    free(results);
+    free(items);
+    free(keys);
+    free(starts);
+    free(order);
+    return true;
+}
+
 FIBInterface *CaesarFIBAsFIB = &(FIBInterface) {
         .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibCaesar_LPM,
         .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibCaesar_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibCaesar_BulkLoad,
         .Destroy = (void (*)(void **instance)) fibCaesar_Destroy,
 };
 
@@ -12,6 +12,8 @@ typedef struct fib_caesar FIBCaesar;
 
 FIBCaesar *fibCaesar_Create(int b, int m, int k);
 
+FIBCaesar *fibCaesar_CreateOptimal(int expectedEntries, double targetFPR);
+
 void fibCaesar_Destroy(FIBCaesar **fibP);
 
 extern FIBInterface *CaesarFIBAsFIB;
@@ -20,6 +22,19 @@ bool fibCaesar_Insert(FIBCaesar *fib, const Name *name, Bitmap *vector);
 
 Bitmap *fibCaesar_LPM(FIBCaesar *fib, const Name *name);
 
+// Insert names[i] with vectors[i] on up to threads threads: the prefix filter block by block,
+// then each length table by hash range. The vectors end up as if fibCaesar_Insert had been called
+// for the names shortest first: merged into the longest prefix loaded before them.
+bool fibCaesar_BulkLoad(FIBCaesar *fib, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+// Lookup counters. A false positive is a length the filter reported that the exact-match table did not hold.
+uint64_t fibCaesar_GetNumLookups(FIBCaesar *fib);
+
+uint64_t fibCaesar_GetNumFalsePositives(FIBCaesar *fib);
+
+// Lookups that had at least one false positive (these were silent misses before backtracking)
+uint64_t fibCaesar_GetNumFalsePositiveLookups(FIBCaesar *fib);
+
 #endif
 
 #ifdef __cplusplus
@@ -1,73 +1,289 @@
 #include "fib_caesar_filter.h"
 
+#include <string.h>
+
 #include "map.h"
 #include "bloom.h"
 #include "prefix_bloom.h"
+#include "cuckoo_filter.h"
+#include "siphasher.h"
+#include "allocator.h"
 
 #include <parc/algol/parc_SafeMemory.h>
 
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// The port filters are stored interleaved: row i of the matrix holds bit i of every port's
+// filter, one port-width word run per row, so a key is hashed once and k rows are ANDed
+// into the egress vector. Ports that outgrow a stage spill into a larger one.
+typedef struct _port_matrix {
+    size_t m;
+    int k;
+    double targetFPR;
+
+    // Entries per port before the next stage is started, or 0 for a fixed-size matrix
+    int capacity;
+    int *portCounts;
+
+    uint64_t *rows;
+    size_t byteSize;
+    Allocator *allocator;
+
+    struct _port_matrix *next;
+} _PortMatrix;
+
 struct fib_caesar_filter {
     PrefixBloomFilter *pbf;
     int numPorts;
-    BloomFilter **portFilters;
+    size_t numWords;
+    uint64_t lastWordMask;
+    _PortMatrix *matrix;
+    SipHasher *hasher;
+
+    // With cuckoo filters, the matrix is replaced by one filter that stores each
+    // (key, port) pair as a fingerprint with the port as its payload
+    CuckooFilter *ports;
 };
 
+static _PortMatrix *
+_portMatrix_Create(FIBCaesarFilter *fib, size_t m, int k)
+{
+    _PortMatrix *matrix = (_PortMatrix *) malloc(sizeof(_PortMatrix));
+    if (matrix != NULL) {
+        matrix->m = m > 0 ? m : 1;
+        matrix->k = k > 0 ? k : 1;
+        matrix->targetFPR = 0.0;
+        matrix->capacity = 0;
+        matrix->portCounts = (int *) calloc(fib->numPorts, sizeof(int));
+        matrix->byteSize = matrix->m * fib->numWords * sizeof(uint64_t);
+        matrix->allocator = allocator_GetDefault();
+        matrix->rows = (uint64_t *) allocator_Allocate(matrix->allocator, matrix->byteSize);
+        matrix->next = NULL;
+    }
+    return matrix;
+}
+
+static _PortMatrix *
+_portMatrix_CreateOptimal(FIBCaesarFilter *fib, int capacity, double targetFPR)
+{
+    size_t m = bloom_OptimalSize(capacity, targetFPR);
+    _PortMatrix *matrix = _portMatrix_Create(fib, m, bloom_OptimalHashCount(m, capacity));
+    if (matrix != NULL) {
+        matrix->capacity = capacity;
+        matrix->targetFPR = targetFPR;
+    }
+    return matrix;
+}
+
+static void
+_portMatrix_Destroy(_PortMatrix **matrixP)
+{
+    _PortMatrix *matrix = *matrixP;
+    while (matrix != NULL) {
+        _PortMatrix *next = matrix->next;
+        allocator_Deallocate(matrix->allocator, matrix->rows, matrix->byteSize);
+        free(matrix->portCounts);
+        free(matrix);
+        matrix = next;
+    }
+    *matrixP = NULL;
+}
+
 void
 fibCaesarFilter_Destroy(FIBCaesarFilter **fibP)
 {
     FIBCaesarFilter *fib = *fibP;
 
     prefixBloomFilter_Destroy(&fib->pbf);
-    for (int i = 0; i < fib->numPorts; i++) {
-        bloom_Destroy(&fib->portFilters[i]);
+    _portMatrix_Destroy(&fib->matrix);
+    if (fib->ports != NULL) {
+        cuckooFilter_Destroy(&fib->ports);
     }
-    free(fib->portFilters);
+    siphasher_Destroy(&fib->hasher);
 
     free(fib);
     *fibP = NULL;
 }
 
+static FIBCaesarFilter *
+_fibCaesarFilter_Create(int numPorts)
+{
+    FIBCaesarFilter *fib = (FIBCaesarFilter *) malloc(sizeof(FIBCaesarFilter));
+    if (fib != NULL) {
+        fib->numPorts = numPorts;
+        fib->numWords = (numPorts + 63) / 64;
+        fib->lastWordMask = (numPorts % 64) == 0 ? UINT64_MAX : UINT64_MAX << (64 - (numPorts % 64));
+        fib->hasher = bloom_CreateHasher();
+        fib->matrix = NULL;
+        fib->ports = NULL;
+    }
+    return fib;
+}
+
 FIBCaesarFilter *
 fibCaesarFilter_Create(int numPorts, int b, int m, int k)
 {
-    FIBCaesarFilter *fib = (FIBCaesarFilter *) malloc(sizeof(FIBCaesarFilter));
+    FIBCaesarFilter *fib = _fibCaesarFilter_Create(numPorts);
     if (fib != NULL) {
         fib->pbf = prefixBloomFilter_Create(b, m, k);
-        fib->numPorts = numPorts;
-        fib->portFilters = (BloomFilter **) malloc(numPorts * sizeof(BloomFilter *));
-        for (int i = 0; i < numPorts; i++) {
-            fib->portFilters[i] = bloom_Create(m, k);
-        }
+        fib->matrix = _portMatrix_Create(fib, m, k);
+    }
+    return fib;
+}
+
+FIBCaesarFilter *
+fibCaesarFilter_CreateOptimal(int numPorts, int expectedEntries, double targetFPR)
+{
+    return fibCaesarFilter_CreateOptimalWithFilter(numPorts, expectedEntries, targetFPR, FilterType_Bloom);
+}
+
+FIBCaesarFilter *
+fibCaesarFilter_CreateOptimalWithFilter(int numPorts, int expectedEntries, double targetFPR, FilterType type)
+{
+    FIBCaesarFilter *fib = _fibCaesarFilter_Create(numPorts);
+    if (fib != NULL && type == FilterType_Cuckoo) {
+        assertTrue(numPorts <= UINT16_MAX + 1, "Expected at most %d ports for cuckoo filter payloads, got %d", UINT16_MAX + 1, numPorts);
+        fib->pbf = prefixBloomFilter_CreateOptimalWithFilter(expectedEntries, targetFPR, type);
+        fib->ports = cuckooFilter_CreateWithHasher(expectedEntries > 0 ? expectedEntries : 1, true, fib->hasher);
+    } else if (fib != NULL) {
+        fib->pbf = prefixBloomFilter_CreateOptimal(expectedEntries, targetFPR);
+        prefixBloomFilter_SetMaxFillRatio(fib->pbf, BloomDefaultMaxFillRatio);
+
+        // Size each port filter for an even share of the load and let skewed ports grow
+        int portEntries = (expectedEntries + numPorts - 1) / numPorts;
+        fib->matrix = _portMatrix_CreateOptimal(fib, portEntries > 0 ? portEntries : 1, targetFPR);
     }
     return fib;
 }
 
+static void
+_fibCaesarFilter_HashKey(FIBCaesarFilter *fib, const Name *name, PARCBuffer *key, uint64_t *h1, uint64_t *h2)
+{
+    // Hashed names are already digests
+    if (name_IsHashed(name)) {
+        bloom_DigestToHashPair(parcBuffer_Remaining(key), parcBuffer_Overlay(key, 0), h1, h2);
+    } else {
+        PARCBuffer *digest = siphasher_HashArray(fib->hasher, parcBuffer_Remaining(key), parcBuffer_Overlay(key, 0));
+        bloom_DigestToHashPair(parcBuffer_Remaining(digest), parcBuffer_Overlay(digest, 0), h1, h2);
+        parcBuffer_Release(&digest);
+    }
+}
+
+static void
+_fibCaesarFilter_SetPort(void *context, uint16_t port)
+{
+    Bitmap *vector = (Bitmap *) context;
+    if (port < bitmap_GetSize(vector)) {
+        bitmap_Set(vector, port);
+    }
+}
+
 Bitmap *
 fibCaesarFilter_LPM(FIBCaesarFilter *fib, const Name *name)
 {
     int numMatches = prefixBloomFilter_LPM(fib->pbf, name);
     if (numMatches >= 0) {
-        Bitmap *vector = bitmap_Create(fib->numPorts);
         PARCBuffer *key = name_GetWireFormat(name, numMatches);
-        for (int i = 0; i < fib->numPorts; i++) {
-            bool set = false;
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+        _fibCaesarFilter_HashKey(fib, name, key, &h1, &h2);
+        parcBuffer_Release(&key);
 
-            if (name_IsHashed(name)) {
-                set = bloom_TestHashed(fib->portFilters[i], key);
-            } else {
-                set = bloom_Test(fib->portFilters[i], key);
-            }
+        Bitmap *vector = bitmap_Create(fib->numPorts);
+        if (fib->ports != NULL) {
+            cuckooFilter_ForEachPayload(fib->ports, h1, h2, _fibCaesarFilter_SetPort, vector);
+            return vector;
+        }
 
-            if (set) {
-                bitmap_Set(vector, i);
+        uint64_t *result = bitmap_GetWords(vector);
+        size_t numWords = fib->numWords;
+
+        // A port matches in a stage if all k of its bits are set there
+        uint64_t ports[numWords];
+        for (_PortMatrix *matrix = fib->matrix; matrix != NULL; matrix = matrix->next) {
+            memset(ports, 0xFF, sizeof(ports));
+            uint64_t any = 0;
+            for (int i = 0; i < matrix->k; i++) {
+                uint64_t *row = matrix->rows + bloom_HashIndex(h1, h2, i, matrix->m) * numWords;
+                any = 0;
+                for (size_t w = 0; w < numWords; w++) {
+                    ports[w] &= row[w];
+                    any |= ports[w];
+                }
+                if (any == 0) {
+                    break;
+                }
+            }
+            for (size_t w = 0; any != 0 && w < numWords; w++) {
+                result[w] |= ports[w];
             }
         }
-        parcBuffer_Release(&key);
         return vector;
     }
     return NULL;
 }
 
+// The stage receiving the next entry, grown if one of its ports reached the stage capacity
+static _PortMatrix *
+_fibCaesarFilter_GetInsertionStage(FIBCaesarFilter *fib, Bitmap *vector)
+{
+    _PortMatrix *matrix = fib->matrix;
+    while (matrix->next != NULL) {
+        matrix = matrix->next;
+    }
+
+    if (matrix->capacity > 0) {
+        bool isFull = false;
+        for (int i = 0; i < fib->numPorts && !isFull; i++) {
+            isFull = bitmap_Get(vector, i) && matrix->portCounts[i] >= matrix->capacity;
+        }
+        if (isFull) {
+            matrix->next = _portMatrix_CreateOptimal(fib, matrix->capacity * BloomGrowthFactor,
+                matrix->targetFPR / BloomGrowthFactor);
+            matrix = matrix->next;
+        }
+    }
+
+    for (int i = 0; i < fib->numPorts; i++) {
+        if (bitmap_Get(vector, i)) {
+            matrix->portCounts[i]++;
+        }
+    }
+    return matrix;
+}
+
+typedef struct {
+    uint16_t port;
+    bool isPresent;
+} _CaesarPortSearch;
+
+static void
+_fibCaesarFilter_FindPort(void *context, uint16_t port)
+{
+    _CaesarPortSearch *search = (_CaesarPortSearch *) context;
+    search->isPresent = search->isPresent || search->port == port;
+}
+
+// Store a (key, port) pair once, however often the key is inserted with the port
+static void
+_fibCaesarFilter_AddPorts(FIBCaesarFilter *fib, uint64_t h1, uint64_t h2, Bitmap *vector)
+{
+    for (int i = 0; i < fib->numPorts; i++) {
+        if (bitmap_Get(vector, i)) {
+            _CaesarPortSearch search = { .port = (uint16_t) i, .isPresent = false };
+            cuckooFilter_ForEachPayload(fib->ports, h1, h2, _fibCaesarFilter_FindPort, &search);
+            if (!search.isPresent) {
+                cuckooFilter_AddHashPairWithPayload(fib->ports, h1, h2, (uint16_t) i);
+            }
+        }
+    }
+}
+
+static void
+_fibCaesarFilter_IgnorePort(void *context, uint16_t port)
+{
+}
+
 bool
 fibCaesarFilter_Insert(FIBCaesarFilter *fib, const Name *name, Bitmap *vector)
 {
@@ -76,22 +292,60 @@ fibCaesarFilter_Insert(FIBCaesarFilter *fib, const Name *name, Bitmap *vector)
 
     prefixBloomFilter_Add(fib->pbf, name);
 
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _fibCaesarFilter_HashKey(fib, name, key, &h1, &h2);
+    parcBuffer_Release(&key);
+
+    if (fib->ports != NULL) {
+        _fibCaesarFilter_AddPorts(fib, h1, h2, vector);
+        return true;
+    }
+
+    _PortMatrix *matrix = _fibCaesarFilter_GetInsertionStage(fib, vector);
+    uint64_t *ports = bitmap_GetWords(vector);
+    size_t numWords = MIN(fib->numWords, bitmap_GetWordCount(vector));
+    for (int i = 0; i < matrix->k; i++) {
+        uint64_t *row = matrix->rows + bloom_HashIndex(h1, h2, i, matrix->m) * fib->numWords;
+        for (size_t w = 0; w < numWords; w++) {
+            row[w] |= w == fib->numWords - 1 ? ports[w] & fib->lastWordMask : ports[w];
+        }
+    }
+
+    return true;
+}
+
+bool
+fibCaesarFilter_Remove(FIBCaesarFilter *fib, const Name *name, Bitmap *vector)
+{
+    // Neither Bloom blocks nor the port matrix can forget a name
+    if (fib->ports == NULL) {
+        return false;
+    }
+
+    PARCBuffer *key = name_GetWireFormat(name, name_GetSegmentCount(name));
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _fibCaesarFilter_HashKey(fib, name, key, &h1, &h2);
+    parcBuffer_Release(&key);
+
+    bool isRemoved = false;
     for (int i = 0; i < fib->numPorts; i++) {
         if (bitmap_Get(vector, i)) {
-            if (name_IsHashed(name)) {
-                bloom_AddHashed(fib->portFilters[i], key);
-            } else {
-                bloom_Add(fib->portFilters[i], key);
-            }
+            isRemoved |= cuckooFilter_RemoveHashPairWithPayload(fib->ports, h1, h2, (uint16_t) i);
         }
     }
-    parcBuffer_Release(&key);
 
-    return true;
+    // The prefix filter holds the name once, so it stays until the name has no ports left
+    if (cuckooFilter_ForEachPayload(fib->ports, h1, h2, _fibCaesarFilter_IgnorePort, NULL) == 0) {
+        isRemoved |= prefixBloomFilter_Remove(fib->pbf, name);
+    }
+    return isRemoved;
 }
 
 FIBInterface *CaesarFilterFIBAsFIB = &(FIBInterface) {
         .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibCaesarFilter_LPM,
         .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibCaesarFilter_Insert,
         .Destroy = (void (*)(void **instance)) fibCaesarFilter_Destroy,
+        .CallerOwnsResults = true,
 };
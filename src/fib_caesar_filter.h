@@ -6,18 +6,30 @@ extern "C" {
 #define fib_caesar_filter_h
 
 #include "fib.h"
+#include "cuckoo_filter.h"
 
 struct fib_caesar_filter;
 typedef struct fib_caesar_filter FIBCaesarFilter;
 
 FIBCaesarFilter *fibCaesarFilter_Create(int numPorts, int b, int m, int k);
 
+FIBCaesarFilter *fibCaesarFilter_CreateOptimal(int numPorts, int expectedEntries, double targetFPR);
+
+// With FilterType_Cuckoo, the prefix filter has cuckoo blocks, and the per-port filters are
+// replaced by one cuckoo filter whose fingerprints carry the port (at most 65536 ports)
+FIBCaesarFilter *fibCaesarFilter_CreateOptimalWithFilter(int numPorts, int expectedEntries, double targetFPR, FilterType type);
+
 void fibCaesarFilter_Destroy(FIBCaesarFilter **fibP);
 
 extern FIBInterface *CaesarFilterFIBAsFIB;
 
 bool fibCaesarFilter_Insert(FIBCaesarFilter *fib, const Name *name, Bitmap *vector);
 
+// Take the ports of vector away from name, and forget name once it has no ports left. Each
+// (name, port) pair is stored once, however often it was inserted. Only a FIB created with
+// FilterType_Cuckoo can: returns false for Bloom filters, or if nothing was found to remove.
+bool fibCaesarFilter_Remove(FIBCaesarFilter *fib, const Name *name, Bitmap *vector);
+
 Bitmap *fibCaesarFilter_LPM(FIBCaesarFilter *fib, const Name *name);
 
 #endif
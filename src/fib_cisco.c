@@ -2,18 +2,65 @@
 
 #include "fib_cisco.h"
 #include "map.h"
+#include "parallel.h"
+#include "perfect_map.h"
 
-typedef struct {
+#include <stdint.h>
+
+// One in every FIBCiscoQuerySampleInterval lookups records its name length
+const int FIBCiscoQuerySampleInterval = 16;
+
+// Sampled query lengths beyond this are counted as this length
+const int FIBCiscoMaxSampledLength = 64;
+
+// The probes per lookup worth saving to add one virtual entry per real prefix, when choosing M
+const double FIBCiscoVirtualEntryCost = 0.5;
+
+typedef struct _fib_cisco_entry {
     bool isVirtual;
+    int length;
     int maxDepth;
-    PARCBuffer *buffer;
     Bitmap *vector;
+
+    // Real entries keep their key, since raw keys are only filed by digest, so that the table
+    // can be rebuilt for a different M
+    PARCBuffer *buffer;
+
+    // Virtual M-segment entries point at their longest real ancestor, which inserts keep up to date,
+    // so a lookup never re-probes lengths at or below M
+    struct _fib_cisco_entry *ancestor;
+
+    // Virtual entries shorter than M list the virtual M-segment entries below them,
+    // whose ancestor a prefix inserted here becomes
+    int numDescendants;
+    int descendantCapacity;
+    struct _fib_cisco_entry **descendants;
 } _FIBCiscoEntry;
 
 struct fib_cisco {
     int M;
     int numMaps;
     Map **maps;
+
+    // Number of hash table probes issued by lookups
+    uint64_t numProbes;
+
+    // Optional pre-filter of the real prefix lengths worth probing
+    PrefixLengthFilter *lengthFilter;
+
+    // Perfect-hash copies of the first numFrozen maps, probed instead of them until the next insert
+    int numFrozen;
+    PerfectMap **frozen;
+
+    // Number of real entries, and whether their keys are hashed names
+    int numRealEntries;
+    bool isHashed;
+
+    // prefixHistogram[i] counts real prefixes with i + 1 segments (sized numMaps),
+    // queryHistogram[i] counts sampled lookups for names with i + 1 segments
+    uint64_t *prefixHistogram;
+    uint64_t *queryHistogram;
+    uint64_t numLookups;
 };
 
 static void
@@ -24,36 +71,47 @@ _fibCisco_DeleteEntry(_FIBCiscoEntry **entryP)
     if (entry->buffer != NULL) {
         parcBuffer_Release(&entry->buffer);
     }
+    free(entry->descendants);
     free(entry);
     *entryP = NULL;
 }
 
 static _FIBCiscoEntry *
-_fibCisco_CreateVirtualEntry(int depth)
+_fibCisco_CreateVirtualEntry(int length, int depth)
 {
-    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) malloc(sizeof(_FIBCiscoEntry));
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) calloc(1, sizeof(_FIBCiscoEntry));
     if (entry != NULL) {
         entry->isVirtual = true;
+        entry->length = length;
         entry->maxDepth = depth;
-        entry->vector = NULL;
-        entry->buffer = NULL;
     }
     return entry;
 }
 
 static _FIBCiscoEntry *
-_fibCisco_CreateEntry(Bitmap *vector, PARCBuffer *buffer, int depth)
+_fibCisco_CreateEntry(Bitmap *vector, PARCBuffer *buffer, int length, int depth)
 {
-    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) malloc(sizeof(_FIBCiscoEntry));
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) calloc(1, sizeof(_FIBCiscoEntry));
     if (entry != NULL) {
         entry->isVirtual = false;
+        entry->length = length;
         entry->maxDepth = depth;
         entry->vector = vector;
-        entry->buffer = parcBuffer_Acquire(buffer);
+        entry->buffer = parcBuffer_Copy(buffer);
     }
     return entry;
 }
 
+static void
+_fibCisco_AddDescendant(_FIBCiscoEntry *entry, _FIBCiscoEntry *descendant)
+{
+    if (entry->numDescendants == entry->descendantCapacity) {
+        entry->descendantCapacity = entry->descendantCapacity == 0 ? 4 : 2 * entry->descendantCapacity;
+        entry->descendants = (_FIBCiscoEntry **) realloc(entry->descendants, entry->descendantCapacity * sizeof(_FIBCiscoEntry *));
+    }
+    entry->descendants[entry->numDescendants++] = descendant;
+}
+
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
@@ -68,7 +126,13 @@ _lookupNamePrefix(FIBCisco *fib, const Name *prefix, int numSegments)
 {
     PARCBuffer *buffer = _computeNameBuffer(fib, prefix, numSegments);
     _FIBCiscoEntry *entry = NULL;
-    if (name_IsHashed(prefix)) {
+    if (fib->frozen != NULL) {
+        if (name_IsHashed(prefix)) {
+            entry = perfectMap_GetHashed(fib->frozen[numSegments - 1], buffer);
+        } else {
+            entry = perfectMap_Get(fib->frozen[numSegments - 1], buffer);
+        }
+    } else if (name_IsHashed(prefix)) {
         entry = map_GetHashed(fib->maps[numSegments - 1], buffer);
     } else {
         entry = map_Get(fib->maps[numSegments - 1], buffer);
@@ -77,62 +141,115 @@ _lookupNamePrefix(FIBCisco *fib, const Name *prefix, int numSegments)
     return entry;
 }
 
+// The key a prefix of name is filed under. Hashed keys are stored as they are, so they are copied
+// out of the name, which the table does not hold on to.
+static PARCBuffer *
+_computeNameKey(FIBCisco *fib, const Name *prefix, int numSegments)
+{
+    PARCBuffer *buffer = _computeNameBuffer(fib, prefix, numSegments);
+    if (name_IsHashed(prefix)) {
+        PARCBuffer *key = parcBuffer_Copy(buffer);
+        parcBuffer_Release(&buffer);
+        return key;
+    }
+    return buffer;
+}
+
 static void
 _insertNamePrefix(FIBCisco *fib, const Name *prefix, int numSegments, _FIBCiscoEntry *entry)
 {
-    PARCBuffer *buffer = _computeNameBuffer(fib, prefix, numSegments);
+    // Real entries are filed under their own copy of the key
+    PARCBuffer *key = entry->buffer != NULL ? parcBuffer_Acquire(entry->buffer) : _computeNameKey(fib, prefix, numSegments);
     if (name_IsHashed(prefix)) {
-        map_InsertHashed(fib->maps[numSegments - 1], buffer, entry);
+        map_InsertHashed(fib->maps[numSegments - 1], key, entry);
     } else {
-        map_Insert(fib->maps[numSegments - 1], buffer, entry);
+        map_Insert(fib->maps[numSegments - 1], key, entry);
     }
-    parcBuffer_Release(&buffer);
+    parcBuffer_Release(&key);
 }
 
-Bitmap *
-fibCisco_LPM(FIBCisco *fib, const Name *name)
+// Return the longest real entry for a prefix of name with at most fromLength segments
+static _FIBCiscoEntry *
+_fibCisco_FindRealEntry(FIBCisco *fib, const Name *name, int fromLength, uint64_t candidates, uint64_t *numProbes)
+{
+    for (int i = MIN(fromLength, fib->numMaps); i > 0; i--) {
+        if (!prefixLengthFilter_IsCandidate(candidates, i)) {
+            continue;
+        }
+        (*numProbes)++;
+        _FIBCiscoEntry *entry = _lookupNamePrefix(fib, name, i);
+        if (entry != NULL && !entry->isVirtual) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static _FIBCiscoEntry *
+_fibCisco_Lookup(FIBCisco *fib, const Name *name, uint64_t candidates, uint64_t *numProbes)
 {
     int numSegments = name_GetSegmentCount(name);
 
-    // prefixCount = min(numSegments, M)
-    int prefixCount = MIN(MIN(fib->M, numSegments), fib->numMaps);
-    int startPrefix = MIN(numSegments, fib->numMaps);
+    // Short names, or tables that never reached M segments, are a plain descending search
+    if (numSegments < fib->M || fib->numMaps < fib->M) {
+        return _fibCisco_FindRealEntry(fib, name, numSegments, candidates, numProbes);
+    }
 
-    _FIBCiscoEntry *firstEntryMatch = NULL;
-    for (int i = prefixCount; i > 0; i--) {
-        _FIBCiscoEntry *entry = _lookupNamePrefix(fib, name, i); 
+    // Stage one: probe the M-segment prefix. A miss means no longer prefix exists either.
+    // Without a candidate of at least M segments, a (virtual) hit could only lead to a shorter prefix.
+    _FIBCiscoEntry *entryM = NULL;
+    if (prefixLengthFilter_HasCandidate(candidates, fib->M, numSegments)) {
+        (*numProbes)++;
+        entryM = _lookupNamePrefix(fib, name, fib->M);
+    }
+    if (entryM == NULL) {
+        return _fibCisco_FindRealEntry(fib, name, fib->M - 1, candidates, numProbes);
+    }
 
-        if (entry != NULL) {
-            if (entry->maxDepth > fib->M && numSegments > fib->M) {
-                startPrefix = MIN(numSegments, entry->maxDepth); 
-                firstEntryMatch = entry;
-                break;
-            } else if (!entry->isVirtual) {
-                return entry->vector;
-            } 
+    // Stage two: probe downward from the deepest possible match to M + 1,
+    // then fall back to the M-level entry (or its ancestor) without re-probing
+    int startPrefix = MIN(MIN(numSegments, entryM->maxDepth), fib->numMaps);
+    for (int i = startPrefix; i > fib->M; i--) {
+        if (!prefixLengthFilter_IsCandidate(candidates, i)) {
+            continue;
+        }
+        (*numProbes)++;
+        _FIBCiscoEntry *entry = _lookupNamePrefix(fib, name, i);
+        if (entry != NULL && !entry->isVirtual) {
+            return entry;
         }
     }
 
-    if (firstEntryMatch == NULL) {
-        return NULL;
-    }
+    return entryM->isVirtual ? entryM->ancestor : entryM;
+}
 
-    _FIBCiscoEntry *entry = NULL;
-    for (int i = startPrefix; i >= 1; i--) {
-        if (startPrefix == fib->M) {
-            entry = firstEntryMatch;
-            if (!entry->isVirtual) {
-                return entry->vector;
-            }
-        }
+Bitmap *
+fibCisco_LPM(FIBCisco *fib, const Name *name)
+{
+    int numSegments = name_GetSegmentCount(name);
 
-        _FIBCiscoEntry *targetEntry = _lookupNamePrefix(fib, name, i); 
-        if (targetEntry != NULL && !targetEntry->isVirtual) {
-            return targetEntry->vector;
-        } 
+    // Lookups never modify the table, so concurrent ones only share these counters
+    uint64_t numLookups = __atomic_add_fetch(&fib->numLookups, 1, __ATOMIC_RELAXED);
+    if ((numLookups % FIBCiscoQuerySampleInterval) == 0 && numSegments > 0) {
+        __atomic_fetch_add(&fib->queryHistogram[MIN(numSegments, FIBCiscoMaxSampledLength) - 1], 1, __ATOMIC_RELAXED);
     }
 
-    return NULL;
+    uint64_t candidates = PrefixLengthFilterAllLengths;
+    if (fib->lengthFilter != NULL) {
+        candidates = prefixLengthFilter_Candidates(fib->lengthFilter, name);
+    }
+
+    uint64_t numProbes = 0;
+    _FIBCiscoEntry *entry = _fibCisco_Lookup(fib, name, candidates, &numProbes);
+    __atomic_fetch_add(&fib->numProbes, numProbes, __ATOMIC_RELAXED);
+
+    return entry == NULL ? NULL : entry->vector;
+}
+
+uint64_t
+fibCisco_GetNumProbes(FIBCisco *fib)
+{
+    return fib->numProbes;
 }
 
 static Map *
@@ -146,16 +263,124 @@ _fibCisco_ExpandMapsToSize(FIBCisco *fib, int number)
 {
     if (fib->numMaps <= number) {
         fib->maps = (Map **) realloc(fib->maps, (number + 1) * (sizeof(Map *)));
+        fib->prefixHistogram = (uint64_t *) realloc(fib->prefixHistogram, (number + 1) * sizeof(uint64_t));
         for (size_t i = fib->numMaps; i < number; i++) {
             fib->maps[i] = _fibCisco_CreateMap();
+            fib->prefixHistogram[i] = 0;
         }
         fib->numMaps = number;
     }
 }
 
+// A real prefix shorter than M becomes the ancestor of the virtual M-segment entries below it,
+// unless they already have a longer one
+static void
+_fibCisco_AdoptDescendants(_FIBCiscoEntry *entry)
+{
+    for (int i = 0; i < entry->numDescendants; i++) {
+        _FIBCiscoEntry *descendant = entry->descendants[i];
+        if (descendant->ancestor == NULL || descendant->ancestor->length < entry->length) {
+            descendant->ancestor = entry;
+        }
+    }
+
+    // Real entries are never replaced, so the list is done with
+    free(entry->descendants);
+    entry->descendants = NULL;
+    entry->numDescendants = 0;
+    entry->descendantCapacity = 0;
+}
+
+static void
+_fibCisco_AddRealEntry(FIBCisco *fib, _FIBCiscoEntry *entry, const Name *name)
+{
+    if (entry->isVirtual) {
+        PARCBuffer *buffer = _computeNameBuffer(fib, name, entry->length);
+        entry->buffer = parcBuffer_Copy(buffer);
+        parcBuffer_Release(&buffer);
+        entry->isVirtual = false;
+    }
+    _fibCisco_AdoptDescendants(entry);
+
+    fib->numRealEntries++;
+    fib->isHashed = name_IsHashed(name);
+    fib->prefixHistogram[name_GetSegmentCount(name) - 1]++;
+
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Add(fib->lengthFilter, name);
+    }
+}
+
+static void
+_fibCisco_Thaw(FIBCisco *fib)
+{
+    if (fib->frozen != NULL) {
+        for (int i = 0; i < fib->numFrozen; i++) {
+            perfectMap_Destroy(&fib->frozen[i]);
+        }
+        free(fib->frozen);
+        fib->frozen = NULL;
+        fib->numFrozen = 0;
+    }
+}
+
+void
+fibCisco_Freeze(FIBCisco *fib)
+{
+    _fibCisco_Thaw(fib);
+    fib->frozen = (PerfectMap **) malloc(fib->numMaps * sizeof(PerfectMap *));
+    for (int i = 0; i < fib->numMaps; i++) {
+        fib->frozen[i] = perfectMap_CreateFromMap(fib->maps[i], PerfectMapDefaultGamma);
+    }
+    fib->numFrozen = fib->numMaps;
+}
+
+bool
+fibCisco_IsFrozen(FIBCisco *fib)
+{
+    return fib->frozen != NULL;
+}
+
+double
+fibCisco_GetFrozenBitsPerKey(FIBCisco *fib)
+{
+    double bits = 0.0;
+    size_t count = 0;
+    for (int i = 0; i < fib->numFrozen; i++) {
+        bits += perfectMap_GetBitsPerKey(fib->frozen[i]) * perfectMap_GetCount(fib->frozen[i]);
+        count += perfectMap_GetCount(fib->frozen[i]);
+    }
+    return count > 0 ? bits / count : 0.0;
+}
+
+// Point a new virtual M-segment entry at the longest real prefix of name shorter than M, and file it
+// under the virtual entries (created if needed) of every other prefix shorter than M, where an
+// insert may later provide a longer ancestor. A table thus holds one virtual entry for each prefix
+// of at most M segments that was not inserted but is extended by one longer than M.
+static void
+_fibCisco_LinkVirtualEntry(FIBCisco *fib, const Name *name, _FIBCiscoEntry *virtualEntry)
+{
+    for (int i = fib->M - 1; i > 0; i--) {
+        _FIBCiscoEntry *entry = _lookupNamePrefix(fib, name, i);
+        if (entry == NULL) {
+            entry = _fibCisco_CreateVirtualEntry(i, virtualEntry->maxDepth);
+            _insertNamePrefix(fib, name, i, entry);
+        }
+        if (!entry->isVirtual) {
+            if (virtualEntry->ancestor == NULL) {
+                virtualEntry->ancestor = entry;
+            }
+        } else {
+            _fibCisco_AddDescendant(entry, virtualEntry);
+        }
+    }
+}
+
 bool
 fibCisco_Insert(FIBCisco *fib, const Name *name, Bitmap *vector)
 {
+    _fibCisco_Thaw(fib);
+
     size_t numSegments = name_GetSegmentCount(name);
     _fibCisco_ExpandMapsToSize(fib, numSegments);
 
@@ -167,8 +392,9 @@ fibCisco_Insert(FIBCisco *fib, const Name *name, Bitmap *vector)
         _FIBCiscoEntry *entry = _lookupNamePrefix(fib, name, fib->M); 
 
         if (entry == NULL) {
-            entry = _fibCisco_CreateVirtualEntry(maximumDepth);
+            entry = _fibCisco_CreateVirtualEntry(fib->M, maximumDepth);
             _insertNamePrefix(fib, name, fib->M, entry);
+            _fibCisco_LinkVirtualEntry(fib, name, entry);
         } else if (entry->maxDepth < maximumDepth) {
             entry->maxDepth = MAX(entry->maxDepth, maximumDepth);
         }
@@ -182,14 +408,12 @@ fibCisco_Insert(FIBCisco *fib, const Name *name, Bitmap *vector)
         }
     }
 
-    PARCBuffer *buffer = _computeNameBuffer(fib, name, numSegments);
-    _FIBCiscoEntry *entry = _fibCisco_CreateEntry(vector, buffer, maximumDepth);
-    parcBuffer_Release(&buffer);
-
     // If there is an existing entry, make sure it's *NOT* virtual and update its MD if necessary
     _FIBCiscoEntry *existingEntry = _lookupNamePrefix(fib, name, numSegments);
     if (existingEntry != NULL) {
-        existingEntry->isVirtual = false;
+        if (existingEntry->isVirtual) {
+            _fibCisco_AddRealEntry(fib, existingEntry, name);
+        }
         existingEntry->maxDepth = MAX(numSegments, existingEntry->maxDepth);
         if (existingEntry->vector == NULL) {
             existingEntry->vector = vector;
@@ -197,21 +421,268 @@ fibCisco_Insert(FIBCisco *fib, const Name *name, Bitmap *vector)
             bitmap_SetVector(existingEntry->vector, vector);
         }
     } else {
+        PARCBuffer *buffer = _computeNameBuffer(fib, name, numSegments);
+        _FIBCiscoEntry *entry = _fibCisco_CreateEntry(vector, buffer, numSegments, maximumDepth);
+        parcBuffer_Release(&buffer);
         _insertNamePrefix(fib, name, numSegments, entry);
+        _fibCisco_AddRealEntry(fib, entry, name);
     }
 
     return false;
 }
 
+typedef struct {
+    Name **names;
+    Bitmap **vectors;
+    const size_t *group;
+    int length;
+    PARCBuffer **keys;
+    void **entries;
+} _FIBCiscoBulkGroup;
+
+static void
+_fibCisco_CreateBulkEntry(void *context, size_t i)
+{
+    _FIBCiscoBulkGroup *group = (_FIBCiscoBulkGroup *) context;
+    const Name *name = group->names[group->group[i]];
+
+    PARCBuffer *buffer = name_GetWireFormat(name, group->length);
+    _FIBCiscoEntry *entry = _fibCisco_CreateEntry(group->vectors[group->group[i]], buffer, group->length, group->length);
+    parcBuffer_Release(&buffer);
+
+    group->keys[i] = parcBuffer_Acquire(entry->buffer);
+    group->entries[i] = entry;
+}
+
+static void
+_fibCisco_MergeRealEntry(void *existing, void *item)
+{
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) existing;
+    bitmap_SetVector(entry->vector, ((_FIBCiscoEntry *) item)->vector);
+}
+
+static void
+_fibCisco_MergeMaxDepth(void *existing, void *item)
+{
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) existing;
+    entry->maxDepth = MAX(entry->maxDepth, ((_FIBCiscoEntry *) item)->maxDepth);
+}
+
+static void
+_fibCisco_UpdateMaxDepth(void *existing, void *depth)
+{
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) existing;
+    entry->maxDepth = MAX(entry->maxDepth, (int) (intptr_t) depth);
+}
+
+// Drop the batch items that were merged into an entry already in the table
+static void
+_fibCisco_ReleaseMerged(size_t count, void *items[count], void *results[count])
+{
+    for (size_t i = 0; i < count; i++) {
+        if (results[i] != items[i]) {
+            _FIBCiscoEntry *entry = (_FIBCiscoEntry *) items[i];
+            _fibCisco_DeleteEntry(&entry);
+        }
+    }
+}
+
+bool
+fibCisco_BulkLoad(FIBCisco *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    _fibCisco_Thaw(fib);
+
+    // Real entries are converted from virtual ones one at a time, so only a fresh table is built in bulk
+    if (fib->numRealEntries > 0) {
+        for (size_t i = 0; i < n; i++) {
+            fibCisco_Insert(fib, names[i], vectors[i]);
+        }
+        return true;
+    }
+
+    size_t *order = NULL;
+    size_t *starts = NULL;
+    int maxLength = fib_GroupByLength(names, n, &order, &starts);
+    _fibCisco_ExpandMapsToSize(fib, maxLength);
+
+    size_t capacity = n > 0 ? n : 1;
+    PARCBuffer **keys = (PARCBuffer **) malloc(capacity * sizeof(PARCBuffer *));
+    void **items = (void **) malloc(capacity * sizeof(void *));
+    void **results = (void **) malloc(capacity * sizeof(void *));
+
+    // 1. The real entries of each length, with repeated names merged
+    for (int length = 1; length <= maxLength; length++) {
+        size_t count = starts[length] - starts[length - 1];
+        if (count == 0) {
+            continue;
+        }
+
+        _FIBCiscoBulkGroup group = {
+                .names = names,
+                .vectors = vectors,
+                .group = order + starts[length - 1],
+                .length = length,
+                .keys = keys,
+                .entries = items,
+        };
+        parallel_For(threads, count, _fibCisco_CreateBulkEntry, &group);
+
+        fib->isHashed = name_IsHashed(names[group.group[0]]);
+        map_BulkInsert(fib->maps[length - 1], count, keys, items, fib->isHashed,
+                       _fibCisco_MergeRealEntry, results, threads);
+        _fibCisco_ReleaseMerged(count, items, results);
+
+        for (size_t i = 0; i < count; i++) {
+            if (results[i] == items[i]) {
+                fib->numRealEntries++;
+                fib->prefixHistogram[length - 1]++;
+                if (fib->lengthFilter != NULL) {
+                    prefixLengthFilter_Add(fib->lengthFilter, names[group.group[i]]);
+                }
+            }
+            parcBuffer_Release(&keys[i]);
+        }
+    }
+
+    // 2. Virtual M-segment entries for longer names, or a deeper MD on the entry already there.
+    // The new ones are linked to their ancestors, which are all in the table by now.
+    size_t numLong = starts[maxLength] - (fib->M <= maxLength ? starts[fib->M] : starts[maxLength]);
+    if (numLong > 0) {
+        const size_t *group = order + starts[fib->M];
+        for (size_t i = 0; i < numLong; i++) {
+            const Name *name = names[group[i]];
+            keys[i] = _computeNameKey(fib, name, fib->M);
+            items[i] = _fibCisco_CreateVirtualEntry(fib->M, name_GetSegmentCount(name));
+        }
+        map_BulkInsert(fib->maps[fib->M - 1], numLong, keys, items, name_IsHashed(names[group[0]]),
+                       _fibCisco_MergeMaxDepth, results, threads);
+        _fibCisco_ReleaseMerged(numLong, items, results);
+        for (size_t i = 0; i < numLong; i++) {
+            if (results[i] == items[i]) {
+                _fibCisco_LinkVirtualEntry(fib, names[group[i]], (_FIBCiscoEntry *) items[i]);
+            }
+            parcBuffer_Release(&keys[i]);
+        }
+    }
+
+    // 3. The MD of every shorter prefix that is in the table covers the longest name below it
+    for (int length = 1; length < maxLength; length++) {
+        size_t count = starts[maxLength] - starts[length];
+        const size_t *group = order + starts[length];
+        for (size_t i = 0; i < count; i++) {
+            const Name *name = names[group[i]];
+            keys[i] = _computeNameBuffer(fib, name, length);
+            items[i] = (void *) (intptr_t) name_GetSegmentCount(name);
+        }
+        map_BulkUpdate(fib->maps[length - 1], count, keys, items, name_IsHashed(names[group[0]]),
+                       _fibCisco_UpdateMaxDepth, threads);
+        for (size_t i = 0; i < count; i++) {
+            parcBuffer_Release(&keys[i]);
+        }
+    }
+
+    free(results);
+    free(items);
+    free(keys);
+    free(starts);
+    free(order);
+    return true;
+}
+
+typedef struct {
+    int count;
+    _FIBCiscoEntry **entries;
+} _FIBCiscoEntryList;
+
+static void
+_fibCisco_CollectRealEntry(void *context, PARCBuffer *storedKey, void *item)
+{
+    _FIBCiscoEntryList *list = (_FIBCiscoEntryList *) context;
+    _FIBCiscoEntry *entry = (_FIBCiscoEntry *) item;
+    if (!entry->isVirtual) {
+        list->entries[list->count++] = entry;
+    }
+}
+
+// Every real entry in the tables, fib->numRealEntries of them
+static _FIBCiscoEntry **
+_fibCisco_CollectRealEntries(FIBCisco *fib)
+{
+    _FIBCiscoEntryList list = {
+            .count = 0,
+            .entries = (_FIBCiscoEntry **) malloc(MAX(fib->numRealEntries, 1) * sizeof(_FIBCiscoEntry *)),
+    };
+    for (int i = 0; i < fib->numMaps; i++) {
+        map_ForEach(fib->maps[i], _fibCisco_CollectRealEntry, &list);
+    }
+    return list.entries;
+}
+
+// The prefix a real entry was inserted for, read back from its key
+static Name *
+_fibCisco_CreateEntryName(FIBCisco *fib, _FIBCiscoEntry *entry)
+{
+    if (fib->isHashed) {
+        return name_CreateFromHashedBuffer(entry->buffer, entry->length);
+    }
+    return name_CreateFromBuffer(entry->buffer);
+}
+
+void
+fibCisco_SetLengthFilter(FIBCisco *fib, PrefixLengthFilter *filter)
+{
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Destroy(&fib->lengthFilter);
+    }
+    fib->lengthFilter = filter;
+
+    // Add the prefixes inserted so far, read back from their keys
+    if (filter != NULL && fib->numRealEntries > 0) {
+        _FIBCiscoEntry **entries = _fibCisco_CollectRealEntries(fib);
+        for (int i = 0; i < fib->numRealEntries; i++) {
+            Name *name = _fibCisco_CreateEntryName(fib, entries[i]);
+            prefixLengthFilter_Add(filter, name);
+            name_Destroy(&name);
+        }
+        free(entries);
+    }
+}
+
+static void
+_fibCisco_DestroyMaps(int numMaps, Map **maps)
+{
+    for (int i = 0; i < numMaps; i++) {
+        map_Destroy(&maps[i]);
+    }
+    free(maps);
+}
+
+static void
+_fibCisco_InitializeTable(FIBCisco *fib, int M)
+{
+    fib->M = M;
+    fib->maps = (Map **) malloc(sizeof(Map *));
+    fib->numMaps = 1;
+    fib->maps[0] = _fibCisco_CreateMap();
+    fib->numFrozen = 0;
+    fib->frozen = NULL;
+
+    fib->numRealEntries = 0;
+    fib->prefixHistogram = (uint64_t *) calloc(1, sizeof(uint64_t));
+}
+
 void
 fibCisco_Destroy(FIBCisco **fibP)
 {
     FIBCisco *fib = *fibP;
 
-    for (int i = 0; i < fib->numMaps; i++) {
-        map_Destroy(&fib->maps[i]);
+    _fibCisco_Thaw(fib);
+    _fibCisco_DestroyMaps(fib->numMaps, fib->maps);
+    free(fib->prefixHistogram);
+    free(fib->queryHistogram);
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Destroy(&fib->lengthFilter);
     }
-    free(fib->maps);
 
     free(fib);
     *fibP = NULL;
@@ -222,17 +693,267 @@ fibCisco_Create(int M)
 {
     FIBCisco *native = (FIBCisco *) malloc(sizeof(FIBCisco));
     if (native != NULL) {
-        native->M = M;
-        native->maps = (Map **) malloc(sizeof(Map *));
-        native->numMaps = 1;
-        native->maps[0] = _fibCisco_CreateMap();
+        _fibCisco_InitializeTable(native, M);
+        native->numProbes = 0;
+        native->isHashed = false;
+        native->lengthFilter = NULL;
+        native->numLookups = 0;
+        native->queryHistogram = (uint64_t *) calloc(FIBCiscoMaxSampledLength, sizeof(uint64_t));
     }
 
     return native;
 }
 
+int
+fibCisco_GetM(FIBCisco *fib)
+{
+    return fib->M;
+}
+
+int
+fibCisco_GetMaxPrefixLength(FIBCisco *fib)
+{
+    return fib->numMaps;
+}
+
+uint64_t
+fibCisco_GetPrefixLengthCount(FIBCisco *fib, int length)
+{
+    if (length < 1 || length > fib->numMaps) {
+        return 0;
+    }
+    return fib->prefixHistogram[length - 1];
+}
+
+double
+fibCisco_ExpectedProbes(FIBCisco *fib, int M, int numLengths, const double queryDistribution[])
+{
+    int L = fib->numMaps;
+
+    // Model the table by its prefix-length histogram: a query's M-prefix is assumed present with
+    // the probability mass of prefixes at least M long, whose mean length bounds the MD of the M-level entry.
+    double total = 0.0;
+    double tailMass = 0.0;
+    double tailDepth = 0.0;
+    for (int l = 1; l <= L; l++) {
+        total += fib->prefixHistogram[l - 1];
+        if (l >= M) {
+            tailMass += fib->prefixHistogram[l - 1];
+            tailDepth += (double) l * fib->prefixHistogram[l - 1];
+        }
+    }
+    double hitProbability = total > 0 ? tailMass / total : 0.0;
+    double meanDepth = tailMass > 0 ? tailDepth / tailMass : M;
+
+    double probes = 0.0;
+    double weight = 0.0;
+    for (int i = 0; i < numLengths; i++) {
+        if (queryDistribution[i] <= 0) {
+            continue;
+        }
+
+        // Lengths past the deepest table prefix are probed like the deepest one
+        int n = MIN(i + 1, L);
+        double cost = 0.0;
+        if (n < M) {
+            cost = n;
+        } else {
+            double deep = MIN((double) n, meanDepth);
+            cost = 1.0 + hitProbability * MAX(0.0, deep - M) + (1.0 - hitProbability) * (M - 1);
+        }
+        probes += queryDistribution[i] * cost;
+        weight += queryDistribution[i];
+    }
+
+    return weight > 0 ? probes / weight : 0.0;
+}
+
+typedef struct {
+    int maxDepth;
+    bool isReal;
+} _FIBCiscoPrefix;
+
+static void
+_fibCisco_DeletePrefix(void **prefixP)
+{
+    free(*prefixP);
+    *prefixP = NULL;
+}
+
+static void
+_fibCisco_CountVirtualPrefix(void *context, PARCBuffer *storedKey, void *item)
+{
+    uint64_t *byDepth = (uint64_t *) context;
+    _FIBCiscoPrefix *prefix = (_FIBCiscoPrefix *) item;
+    if (!prefix->isReal) {
+        byDepth[prefix->maxDepth - 1]++;
+    }
+}
+
+// Fill virtualEntries[M - 1] with the number of virtual entries a table with M holds, for each M
+// up to the longest prefix, from the distinct prefixes of the real entries' keys
+static void
+_fibCisco_CountVirtualEntries(FIBCisco *fib, uint64_t virtualEntries[])
+{
+    int L = fib->numMaps;
+    int numEntries = fib->numRealEntries;
+    _FIBCiscoEntry **entries = _fibCisco_CollectRealEntries(fib);
+    Name **names = (Name **) malloc(MAX(numEntries, 1) * sizeof(Name *));
+    for (int i = 0; i < numEntries; i++) {
+        names[i] = _fibCisco_CreateEntryName(fib, entries[i]);
+    }
+
+    // byDepth[(l - 1) * L + D - 1] counts the l-segment prefixes that were not inserted,
+    // whose longest extension has D segments
+    uint64_t *byDepth = (uint64_t *) calloc(L * L, sizeof(uint64_t));
+    for (int l = 1; l <= L; l++) {
+        Map *prefixes = map_Create(_fibCisco_DeletePrefix);
+        for (int i = 0; i < numEntries; i++) {
+            int length = name_GetSegmentCount(names[i]);
+            if (length < l) {
+                continue;
+            }
+
+            PARCBuffer *key = name_GetWireFormat(names[i], l);
+            _FIBCiscoPrefix *prefix = fib->isHashed ? map_GetHashed(prefixes, key) : map_Get(prefixes, key);
+            if (prefix == NULL) {
+                prefix = (_FIBCiscoPrefix *) calloc(1, sizeof(_FIBCiscoPrefix));
+                if (fib->isHashed) {
+                    map_InsertHashed(prefixes, key, prefix);
+                } else {
+                    map_Insert(prefixes, key, prefix);
+                }
+            }
+            prefix->maxDepth = MAX(prefix->maxDepth, length);
+            prefix->isReal |= length == l;
+            parcBuffer_Release(&key);
+        }
+        map_ForEach(prefixes, _fibCisco_CountVirtualPrefix, byDepth + (l - 1) * L);
+        map_Destroy(&prefixes);
+    }
+
+    for (int M = 1; M <= L; M++) {
+        virtualEntries[M - 1] = 0;
+        for (int l = 1; l <= M; l++) {
+            for (int D = M + 1; D <= L; D++) {
+                virtualEntries[M - 1] += byDepth[(l - 1) * L + D - 1];
+            }
+        }
+    }
+
+    for (int i = 0; i < numEntries; i++) {
+        name_Destroy(&names[i]);
+    }
+    free(byDepth);
+    free(names);
+    free(entries);
+}
+
+uint64_t
+fibCisco_CountVirtualEntries(FIBCisco *fib, int M)
+{
+    if (M < 1 || M > fib->numMaps) {
+        return 0;
+    }
+
+    uint64_t *virtualEntries = (uint64_t *) malloc(fib->numMaps * sizeof(uint64_t));
+    _fibCisco_CountVirtualEntries(fib, virtualEntries);
+    uint64_t count = virtualEntries[M - 1];
+    free(virtualEntries);
+    return count;
+}
+
+// Expected probes per lookup, plus the cost of the virtual entries per real prefix
+static double
+_fibCisco_Cost(FIBCisco *fib, int M, int numLengths, const double queryDistribution[],
+               const uint64_t virtualEntries[])
+{
+    double cost = fibCisco_ExpectedProbes(fib, M, numLengths, queryDistribution);
+    if (M <= fib->numMaps && fib->numRealEntries > 0) {
+        cost += FIBCiscoVirtualEntryCost * virtualEntries[M - 1] / fib->numRealEntries;
+    }
+    return cost;
+}
+
+int
+fibCisco_OptimalM(FIBCisco *fib, int numLengths, const double queryDistribution[])
+{
+    double *distribution = NULL;
+    if (queryDistribution == NULL) {
+        // Use the sampled lookups, or the table's own length distribution before any were sampled
+        uint64_t numSamples = 0;
+        for (int i = 0; i < FIBCiscoMaxSampledLength; i++) {
+            numSamples += fib->queryHistogram[i];
+        }
+
+        numLengths = numSamples > 0 ? FIBCiscoMaxSampledLength : fib->numMaps;
+        distribution = (double *) malloc(numLengths * sizeof(double));
+        for (int i = 0; i < numLengths; i++) {
+            distribution[i] = numSamples > 0 ? fib->queryHistogram[i] : fib->prefixHistogram[i];
+        }
+        queryDistribution = distribution;
+    }
+
+    uint64_t *virtualEntries = (uint64_t *) malloc(fib->numMaps * sizeof(uint64_t));
+    _fibCisco_CountVirtualEntries(fib, virtualEntries);
+
+    int bestM = fib->M;
+    double bestCost = _fibCisco_Cost(fib, bestM, numLengths, queryDistribution, virtualEntries);
+    for (int M = 1; M <= fib->numMaps; M++) {
+        double cost = _fibCisco_Cost(fib, M, numLengths, queryDistribution, virtualEntries);
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestM = M;
+        }
+    }
+
+    free(virtualEntries);
+    free(distribution);
+    return bestM;
+}
+
+void
+fibCisco_Rebuild(FIBCisco *fib, int M)
+{
+    _fibCisco_Thaw(fib);
+
+    int oldNumMaps = fib->numMaps;
+    Map **oldMaps = fib->maps;
+    int numEntries = fib->numRealEntries;
+    _FIBCiscoEntry **entries = _fibCisco_CollectRealEntries(fib);
+    uint64_t *oldHistogram = fib->prefixHistogram;
+
+    // The real prefixes do not depend on M, so the length filter is kept as is
+    PrefixLengthFilter *lengthFilter = fib->lengthFilter;
+    fib->lengthFilter = NULL;
+
+    // Re-insert every real prefix into fresh tables, then drop the old ones (which own the old entries)
+    _fibCisco_InitializeTable(fib, M);
+    for (int i = 0; i < numEntries; i++) {
+        Name *name = _fibCisco_CreateEntryName(fib, entries[i]);
+        fibCisco_Insert(fib, name, entries[i]->vector);
+        name_Destroy(&name);
+    }
+    fib->lengthFilter = lengthFilter;
+
+    _fibCisco_DestroyMaps(oldNumMaps, oldMaps);
+    free(entries);
+    free(oldHistogram);
+}
+
+int
+fibCisco_Tune(FIBCisco *fib)
+{
+    int M = fibCisco_OptimalM(fib, 0, NULL);
+    if (M != fib->M) {
+        fibCisco_Rebuild(fib, M);
+    }
+    return M;
+}
+
 FIBInterface *CiscoFIBAsFIB = &(FIBInterface) {
         .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibCisco_LPM,
         .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibCisco_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibCisco_BulkLoad,
         .Destroy = (void (*)(void **instance)) fibCisco_Destroy,
 };
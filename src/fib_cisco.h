@@ -6,6 +6,7 @@ extern "C" {
 #define fib_cisco_h
 
 #include "fib.h"
+#include "prefix_length_filter.h"
 
 struct fib_cisco;
 typedef struct fib_cisco FIBCisco;
@@ -20,6 +21,53 @@ bool fibCisco_Insert(FIBCisco *fib, const Name *name, Bitmap *vector);
 
 Bitmap *fibCisco_LPM(FIBCisco *fib, const Name *name);
 
+// Build a fresh table from names[i] and vectors[i] on up to threads threads: the real entries
+// of each length, then the virtual M-segment entries and the MDs, each in one bulk insertion.
+// Repeated names are merged. A FIB that already has entries falls back to fibCisco_Insert.
+bool fibCisco_BulkLoad(FIBCisco *fib, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+// Build a minimal perfect hash of every length table and probe it instead, for tables that change
+// rarely. The next insert or rebuild drops the perfect hashes again, until the FIB is frozen anew.
+void fibCisco_Freeze(FIBCisco *fib);
+
+bool fibCisco_IsFrozen(FIBCisco *fib);
+
+// Perfect hash metadata per entry (real or virtual) across the frozen tables, or 0 if not frozen
+double fibCisco_GetFrozenBitsPerKey(FIBCisco *fib);
+
+// Total number of hash table probes issued by fibCisco_LPM
+uint64_t fibCisco_GetNumProbes(FIBCisco *fib);
+
+// Only probe the real prefix lengths the filter reports as candidates. The FIB takes
+// ownership of the filter, and adds the prefixes already inserted to it.
+void fibCisco_SetLengthFilter(FIBCisco *fib, PrefixLengthFilter *filter);
+
+int fibCisco_GetM(FIBCisco *fib);
+
+int fibCisco_GetMaxPrefixLength(FIBCisco *fib);
+
+// Number of inserted prefixes with the given number of segments
+uint64_t fibCisco_GetPrefixLengthCount(FIBCisco *fib, int length);
+
+// Expected probes per lookup for a query length distribution, where queryDistribution[i]
+// weighs names with i + 1 segments, estimated from the loaded prefix-length histogram.
+double fibCisco_ExpectedProbes(FIBCisco *fib, int M, int numLengths, const double queryDistribution[]);
+
+// Number of virtual entries the loaded prefixes would take with the given M: one for each prefix
+// of at most M segments that was not inserted but is extended by a prefix longer than M
+uint64_t fibCisco_CountVirtualEntries(FIBCisco *fib, int M);
+
+// The M minimizing fibCisco_ExpectedProbes plus half a probe for each virtual entry per real
+// prefix. A NULL distribution uses the lengths sampled from lookups, or the prefix-length
+// histogram if there were none.
+int fibCisco_OptimalM(FIBCisco *fib, int numLengths, const double queryDistribution[]);
+
+// Rebuild the table in place for a new M
+void fibCisco_Rebuild(FIBCisco *fib, int M);
+
+// Rebuild with fibCisco_OptimalM(fib, 0, NULL) if it differs from the current M; returns the M in use
+int fibCisco_Tune(FIBCisco *fib);
+
 #endif
 
 #ifdef __cplusplus
@@ -55,7 +55,7 @@ fibMergedFilter_Create(int N, int m, int k) // N and m determine the matrix dime
 {
     FIBMergedFilter *filter = (FIBMergedFilter *) malloc(sizeof(FIBMergedFilter));
     if (filter != NULL) {
-        filter->N = N; // N = m here, by design
+        filter->N = N; // one row per port, m columns per row
         filter->m = m;
         filter->k = k;
         filter->ln2m = _log2(m);
@@ -79,23 +79,28 @@ fibMergedFilter_Create(int N, int m, int k) // N and m determine the matrix dime
     return filter;
 }
 
+FIBMergedFilter *
+fibMergedFilter_CreateOptimal(int N, int expectedEntries, double targetFPR)
+{
+    // Every row is a Bloom filter over the names forwarded to that port, so size
+    // the columns for an even share of the load across the N rows
+    int rowEntries = (expectedEntries + N - 1) / N;
+    int m = bloom_OptimalSize(rowEntries, targetFPR);
+    int k = bloom_OptimalHashCount(m, rowEntries);
+    return fibMergedFilter_Create(N, m, k);
+}
+
 static Bitmap *
 _hashedNameToVector(FIBMergedFilter *filter, PARCBuffer *value)
 {
-    int numBytesRequired = (filter->k * filter->ln2m) / 8;
-    size_t inputSize = parcBuffer_Remaining(value);
-    int blockSize = inputSize / filter->k;
-    uint8_t *overlay = parcBuffer_Overlay(value, 0);
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_DigestToHashPair(parcBuffer_Remaining(value), parcBuffer_Overlay(value, 0), &h1, &h2);
 
-    Bitmap *map = bitmap_Create(filter->N);
+    Bitmap *map = bitmap_Create(filter->m);
 
     for (int i = 0; i < filter->k; i++) {
-        size_t checkSum = 0;
-        for (int b = 0; b < blockSize; b++) {
-            checkSum += overlay[(i * blockSize) + b];
-        }
-        checkSum %= filter->m;
-        bitmap_Set(map, checkSum);
+        bitmap_Set(map, bloom_HashIndex(h1, h2, i, filter->m));
     }
 
     return map;
@@ -115,7 +120,7 @@ fibMergedFilter_Insert(FIBMergedFilter *filter, Name *name, Bitmap *vector)
 
     for (int r = 0; r < filter->N; r++) {
         if (bitmap_Get(vector, r)) {
-            for (int c = 0; c < filter->N; c++) {
+            for (int c = 0; c < filter->m; c++) {
                 if (bitmap_Get(columns, c)) { // if the hash pointed us to this column
                     bitmap_Set(filter->filters[r], c);
                 }
@@ -150,7 +155,7 @@ fibMergedFilter_LPM(FIBMergedFilter *filter, Name *name)
 
         for (int r = 0; r < filter->N; r++) {
             bool isMatch = true;
-            for (int c = 0; c < filter->N; c++) {
+            for (int c = 0; c < filter->m; c++) {
                 if (bitmap_Get(columns, c) && !bitmap_Get(filter->filters[r], c)) { // if the hash pointed us to this column
                     isMatch = false;
                     break;
@@ -186,4 +191,5 @@ FIBInterface *MergedFilterFIBAsFIB = &(FIBInterface) {
     .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibMergedFilter_LPM,
     .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibMergedFilter_Insert,
     .Destroy = (void (*)(void **instance)) fibMergedFilter_Destroy,
+    .CallerOwnsResults = true,
 };
@@ -15,6 +15,7 @@ typedef struct fib_merged_filter FIBMergedFilter;
 extern FIBInterface *MergedFilterFIBAsFIB;
 
 FIBMergedFilter *fibMergedFilter_Create(int N, int m, int k); // N and m determine the matrix dimensions
+FIBMergedFilter *fibMergedFilter_CreateOptimal(int N, int expectedEntries, double targetFPR);
 void fibMergedFilter_Destroy(FIBMergedFilter **bfP);
 
 bool fibMergedFilter_Insert(FIBMergedFilter *filter, Name *name, Bitmap *vector);
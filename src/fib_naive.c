@@ -1,18 +1,77 @@
+#include <LongBow/runtime.h>
+
 #include "fib_naive.h"
 #include "map.h"
+#include "multi_length_table.h"
+#include "perfect_map.h"
+#include "parallel.h"
+#include "random.h"
+#include "wyhasher.h"
 
 struct fib_naive {
     int numMaps;
     Map **maps;
+
+    // Optional pre-filter of the prefix lengths worth probing
+    PrefixLengthFilter *lengthFilter;
+
+    // Whether any prefix was inserted, which a length filter set afterwards would miss
+    bool hasPrefixes;
+
+    // Perfect-hash copies of the maps, probed instead of them until the next insert
+    PerfectMap **frozen;
+
+    // Optional dictionary (not owned): the tables are then keyed on component ID tuples
+    ComponentDictionary *dictionary;
+
+    // Optional fingerprints of the inserted prefixes, which fibNaive_Freeze buckets into a
+    // MultiLengthTable probed instead of the maps. stagedVectors[i] is the vector the maps hold
+    // for the prefix of stagedLengths[i] segments with stagedFingerprints[i].
+    WYHasher *hasher;
+    uint64_t seed;
+    size_t numStaged;
+    size_t stagedCapacity;
+    int *stagedLengths;
+    uint64_t *stagedFingerprints;
+    Bitmap **stagedVectors;
+    MultiLengthTable *multiLengthTable;
+
+    // Number of hash table probes issued by lookups
+    uint64_t numProbes;
 };
 
+// The key of the name's first count components: their IDs if the FIB interns names, else their wire format
+static PARCBuffer *
+_fibNaive_CreateKey(const Name *name, int count, const uint32_t ids[])
+{
+    if (ids != NULL) {
+        size_t length = count * sizeof(uint32_t);
+        return parcBuffer_Wrap((void *) ids, length, 0, length);
+    }
+    return name_GetWireFormat(name, count);
+}
+
+// ID keys are always raw, even for hashed names
+static bool
+_fibNaive_IsKeyHashed(const Name *name, const uint32_t ids[])
+{
+    return ids == NULL && name_IsHashed(name);
+}
+
 static Bitmap *
-_fibNaive_LookupName(FIBNaive *fib, const Name *name, int count)
+_fibNaive_LookupName(FIBNaive *fib, const Name *name, int count, const uint32_t ids[])
 {
-    PARCBuffer *buffer = name_GetWireFormat(name, count);
+    PARCBuffer *buffer = _fibNaive_CreateKey(name, count, ids);
+    bool hashed = _fibNaive_IsKeyHashed(name, ids);
     Bitmap *result = NULL;
 
-    if (name_IsHashed(name)) {
+    if (fib->frozen != NULL) {
+        if (hashed) {
+            result = perfectMap_GetHashed(fib->frozen[count - 1], buffer);
+        } else {
+            result = perfectMap_Get(fib->frozen[count - 1], buffer);
+        }
+    } else if (hashed) {
         result = map_GetHashed(fib->maps[count - 1], buffer);
     } else {
         result = map_Get(fib->maps[count - 1], buffer);
@@ -22,23 +81,111 @@ _fibNaive_LookupName(FIBNaive *fib, const Name *name, int count)
     return result;
 }
 
+// All the lengths are probed at once, in one probe of the multi-length table
+static Bitmap *
+_fibNaive_LookupMultiLength(FIBNaive *fib, const Name *name, int count)
+{
+    int numLengths = multiLengthTable_GetNumLengths(fib->multiLengthTable);
+    count = count > numLengths ? numLengths : count;
+    if (count < 1) {
+        return NULL;
+    }
+
+    uint64_t fingerprints[count];
+    multiLengthTable_Fingerprints(fib->hasher, fib->seed, name, count, fingerprints);
+
+    fib->numProbes++;
+    uint32_t index;
+    return multiLengthTable_Longest(fib->multiLengthTable, count, fingerprints, &index) > 0 ? fib->stagedVectors[index] : NULL;
+}
+
 Bitmap *
 fibNaive_LPM(FIBNaive *fib, const Name *name)
 {
     int numSegments = name_GetSegmentCount(name);
     int count = numSegments > fib->numMaps ? fib->numMaps : numSegments;
 
-    Bitmap *vector = NULL;
+    if (fib->multiLengthTable != NULL) {
+        return _fibNaive_LookupMultiLength(fib, name, count);
+    }
+
+    // No prefix extends past a component the dictionary has never seen
+    uint32_t ids[numSegments > 0 ? numSegments : 1];
+    if (fib->dictionary != NULL && count > 0) {
+        int known = name_Intern(name, fib->dictionary, false, ids);
+        count = known < count ? known : count;
+    }
+
+    uint64_t candidates = PrefixLengthFilterAllLengths;
+    if (fib->lengthFilter != NULL) {
+        candidates = prefixLengthFilter_Candidates(fib->lengthFilter, name);
+    }
+
+    // Probe from the longest prefix down, so the first hit is the longest match
     for (int i = count; i > 0; i--) {
-        Bitmap *result = _fibNaive_LookupName(fib, name, i);
-        if (result == NULL && vector != NULL) {
-            return vector;
-        } else { // vector == NULL
-            vector = result;
+        // Filtered lengths are definitely absent, just as if the probe had missed
+        if (prefixLengthFilter_IsCandidate(candidates, i)) {
+            fib->numProbes++;
+            Bitmap *result = _fibNaive_LookupName(fib, name, i, fib->dictionary != NULL ? ids : NULL);
+            if (result != NULL) {
+                return result;
+            }
         }
     }
 
-    return vector;
+    return NULL;
+}
+
+static void
+_fibNaive_Thaw(FIBNaive *fib)
+{
+    if (fib->frozen != NULL) {
+        for (int i = 0; i < fib->numMaps; i++) {
+            perfectMap_Destroy(&fib->frozen[i]);
+        }
+        free(fib->frozen);
+        fib->frozen = NULL;
+    }
+    if (fib->multiLengthTable != NULL) {
+        multiLengthTable_Destroy(&fib->multiLengthTable);
+    }
+}
+
+void
+fibNaive_Freeze(FIBNaive *fib)
+{
+    _fibNaive_Thaw(fib);
+    if (fib->hasher != NULL) {
+        fib->multiLengthTable = multiLengthTable_Create(fib->numStaged, fib->stagedLengths, fib->stagedFingerprints, NULL);
+        return;
+    }
+
+    fib->frozen = (PerfectMap **) malloc(fib->numMaps * sizeof(PerfectMap *));
+    for (int i = 0; i < fib->numMaps; i++) {
+        fib->frozen[i] = perfectMap_CreateFromMap(fib->maps[i], PerfectMapDefaultGamma);
+    }
+}
+
+bool
+fibNaive_IsFrozen(FIBNaive *fib)
+{
+    return fib->frozen != NULL || fib->multiLengthTable != NULL;
+}
+
+double
+fibNaive_GetFrozenBitsPerKey(FIBNaive *fib)
+{
+    if (fib->frozen == NULL) {
+        return 0.0;
+    }
+
+    double bits = 0.0;
+    size_t count = 0;
+    for (int i = 0; i < fib->numMaps; i++) {
+        bits += perfectMap_GetBitsPerKey(fib->frozen[i]) * perfectMap_GetCount(fib->frozen[i]);
+        count += perfectMap_GetCount(fib->frozen[i]);
+    }
+    return count > 0 ? bits / count : 0.0;
 }
 
 static Map *
@@ -59,13 +206,49 @@ _fibNative_ExpandMapsToSize(FIBNaive *fib, int number)
     }
 }
 
+static void
+_fibNaive_ReserveStaged(FIBNaive *fib, size_t count)
+{
+    if (fib->numStaged + count > fib->stagedCapacity) {
+        size_t capacity = fib->stagedCapacity > 0 ? fib->stagedCapacity : 64;
+        while (capacity < fib->numStaged + count) {
+            capacity *= 2;
+        }
+        fib->stagedLengths = (int *) realloc(fib->stagedLengths, capacity * sizeof(int));
+        fib->stagedFingerprints = (uint64_t *) realloc(fib->stagedFingerprints, capacity * sizeof(uint64_t));
+        fib->stagedVectors = (Bitmap **) realloc(fib->stagedVectors, capacity * sizeof(Bitmap *));
+        fib->stagedCapacity = capacity;
+    }
+}
+
+// Record the fingerprint of the whole name at index, which the caller reserved
+static void
+_fibNaive_StageName(FIBNaive *fib, size_t index, const Name *name, Bitmap *vector)
+{
+    int numSegments = name_GetSegmentCount(name);
+    uint64_t fingerprints[numSegments];
+    multiLengthTable_Fingerprints(fib->hasher, fib->seed, name, numSegments, fingerprints);
+    fib->stagedLengths[index] = numSegments;
+    fib->stagedFingerprints[index] = fingerprints[numSegments - 1];
+    fib->stagedVectors[index] = vector;
+}
+
 bool
 fibNaive_Insert(FIBNaive *fib, const Name *name, Bitmap *vector)
 {
+    _fibNaive_Thaw(fib);
+
     size_t numSegments = name_GetSegmentCount(name);
+    uint32_t *ids = NULL;
+    if (fib->dictionary != NULL) {
+        ids = (uint32_t *) malloc((numSegments > 0 ? numSegments : 1) * sizeof(uint32_t));
+        name_Intern(name, fib->dictionary, true, ids);
+    }
+
     if (numSegments < fib->numMaps) {
-        Bitmap *lookup = _fibNaive_LookupName(fib, name, numSegments);
+        Bitmap *lookup = _fibNaive_LookupName(fib, name, numSegments, ids);
         if (lookup != NULL) {
+            free(ids);
             bitmap_SetVector(lookup, vector);
             return true;
         }
@@ -73,14 +256,134 @@ fibNaive_Insert(FIBNaive *fib, const Name *name, Bitmap *vector)
 
     _fibNative_ExpandMapsToSize(fib, numSegments);
 
-    PARCBuffer *buffer = name_GetWireFormat(name, numSegments);
-    if (name_IsHashed(name)) {
+    fib->hasPrefixes = true;
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Add(fib->lengthFilter, name);
+    }
+    if (fib->hasher != NULL && numSegments > 0) {
+        _fibNaive_ReserveStaged(fib, 1);
+        _fibNaive_StageName(fib, fib->numStaged++, name, vector);
+    }
+
+    PARCBuffer *buffer = _fibNaive_CreateKey(name, numSegments, ids);
+    if (_fibNaive_IsKeyHashed(name, ids)) {
         map_InsertHashed(fib->maps[numSegments - 1], buffer, (void *) vector);
     } else {
         map_Insert(fib->maps[numSegments - 1], buffer, (void *) vector);
     }
     parcBuffer_Release(&buffer);
+    free(ids);
+
+    return true;
+}
+
+static void
+_fibNaive_MergeVector(void *existing, void *vector)
+{
+    bitmap_SetVector((Bitmap *) existing, (Bitmap *) vector);
+}
+
+typedef struct {
+    Name **names;
+    ComponentDictionary *dictionary;
+    uint32_t *ids;
+    size_t *offsets;
+} _InternContext;
+
+static void
+_fibNaive_InternName(void *context, size_t index)
+{
+    _InternContext *intern = (_InternContext *) context;
+    name_Intern(intern->names[index], intern->dictionary, true, intern->ids + intern->offsets[index]);
+}
+
+typedef struct {
+    FIBNaive *fib;
+    Name **names;
+    Bitmap **vectors;
+    const size_t *order;
+} _StageContext;
+
+static void
+_fibNaive_StageOrdered(void *context, size_t index)
+{
+    _StageContext *stage = (_StageContext *) context;
+    size_t i = stage->order[index];
+    _fibNaive_StageName(stage->fib, stage->fib->numStaged + index, stage->names[i], stage->vectors[i]);
+}
+
+bool
+fibNaive_BulkLoad(FIBNaive *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    size_t *order = NULL;
+    size_t *starts = NULL;
+    int maxLength = fib_GroupByLength(names, n, &order, &starts);
+    _fibNaive_Thaw(fib);
+    _fibNative_ExpandMapsToSize(fib, maxLength);
+
+    // The dictionary takes concurrent interning, so the names are interned on the threads too
+    _InternContext intern = { .names = names, .dictionary = fib->dictionary, .ids = NULL, .offsets = NULL };
+    if (fib->dictionary != NULL) {
+        intern.offsets = (size_t *) malloc((n + 1) * sizeof(size_t));
+        intern.offsets[0] = 0;
+        for (size_t i = 0; i < n; i++) {
+            intern.offsets[i + 1] = intern.offsets[i] + name_GetSegmentCount(names[i]);
+        }
+        intern.ids = (uint32_t *) malloc((intern.offsets[n] > 0 ? intern.offsets[n] : 1) * sizeof(uint32_t));
+        parallel_For(threads, n, _fibNaive_InternName, &intern);
+    }
 
+    // Each length table is filled in one bulk insertion, spread over the threads by hash range
+    PARCBuffer **keys = (PARCBuffer **) malloc((n > 0 ? n : 1) * sizeof(PARCBuffer *));
+    void **items = (void **) malloc((n > 0 ? n : 1) * sizeof(void *));
+    for (int length = 1; length <= maxLength; length++) {
+        size_t count = starts[length] - starts[length - 1];
+        if (count == 0) {
+            continue;
+        }
+
+        const size_t *group = order + starts[length - 1];
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t *ids = intern.ids != NULL ? intern.ids + intern.offsets[group[i]] : NULL;
+            keys[i] = _fibNaive_CreateKey(names[group[i]], length, ids);
+            items[i] = vectors[group[i]];
+        }
+        map_BulkInsert(fib->maps[length - 1], count, keys, items, _fibNaive_IsKeyHashed(names[group[0]], intern.ids),
+                       _fibNaive_MergeVector, NULL, threads);
+        for (size_t i = 0; i < count; i++) {
+            parcBuffer_Release(&keys[i]);
+        }
+    }
+
+    fib->hasPrefixes |= starts[maxLength] > 0;
+    if (fib->lengthFilter != NULL) {
+        for (size_t i = 0; i < starts[maxLength]; i++) {
+            prefixLengthFilter_Add(fib->lengthFilter, names[order[i]]);
+        }
+    }
+
+    // Staged in batch order, so the first of repeated names is the one whose vector the maps keep
+    if (fib->hasher != NULL) {
+        size_t *batchOrder = (size_t *) malloc((n > 0 ? n : 1) * sizeof(size_t));
+        size_t numOrdered = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (name_GetSegmentCount(names[i]) > 0) {
+                batchOrder[numOrdered++] = i;
+            }
+        }
+        _fibNaive_ReserveStaged(fib, numOrdered);
+        _StageContext stage = { .fib = fib, .names = names, .vectors = vectors, .order = batchOrder };
+        parallel_For(threads, numOrdered, _fibNaive_StageOrdered, &stage);
+        fib->numStaged += numOrdered;
+        free(batchOrder);
+    }
+
+    free(intern.ids);
+    free(intern.offsets);
+    free(items);
+    free(keys);
+    free(starts);
+    free(order);
     return true;
 }
 
@@ -89,10 +392,20 @@ fibNaive_Destroy(FIBNaive **fibP)
 {
     FIBNaive *fib = *fibP;
 
+    _fibNaive_Thaw(fib);
     for (int i = 0; i < fib->numMaps; i++) {
         map_Destroy(&fib->maps[i]);
     }
     free(fib->maps);
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Destroy(&fib->lengthFilter);
+    }
+    if (fib->hasher != NULL) {
+        wyhasher_Destroy(&fib->hasher);
+    }
+    free(fib->stagedLengths);
+    free(fib->stagedFingerprints);
+    free(fib->stagedVectors);
 
     free(fib);
     *fibP = NULL;
@@ -106,13 +419,61 @@ fibNative_Create()
         native->numMaps = 1;
         native->maps = (Map **) malloc(sizeof(Map *));
         native->maps[0] = _fibNative_CreateMap();
+        native->lengthFilter = NULL;
+        native->hasPrefixes = false;
+        native->frozen = NULL;
+        native->dictionary = NULL;
+        native->hasher = NULL;
+        native->seed = 0;
+        native->numStaged = 0;
+        native->stagedCapacity = 0;
+        native->stagedLengths = NULL;
+        native->stagedFingerprints = NULL;
+        native->stagedVectors = NULL;
+        native->multiLengthTable = NULL;
+        native->numProbes = 0;
     }
     return native;
 }
 
+void
+fibNaive_SetLengthFilter(FIBNaive *fib, PrefixLengthFilter *filter)
+{
+    // The tables only keep digests of the prefixes, so the filter cannot be filled afterwards
+    assertFalse(fib->hasPrefixes, "Expected the length filter to be set before any prefix is inserted");
+    if (fib->lengthFilter != NULL) {
+        prefixLengthFilter_Destroy(&fib->lengthFilter);
+    }
+    fib->lengthFilter = filter;
+}
+
+void
+fibNaive_SetDictionary(FIBNaive *fib, ComponentDictionary *dictionary)
+{
+    fib->dictionary = dictionary;
+}
+
+void
+fibNaive_SetMultiLength(FIBNaive *fib)
+{
+    if (fib->hasher == NULL) {
+        PARCBuffer *seed = random_Bytes(parcBuffer_Allocate(2 * sizeof(uint64_t)));
+        fib->hasher = wyhasher_Create(parcBuffer_GetUint64(seed));
+        fib->seed = parcBuffer_GetUint64(seed);
+        parcBuffer_Release(&seed);
+    }
+}
+
+uint64_t
+fibNaive_GetNumProbes(FIBNaive *fib)
+{
+    return fib->numProbes;
+}
+
 FIBInterface *NativeFIBAsFIB = &(FIBInterface) {
         .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibNaive_LPM,
         .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibNaive_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibNaive_BulkLoad,
         .Destroy = (void (*)(void **instance)) fibNaive_Destroy,
 };
 
@@ -6,6 +6,7 @@ extern "C" {
 #define fib_naive_h
 
 #include "fib.h"
+#include "prefix_length_filter.h"
 
 struct fib_naive;
 typedef struct fib_naive FIBNaive;
@@ -20,6 +21,38 @@ bool fibNaive_Insert(FIBNaive *fib, const Name *name, Bitmap *vector);
 
 Bitmap *fibNaive_LPM(FIBNaive *fib, const Name *name);
 
+// Insert names[i] with vectors[i], filling each length table on up to threads threads. Names that
+// repeat are merged into one entry. The names of one batch are either all hashed or all plain.
+bool fibNaive_BulkLoad(FIBNaive *fib, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+// Only probe the lengths the filter reports as candidates. The FIB takes ownership of the
+// filter, which must be set before any prefix is inserted (the tables cannot list theirs).
+void fibNaive_SetLengthFilter(FIBNaive *fib, PrefixLengthFilter *filter);
+
+// Key the length tables on the prefixes' component ID tuples (see name_Intern) instead of their
+// wire format, so keys are 4 bytes per component. Inserts intern the names' components; lookups
+// only probe the prefixes whose components are all interned. The dictionary, which may be shared,
+// must outlive the FIB and be set before any prefix is inserted.
+void fibNaive_SetDictionary(FIBNaive *fib, ComponentDictionary *dictionary);
+
+// Build a minimal perfect hash of every length table and probe it instead, for tables that change
+// rarely. The next insert drops the perfect hashes again, until the FIB is frozen anew.
+void fibNaive_Freeze(FIBNaive *fib);
+
+bool fibNaive_IsFrozen(FIBNaive *fib);
+
+// Freeze the FIB into a MultiLengthTable instead of perfect hashes, so that a frozen lookup probes
+// all prefix lengths up to 16 at once, without the length filter or dictionary. Inserts then also
+// record a 64-bit fingerprint of every prefix, so this must be set before any prefix is inserted.
+// Two prefixes of one length whose fingerprints collide are treated as the same prefix.
+void fibNaive_SetMultiLength(FIBNaive *fib);
+
+// Perfect hash metadata per prefix across the frozen tables, or 0 if the FIB is not frozen
+double fibNaive_GetFrozenBitsPerKey(FIBNaive *fib);
+
+// Total number of hash table probes issued by fibNaive_LPM
+uint64_t fibNaive_GetNumProbes(FIBNaive *fib);
+
 #endif
 
 #ifdef __cplusplus
@@ -16,6 +16,8 @@ extern FIBInterface *PatriciaFIBAsFIB;
 
 FIBPatricia *fibPatricia_Create();
 
+void fibPatricia_Destroy(FIBPatricia **fibP);
+
 bool fibPatricia_Insert(FIBPatricia *fib, const Name *name, Bitmap *vector);
 
 Bitmap *fibPatricia_LPM(FIBPatricia *fib, const Name *name);
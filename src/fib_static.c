@@ -0,0 +1,432 @@
+#include "fib_static.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <LongBow/runtime.h>
+
+#include "allocator.h"
+#include "multi_length_table.h"
+#include "parallel.h"
+#include "random.h"
+#include "wyhasher.h"
+
+// Eight fingerprints fill a cache line, so the line at 8k holds the descendants of k three levels down
+#define STATIC_PREFETCH_STRIDE 8
+
+// One prefix length. keys[k] and hops[k], for 1 <= k <= count, hold the k-th node of the BFS
+// layout of the sorted fingerprints; slot 0 is unused so that the children of k are 2k and 2k + 1.
+typedef struct {
+    size_t count;
+    uint64_t *keys;
+    uint32_t *hops;
+} _FIBStaticLevel;
+
+// A prefix being built, ordered by (length, fingerprint) and then by staging order
+typedef struct {
+    uint64_t fingerprint;
+    int length;
+    size_t sequence;
+    Bitmap *vector;
+} _FIBStaticEntry;
+
+struct fib_static {
+    int numLevels;
+    _FIBStaticLevel *levels;
+
+    // Next-hop vectors, indexed by the hops arrays
+    size_t numVectors;
+    Bitmap **vectors;
+
+    size_t numPending;
+    size_t pendingCapacity;
+    _FIBStaticEntry *pending;
+
+    // Keys the per-segment hashes that are chained into the prefix fingerprints. The tables are
+    // only ever searched, never bucketed, so a fast non-cryptographic hash is enough.
+    WYHasher *hasher;
+    uint64_t seed;
+
+    // Optional copy of the levels bucketed for probing every length at once, rebuilt with them
+    bool multiLength;
+    MultiLengthTable *multiLengthTable;
+
+    Allocator *allocator;
+};
+
+FIBStatic *
+fibStatic_Create()
+{
+    FIBStatic *fib = (FIBStatic *) malloc(sizeof(FIBStatic));
+    if (fib != NULL) {
+        fib->numLevels = 0;
+        fib->levels = NULL;
+        fib->numVectors = 0;
+        fib->vectors = NULL;
+        fib->numPending = 0;
+        fib->pendingCapacity = 0;
+        fib->pending = NULL;
+        fib->multiLength = false;
+        fib->multiLengthTable = NULL;
+        fib->allocator = allocator_GetDefault();
+
+        PARCBuffer *seed = random_Bytes(parcBuffer_Allocate(2 * sizeof(uint64_t)));
+        fib->hasher = wyhasher_Create(parcBuffer_GetUint64(seed));
+        fib->seed = parcBuffer_GetUint64(seed);
+        parcBuffer_Release(&seed);
+    }
+    return fib;
+}
+
+FIBStatic *
+fibStatic_CreateFromNames(size_t n, Name *names[], Bitmap *vectors[], int threads)
+{
+    FIBStatic *fib = fibStatic_Create();
+    if (fib != NULL) {
+        fibStatic_BulkLoad(fib, names, vectors, n, threads);
+    }
+    return fib;
+}
+
+static void
+_fibStatic_ReleaseLevels(FIBStatic *fib)
+{
+    for (int i = 0; i < fib->numLevels; i++) {
+        _FIBStaticLevel *level = &fib->levels[i];
+        allocator_Deallocate(fib->allocator, level->keys, (level->count + 1) * sizeof(uint64_t));
+        allocator_Deallocate(fib->allocator, level->hops, (level->count + 1) * sizeof(uint32_t));
+    }
+    if (fib->multiLengthTable != NULL) {
+        multiLengthTable_Destroy(&fib->multiLengthTable);
+    }
+    free(fib->levels);
+    free(fib->vectors);
+    fib->levels = NULL;
+    fib->numLevels = 0;
+    fib->vectors = NULL;
+    fib->numVectors = 0;
+}
+
+void
+fibStatic_Destroy(FIBStatic **fibP)
+{
+    FIBStatic *fib = *fibP;
+    _fibStatic_ReleaseLevels(fib);
+    free(fib->pending);
+    wyhasher_Destroy(&fib->hasher);
+    free(fib);
+    *fibP = NULL;
+}
+
+static uint64_t
+_fibStatic_Fingerprint(FIBStatic *fib, const Name *name)
+{
+    int numSegments = name_GetSegmentCount(name);
+    uint64_t fingerprints[numSegments];
+    multiLengthTable_Fingerprints(fib->hasher, fib->seed, name, numSegments, fingerprints);
+    return fingerprints[numSegments - 1];
+}
+
+static void
+_fibStatic_ReservePending(FIBStatic *fib, size_t count)
+{
+    if (fib->numPending + count > fib->pendingCapacity) {
+        size_t capacity = fib->pendingCapacity > 0 ? fib->pendingCapacity : 64;
+        while (capacity < fib->numPending + count) {
+            capacity *= 2;
+        }
+        fib->pending = (_FIBStaticEntry *) realloc(fib->pending, capacity * sizeof(_FIBStaticEntry));
+        fib->pendingCapacity = capacity;
+    }
+}
+
+bool
+fibStatic_Insert(FIBStatic *fib, const Name *name, Bitmap *vector)
+{
+    int numSegments = name_GetSegmentCount(name);
+    if (numSegments < 1) {
+        return false;
+    }
+
+    _fibStatic_ReservePending(fib, 1);
+    _FIBStaticEntry *entry = &fib->pending[fib->numPending];
+    entry->fingerprint = _fibStatic_Fingerprint(fib, name);
+    entry->length = numSegments;
+    entry->vector = vector;
+    fib->numPending++;
+    return true;
+}
+
+typedef struct {
+    FIBStatic *fib;
+    Name **names;
+    Bitmap **vectors;
+    _FIBStaticEntry *entries;
+} _FIBStaticBulkFingerprint;
+
+static void
+_fibStatic_FingerprintEntry(void *context, size_t index)
+{
+    _FIBStaticBulkFingerprint *bulk = (_FIBStaticBulkFingerprint *) context;
+    _FIBStaticEntry *entry = &bulk->entries[index];
+    entry->length = name_GetSegmentCount(bulk->names[index]);
+    entry->fingerprint = entry->length > 0 ? _fibStatic_Fingerprint(bulk->fib, bulk->names[index]) : 0;
+    entry->vector = bulk->vectors[index];
+}
+
+bool
+fibStatic_BulkLoad(FIBStatic *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    _fibStatic_ReservePending(fib, n);
+
+    _FIBStaticBulkFingerprint bulk = {
+            .fib = fib,
+            .names = names,
+            .vectors = vectors,
+            .entries = fib->pending + fib->numPending,
+    };
+    parallel_For(threads, n, _fibStatic_FingerprintEntry, &bulk);
+
+    // Drop names without segments, keeping the staging order of the rest
+    size_t numStaged = fib->numPending;
+    for (size_t i = 0; i < n; i++) {
+        if (bulk.entries[i].length > 0) {
+            fib->pending[numStaged++] = bulk.entries[i];
+        }
+    }
+    fib->numPending = numStaged;
+
+    fibStatic_Build(fib);
+    return true;
+}
+
+static int
+_fibStatic_CompareEntries(const void *a, const void *b)
+{
+    const _FIBStaticEntry *x = (const _FIBStaticEntry *) a;
+    const _FIBStaticEntry *y = (const _FIBStaticEntry *) b;
+    if (x->length != y->length) {
+        return x->length < y->length ? -1 : 1;
+    } else if (x->fingerprint != y->fingerprint) {
+        return x->fingerprint < y->fingerprint ? -1 : 1;
+    } else if (x->sequence != y->sequence) {
+        return x->sequence < y->sequence ? -1 : 1;
+    }
+    return 0;
+}
+
+// Lay sorted[] out in BFS order: an in-order walk of the implicit tree visits the sorted keys in turn
+static size_t
+_fibStatic_Layout(_FIBStaticLevel *level, const uint64_t sorted[], const uint32_t sortedHops[], size_t i, size_t k)
+{
+    if (k <= level->count) {
+        i = _fibStatic_Layout(level, sorted, sortedHops, i, 2 * k);
+        level->keys[k] = sorted[i];
+        level->hops[k] = sortedHops[i];
+        i++;
+        i = _fibStatic_Layout(level, sorted, sortedHops, i, 2 * k + 1);
+    }
+    return i;
+}
+
+// Bucket the fingerprints of the built levels, with their hops as the values
+static void
+_fibStatic_BuildMultiLength(FIBStatic *fib)
+{
+    size_t numBuilt = 0;
+    for (int i = 0; i < fib->numLevels; i++) {
+        numBuilt += fib->levels[i].count;
+    }
+
+    int *lengths = (int *) malloc((numBuilt > 0 ? numBuilt : 1) * sizeof(int));
+    uint64_t *fingerprints = (uint64_t *) malloc((numBuilt > 0 ? numBuilt : 1) * sizeof(uint64_t));
+    uint32_t *hops = (uint32_t *) malloc((numBuilt > 0 ? numBuilt : 1) * sizeof(uint32_t));
+    size_t e = 0;
+    for (int i = 0; i < fib->numLevels; i++) {
+        _FIBStaticLevel *level = &fib->levels[i];
+        for (size_t k = 1; k <= level->count; k++) {
+            lengths[e] = i + 1;
+            fingerprints[e] = level->keys[k];
+            hops[e] = level->hops[k];
+            e++;
+        }
+    }
+
+    fib->multiLengthTable = multiLengthTable_Create(numBuilt, lengths, fingerprints, hops);
+    free(hops);
+    free(fingerprints);
+    free(lengths);
+}
+
+void
+fibStatic_Build(FIBStatic *fib)
+{
+    if (fib->numPending == 0) {
+        return;
+    }
+
+    // The current table is staged ahead of the new names, so its vectors stay first among repeats
+    size_t numBuilt = 0;
+    for (int i = 0; i < fib->numLevels; i++) {
+        numBuilt += fib->levels[i].count;
+    }
+    size_t numEntries = numBuilt + fib->numPending;
+    _FIBStaticEntry *entries = (_FIBStaticEntry *) malloc(numEntries * sizeof(_FIBStaticEntry));
+
+    size_t e = 0;
+    for (int i = 0; i < fib->numLevels; i++) {
+        _FIBStaticLevel *level = &fib->levels[i];
+        for (size_t k = 1; k <= level->count; k++) {
+            entries[e].fingerprint = level->keys[k];
+            entries[e].length = i + 1;
+            entries[e].sequence = e;
+            entries[e].vector = fib->vectors[level->hops[k]];
+            e++;
+        }
+    }
+    for (size_t i = 0; i < fib->numPending; i++) {
+        entries[e] = fib->pending[i];
+        entries[e].sequence = e;
+        e++;
+    }
+    fib->numPending = 0;
+
+    qsort(entries, numEntries, sizeof(_FIBStaticEntry), _fibStatic_CompareEntries);
+
+    _fibStatic_ReleaseLevels(fib);
+    fib->numLevels = entries[numEntries - 1].length;
+    fib->levels = (_FIBStaticLevel *) calloc(fib->numLevels, sizeof(_FIBStaticLevel));
+    fib->vectors = (Bitmap **) malloc(numEntries * sizeof(Bitmap *));
+
+    uint64_t *sorted = (uint64_t *) malloc(numEntries * sizeof(uint64_t));
+    uint32_t *sortedHops = (uint32_t *) malloc(numEntries * sizeof(uint32_t));
+
+    size_t start = 0;
+    while (start < numEntries) {
+        int length = entries[start].length;
+
+        // Merge the repeats of each prefix into the vector staged first
+        size_t count = 0;
+        size_t end = start;
+        for (; end < numEntries && entries[end].length == length; end++) {
+            if (count > 0 && sorted[count - 1] == entries[end].fingerprint) {
+                bitmap_SetVector(fib->vectors[sortedHops[count - 1]], entries[end].vector);
+                continue;
+            }
+            sorted[count] = entries[end].fingerprint;
+            sortedHops[count] = (uint32_t) fib->numVectors;
+            fib->vectors[fib->numVectors++] = entries[end].vector;
+            count++;
+        }
+
+        _FIBStaticLevel *level = &fib->levels[length - 1];
+        level->count = count;
+        level->keys = (uint64_t *) allocator_Allocate(fib->allocator, (count + 1) * sizeof(uint64_t));
+        level->hops = (uint32_t *) allocator_Allocate(fib->allocator, (count + 1) * sizeof(uint32_t));
+        level->keys[0] = 0;
+        level->hops[0] = 0;
+        _fibStatic_Layout(level, sorted, sortedHops, 0, 1);
+
+        start = end;
+    }
+
+    // Lengths with no prefixes keep empty arrays, so lookups need no special case for them
+    for (int i = 0; i < fib->numLevels; i++) {
+        _FIBStaticLevel *level = &fib->levels[i];
+        if (level->keys == NULL) {
+            level->keys = (uint64_t *) allocator_Allocate(fib->allocator, sizeof(uint64_t));
+            level->hops = (uint32_t *) allocator_Allocate(fib->allocator, sizeof(uint32_t));
+        }
+    }
+
+    fib->vectors = (Bitmap **) realloc(fib->vectors, (fib->numVectors > 0 ? fib->numVectors : 1) * sizeof(Bitmap *));
+    free(sortedHops);
+    free(sorted);
+    free(entries);
+
+    if (fib->multiLength) {
+        _fibStatic_BuildMultiLength(fib);
+    }
+}
+
+void
+fibStatic_SetMultiLength(FIBStatic *fib, bool enabled)
+{
+    fib->multiLength = enabled;
+    if (!enabled && fib->multiLengthTable != NULL) {
+        multiLengthTable_Destroy(&fib->multiLengthTable);
+    } else if (enabled && fib->multiLengthTable == NULL && fib->numLevels > 0) {
+        _fibStatic_BuildMultiLength(fib);
+    }
+}
+
+// The slot holding key, or 0. The descent only ever moves to a child, so it compiles to
+// conditional moves; the position after the last right turn is recovered from the trailing ones.
+static size_t
+_fibStatic_Search(const _FIBStaticLevel *level, uint64_t key)
+{
+    const uint64_t *keys = level->keys;
+    size_t k = 1;
+    while (k <= level->count) {
+        __builtin_prefetch(keys + STATIC_PREFETCH_STRIDE * k);
+        k = 2 * k + (keys[k] < key);
+    }
+    k >>= __builtin_ffsll(~k);
+    return (k != 0 && keys[k] == key) ? k : 0;
+}
+
+Bitmap *
+fibStatic_LPM(FIBStatic *fib, const Name *name)
+{
+    // Lookups never rebuild, so that they stay read-only
+    assertTrue(fib->numPending == 0, "fibStatic_Build must be called after inserting and before looking up");
+
+    int numSegments = name_GetSegmentCount(name);
+    int count = numSegments > fib->numLevels ? fib->numLevels : numSegments;
+    if (count < 1) {
+        return NULL;
+    }
+
+    uint64_t fingerprints[count];
+    multiLengthTable_Fingerprints(fib->hasher, fib->seed, name, count, fingerprints);
+
+    if (fib->multiLengthTable != NULL) {
+        uint32_t hop;
+        return multiLengthTable_Longest(fib->multiLengthTable, count, fingerprints, &hop) > 0 ? fib->vectors[hop] : NULL;
+    }
+
+    for (int d = count; d > 0; d--) {
+        const _FIBStaticLevel *level = &fib->levels[d - 1];
+        size_t k = _fibStatic_Search(level, fingerprints[d - 1]);
+        if (k != 0) {
+            return fib->vectors[level->hops[k]];
+        }
+    }
+    return NULL;
+}
+
+size_t
+fibStatic_GetNumPrefixes(FIBStatic *fib)
+{
+    return fib->numVectors;
+}
+
+size_t
+fibStatic_GetSizeInBytes(FIBStatic *fib)
+{
+    size_t size = fib->numLevels * sizeof(_FIBStaticLevel) + fib->numVectors * sizeof(Bitmap *);
+    for (int i = 0; i < fib->numLevels; i++) {
+        size += (fib->levels[i].count + 1) * (sizeof(uint64_t) + sizeof(uint32_t));
+    }
+    if (fib->multiLengthTable != NULL) {
+        size += multiLengthTable_GetSizeInBytes(fib->multiLengthTable);
+    }
+    return size;
+}
+
+FIBInterface *StaticFIBAsFIB = &(FIBInterface) {
+        .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibStatic_LPM,
+        .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibStatic_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibStatic_BulkLoad,
+        .Destroy = (void (*)(void **instance)) fibStatic_Destroy,
+};
@@ -0,0 +1,55 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef fib_static_h_
+#define fib_static_h_
+
+#include "bitmap.h"
+#include "name.h"
+#include "fib.h"
+
+struct fib_static;
+typedef struct fib_static FIBStatic;
+
+extern FIBInterface *StaticFIBAsFIB;
+
+// A read-mostly FIB. Every prefix length is a sorted array of 64-bit prefix fingerprints in
+// Eytzinger (BFS) order, searched without branches, beside an array of next-hop indices.
+// Inserted names are staged until fibStatic_Build compacts them into the arrays, which must
+// happen before the next lookup. Two prefixes of one length whose fingerprints collide are treated as
+// the same prefix, which for n prefixes happens with probability about n^2 / 2^65.
+FIBStatic *fibStatic_Create();
+
+// Build a finished table from names[i] and vectors[i], fingerprinting on up to threads threads
+FIBStatic *fibStatic_CreateFromNames(size_t n, Name *names[], Bitmap *vectors[], int threads);
+
+void fibStatic_Destroy(FIBStatic **fibP);
+
+// Stage a name for the next build. Repeated names are merged into the first one's vector.
+bool fibStatic_Insert(FIBStatic *fib, const Name *name, Bitmap *vector);
+
+// Stage names[i] with vectors[i], fingerprinting on up to threads threads, and build the table
+bool fibStatic_BulkLoad(FIBStatic *fib, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
+// Compact the staged names and the current table into a new table. Not safe alongside lookups.
+void fibStatic_Build(FIBStatic *fib);
+
+Bitmap *fibStatic_LPM(FIBStatic *fib, const Name *name);
+
+// Also keep the built table in a MultiLengthTable, and look up through it: all prefix lengths up
+// to 16 are then probed at once instead of searched one after the other, which pays off when
+// lookups fall through several lengths. The buckets take about 26 more bytes per prefix.
+void fibStatic_SetMultiLength(FIBStatic *fib, bool enabled);
+
+// Number of distinct prefixes in the built table
+size_t fibStatic_GetNumPrefixes(FIBStatic *fib);
+
+// Bytes held by the built table's fingerprint, next-hop and vector arrays (not the vectors)
+size_t fibStatic_GetSizeInBytes(FIBStatic *fib);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
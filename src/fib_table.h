@@ -0,0 +1,292 @@
+#ifndef FIB_TABLE_H_
+#define FIB_TABLE_H_
+
+#ifndef __cplusplus
+#error "fib_table.h is the C++ front-end of the FIB engines; C code uses fib.h"
+#endif
+
+#include "fib.h"
+#include "fib_naive.h"
+#include "fib_cisco.h"
+#include "fib_caesar.h"
+#include "fib_caesar_filter.h"
+#include "fib_patricia.h"
+#include "fib_tbf.h"
+#include "fib_static.h"
+#include "hasher.h"
+
+#include <cstddef>
+#include <vector>
+
+// A header-only C++17 front-end to the FIB engines. fib::Table<Engine, Hasher, MaxDepth> calls the
+// engine's functions directly instead of through a FIBInterface, and fixes its parameters (M, T, m,
+// k, ...) at compile time, where they are also checked against the deepest prefix the table takes.
+//
+//     fib::Table<fib::Cisco<3>> table;
+//     fib::Table<fib::TBF<2, 1 << 20, 7>, fib::Digest<fib::WyHash, 8>, 16> hashed;
+//
+// Engine policies bind one C engine: its instance type, create/destroy, lpm/insert/bulkLoad, and
+// the FIBInterface of the same engine for code that needs the function-pointer path.
+namespace fib {
+
+struct Naive {
+    using Instance = FIBNaive;
+    static constexpr int depth = 1;
+
+    static Instance *create() { return fibNative_Create(); }
+    static void destroy(Instance **fib) { fibNaive_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibNaive_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibNaive_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        return fibNaive_BulkLoad(fib, names, vectors, n, threads);
+    }
+    static FIBInterface *interface() { return NativeFIBAsFIB; }
+};
+
+template <int M>
+struct Cisco {
+    static_assert(M > 0, "The cisco FIB's first probe length M must be positive");
+
+    using Instance = FIBCisco;
+    static constexpr int depth = M;
+
+    static Instance *create() { return fibCisco_Create(M); }
+    static void destroy(Instance **fib) { fibCisco_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibCisco_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibCisco_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        return fibCisco_BulkLoad(fib, names, vectors, n, threads);
+    }
+    static FIBInterface *interface() { return CiscoFIBAsFIB; }
+};
+
+// b and m are the filter counts and sizes, k the hash functions per filter
+template <int B, int M, int K>
+struct Caesar {
+    static_assert(B > 0 && M > 0 && K > 0, "The caesar FIB needs filters, filter bits and hash functions");
+
+    using Instance = FIBCaesar;
+    static constexpr int depth = 1;
+
+    static Instance *create() { return fibCaesar_Create(B, M, K); }
+    static void destroy(Instance **fib) { fibCaesar_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibCaesar_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibCaesar_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        return fibCaesar_BulkLoad(fib, names, vectors, n, threads);
+    }
+    static FIBInterface *interface() { return CaesarFIBAsFIB; }
+};
+
+template <int Ports, int B, int M, int K>
+struct CaesarFilter {
+    static_assert(Ports > 0 && B > 0 && M > 0 && K > 0, "The caesar-filter FIB needs ports, filters, filter bits and hash functions");
+
+    using Instance = FIBCaesarFilter;
+    static constexpr int depth = 1;
+
+    static Instance *create() { return fibCaesarFilter_Create(Ports, B, M, K); }
+    static void destroy(Instance **fib) { fibCaesarFilter_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibCaesarFilter_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibCaesarFilter_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        for (size_t i = 0; i < n; i++) {
+            fibCaesarFilter_Insert(fib, names[i], vectors[i]);
+        }
+        return true;
+    }
+    static FIBInterface *interface() { return CaesarFilterFIBAsFIB; }
+};
+
+struct Patricia {
+    using Instance = FIBPatricia;
+    static constexpr int depth = 1;
+
+    static Instance *create() { return fibPatricia_Create(); }
+    static void destroy(Instance **fib) { fibPatricia_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibPatricia_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibPatricia_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        for (size_t i = 0; i < n; i++) {
+            fibPatricia_Insert(fib, names[i], vectors[i]);
+        }
+        return true;
+    }
+    static FIBInterface *interface() { return PatriciaFIBAsFIB; }
+};
+
+// T is the trie depth, m and k the bits and hash functions of each node's filter
+template <int T, int M, int K>
+struct TBF {
+    static_assert(T > 0 && M > 0 && K > 0, "The TBF needs a trie depth, filter bits and hash functions");
+
+    using Instance = FIBTBF;
+    static constexpr int depth = T;
+
+    static Instance *create() { return fibTBF_Create(T, M, K); }
+    static void destroy(Instance **fib) { fibTBF_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibTBF_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibTBF_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        return fibTBF_BulkLoad(fib, names, vectors, n, threads);
+    }
+    static FIBInterface *interface() { return TBFAsFIB; }
+};
+
+// Inserts are only staged: call fibStatic_Build(table.get()) after them, before looking up
+struct Static {
+    using Instance = FIBStatic;
+    static constexpr int depth = 1;
+
+    static Instance *create() { return fibStatic_Create(); }
+    static void destroy(Instance **fib) { fibStatic_Destroy(fib); }
+    static Bitmap *lpm(Instance *fib, const Name *name) { return fibStatic_LPM(fib, name); }
+    static bool insert(Instance *fib, const Name *name, Bitmap *vector) { return fibStatic_Insert(fib, name, vector); }
+    static bool bulkLoad(Instance *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        return fibStatic_BulkLoad(fib, names, vectors, n, threads);
+    }
+    static FIBInterface *interface() { return StaticFIBAsFIB; }
+};
+
+// Hash functions for Digest, by their hasher_CreateNamed names
+struct SHA256 { static constexpr const char *name = "sha256"; static constexpr int length = 32; };
+struct SipHash { static constexpr const char *name = "siphash"; static constexpr int length = 8; };
+struct XXHash { static constexpr const char *name = "xxhash"; static constexpr int length = 8; };
+struct WyHash { static constexpr const char *name = "wyhash"; static constexpr int length = 8; };
+struct CRC32C { static constexpr const char *name = "crc32c"; static constexpr int length = 4; };
+
+// Names go to the engine as they are
+struct Plain {
+    static constexpr bool digests = false;
+};
+
+// Names are replaced by digests of each prefix, Length bytes long, as name_Hash makes them
+template <typename Function, int Length = Function::length>
+class Digest {
+public:
+    static_assert(Length > 0, "Digests must be at least one byte long");
+
+    static constexpr bool digests = true;
+    static constexpr int length = Length;
+
+    Digest() : hasher(hasher_CreateNamed(Function::name)) { }
+    ~Digest() { hasher_Destroy(&hasher); }
+
+    Digest(const Digest &) = delete;
+    Digest &operator=(const Digest &) = delete;
+
+    Name *digest(const Name *name) const { return name_Hash(const_cast<Name *>(name), hasher, Length); }
+
+private:
+    Hasher *hasher;
+};
+
+template <typename Engine, typename Hashing = Plain, int MaxDepth = 32>
+class Table : private Hashing {
+public:
+    static_assert(MaxDepth > 0, "A table must take prefixes of at least one component");
+    static_assert(Engine::depth <= MaxDepth, "The engine's parameters need deeper prefixes than the table takes");
+
+    using Instance = typename Engine::Instance;
+    static constexpr int maxDepth = MaxDepth;
+
+    Table() : instance(Engine::create()) { }
+
+    // Adopt an engine instance made elsewhere, e.g., one also wrapped in a FIB
+    explicit Table(Instance *adopted) : instance(adopted) { }
+
+    ~Table()
+    {
+        if (instance != nullptr) {
+            Engine::destroy(&instance);
+        }
+        for (Name *&digest : inserted) {
+            name_Destroy(&digest);
+        }
+    }
+
+    Table(const Table &) = delete;
+    Table &operator=(const Table &) = delete;
+
+    // The vector of the longest prefix of name in the table, or NULL, borrowed as from fib_LPM
+    Bitmap *lpm(const Name *name) const
+    {
+        if constexpr (Hashing::digests) {
+            Name *digest = Hashing::digest(name);
+            Bitmap *result = Engine::lpm(instance, digest);
+            name_Destroy(&digest);
+            return result;
+        } else {
+            return Engine::lpm(instance, name);
+        }
+    }
+
+    // Prefixes deeper than MaxDepth are rejected
+    bool insert(const Name *name, Bitmap *vector)
+    {
+        if (name_GetSegmentCount(name) > MaxDepth) {
+            return false;
+        }
+        if constexpr (Hashing::digests) {
+            Name *digest = Hashing::digest(name);
+            inserted.push_back(digest);
+            return Engine::insert(instance, digest, vector);
+        } else {
+            return Engine::insert(instance, name, vector);
+        }
+    }
+
+    // As fib_BulkLoad, skipping prefixes deeper than MaxDepth. Returns false if any was skipped.
+    bool bulkLoad(Name *names[], Bitmap *vectors[], size_t n, int threads)
+    {
+        std::vector<Name *> accepted;
+        std::vector<Bitmap *> acceptedVectors;
+        accepted.reserve(n);
+        acceptedVectors.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            if (name_GetSegmentCount(names[i]) <= MaxDepth) {
+                if constexpr (Hashing::digests) {
+                    accepted.push_back(Hashing::digest(names[i]));
+                } else {
+                    accepted.push_back(names[i]);
+                }
+                acceptedVectors.push_back(vectors[i]);
+            }
+        }
+
+        bool loaded = Engine::bulkLoad(instance, accepted.data(), acceptedVectors.data(), accepted.size(), threads);
+        if constexpr (Hashing::digests) {
+            inserted.insert(inserted.end(), accepted.begin(), accepted.end());
+        }
+        return loaded && accepted.size() == n;
+    }
+
+    // The engine instance, e.g., to freeze or tune it
+    Instance *get() const { return instance; }
+
+    // Give up the engine instance, which the caller then destroys
+    Instance *release()
+    {
+        static_assert(!Hashing::digests, "Engines may refer to the digests the table keeps, so they stay with it");
+        Instance *released = instance;
+        instance = nullptr;
+        return released;
+    }
+
+private:
+    Instance *instance;
+
+    // Engines may keep referring to the names they were loaded with, so digests live as long as the table
+    std::vector<Name *> inserted;
+};
+
+} // namespace fib
+
+#endif // FIB_TABLE_H_
@@ -1,8 +1,13 @@
 #include "fib_tbf.h"
 
+#include <string.h>
+
 #include "map.h"
 #include "patricia.h"
 #include "bloom.h"
+#include "cuckoo_filter.h"
+#include "siphasher.h"
+#include "parallel.h"
 
 typedef enum {
     _FIBEntryType_Bitmap,
@@ -11,10 +16,17 @@ typedef enum {
 
 typedef struct {
     int type;
+
+    // The vector of the trie prefix itself, if it was inserted
     Bitmap *vector;
 
-    BloomFilter **filters;
-    int numFilters;
+    // Suffixes of every length B, added with B as the salt to whichever filter the FIB uses
+    BloomFilter *filter;
+    CuckooFilter *cuckoo;
+    int maxSuffixLength;
+
+    // Distinguishes this entry's suffixes from equal suffixes under other trie prefixes in the exact-match table
+    uint64_t id;
 } _fibEntry;
 
 static void
@@ -22,100 +34,228 @@ _fibEntry_Destroy(_fibEntry **entryP)
 {
     _fibEntry *entry = *entryP;
 
-    if (entry->vector != NULL) {
-        bitmap_Destroy(&entry->vector);
+    if (entry->filter != NULL) {
+        bloom_Destroy(&entry->filter);
     }
-    for (int i = 0; i < entry->numFilters; i++) {
-        bloom_Destroy(&(entry->filters[i]));
-    }
-    if (entry->filters != NULL) {
-        free(entry->filters);
+    if (entry->cuckoo != NULL) {
+        cuckooFilter_Destroy(&entry->cuckoo);
     }
 
     free(entry);
     *entryP = NULL;
 }
 
+static bool
+_fibEntry_HasSuffixes(_fibEntry *entry)
+{
+    return entry->filter != NULL || entry->cuckoo != NULL;
+}
+
 static void
 _fibEntry_AssertIsValid(_fibEntry *entry)
 {
     assertTrue(entry->type == _FIBEntryType_Bitmap || entry->type == _FIBEntryType_BF, "Invalid entry type");
 
-    if (entry->type == _FIBEntryType_Bitmap) {
-        assertTrue(entry->vector != NULL, "Invalid entry vector");
-    } else {
-        assertTrue(entry->filters != NULL, "Invalid entry filters");
+    if (entry->type == _FIBEntryType_BF) {
+        assertTrue(_fibEntry_HasSuffixes(entry), "Invalid entry filter");
     }
 
 }
 
 static _fibEntry *
-_fibEntry_Create(int type)
+_fibEntry_Create(int type, uint64_t id)
 {
     _fibEntry *entry = (_fibEntry *) malloc(sizeof(_fibEntry));
     if (entry != NULL) {
         entry->type = type;
         entry->vector = NULL;
-        entry->filters = NULL;
-        entry->numFilters = 0;
+        entry->filter = NULL;
+        entry->cuckoo = NULL;
+        entry->maxSuffixLength = 0;
+        entry->id = id;
     }
     return entry;
 }
 
+// Initial capacity of each auto-sized suffix filter -- filters grow with their actual load
+const int TBFDefaultFilterCapacity = 16;
+
 struct fib_tbf {
     int T;
     int m;
     int k;
+    double targetFPR;
+    FilterType filterType;
     Patricia *trie;
+
+    // Exact-match table for long names, keyed by the salted suffix hash and the trie entry
     Map *map;
+    uint64_t numEntries;
+
+    // Shared by every entry filter
+    SipHasher *hasher;
 };
 
+static PARCBuffer *
+_fibTBF_CreateSuffixKey(_fibEntry *entry, uint64_t suffixHash)
+{
+    PARCBuffer *key = parcBuffer_Allocate(sizeof(uint64_t));
+    parcBuffer_PutUint64(key, suffixHash + entry->id * 0x9E3779B97F4A7C15ULL);
+    return parcBuffer_Flip(key);
+}
+
+static void
+_fibTBF_CreateFilter(FIBTBF *fib, _fibEntry *entry)
+{
+    if (fib->filterType == FilterType_Cuckoo) {
+        entry->cuckoo = cuckooFilter_CreateWithHasher(TBFDefaultFilterCapacity, false, fib->hasher);
+    } else if (fib->targetFPR > 0) {
+        entry->filter = bloom_CreateOptimalWithHasher(TBFDefaultFilterCapacity, fib->targetFPR, fib->hasher);
+        bloom_SetMaxFillRatio(entry->filter, BloomDefaultMaxFillRatio);
+    } else {
+        entry->filter = bloom_CreateWithHasher(fib->m, fib->k, fib->hasher);
+    }
+}
+
+// Both filter types derive the same salted pair from the shared hasher
+static void
+_fibTBF_HashSuffix(_fibEntry *entry, int B, PARCBuffer *suffix, uint64_t *h1, uint64_t *h2)
+{
+    if (entry->cuckoo != NULL) {
+        cuckooFilter_HashSalted(entry->cuckoo, B, suffix, h1, h2);
+    } else {
+        bloom_HashSalted(entry->filter, B, suffix, h1, h2);
+    }
+}
+
+static bool
+_fibTBF_TestSuffixHash(_fibEntry *entry, uint64_t h1, uint64_t h2)
+{
+    if (entry->cuckoo != NULL) {
+        return cuckooFilter_TestHashPair(entry->cuckoo, h1, h2);
+    }
+    return bloom_TestHashPair(entry->filter, h1, h2);
+}
+
+// Hash the suffix of a long name for its entry's filter, which is created if need be. h1 is also
+// what the name's exact-match key is built from.
+static void
+_fibTBF_HashNameSuffix(FIBTBF *fib, _fibEntry *entry, const Name *name, uint64_t *h1, uint64_t *h2)
+{
+    int numSegments = name_GetSegmentCount(name);
+    int B = numSegments - fib->T;
+    assertTrue(B > 0, "A BF entry must have at least T segments");
+
+    if (!_fibEntry_HasSuffixes(entry)) {
+        _fibTBF_CreateFilter(fib, entry);
+    }
+    entry->maxSuffixLength = B > entry->maxSuffixLength ? B : entry->maxSuffixLength;
+
+    PARCBuffer *suffix = name_GetSubWireFormat(name, fib->T, numSegments);
+    _fibTBF_HashSuffix(entry, B, suffix, h1, h2);
+    parcBuffer_Release(&suffix);
+}
+
+// Suffixes are filtered once each, when their exact-match key is added, so that a cuckoo filter
+// holds one fingerprint per key and fibTBF_Remove takes out exactly that one
+static void
+_fibTBF_FilterSuffixHash(_fibEntry *entry, uint64_t h1, uint64_t h2)
+{
+    if (entry->cuckoo != NULL) {
+        cuckooFilter_AddHashPair(entry->cuckoo, h1, h2);
+    } else {
+        bloom_AddHashPair(entry->filter, h1, h2);
+    }
+}
+
+static void
+_fibTBF_AddSuffix(FIBTBF *fib, _fibEntry *entry, const Name *name, Bitmap *egressVector)
+{
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _fibTBF_HashNameSuffix(fib, entry, name, &h1, &h2);
+
+    PARCBuffer *key = _fibTBF_CreateSuffixKey(entry, h1);
+    Bitmap *existing = map_GetHashed(fib->map, key);
+    if (existing == NULL) {
+        _fibTBF_FilterSuffixHash(entry, h1, h2);
+        map_InsertHashed(fib->map, key, egressVector);
+    } else {
+        bitmap_SetVector(existing, egressVector);
+    }
+    parcBuffer_Release(&key);
+}
+
+static void
+_fibTBF_SetPrefixVector(_fibEntry *entry, Bitmap *egressVector)
+{
+    if (entry->vector == NULL) {
+        entry->vector = egressVector;
+    } else {
+        bitmap_SetVector(entry->vector, egressVector);
+    }
+}
+
 #define MIN(a, b) (a < b ? a : b)
 
+// Longest inserted prefix of at most length segments, which are all held in the trie
+static Bitmap *
+_fibTBF_TrieLPM(FIBTBF *fib, const Name *name, int length)
+{
+    for (int i = length; i > 0; i--) {
+        PARCBuffer *prefix = name_GetWireFormat(name, i);
+        _fibEntry *entry = patricia_GetExact(fib->trie, prefix);
+        parcBuffer_Release(&prefix);
+
+        if (entry != NULL && entry->vector != NULL) {
+            return entry->vector;
+        }
+    }
+    return NULL;
+}
+
 Bitmap *
 fibTBF_LPM(FIBTBF *fib, const Name *name)
 {
     int numSegments = name_GetSegmentCount(name);
     bool isShortName = numSegments <= fib->T;
+    if (isShortName) {
+        return _fibTBF_TrieLPM(fib, name, numSegments);
+    }
 
-    PARCBuffer *tSegment = name_GetWireFormat(name, MIN(fib->T, numSegments));
-    _fibEntry *entry = patricia_Get(fib->trie, tSegment);
-
+    PARCBuffer *tSegment = name_GetWireFormat(name, fib->T);
+    _fibEntry *entry = patricia_GetExact(fib->trie, tSegment);
     parcBuffer_Release(&tSegment);
-    if (entry == NULL) {
-        return NULL;
-    }
 
-    _fibEntry_AssertIsValid(entry);
-    if (isShortName) {
-        return entry->vector;
-    } else {
-        // Lookup prefix with the BFs
-        BloomFilter **maps = entry->filters;
-
-        // Find the longest prefix
-        int i = 0;
-        for (i = MIN(entry->numFilters + fib->T, numSegments); i > fib->T; i--) {
-            PARCBuffer *subPrefix = name_GetSubWireFormat(name, fib->T, i);
-            if (bloom_Test(entry->filters[i - fib->T - 1], subPrefix)) {
-                parcBuffer_Release(&subPrefix);
-                break;
-            }
-            parcBuffer_Release(&subPrefix);
-        }
+    if (entry != NULL && _fibEntry_HasSuffixes(entry)) {
+        _fibEntry_AssertIsValid(entry);
+
+        // Find the longest suffix, testing each length against the entry's one filter. Each filter
+        // hit is verified in the exact-match table with the same hash, and a false positive
+        // moves on to the next shorter length.
+        for (int i = MIN(entry->maxSuffixLength + fib->T, numSegments); i > fib->T; i--) {
+            uint64_t h1 = 0;
+            uint64_t h2 = 0;
+            PARCBuffer *suffix = name_GetSubWireFormat(name, fib->T, i);
+            _fibTBF_HashSuffix(entry, i - fib->T, suffix, &h1, &h2);
+            parcBuffer_Release(&suffix);
 
-        // We didn't find a hit in the bloom filters, so return the vector associated with the trie lookup
-        if (i == fib->T) {
-            return entry->vector;
-        } else {
-            PARCBuffer *matchingPrefix = name_GetWireFormat(name, i);
-            void *result = map_Get(fib->map, matchingPrefix);
-            parcBuffer_Release(&matchingPrefix);
-            return result;
+            if (_fibTBF_TestSuffixHash(entry, h1, h2)) {
+                PARCBuffer *key = _fibTBF_CreateSuffixKey(entry, h1);
+                Bitmap *result = map_GetHashed(fib->map, key);
+                parcBuffer_Release(&key);
+                if (result != NULL) {
+                    return result;
+                }
+            }
         }
     }
 
-    return NULL;
+    // No suffix matched, so fall back to the prefixes of at most T segments
+    if (entry != NULL && entry->vector != NULL) {
+        return entry->vector;
+    }
+    return _fibTBF_TrieLPM(fib, name, fib->T - 1);
 }
 
 bool
@@ -127,54 +267,23 @@ fibTBF_Insert(FIBTBF *fib, const Name *name, Bitmap *egressVector)
     bool isShortName = numSegments <= fib->T;
 
     PARCBuffer *tSegment = name_GetWireFormat(name, MIN(fib->T, numSegments));
-    _fibEntry *entry = patricia_Get(fib->trie, tSegment);
+    _fibEntry *entry = patricia_GetExact(fib->trie, tSegment);
 
     if (entry != NULL) {
         if (isShortName) { // if it's a short name, then insert into the BitMap
-            bitmap_SetVector(entry->vector, egressVector);
+            _fibTBF_SetPrefixVector(entry, egressVector);
         } else { // else, insert into the BF
-            int B = numSegments - fib->T;
-            assertTrue(B > 0, "A BF entry must have at least T segments");
-
-            if (B > entry->numFilters) {
-                entry->filters = (BloomFilter **) realloc(entry->filters, (B + 1) * sizeof(BloomFilter *));
-                for (int i = entry->numFilters; i <= B; i++) {
-                    entry->filters[i] = bloom_Create(fib->m, fib->k);
-                }
-                entry->numFilters = B;
-            }
-
-            PARCBuffer *suffix = name_GetSubWireFormat(name, fib->T, numSegments);
-            bloom_Add(entry->filters[B], suffix);
-            parcBuffer_Release(&suffix);
-
-            PARCBuffer *entireName = name_GetWireFormat(name, numSegments);
-            map_Insert(fib->map, entireName, egressVector);
-            parcBuffer_Release(&entireName);
+            _fibTBF_AddSuffix(fib, entry, name, egressVector);
         }
     } else {
         _fibEntry *newEntry = NULL;
         if (isShortName) {
-            newEntry = _fibEntry_Create(_FIBEntryType_Bitmap);
+            newEntry = _fibEntry_Create(_FIBEntryType_Bitmap, fib->numEntries++);
             newEntry->vector = egressVector;
         } else {
-            newEntry = _fibEntry_Create(_FIBEntryType_BF);
-            newEntry->vector = egressVector;
-            int B = numSegments - fib->T;
-
-            newEntry->filters = (BloomFilter **) malloc((B + 1) * sizeof(BloomFilter *));
-            for (int i = 0; i <= B; i++) {
-                newEntry->filters[i] = bloom_Create(fib->m, fib->k);
-            }
-            newEntry->numFilters = B;
-
-            PARCBuffer *suffix = name_GetSubWireFormat(name, fib->T, numSegments);
-            bloom_Add(newEntry->filters[B], suffix);
-            parcBuffer_Release(&suffix);
-
-            PARCBuffer *entireName = name_GetWireFormat(name, numSegments);
-            map_Insert(fib->map, entireName, egressVector);
-            parcBuffer_Release(&entireName);
+            // The T-segment prefix itself is not in the FIB unless it is inserted later
+            newEntry = _fibEntry_Create(_FIBEntryType_BF, fib->numEntries++);
+            _fibTBF_AddSuffix(fib, newEntry, name, egressVector);
         }
 
         patricia_Insert(fib->trie, tSegment, newEntry);
@@ -188,6 +297,176 @@ fibTBF_Insert(FIBTBF *fib, const Name *name, Bitmap *egressVector)
     return true;
 }
 
+typedef struct {
+    FIBTBF *fib;
+    Name **names;
+    _fibEntry **entries;
+
+    // Long names grouped by trie entry id, with the suffix hashes and key each of them is stored
+    // under, and the vector the exact-match table then holds for it
+    size_t *order;
+    size_t *groupStarts;
+    uint64_t *hashes;
+    PARCBuffer **keys;
+    void **items;
+    void **results;
+} _FIBTBFBulkLoad;
+
+// All suffixes of one trie entry are hashed and filtered by the same thread, so its filter needs no locking
+static void
+_fibTBF_HashSuffixGroup(void *context, size_t id)
+{
+    _FIBTBFBulkLoad *bulk = (_FIBTBFBulkLoad *) context;
+    FIBTBF *fib = bulk->fib;
+
+    for (size_t i = bulk->groupStarts[id]; i < bulk->groupStarts[id + 1]; i++) {
+        _fibEntry *entry = bulk->entries[bulk->order[i]];
+        _fibTBF_HashNameSuffix(fib, entry, bulk->names[bulk->order[i]], &bulk->hashes[2 * i], &bulk->hashes[2 * i + 1]);
+        bulk->keys[i] = _fibTBF_CreateSuffixKey(entry, bulk->hashes[2 * i]);
+    }
+}
+
+// Only the names that added their key to the exact-match table are filtered, as with inserts
+static void
+_fibTBF_FilterSuffixGroup(void *context, size_t id)
+{
+    _FIBTBFBulkLoad *bulk = (_FIBTBFBulkLoad *) context;
+    for (size_t i = bulk->groupStarts[id]; i < bulk->groupStarts[id + 1]; i++) {
+        if (bulk->results[i] == bulk->items[i]) {
+            _fibTBF_FilterSuffixHash(bulk->entries[bulk->order[i]], bulk->hashes[2 * i], bulk->hashes[2 * i + 1]);
+        }
+    }
+}
+
+static void
+_fibTBF_MergeVector(void *existing, void *vector)
+{
+    bitmap_SetVector((Bitmap *) existing, (Bitmap *) vector);
+}
+
+bool
+fibTBF_BulkLoad(FIBTBF *fib, Name *names[], Bitmap *vectors[], size_t n, int threads)
+{
+    size_t capacity = n > 0 ? n : 1;
+    _fibEntry **entries = (_fibEntry **) calloc(capacity, sizeof(_fibEntry *));
+
+    // The trie holds one entry per distinct T-segment prefix and is built on this thread.
+    // Short names are complete once their entry is found; long names are left for the suffix stage.
+    size_t numLong = 0;
+    for (size_t i = 0; i < n; i++) {
+        int numSegments = name_GetSegmentCount(names[i]);
+        if (numSegments == 0) {
+            continue;
+        }
+        bool isShortName = numSegments <= fib->T;
+
+        PARCBuffer *tSegment = name_GetWireFormat(names[i], MIN(fib->T, numSegments));
+        _fibEntry *entry = patricia_GetExact(fib->trie, tSegment);
+        if (entry == NULL) {
+            entry = _fibEntry_Create(isShortName ? _FIBEntryType_Bitmap : _FIBEntryType_BF, fib->numEntries++);
+            patricia_Insert(fib->trie, tSegment, entry);
+        }
+        parcBuffer_Release(&tSegment);
+
+        if (isShortName) {
+            _fibTBF_SetPrefixVector(entry, vectors[i]);
+        } else {
+            entries[i] = entry;
+            numLong++;
+        }
+    }
+
+    // Group the long names by entry id, which is dense over every entry ever created
+    _FIBTBFBulkLoad bulk = {
+            .fib = fib,
+            .names = names,
+            .entries = entries,
+            .order = (size_t *) malloc((numLong > 0 ? numLong : 1) * sizeof(size_t)),
+            .groupStarts = (size_t *) calloc(fib->numEntries + 1, sizeof(size_t)),
+            .hashes = (uint64_t *) malloc((numLong > 0 ? numLong : 1) * 2 * sizeof(uint64_t)),
+            .keys = (PARCBuffer **) malloc((numLong > 0 ? numLong : 1) * sizeof(PARCBuffer *)),
+            .items = (void **) malloc((numLong > 0 ? numLong : 1) * sizeof(void *)),
+            .results = (void **) malloc((numLong > 0 ? numLong : 1) * sizeof(void *)),
+    };
+    for (size_t i = 0; i < n; i++) {
+        if (entries[i] != NULL) {
+            bulk.groupStarts[entries[i]->id + 1]++;
+        }
+    }
+    for (uint64_t id = 0; id < fib->numEntries; id++) {
+        bulk.groupStarts[id + 1] += bulk.groupStarts[id];
+    }
+    size_t *next = (size_t *) malloc((fib->numEntries + 1) * sizeof(size_t));
+    memcpy(next, bulk.groupStarts, (fib->numEntries + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        if (entries[i] != NULL) {
+            bulk.order[next[entries[i]->id]++] = i;
+        }
+    }
+    free(next);
+
+    parallel_For(threads, fib->numEntries, _fibTBF_HashSuffixGroup, &bulk);
+
+    // The exact-match table is shared by every entry, so it is filled by hash range
+    for (size_t i = 0; i < numLong; i++) {
+        bulk.items[i] = vectors[bulk.order[i]];
+    }
+    map_BulkInsert(fib->map, numLong, bulk.keys, bulk.items, true, _fibTBF_MergeVector, bulk.results, threads);
+    for (size_t i = 0; i < numLong; i++) {
+        parcBuffer_Release(&bulk.keys[i]);
+    }
+
+    parallel_For(threads, fib->numEntries, _fibTBF_FilterSuffixGroup, &bulk);
+
+    free(bulk.results);
+    free(bulk.items);
+    free(bulk.keys);
+    free(bulk.hashes);
+    free(bulk.groupStarts);
+    free(bulk.order);
+    free(entries);
+    return true;
+}
+
+bool
+fibTBF_Remove(FIBTBF *fib, const Name *name)
+{
+    int numSegments = name_GetSegmentCount(name);
+    bool isShortName = numSegments <= fib->T;
+
+    PARCBuffer *tSegment = name_GetWireFormat(name, MIN(fib->T, numSegments));
+    _fibEntry *entry = patricia_GetExact(fib->trie, tSegment);
+    parcBuffer_Release(&tSegment);
+
+    // The trie entry stays, since longer names may still be filed under it
+    if (isShortName) {
+        bool wasPresent = entry != NULL && entry->vector != NULL;
+        if (wasPresent) {
+            entry->vector = NULL;
+        }
+        return wasPresent;
+    }
+    if (entry == NULL || !_fibEntry_HasSuffixes(entry)) {
+        return false;
+    }
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    PARCBuffer *suffix = name_GetSubWireFormat(name, fib->T, numSegments);
+    _fibTBF_HashSuffix(entry, numSegments - fib->T, suffix, &h1, &h2);
+    parcBuffer_Release(&suffix);
+
+    PARCBuffer *key = _fibTBF_CreateSuffixKey(entry, h1);
+    Bitmap *removed = map_RemoveHashed(fib->map, key);
+    parcBuffer_Release(&key);
+
+    // A Bloom filter keeps the suffix, which lookups then reject in the exact-match table
+    if (removed != NULL && entry->cuckoo != NULL) {
+        cuckooFilter_RemoveHashPair(entry->cuckoo, h1, h2);
+    }
+    return removed != NULL;
+}
+
 void
 fibTBF_Destroy(FIBTBF **fibP)
 {
@@ -195,6 +474,7 @@ fibTBF_Destroy(FIBTBF **fibP)
 
     patricia_Destroy(&fib->trie);
     map_Destroy(&fib->map);
+    siphasher_Destroy(&fib->hasher);
 
     free(fib);
     *fibP = NULL;
@@ -208,8 +488,29 @@ fibTBF_Create(int T, int m, int k)
         fib->T = T;
         fib->m = m;
         fib->k = k;
+        fib->targetFPR = 0.0;
+        fib->filterType = FilterType_Bloom;
         fib->trie = patricia_Create(_fibEntry_Destroy);
-        fib->map = map_Create(bitmap_Destroy);
+        fib->map = map_Create(NULL);
+        fib->numEntries = 0;
+        fib->hasher = bloom_CreateHasher();
+    }
+    return fib;
+}
+
+FIBTBF *
+fibTBF_CreateOptimal(int T, double targetFPR)
+{
+    return fibTBF_CreateOptimalWithFilter(T, targetFPR, FilterType_Bloom);
+}
+
+FIBTBF *
+fibTBF_CreateOptimalWithFilter(int T, double targetFPR, FilterType type)
+{
+    FIBTBF *fib = fibTBF_Create(T, 0, 0);
+    if (fib != NULL) {
+        fib->targetFPR = targetFPR;
+        fib->filterType = type;
     }
     return fib;
 }
@@ -217,6 +518,7 @@ fibTBF_Create(int T, int m, int k)
 FIBInterface *TBFAsFIB = &(FIBInterface) {
         .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibTBF_LPM,
         .Insert = (bool (*)(void *instance, const Name *ccnxName, Bitmap *vector)) fibTBF_Insert,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibTBF_BulkLoad,
         .Destroy = (void (*)(void **instance)) fibTBF_Destroy,
 };
 
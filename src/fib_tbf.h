@@ -6,11 +6,17 @@ extern "C" {
 #define fib_tbf_h
 
 #include "fib.h"
+#include "cuckoo_filter.h"
 
 struct fib_tbf;
 typedef struct fib_tbf FIBTBF;
 
 FIBTBF *fibTBF_Create(int T, int m, int k);
+FIBTBF *fibTBF_CreateOptimal(int T, double targetFPR);
+
+// With FilterType_Cuckoo, the suffix filters are cuckoo filters, whose false positive rate is set
+// by their fingerprint size (see cuckoo_filter.h) rather than by targetFPR
+FIBTBF *fibTBF_CreateOptimalWithFilter(int T, double targetFPR, FilterType type);
 void fibTBF_Destroy(FIBTBF **fibP);
 
 extern FIBInterface *TBFAsFIB;
@@ -18,6 +24,15 @@ extern FIBInterface *TBFAsFIB;
 bool fibTBF_Insert(FIBTBF *fib, const Name *name, Bitmap *vector);
 Bitmap *fibTBF_LPM(FIBTBF *fib, const Name *name);
 
+// Take name out of the FIB, with the vector its inserts were merged into, which stays the caller's.
+// A long name's suffix also leaves a cuckoo filter; a Bloom filter keeps it, and lookups reject it
+// in the exact-match table. Returns false if name was not in the FIB.
+bool fibTBF_Remove(FIBTBF *fib, const Name *name);
+
+// Insert names[i] with vectors[i]: the trie on the calling thread, then the suffix filters entry
+// by entry and the exact-match table by hash range, on up to threads threads.
+bool fibTBF_BulkLoad(FIBTBF *fib, Name *names[], Bitmap *vectors[], size_t n, int threads);
+
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "hasher.h"
+#include "random.h"
+#include "timer.h"
+
+#define DEFAULT_BYTES_PER_LENGTH (16 * 1024 * 1024)
+
+// Name (prefix) lengths, in bytes, from single short segments to long multi-segment names
+static const size_t _nameLengths[] = { 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
+
+void usage() {
+    fprintf(stderr, "usage: hash_perf [-H hash]... [-b bytes] [-m batch]\n");
+    fprintf(stderr, "   - hash  = A hash function to measure (default: all): ['sha256', 'siphash', 'siphash13', 'xxhash', 'wyhash', 'crc32c']\n");
+    fprintf(stderr, "   - bytes = The number of bytes hashed per input length\n");
+    fprintf(stderr, "   - batch = Hash inputs batch at a time with hasher_HashMany (SIMD lanes for siphash)\n");
+}
+
+static void
+_measureHasher(const char *name, size_t totalBytes, PARCBuffer *input, int batch)
+{
+    Hasher *hasher = hasher_CreateNamed(name);
+    if (hasher == NULL) {
+        fprintf(stderr, "Invalid hash function specified: %s\n", name);
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t *bytes = parcBuffer_Overlay(input, 0);
+    for (size_t i = 0; i < sizeof(_nameLengths) / sizeof(_nameLengths[0]); i++) {
+        size_t length = _nameLengths[i];
+        size_t iterations = totalBytes / length;
+
+        // Vary the start so consecutive inputs differ, as they do in a trace
+        struct timespec start = timerStart();
+        if (batch > 1) {
+            size_t lengths[batch];
+            uint8_t *inputs[batch];
+            uint8_t digests[batch][8];
+            uint8_t *outputs[batch];
+            for (size_t j = 0; j < iterations; j += batch) {
+                for (int b = 0; b < batch; b++) {
+                    lengths[b] = length;
+                    inputs[b] = bytes + ((j + b) % 64);
+                    outputs[b] = digests[b];
+                }
+                hasher_HashMany(hasher, batch, lengths, inputs, outputs, sizeof(digests[0]));
+            }
+        } else {
+            for (size_t j = 0; j < iterations; j++) {
+                PARCBuffer *digest = hasher_HashArray(hasher, length, bytes + (j % 64));
+                parcBuffer_Release(&digest);
+            }
+        }
+        long elapsedTime = timerEnd(start);
+
+        // Batched runs round the iteration count up to whole batches
+        if (batch > 1) {
+            iterations = ((iterations + batch - 1) / batch) * batch;
+        }
+
+        printf("%s%s,%zu,%f,%f\n", name, batch > 1 ? "-many" : "", length,
+            (double) elapsedTime / iterations, (double) elapsedTime / (iterations * length));
+    }
+
+    hasher_Destroy(&hasher);
+}
+
+int
+main(int argc, char **argv)
+{
+    static struct option longopts[] = {
+            { "hash",  required_argument, NULL, 'H' },
+            { "bytes", required_argument, NULL, 'b' },
+            { "many",  required_argument, NULL, 'm' },
+            { "help",  no_argument,       NULL, 'h' },
+            { NULL,0,NULL,0}
+    };
+
+    int numHashers = 0;
+    while (HasherNames[numHashers] != NULL) {
+        numHashers++;
+    }
+
+    const char **names = (const char **) calloc(argc + numHashers, sizeof(char *));
+    int numNames = 0;
+    size_t totalBytes = DEFAULT_BYTES_PER_LENGTH;
+    int batch = 1;
+
+    int c;
+    while ((c = getopt_long(argc, argv, "hH:b:m:", longopts, NULL)) != -1) {
+        switch (c) {
+            case 'H':
+                names[numNames++] = optarg;
+                break;
+            case 'b':
+                totalBytes = strtoull(optarg, NULL, 10);
+                break;
+            case 'm':
+                batch = atoi(optarg);
+                break;
+            case 'h':
+                usage();
+                exit(EXIT_SUCCESS);
+            default:
+                usage();
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (numNames == 0) {
+        for (; numNames < numHashers; numNames++) {
+            names[numNames] = HasherNames[numNames];
+        }
+    }
+
+    size_t maxLength = _nameLengths[sizeof(_nameLengths) / sizeof(_nameLengths[0]) - 1];
+    PARCBuffer *input = random_Bytes(parcBuffer_Allocate(maxLength + 64));
+
+    printf("hash,length,ns_per_hash,ns_per_byte\n");
+    for (int i = 0; i < numNames; i++) {
+        _measureHasher(names[i], totalBytes, input, batch);
+    }
+
+    parcBuffer_Release(&input);
+    free(names);
+    return EXIT_SUCCESS;
+}
@@ -4,9 +4,19 @@
 
 #include "hasher.h"
 #include "siphash24.h"
+#include "siphasher.h"
+#include "sha256hasher.h"
+#include "xxhasher.h"
+#include "wyhasher.h"
+#include "crc32chasher.h"
+#include "random.h"
+
+#include <string.h>
 
 #include <parc/algol/parc_Memory.h>
 
+const char *HasherNames[] = { "sha256", "siphash", "siphash13", "xxhash", "wyhash", "crc32c", NULL };
+
 struct hasher {
     void *instance;
     HasherInterface *interface;
@@ -39,7 +49,7 @@ hasher_Hash(Hasher *hasher, PARCBuffer *input)
 }
 
 PARCBuffer *
-hasher_HashArray(Hasher *hasher, size_t length, uint8_t input[length])
+hasher_HashArray(Hasher *hasher, size_t length, uint8_t input[])
 {
     return hasher->interface->HashArray(hasher->instance, length, input);
 }
@@ -51,9 +61,28 @@ hasher_HashToVector(Hasher *hasher, PARCBuffer *input, int range)
 }
 
 Bitmap *
-hasher_HashArrayToVector(Hasher *hasher, size_t length, uint8_t input[length], int range)
+hasher_HashArrayToVector(Hasher *hasher, size_t length, uint8_t input[], int range)
 {
-    return hasher->interface->HashArrayToVector(hasher, length, input, range);
+    return hasher->interface->HashArrayToVector(hasher->instance, length, input, range);
+}
+
+void
+hasher_HashMany(Hasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                uint8_t *outputs[], size_t outputLength)
+{
+    if (hasher->interface->HashMany != NULL) {
+        hasher->interface->HashMany(hasher->instance, count, lengths, inputs, outputs, outputLength);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        PARCBuffer *digest = hasher->interface->HashArray(hasher->instance, lengths[i], inputs[i]);
+        size_t digestLength = parcBuffer_Remaining(digest);
+        size_t copyLength = digestLength < outputLength ? digestLength : outputLength;
+        memset(outputs[i], 0, outputLength);
+        memcpy(outputs[i], parcBuffer_Overlay(digest, 0), copyLength);
+        parcBuffer_Release(&digest);
+    }
 }
 
 PARCBuffer *
@@ -62,4 +91,43 @@ hasher_HashTruncated(Hasher *hasher, PARCBuffer *input, int limit)
     PARCBuffer *hash = hasher_Hash(hasher, input);
     parcBuffer_SetLimit(hash, limit);
     return hash;
-}
\ No newline at end of file
+}
+
+static uint64_t
+_hasher_RandomSeed()
+{
+    PARCBuffer *seed = random_Bytes(parcBuffer_Allocate(sizeof(uint64_t)));
+    uint64_t value = parcBuffer_GetUint64(seed);
+    parcBuffer_Release(&seed);
+    return value;
+}
+
+Hasher *
+hasher_CreateNamed(const char *name)
+{
+    if (strcmp(name, "sha256") == 0) {
+        return hasher_Create(sha256hasher_Create(), SHA256HashAsHasher);
+    } else if (strcmp(name, "siphash") == 0 || strcmp(name, "siphash13") == 0) {
+        PARCBuffer *key = random_Bytes(parcBuffer_Allocate(SIPHASH_KEY_LENGTH));
+        SipHasher *sipHasher = strcmp(name, "siphash") == 0 ? siphasher_Create(key) : siphasher_CreateReduced(key);
+        parcBuffer_Release(&key);
+        return hasher_Create(sipHasher, SipHashAsHasher);
+    } else if (strcmp(name, "xxhash") == 0) {
+        return hasher_Create(xxhasher_Create(_hasher_RandomSeed()), XXHashAsHasher);
+    } else if (strcmp(name, "wyhash") == 0) {
+        return hasher_Create(wyhasher_Create(_hasher_RandomSeed()), WYHashAsHasher);
+    } else if (strcmp(name, "crc32c") == 0) {
+        return hasher_Create(crc32chasher_Create((uint32_t) _hasher_RandomSeed()), CRC32CHashAsHasher);
+    }
+    return NULL;
+}
+
+size_t
+hasher_GetDigestLength(Hasher *hasher)
+{
+    uint8_t empty = 0;
+    PARCBuffer *digest = hasher_HashArray(hasher, 0, &empty);
+    size_t length = parcBuffer_Remaining(digest);
+    parcBuffer_Release(&digest);
+    return length;
+}
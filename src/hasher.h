@@ -15,11 +15,15 @@ typedef struct hasher Hasher;
 typedef struct {
     PARCBuffer *(*Hash)(void *hasher, PARCBuffer *input);
 
-    PARCBuffer *(*HashArray)(void *hasher, size_t length, uint8_t input[length]);
+    PARCBuffer *(*HashArray)(void *hasher, size_t length, uint8_t input[]);
 
     Bitmap *(*HashToVector)(void *hasher, PARCBuffer *input, int range);
 
-    Bitmap *(*HashArrayToVector)(void *hasher, size_t length, uint8_t input[length], int range);
+    Bitmap *(*HashArrayToVector)(void *hasher, size_t length, uint8_t input[], int range);
+
+    // Optional batch hash; NULL hashers are batched through HashArray
+    void (*HashMany)(void *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                     uint8_t *outputs[], size_t outputLength);
 
     void (*Destroy)(void **instance);
 } HasherInterface;
@@ -32,11 +36,24 @@ PARCBuffer *hasher_Hash(Hasher *hasher, PARCBuffer *input);
 
 PARCBuffer *hasher_HashTruncated(Hasher *hasher, PARCBuffer *input, int limit);
 
-PARCBuffer *hasher_HashArray(Hasher *hasher, size_t length, uint8_t input[length]);
+PARCBuffer *hasher_HashArray(Hasher *hasher, size_t length, uint8_t input[]);
 
 Bitmap *hasher_HashToVector(Hasher *hasher, PARCBuffer *input, int range);
 
-Bitmap *hasher_HashArrayToVector(Hasher *hasher, size_t length, uint8_t input[length], int range);
+Bitmap *hasher_HashArrayToVector(Hasher *hasher, size_t length, uint8_t input[], int range);
+
+// Hash count inputs at once into outputs[i], each truncated or zero-padded to outputLength bytes
+void hasher_HashMany(Hasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                     uint8_t *outputs[], size_t outputLength);
+
+// The names accepted by hasher_CreateNamed, NULL-terminated
+extern const char *HasherNames[];
+
+// Create a built-in hasher by name: "sha256", "siphash" (SipHash-2-4), "siphash13" (SipHash-1-3),
+// "xxhash" (XXH64), "wyhash" or "crc32c". Keyed and seeded hashers get random keys. NULL if unknown.
+Hasher *hasher_CreateNamed(const char *name);
+
+size_t hasher_GetDigestLength(Hasher *hasher);
 
 #endif //FIB_PERF_HASHER_H
 
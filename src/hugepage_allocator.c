@@ -0,0 +1,52 @@
+#include "hugepage_allocator.h"
+
+#include <stdlib.h>
+
+// A quarter of a huge page wastes at most 4x -- anything smaller stays on the heap
+const size_t HugePageAllocatorDefaultMinimumSize = 512 * 1024;
+
+struct hugepage_allocator {
+    size_t minimumSize;
+};
+
+HugePageAllocator *
+hugePageAllocator_Create(size_t minimumSize)
+{
+    HugePageAllocator *allocator = (HugePageAllocator *) malloc(sizeof(HugePageAllocator));
+    if (allocator != NULL) {
+        allocator->minimumSize = minimumSize;
+    }
+    return allocator;
+}
+
+void
+hugePageAllocator_Destroy(HugePageAllocator **allocatorP)
+{
+    free(*allocatorP);
+    *allocatorP = NULL;
+}
+
+void *
+hugePageAllocator_Allocate(HugePageAllocator *allocator, size_t size)
+{
+    if (size >= allocator->minimumSize) {
+        return allocator_MapPages(allocator_RoundToHugePages(size), true);
+    }
+    return allocator_AllocateAligned(size);
+}
+
+void
+hugePageAllocator_Deallocate(HugePageAllocator *allocator, void *memory, size_t size)
+{
+    if (size >= allocator->minimumSize) {
+        allocator_UnmapPages(memory, allocator_RoundToHugePages(size));
+    } else {
+        allocator_DeallocateAligned(memory);
+    }
+}
+
+AllocatorInterface *HugePageAsAllocator = &(AllocatorInterface) {
+        .Allocate = (void *(*)(void *, size_t)) hugePageAllocator_Allocate,
+        .Deallocate = (void (*)(void *, void *, size_t)) hugePageAllocator_Deallocate,
+        .Destroy = (void (*)(void **instance)) hugePageAllocator_Destroy,
+};
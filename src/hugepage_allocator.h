@@ -0,0 +1,31 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_HUGEPAGE_ALLOCATOR_H
+#define FIB_PERF_HUGEPAGE_ALLOCATOR_H
+
+#include "allocator.h"
+
+struct hugepage_allocator;
+typedef struct hugepage_allocator HugePageAllocator;
+
+extern const size_t HugePageAllocatorDefaultMinimumSize;
+
+extern AllocatorInterface *HugePageAsAllocator;
+
+// Allocations of at least minimumSize bytes are backed by explicit (MAP_HUGETLB) huge pages,
+// falling back to transparent huge pages when the hugetlbfs pool is empty. Smaller ones use the heap.
+HugePageAllocator *hugePageAllocator_Create(size_t minimumSize);
+
+void hugePageAllocator_Destroy(HugePageAllocator **allocatorP);
+
+void *hugePageAllocator_Allocate(HugePageAllocator *allocator, size_t size);
+
+void hugePageAllocator_Deallocate(HugePageAllocator *allocator, void *memory, size_t size);
+
+#endif //FIB_PERF_HUGEPAGE_ALLOCATOR_H
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,6 +2,11 @@
 #include "siphash24.h"
 #include "random.h"
 #include "siphasher.h"
+#include "allocator.h"
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 // Some defaults
 const int MapDefaultCapacity = 85246;
@@ -16,6 +21,9 @@ typedef struct {
 struct bucket {
     int capacity;
     int numEntries;
+
+    // Entry slots are allocated as the bucket fills, up to its capacity
+    int numSlots;
     _LinkedBucketEntry **entries;
     void (*valueDelete)(void **instance);
     struct bucket *overflow;
@@ -24,8 +32,11 @@ typedef struct bucket _LinkedBucket;
 
 typedef struct {
     int numBuckets;
-    _LinkedBucket **buckets;
+    _LinkedBucket *buckets;
     void (*valueDelete)(void **instance);
+
+    // The bucket array is one flat array from the allocator
+    Allocator *allocator;
 } _BucketMap;
 
 struct map {
@@ -36,6 +47,7 @@ struct map {
     void (*destroy)(void **);
     void *(*insert)(void *, PARCBuffer *, void *);
     void *(*get)(void *, PARCBuffer *);
+    void *(*remove)(void *, PARCBuffer *);
 };
 
 void
@@ -90,23 +102,38 @@ _linkedBucket_Create(int capacity, void (*delete)(void **instance))
         bucket->capacity = capacity;
         bucket->overflow = NULL;
         bucket->valueDelete = delete;
-        if (capacity < 0) {
-            bucket->entries = NULL;
-        } else {
-            bucket->entries = (_LinkedBucketEntry **) malloc(sizeof(_LinkedBucketEntry *) * capacity);
-        }
+        bucket->numSlots = capacity < 0 ? 0 : capacity;
+        bucket->entries = capacity < 0 ? NULL : (_LinkedBucketEntry **) malloc(sizeof(_LinkedBucketEntry *) * capacity);
     }
     return bucket;
 }
 
+// Release the entries and overflow chain of a bucket that lives in the map's bucket array
+static void
+_linkedBucket_Clear(_LinkedBucket *bucket)
+{
+    for (int i = 0; i < bucket->numEntries; i++) {
+        _LinkedBucketEntry *entry = bucket->entries[i];
+        _linkedBucketEntry_Destroy(&entry, bucket->valueDelete);
+    }
+    bucket->numEntries = 0;
+    free(bucket->entries);
+    bucket->entries = NULL;
+    bucket->numSlots = 0;
+
+    if (bucket->overflow != NULL) {
+        _linkedBucket_Destroy(&bucket->overflow);
+    }
+}
+
 static void
 _bucketMap_Destroy(_BucketMap **mapPtr)
 {
     _BucketMap *map = *mapPtr;
     for (int i = 0; i < map->numBuckets; i++) {
-        _LinkedBucket *current = map->buckets[i];
-        _linkedBucket_Destroy(&current);
+        _linkedBucket_Clear(&map->buckets[i]);
     }
+    allocator_Deallocate(map->allocator, map->buckets, sizeof(_LinkedBucket) * map->numBuckets);
     free(map);
     *mapPtr = NULL;
 }
@@ -117,9 +144,16 @@ _bucketMap_Create(void (*delete)(void **instance))
     _BucketMap *map = (_BucketMap *) malloc(sizeof(_BucketMap));
     map->valueDelete = delete;
     map->numBuckets = MapDefaultCapacity;
-    map->buckets = (_LinkedBucket **) malloc(sizeof(_LinkedBucket *) * MapDefaultCapacity);
+    map->allocator = allocator_GetDefault();
+    map->buckets = (_LinkedBucket *) allocator_Allocate(map->allocator, sizeof(_LinkedBucket) * MapDefaultCapacity);
     for (int i = 0; i < MapDefaultCapacity; i++) {
-        map->buckets[i] = _linkedBucket_Create(LinkedBucketDefaultCapacity, delete);
+        _LinkedBucket *bucket = &map->buckets[i];
+        bucket->numEntries = 0;
+        bucket->capacity = LinkedBucketDefaultCapacity;
+        bucket->numSlots = 0;
+        bucket->overflow = NULL;
+        bucket->valueDelete = delete;
+        bucket->entries = NULL;
     }
     return map;
 }
@@ -142,12 +176,14 @@ _bucketMap_ComputeBucketNumberFromHash(_BucketMap *map, PARCBuffer *key)
 static void
 _linkedBucket_AppendItem(_LinkedBucket *bucket, PARCBuffer *key, void *item)
 {
-    if (bucket->capacity == -1) {
-        if (bucket->entries == NULL) {
-            bucket->entries = malloc(sizeof(_LinkedBucketEntry *));
-        } else {
-            bucket->entries = realloc(bucket->entries, sizeof(_LinkedBucketEntry *) * (bucket->numEntries + 1));
+    // Most buckets hold a handful of entries, so slots double from a few rather than starting at capacity
+    if (bucket->numEntries == bucket->numSlots) {
+        int numSlots = bucket->numSlots == 0 ? 4 : bucket->numSlots * 2;
+        if (bucket->capacity != -1 && numSlots > bucket->capacity) {
+            numSlots = bucket->capacity;
         }
+        bucket->entries = realloc(bucket->entries, sizeof(_LinkedBucketEntry *) * numSlots);
+        bucket->numSlots = numSlots;
     }
     bucket->entries[bucket->numEntries++] = _linkedBucketEntry_Create(key, item);
 }
@@ -183,10 +219,40 @@ static void *
 _bucketMap_Get(_BucketMap *map, PARCBuffer *key)
 {
     int bucketNumber = _bucketMap_ComputeBucketNumberFromHash(map, key);
-    _LinkedBucket *bucket = map->buckets[bucketNumber];
+    _LinkedBucket *bucket = &map->buckets[bucketNumber];
     return _linkedBucket_GetItem(bucket, key);
 }
 
+// Unlink the first entry under key, shifting the rest down so that repeats keep their order
+static void *
+_linkedBucket_RemoveItem(_LinkedBucket *bucket, PARCBuffer *key)
+{
+    for (int i = 0; i < bucket->numEntries; i++) {
+        _LinkedBucketEntry *target = bucket->entries[i];
+        if (parcBuffer_Equals(key, target->key)) {
+            void *item = target->item;
+            _linkedBucketEntry_Destroy(&target, NULL);
+            bucket->numEntries--;
+            memmove(&bucket->entries[i], &bucket->entries[i + 1], (bucket->numEntries - i) * sizeof(_LinkedBucketEntry *));
+            return item;
+        }
+    }
+
+    if (bucket->overflow != NULL) {
+        return _linkedBucket_RemoveItem(bucket->overflow, key);
+    } else {
+        return NULL;
+    }
+}
+
+static void *
+_bucketMap_Remove(_BucketMap *map, PARCBuffer *key)
+{
+    int bucketNumber = _bucketMap_ComputeBucketNumberFromHash(map, key);
+    _LinkedBucket *bucket = &map->buckets[bucketNumber];
+    return _linkedBucket_RemoveItem(bucket, key);
+}
+
 static void
 _bucketMap_InsertToOverflowBucket(_BucketMap *map, _LinkedBucket *bucket, PARCBuffer *key, void *item)
 {
@@ -206,7 +272,7 @@ static void
 _bucketMap_InsertToBucket(_BucketMap *map, PARCBuffer *key, void *item)
 {
     int bucketNumber = _bucketMap_ComputeBucketNumberFromHash(map, key);
-    _LinkedBucket *bucket = map->buckets[bucketNumber];
+    _LinkedBucket *bucket = &map->buckets[bucketNumber];
 
     bool wasAdded = _linkedBucket_InsertItem(bucket, key, item);
     if (!wasAdded) {
@@ -240,6 +306,7 @@ map_Create(void (*delete)(void **instance))
         map->destroy = (void (*)(void **)) _bucketMap_Destroy;
         map->insert = (void *(*)(void *, PARCBuffer *, void *)) _bucketMap_InsertToBucket;
         map->get = (void *(*)(void *, PARCBuffer *)) _bucketMap_Get;
+        map->remove = (void *(*)(void *, PARCBuffer *)) _bucketMap_Remove;
     }
 
     return map;
@@ -281,4 +348,171 @@ map_GetHashed(Map *map, PARCBuffer *key)
 {
     void *result = map->get(map->instance, key);
     return result;
-}
\ No newline at end of file
+}
+
+void *
+map_Remove(Map *map, PARCBuffer *key)
+{
+    PARCBuffer *keyHash = _map_ComputeBucketKeyHash(map, key);
+
+    void *result = map->remove(map->instance, keyHash);
+    parcBuffer_Release(&keyHash);
+
+    return result;
+}
+
+void *
+map_RemoveHashed(Map *map, PARCBuffer *key)
+{
+    return map->remove(map->instance, key);
+}
+
+typedef struct {
+    Map *map;
+    _BucketMap *buckets;
+    PARCBuffer **keys;
+    void **items;
+    bool hashed;
+    void (*merge)(void *existing, void *item);
+    void **results;
+
+    // Whether items with absent keys are added (bulk insert) or skipped (bulk update)
+    bool insertMissing;
+
+    // The bucket key (the key's hash, or the key itself when pre-hashed) and bucket of every item
+    PARCBuffer **bucketKeys;
+    int *bucketNumbers;
+
+    // Item indices grouped by partition (a run of adjacent buckets), in batch order within each
+    int bucketsPerPartition;
+    size_t *order;
+    size_t *partitionStarts;
+} _MapBulkInsert;
+
+static void
+_map_BulkHashKey(void *context, size_t index)
+{
+    _MapBulkInsert *bulk = (_MapBulkInsert *) context;
+    if (bulk->hashed) {
+        bulk->bucketKeys[index] = bulk->keys[index];
+    } else {
+        bulk->bucketKeys[index] = _map_ComputeBucketKeyHash(bulk->map, bulk->keys[index]);
+    }
+    bulk->bucketNumbers[index] = _bucketMap_ComputeBucketNumberFromHash(bulk->buckets, bulk->bucketKeys[index]);
+}
+
+// Fill one partition. No other thread touches its buckets, so they need no locking.
+static void
+_map_BulkInsertPartition(void *context, size_t partition)
+{
+    _MapBulkInsert *bulk = (_MapBulkInsert *) context;
+    for (size_t i = bulk->partitionStarts[partition]; i < bulk->partitionStarts[partition + 1]; i++) {
+        size_t index = bulk->order[i];
+        PARCBuffer *key = bulk->bucketKeys[index];
+        _LinkedBucket *bucket = &bulk->buckets->buckets[bulk->bucketNumbers[index]];
+
+        void *stored = bulk->items[index];
+        void *existing = bulk->merge == NULL ? NULL : _linkedBucket_GetItem(bucket, key);
+        if (existing != NULL) {
+            bulk->merge(existing, stored);
+            stored = existing;
+        } else if (!bulk->insertMissing) {
+            stored = NULL;
+        } else if (!_linkedBucket_InsertItem(bucket, key, stored)) {
+            _bucketMap_InsertToOverflowBucket(bulk->buckets, bucket, key, stored);
+        }
+
+        if (bulk->results != NULL) {
+            bulk->results[index] = stored;
+        }
+        if (!bulk->hashed) {
+            parcBuffer_Release(&bulk->bucketKeys[index]);
+        }
+    }
+}
+
+static void
+_map_Bulk(Map *map, size_t n, PARCBuffer *keys[n], void *items[n], bool hashed,
+          void (*merge)(void *existing, void *item), void *results[], bool insertMissing, int threads)
+{
+    if (threads <= 0) {
+        threads = parallel_GetDefaultThreads();
+    }
+
+    _BucketMap *buckets = (_BucketMap *) map->instance;
+    int numPartitions = threads * 16 < buckets->numBuckets ? threads * 16 : buckets->numBuckets;
+
+    _MapBulkInsert bulk = {
+            .map = map,
+            .buckets = buckets,
+            .keys = keys,
+            .items = items,
+            .hashed = hashed,
+            .merge = merge,
+            .results = results,
+            .insertMissing = insertMissing,
+            .bucketKeys = (PARCBuffer **) malloc(n * sizeof(PARCBuffer *)),
+            .bucketNumbers = (int *) malloc(n * sizeof(int)),
+            .bucketsPerPartition = (buckets->numBuckets + numPartitions - 1) / numPartitions,
+            .order = (size_t *) malloc(n * sizeof(size_t)),
+            .partitionStarts = (size_t *) calloc(numPartitions + 1, sizeof(size_t)),
+    };
+
+    parallel_For(threads, n, _map_BulkHashKey, &bulk);
+
+    // Counting sort by partition, stable so that equal keys are resolved in batch order
+    for (size_t i = 0; i < n; i++) {
+        bulk.partitionStarts[bulk.bucketNumbers[i] / bulk.bucketsPerPartition + 1]++;
+    }
+    for (int p = 0; p < numPartitions; p++) {
+        bulk.partitionStarts[p + 1] += bulk.partitionStarts[p];
+    }
+    size_t *next = (size_t *) malloc(numPartitions * sizeof(size_t));
+    for (int p = 0; p < numPartitions; p++) {
+        next[p] = bulk.partitionStarts[p];
+    }
+    for (size_t i = 0; i < n; i++) {
+        bulk.order[next[bulk.bucketNumbers[i] / bulk.bucketsPerPartition]++] = i;
+    }
+    free(next);
+
+    parallel_For(threads, numPartitions, _map_BulkInsertPartition, &bulk);
+
+    free(bulk.partitionStarts);
+    free(bulk.order);
+    free(bulk.bucketNumbers);
+    free(bulk.bucketKeys);
+}
+
+void
+map_BulkInsert(Map *map, size_t n, PARCBuffer *keys[], void *items[], bool hashed,
+               void (*merge)(void *existing, void *item), void *results[], int threads)
+{
+    _map_Bulk(map, n, keys, items, hashed, merge, results, true, threads);
+}
+
+void
+map_BulkUpdate(Map *map, size_t n, PARCBuffer *keys[], void *args[], bool hashed,
+               void (*update)(void *existing, void *arg), int threads)
+{
+    _map_Bulk(map, n, keys, args, hashed, update, NULL, false, threads);
+}
+
+void
+map_ForEach(Map *map, void (*visit)(void *context, PARCBuffer *storedKey, void *item), void *context)
+{
+    _BucketMap *buckets = (_BucketMap *) map->instance;
+    for (int i = 0; i < buckets->numBuckets; i++) {
+        for (_LinkedBucket *bucket = &buckets->buckets[i]; bucket != NULL; bucket = bucket->overflow) {
+            for (int j = 0; j < bucket->numEntries; j++) {
+                visit(context, bucket->entries[j]->key, bucket->entries[j]->item);
+            }
+        }
+    }
+}
+
+void
+map_DigestKey(Map *map, PARCBuffer *key, uint8_t digest[])
+{
+    siphasher_Digest(map->hasher, parcBuffer_Remaining(key), parcBuffer_Overlay(key, 0), digest);
+}
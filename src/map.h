@@ -5,6 +5,9 @@ extern "C" {
 #ifndef map_h_
 #define map_h_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <parc/algol/parc_Buffer.h>
 
 struct map;
@@ -12,7 +15,7 @@ typedef struct map Map;
 
 extern const int MapDefaultCapacity;
 
-Map *map_Create(void (*delete)(void **instance));
+Map *map_Create(void (*deleteItem)(void **instance));
 
 void map_Destroy(Map **map);
 
@@ -24,6 +27,32 @@ void map_InsertHashed(Map *map, PARCBuffer *key, void *item);
 
 void *map_GetHashed(Map *map, PARCBuffer *key);
 
+// Take out the item map_Get (or map_GetHashed) would return, without deleting it, and return it,
+// or NULL if the key is absent. Later items stored under the same key stay.
+void *map_Remove(Map *map, PARCBuffer *key);
+
+void *map_RemoveHashed(Map *map, PARCBuffer *key);
+
+// Insert n items at once on up to threads threads (0 for one per core): the keys are hashed in
+// parallel, then disjoint bucket ranges are filled in parallel. Keys are raw (as for map_Insert)
+// or already hashed (as for map_InsertHashed). With a merge function, an item whose key is
+// already present (in the map or earlier in the batch) is merged into the existing item instead
+// of being added. results[i], if given, receives the item stored for keys[i].
+void map_BulkInsert(Map *map, size_t n, PARCBuffer *keys[], void *items[], bool hashed,
+                    void (*merge)(void *existing, void *item), void *results[], int threads);
+
+// As map_BulkInsert, but only calls update(item, args[i]) on the items already stored under
+// keys[i]; absent keys are skipped. Updates of one item are applied in batch order.
+void map_BulkUpdate(Map *map, size_t n, PARCBuffer *keys[], void *args[], bool hashed,
+                    void (*update)(void *existing, void *arg), int threads);
+
+// Visit every stored item with the key it is filed under: the map_DigestKey digest of a raw key,
+// or the key itself for hashed inserts. Items stored under one key are visited in insertion order.
+void map_ForEach(Map *map, void (*visit)(void *context, PARCBuffer *storedKey, void *item), void *context);
+
+// The SIPHASH_HASH_LENGTH-byte digest map_Insert files a raw key under
+void map_DigestKey(Map *map, PARCBuffer *key, uint8_t digest[]);
+
 #endif // map_h_
 
 #ifdef __cplusplus
@@ -0,0 +1,416 @@
+#include "multi_length_table.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+
+#define MULTI_LENGTH_LANES 16
+
+// Five fingerprints and their values fill a cache line
+#define MULTI_LENGTH_SLOTS 5
+#define MULTI_LENGTH_BUCKET_BITS 6
+
+const int MultiLengthTableLanes = MULTI_LENGTH_LANES;
+
+// Empty slots hold fingerprint 0. A hit needs no other line than the bucket itself.
+typedef struct {
+    uint64_t fingerprints[MULTI_LENGTH_SLOTS];
+    uint32_t values[MULTI_LENGTH_SLOTS];
+    uint32_t unused;
+} __attribute__((aligned(64))) _Bucket;
+
+// One prefix length. Fingerprints that find their bucket full go to the stash, sorted, which is
+// only searched when a lookup misses in a full bucket.
+typedef struct {
+    size_t numBuckets;
+    _Bucket *buckets;
+
+    size_t numStashed;
+    uint64_t *stash;
+    uint32_t *stashValues;
+} _Level;
+
+typedef struct {
+    uint64_t key;
+    size_t index;
+} _StashEntry;
+
+struct multi_length_table {
+    int numLevels;
+    _Level *levels;
+
+    // The bucket counts and bucket arrays of the first 16 lengths, lane by lane, for the vector
+    // bucket computation. Lanes past the longest length point at an empty bucket.
+    uint64_t numBuckets[MULTI_LENGTH_LANES] __attribute__((aligned(32)));
+    uint64_t bases[MULTI_LENGTH_LANES] __attribute__((aligned(32)));
+
+    // Bit l is set if length l + 1 has a stash
+    uint32_t stashedLanes;
+
+    int (*probe)(const MultiLengthTable *table, int lanes, const uint64_t keys[], uint32_t *value);
+
+    Allocator *allocator;
+};
+
+static const _Bucket _emptyBucket = { { 0 } };
+
+static inline uint64_t
+_multiLengthTable_Key(uint64_t fingerprint)
+{
+    return fingerprint | (fingerprint == 0);
+}
+
+static uint64_t
+_multiLengthTable_Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+void
+multiLengthTable_Fingerprints(WYHasher *hasher, uint64_t seed, const Name *name, int count, uint64_t fingerprints[])
+{
+    const uint8_t *buffer = name_GetBuffer(name);
+    uint64_t fingerprint = seed;
+    int start = 0;
+    for (int d = 1; d <= count; d++) {
+        int end = name_GetPrefixLength(name, d);
+        uint64_t segmentHash = wyhasher_Hash64(hasher, end - start, buffer + start);
+        fingerprint = _multiLengthTable_Mix(fingerprint ^ segmentHash);
+        fingerprints[d - 1] = fingerprint;
+        start = end;
+    }
+}
+
+// Buckets are picked by multiplying the low half of the key by the bucket count, so any count works
+static inline uint64_t
+_multiLengthTable_Bucket(uint64_t key, uint64_t numBuckets)
+{
+    return ((key & UINT32_MAX) * numBuckets) >> 32;
+}
+
+// The slot of key in the bucket, or -1
+static inline int
+_multiLengthTable_Find(const _Bucket *bucket, uint64_t key)
+{
+    for (int s = 0; s < MULTI_LENGTH_SLOTS; s++) {
+        if (bucket->fingerprints[s] == key) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+static inline bool
+_multiLengthTable_IsFull(const _Bucket *bucket)
+{
+    return bucket->fingerprints[MULTI_LENGTH_SLOTS - 1] != 0;
+}
+
+static bool
+_multiLengthTable_FindStashed(const _Level *level, uint64_t key, uint32_t *value)
+{
+    size_t low = 0;
+    size_t high = level->numStashed;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (level->stash[middle] < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < level->numStashed && level->stash[low] == key) {
+        *value = level->stashValues[low];
+        return true;
+    }
+    return false;
+}
+
+static bool
+_multiLengthTable_FindLevel(const _Level *level, uint64_t key, uint32_t *value)
+{
+    const _Bucket *bucket = &level->buckets[_multiLengthTable_Bucket(key, level->numBuckets)];
+    int slot = _multiLengthTable_Find(bucket, key);
+    if (slot >= 0) {
+        *value = bucket->values[slot];
+        return true;
+    }
+    return _multiLengthTable_IsFull(bucket) && _multiLengthTable_FindStashed(level, key, value);
+}
+
+// The longest of the lanes hit in their buckets, unless a longer lane missed in a full bucket and
+// is found in its stash
+static int
+_multiLengthTable_Resolve(const MultiLengthTable *table, uint32_t hits, uint32_t full, const _Bucket *buckets[],
+                          const int slots[], const uint64_t keys[], uint32_t *value)
+{
+    int longest = hits != 0 ? 31 - __builtin_clz(hits) : -1;
+    uint32_t longer = longest >= 0 ? ~((2u << longest) - 1) : ~0u;
+    uint32_t stashed = full & ~hits & table->stashedLanes & longer;
+    while (stashed != 0) {
+        int l = 31 - __builtin_clz(stashed);
+        if (_multiLengthTable_FindStashed(&table->levels[l], keys[l], value)) {
+            return l + 1;
+        }
+        stashed &= ~(1u << l);
+    }
+
+    if (longest < 0) {
+        return 0;
+    }
+    *value = buckets[longest]->values[slots[longest]];
+    return longest + 1;
+}
+
+static int
+_multiLengthTable_ProbeScalar(const MultiLengthTable *table, int lanes, const uint64_t keys[], uint32_t *value)
+{
+    const _Bucket *buckets[MULTI_LENGTH_LANES];
+    for (int l = 0; l < lanes; l++) {
+        buckets[l] = (const _Bucket *) (uintptr_t) table->bases[l] + _multiLengthTable_Bucket(keys[l], table->numBuckets[l]);
+        __builtin_prefetch(buckets[l]);
+    }
+
+    uint32_t hits = 0;
+    uint32_t full = 0;
+    int slots[MULTI_LENGTH_LANES];
+    for (int l = 0; l < lanes; l++) {
+        slots[l] = _multiLengthTable_Find(buckets[l], keys[l]);
+        hits |= (uint32_t) (slots[l] >= 0) << l;
+        full |= (uint32_t) _multiLengthTable_IsFull(buckets[l]) << l;
+    }
+    return _multiLengthTable_Resolve(table, hits, full, buckets, slots, keys, value);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+#define MULTI_LENGTH_HAS_SIMD 1
+
+__attribute__((target("avx2")))
+static int
+_multiLengthTable_ProbeAVX2(const MultiLengthTable *table, int lanes, const uint64_t keys[], uint32_t *value)
+{
+    // Bucket addresses of four lengths per vector: base + ((low half of key * buckets) >> 32) * 64
+    const _Bucket *buckets[MULTI_LENGTH_LANES];
+    for (int l = 0; l < MULTI_LENGTH_LANES; l += 4) {
+        __m256i key = _mm256_loadu_si256((const __m256i *) (keys + l));
+        __m256i numBuckets = _mm256_load_si256((const __m256i *) (table->numBuckets + l));
+        __m256i base = _mm256_load_si256((const __m256i *) (table->bases + l));
+        __m256i bucket = _mm256_srli_epi64(_mm256_mul_epu32(key, numBuckets), 32);
+        __m256i offset = _mm256_slli_epi64(bucket, MULTI_LENGTH_BUCKET_BITS);
+        _mm256_storeu_si256((__m256i *) (buckets + l), _mm256_add_epi64(base, offset));
+    }
+
+    // Issue every bucket's load before comparing any of them
+    for (int l = 0; l < lanes; l++) {
+        __builtin_prefetch(buckets[l]);
+    }
+
+    // The first four slots are one compare; the fifth shares the second half of the line with the values
+    uint32_t hits = 0;
+    uint32_t full = 0;
+    int slots[MULTI_LENGTH_LANES];
+    for (int l = 0; l < lanes; l++) {
+        __m256i key = _mm256_set1_epi64x((long long) keys[l]);
+        __m256i low = _mm256_load_si256((const __m256i *) buckets[l]->fingerprints);
+        int matches = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(low, key)))
+                    | ((buckets[l]->fingerprints[4] == keys[l]) << 4);
+        slots[l] = __builtin_ctz(matches | (1 << MULTI_LENGTH_SLOTS));
+        hits |= (uint32_t) (matches != 0) << l;
+        full |= (uint32_t) _multiLengthTable_IsFull(buckets[l]) << l;
+    }
+    return _multiLengthTable_Resolve(table, hits, full, buckets, slots, keys, value);
+}
+#endif
+
+static void
+_multiLengthTable_ReleaseLevel(MultiLengthTable *table, _Level *level)
+{
+    allocator_Deallocate(table->allocator, level->buckets, level->numBuckets * sizeof(_Bucket));
+    free(level->stash);
+    free(level->stashValues);
+}
+
+static int
+_multiLengthTable_CompareStashEntries(const void *a, const void *b)
+{
+    const _StashEntry *x = (const _StashEntry *) a;
+    const _StashEntry *y = (const _StashEntry *) b;
+    if (x->key != y->key) {
+        return x->key < y->key ? -1 : 1;
+    } else if (x->index != y->index) {
+        return x->index < y->index ? -1 : 1;
+    }
+    return 0;
+}
+
+// Place the entries order[0 .. count - 1] of one length, stashing those whose bucket is full
+static void
+_multiLengthTable_Fill(_Level *level, size_t count, const size_t order[], const uint64_t fingerprints[],
+                       const uint32_t values[])
+{
+    _StashEntry *overflow = NULL;
+    size_t numOverflowing = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = _multiLengthTable_Key(fingerprints[order[i]]);
+        _Bucket *bucket = &level->buckets[_multiLengthTable_Bucket(key, level->numBuckets)];
+        if (_multiLengthTable_Find(bucket, key) >= 0) {
+            continue;
+        }
+
+        int slot = _multiLengthTable_Find(bucket, 0);
+        if (slot < 0) {
+            overflow = (_StashEntry *) realloc(overflow, (numOverflowing + 1) * sizeof(_StashEntry));
+            overflow[numOverflowing].key = key;
+            overflow[numOverflowing].index = order[i];
+            numOverflowing++;
+            continue;
+        }
+        bucket->fingerprints[slot] = key;
+        bucket->values[slot] = values != NULL ? values[order[i]] : (uint32_t) order[i];
+    }
+
+    // Repeats in the stash keep the first one, as in the buckets
+    if (numOverflowing > 1) {
+        qsort(overflow, numOverflowing, sizeof(_StashEntry), _multiLengthTable_CompareStashEntries);
+    }
+    level->stash = (uint64_t *) malloc((numOverflowing > 0 ? numOverflowing : 1) * sizeof(uint64_t));
+    level->stashValues = (uint32_t *) malloc((numOverflowing > 0 ? numOverflowing : 1) * sizeof(uint32_t));
+    level->numStashed = 0;
+    for (size_t i = 0; i < numOverflowing; i++) {
+        if (level->numStashed > 0 && level->stash[level->numStashed - 1] == overflow[i].key) {
+            continue;
+        }
+        level->stash[level->numStashed] = overflow[i].key;
+        level->stashValues[level->numStashed] = values != NULL ? values[overflow[i].index] : (uint32_t) overflow[i].index;
+        level->numStashed++;
+    }
+    free(overflow);
+}
+
+MultiLengthTable *
+multiLengthTable_Create(size_t n, const int lengths[], const uint64_t fingerprints[], const uint32_t values[])
+{
+    MultiLengthTable *table = (MultiLengthTable *) malloc(sizeof(MultiLengthTable));
+    if (table == NULL) {
+        return NULL;
+    }
+
+    table->allocator = allocator_GetDefault();
+    table->numLevels = 0;
+    for (size_t i = 0; i < n; i++) {
+        table->numLevels = lengths[i] > table->numLevels ? lengths[i] : table->numLevels;
+    }
+    table->levels = (_Level *) calloc(table->numLevels > 0 ? table->numLevels : 1, sizeof(_Level));
+
+    // Group the entries by length, keeping their order within a length
+    size_t *starts = (size_t *) calloc(table->numLevels + 2, sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        starts[lengths[i] + 1]++;
+    }
+    for (int d = 1; d <= table->numLevels + 1; d++) {
+        starts[d] += starts[d - 1];
+    }
+    size_t *order = (size_t *) malloc((n > 0 ? n : 1) * sizeof(size_t));
+    size_t *next = (size_t *) malloc((table->numLevels + 1) * sizeof(size_t));
+    memcpy(next, starts, (table->numLevels + 1) * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        order[next[lengths[i]]++] = i;
+    }
+
+    // Buckets are half full on average, and the few that overflow spill into the stash
+    for (int d = 1; d <= table->numLevels; d++) {
+        _Level *level = &table->levels[d - 1];
+        size_t count = starts[d + 1] - starts[d];
+        size_t numBuckets = (2 * count + MULTI_LENGTH_SLOTS - 1) / MULTI_LENGTH_SLOTS;
+        level->numBuckets = numBuckets > 0 ? numBuckets : 1;
+        level->buckets = (_Bucket *) allocator_Allocate(table->allocator, level->numBuckets * sizeof(_Bucket));
+        _multiLengthTable_Fill(level, count, order + starts[d], fingerprints, values);
+    }
+
+    table->stashedLanes = 0;
+    for (int l = 0; l < MULTI_LENGTH_LANES; l++) {
+        if (l < table->numLevels) {
+            table->numBuckets[l] = table->levels[l].numBuckets;
+            table->bases[l] = (uint64_t) (uintptr_t) table->levels[l].buckets;
+            table->stashedLanes |= (uint32_t) (table->levels[l].numStashed > 0) << l;
+        } else {
+            table->numBuckets[l] = 0;
+            table->bases[l] = (uint64_t) (uintptr_t) &_emptyBucket;
+        }
+    }
+
+    table->probe = _multiLengthTable_ProbeScalar;
+#ifdef MULTI_LENGTH_HAS_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        table->probe = _multiLengthTable_ProbeAVX2;
+    }
+#endif
+
+    free(next);
+    free(order);
+    free(starts);
+    return table;
+}
+
+void
+multiLengthTable_Destroy(MultiLengthTable **tableP)
+{
+    MultiLengthTable *table = *tableP;
+    for (int i = 0; i < table->numLevels; i++) {
+        _multiLengthTable_ReleaseLevel(table, &table->levels[i]);
+    }
+    free(table->levels);
+    free(table);
+    *tableP = NULL;
+}
+
+int
+multiLengthTable_Longest(const MultiLengthTable *table, int count, const uint64_t fingerprints[], uint32_t *value)
+{
+    count = count > table->numLevels ? table->numLevels : count;
+
+    // Lengths past the lanes are rare enough to probe one at a time, longest first
+    for (int d = count; d > MULTI_LENGTH_LANES; d--) {
+        if (_multiLengthTable_FindLevel(&table->levels[d - 1], _multiLengthTable_Key(fingerprints[d - 1]), value)) {
+            return d;
+        }
+    }
+
+    int lanes = count < MULTI_LENGTH_LANES ? count : MULTI_LENGTH_LANES;
+    if (lanes < 1) {
+        return 0;
+    }
+
+    // Unused lanes still compute a bucket address, from a key of 0, but are never compared
+    uint64_t keys[MULTI_LENGTH_LANES] = { 0 };
+    for (int l = 0; l < lanes; l++) {
+        keys[l] = _multiLengthTable_Key(fingerprints[l]);
+    }
+    return table->probe(table, lanes, keys, value);
+}
+
+int
+multiLengthTable_GetNumLengths(const MultiLengthTable *table)
+{
+    return table->numLevels;
+}
+
+size_t
+multiLengthTable_GetSizeInBytes(const MultiLengthTable *table)
+{
+    size_t size = table->numLevels * sizeof(_Level);
+    for (int i = 0; i < table->numLevels; i++) {
+        size += table->levels[i].numBuckets * sizeof(_Bucket);
+        size += table->levels[i].numStashed * (sizeof(uint64_t) + sizeof(uint32_t));
+    }
+    return size;
+}
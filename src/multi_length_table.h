@@ -0,0 +1,52 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef multi_length_table_h_
+#define multi_length_table_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "name.h"
+#include "wyhasher.h"
+
+struct multi_length_table;
+typedef struct multi_length_table MultiLengthTable;
+
+// Prefix lengths probed together by one lookup; longer lengths are probed one at a time first
+extern const int MultiLengthTableLanes;
+
+// The fingerprints of every prefix length of a name, bucketed per length so that a lookup probes
+// all of them at once. Each length is a table of 64-byte buckets, each holding 5 fingerprints and
+// their values, indexed by the fingerprint's low bits. A lookup computes the bucket of every length up to 16 in a vector,
+// prefetches them all, compares each bucket against its fingerprint in one vector compare, and
+// takes the longest hit from the mask of hits. Fingerprints 0 and 1 are treated as the same.
+//
+// values[i] is stored for fingerprints[i] at length lengths[i], or i if values is NULL. Of
+// repeated (length, fingerprint) pairs, the first one's value is kept.
+MultiLengthTable *multiLengthTable_Create(size_t n, const int lengths[], const uint64_t fingerprints[],
+                                          const uint32_t values[]);
+
+void multiLengthTable_Destroy(MultiLengthTable **tableP);
+
+// The longest length d <= count whose fingerprints[d - 1] is stored at d, whose value is stored in
+// *value, or 0 if there is none
+int multiLengthTable_Longest(const MultiLengthTable *table, int count, const uint64_t fingerprints[], uint32_t *value);
+
+// The longest length stored
+int multiLengthTable_GetNumLengths(const MultiLengthTable *table);
+
+// Bytes held by the buckets and their values
+size_t multiLengthTable_GetSizeInBytes(const MultiLengthTable *table);
+
+// fingerprints[d - 1] is the fingerprint of the first d segments of name, for d = 1 to count. Each
+// segment is hashed once and chained into the fingerprint of the prefix before it, so all the
+// fingerprints take one pass over the name.
+void multiLengthTable_Fingerprints(WYHasher *hasher, uint64_t seed, const Name *name, int count, uint64_t fingerprints[]);
+
+#endif // multi_length_table_h_
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,8 @@
 #include "siphasher.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <parc/algol/parc_Memory.h>
 
@@ -107,6 +109,7 @@ name_CreateFromBuffer(PARCBuffer *buffer)
     Name *name = parcMemory_Allocate(sizeof(Name));
     if (name != NULL) {
         name->uri = NULL;
+        name->isHashed = false;
         name->wireFormat = parcBuffer_Acquire(buffer);
         name->numSegments = _countSegmentsFromWireFormat(name);
         name->offsets = parcMemory_Allocate(sizeof(int) * name->numSegments);
@@ -116,6 +119,26 @@ name_CreateFromBuffer(PARCBuffer *buffer)
     return name;
 }
 
+Name *
+name_CreateFromHashedBuffer(PARCBuffer *buffer, int numSegments)
+{
+    Name *name = parcMemory_Allocate(sizeof(Name));
+    if (name != NULL) {
+        int hashSize = parcBuffer_Remaining(buffer) / numSegments;
+        name->uri = NULL;
+        name->isHashed = true;
+        name->wireFormat = parcBuffer_Acquire(buffer);
+        name->numSegments = numSegments;
+        name->offsets = parcMemory_Allocate(sizeof(int) * numSegments);
+        name->sizes = parcMemory_Allocate(sizeof(int) * numSegments);
+        for (int i = 0; i < numSegments; i++) {
+            name->offsets[i] = i * hashSize;
+            name->sizes[i] = hashSize;
+        }
+    }
+    return name;
+}
+
 void
 name_Destroy(Name **nameP)
 {
@@ -131,6 +154,23 @@ name_Destroy(Name **nameP)
     *nameP = NULL;
 }
 
+Name *
+name_Copy(const Name *name)
+{
+    Name *copy = parcMemory_Allocate(sizeof(Name));
+    if (copy != NULL) {
+        copy->uri = name->uri == NULL ? NULL : parcMemory_StringDuplicate(name->uri, strlen(name->uri));
+        copy->isHashed = name->isHashed;
+        copy->wireFormat = parcBuffer_Acquire(name->wireFormat);
+        copy->numSegments = name->numSegments;
+        copy->offsets = parcMemory_Allocate(sizeof(int) * name->numSegments);
+        copy->sizes = parcMemory_Allocate(sizeof(int) * name->numSegments);
+        memcpy(copy->offsets, name->offsets, sizeof(int) * name->numSegments);
+        memcpy(copy->sizes, name->sizes, sizeof(int) * name->numSegments);
+    }
+    return copy;
+}
+
 Name *
 name_Hash(Name *name, Hasher *hasher, int hashSize)
 {
@@ -147,17 +187,27 @@ name_Hash(Name *name, Hasher *hasher, int hashSize)
         if (parcBuffer_Remaining(newName->wireFormat)) {
             overlay = parcBuffer_Overlay(newName->wireFormat, 0);
         }
-        for (int i = 1; i <= name->numSegments; i++) {
-            PARCBuffer *prefix = name_GetWireFormat(name, i);
-            PARCBuffer *hash = hasher_Hash(hasher, prefix);
 
-            memcpy(overlay + (hashSize * (i - 1)), parcBuffer_Overlay(hash, 0), hashSize);
+        // Every prefix starts at the head of the wire format, so all of them are hashed in one batch
+        int count = name->numSegments;
+        size_t *lengths = (size_t *) malloc(count * sizeof(size_t));
+        uint8_t **inputs = (uint8_t **) malloc(count * sizeof(uint8_t *));
+        uint8_t **outputs = (uint8_t **) malloc(count * sizeof(uint8_t *));
+        uint8_t *buffer = name_GetBuffer(name);
+        for (int i = 1; i <= count; i++) {
+            lengths[i - 1] = name_GetPrefixLength(name, i);
+            inputs[i - 1] = buffer;
+            outputs[i - 1] = overlay + (hashSize * (i - 1));
             newName->offsets[i - 1] = i == 1 ? 0 : newName->offsets[i - 2] + newName->sizes[i - 2];
             newName->sizes[i - 1] = hashSize;
-
-            parcBuffer_Release(&hash);
-            parcBuffer_Release(&prefix);
         }
+
+        // Digests shorter than hashSize (e.g., 32-bit CRCs) are zero-padded
+        hasher_HashMany(hasher, count, lengths, inputs, outputs, hashSize);
+
+        free(outputs);
+        free(inputs);
+        free(lengths);
     }
     return newName;
 }
@@ -204,7 +254,7 @@ name_GetSubWireFormat(const Name *name, int start, int end)
     int capacity = end == name->numSegments ? parcBuffer_Remaining(name->wireFormat) : name->offsets[end];
     capacity -= offset;
 
-    PARCBuffer *buffer = parcBuffer_Wrap(parcBuffer_Overlay(name->wireFormat, 0), parcBuffer_Remaining(name->wireFormat), offset, parcBuffer_Remaining(name->wireFormat));
+    PARCBuffer *buffer = parcBuffer_Wrap(parcBuffer_Overlay(name->wireFormat, 0), parcBuffer_Remaining(name->wireFormat), offset, offset + capacity);
     assertTrue(parcBuffer_IsValid(buffer), "Expected buffer to be valid");
     return buffer;
 }
@@ -257,6 +307,24 @@ name_XORSegment(const Name *name, int index, PARCBuffer *vector)
     return xor;
 }
 
+int
+name_Intern(const Name *name, ComponentDictionary *dictionary, bool insert, uint32_t ids[])
+{
+    uint8_t *base = name_GetBuffer(name);
+    for (int i = 0; i < name->numSegments; i++) {
+        // Hashed names have no TL headers, so the component is the span up to the next offset
+        int start = name_GetPrefixLength(name, i);
+        int length = name_GetPrefixLength(name, i + 1) - start;
+        ids[i] = insert ?
+            componentDictionary_Intern(dictionary, length, base + start) :
+            componentDictionary_Find(dictionary, length, base + start);
+        if (ids[i] == ComponentDictionaryNoID) {
+            return i;
+        }
+    }
+    return name->numSegments;
+}
+
 void
 name_Display(const Name *name)
 {
@@ -8,6 +8,7 @@ extern "C" {
 #include <parc/algol/parc_Buffer.h>
 
 #include "hasher.h"
+#include "component_dictionary.h"
 
 struct name;
 typedef struct name Name;
@@ -16,8 +17,13 @@ Name *name_CreateFromCString(char *uri);
 
 Name *name_CreateFromBuffer(PARCBuffer *buffer);
 
+// A hashed name from the wire format of name_Hash, i.e., numSegments prefix digests of equal size
+Name *name_CreateFromHashedBuffer(PARCBuffer *buffer, int numSegments);
+
 void name_Destroy(Name **nameP);
 
+Name *name_Copy(const Name *name);
+
 Name *name_Hash(Name *name, Hasher *hasher, int hashSize);
 
 bool name_IsHashed(const Name *name);
@@ -48,6 +54,13 @@ void name_Display(const Name *name);
 
 PARCBuffer *name_XORSegment(const Name *name, int index, PARCBuffer *vector);
 
+// Fill ids with the dictionary IDs of the name's components (TL header included), so that prefixes
+// can be keyed and compared as ID tuples. ids must hold name_GetSegmentCount(name) entries. With
+// insert, new components are added and every ID is filled. Without it, the IDs stop at the first
+// component the dictionary does not hold: no interned prefix can extend past it. Returns the number
+// of IDs filled.
+int name_Intern(const Name *name, ComponentDictionary *dictionary, bool insert, uint32_t ids[]);
+
 #endif // FIB_PERF_NAME_H
 
 #ifdef __cplusplus
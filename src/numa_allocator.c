@@ -0,0 +1,91 @@
+#include "numa_allocator.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// From <numaif.h>, which is only shipped with libnuma
+#define NUMA_MPOL_BIND 2
+
+struct numa_allocator {
+    int node;
+    bool useHugePages;
+    size_t pageSize;
+};
+
+NUMAAllocator *
+numaAllocator_Create(int node, bool useHugePages)
+{
+    NUMAAllocator *allocator = (NUMAAllocator *) malloc(sizeof(NUMAAllocator));
+    if (allocator != NULL) {
+        allocator->node = node;
+        allocator->useHugePages = useHugePages;
+        allocator->pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    }
+    return allocator;
+}
+
+void
+numaAllocator_Destroy(NUMAAllocator **allocatorP)
+{
+    free(*allocatorP);
+    *allocatorP = NULL;
+}
+
+static size_t
+_numaAllocator_MappedSize(NUMAAllocator *allocator, size_t size)
+{
+    if (allocator->useHugePages) {
+        return allocator_RoundToHugePages(size);
+    }
+    return ((size + allocator->pageSize - 1) / allocator->pageSize) * allocator->pageSize;
+}
+
+static void
+_numaAllocator_Bind(NUMAAllocator *allocator, void *memory, size_t size)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    // The pages are not touched yet, so binding the range places them on the node when first faulted in
+    unsigned long nodeMask[4] = { 0 };
+    int maxNode = sizeof(nodeMask) * 8;
+    if (allocator->node >= 0 && allocator->node < maxNode) {
+        nodeMask[allocator->node / (sizeof(unsigned long) * 8)] |= 1UL << (allocator->node % (sizeof(unsigned long) * 8));
+        syscall(SYS_mbind, memory, size, NUMA_MPOL_BIND, nodeMask, maxNode + 1, 0);
+    }
+#endif
+}
+
+void *
+numaAllocator_Allocate(NUMAAllocator *allocator, size_t size)
+{
+    if (size < allocator->pageSize) {
+        return allocator_AllocateAligned(size);
+    }
+
+    size_t mappedSize = _numaAllocator_MappedSize(allocator, size);
+    void *memory = allocator_MapPages(mappedSize, allocator->useHugePages);
+    if (memory != NULL) {
+        _numaAllocator_Bind(allocator, memory, mappedSize);
+    }
+    return memory;
+}
+
+void
+numaAllocator_Deallocate(NUMAAllocator *allocator, void *memory, size_t size)
+{
+    if (size < allocator->pageSize) {
+        allocator_DeallocateAligned(memory);
+    } else {
+        allocator_UnmapPages(memory, _numaAllocator_MappedSize(allocator, size));
+    }
+}
+
+AllocatorInterface *NUMAAsAllocator = &(AllocatorInterface) {
+        .Allocate = (void *(*)(void *, size_t)) numaAllocator_Allocate,
+        .Deallocate = (void (*)(void *, void *, size_t)) numaAllocator_Deallocate,
+        .Destroy = (void (*)(void **instance)) numaAllocator_Destroy,
+};
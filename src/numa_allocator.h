@@ -0,0 +1,30 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_NUMA_ALLOCATOR_H
+#define FIB_PERF_NUMA_ALLOCATOR_H
+
+#include "allocator.h"
+
+struct numa_allocator;
+typedef struct numa_allocator NUMAAllocator;
+
+extern AllocatorInterface *NUMAAsAllocator;
+
+// Page-sized and larger allocations are bound to the given NUMA node with mbind(2),
+// issued as a raw system call so there is no libnuma dependency. Smaller ones use the heap.
+// On platforms without mbind the binding is skipped.
+NUMAAllocator *numaAllocator_Create(int node, bool useHugePages);
+
+void numaAllocator_Destroy(NUMAAllocator **allocatorP);
+
+void *numaAllocator_Allocate(NUMAAllocator *allocator, size_t size);
+
+void numaAllocator_Deallocate(NUMAAllocator *allocator, void *memory, size_t size);
+
+#endif //FIB_PERF_NUMA_ALLOCATOR_H
+
+#ifdef __cplusplus
+}
+#endif
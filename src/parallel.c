@@ -0,0 +1,80 @@
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Indices are claimed in runs of up to this many to keep the shared counter off the fast path
+#define PARALLEL_MAX_CHUNK_SIZE 64
+
+typedef struct {
+    size_t count;
+    size_t chunkSize;
+    size_t next;
+    void (*body)(void *context, size_t index);
+    void *context;
+} _ParallelLoop;
+
+int
+parallel_GetDefaultThreads(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+}
+
+static void *
+_parallel_Worker(void *arg)
+{
+    _ParallelLoop *loop = (_ParallelLoop *) arg;
+    for (;;) {
+        size_t start = __atomic_fetch_add(&loop->next, loop->chunkSize, __ATOMIC_RELAXED);
+        if (start >= loop->count) {
+            break;
+        }
+        size_t end = start + loop->chunkSize < loop->count ? start + loop->chunkSize : loop->count;
+        for (size_t i = start; i < end; i++) {
+            loop->body(loop->context, i);
+        }
+    }
+    return NULL;
+}
+
+void
+parallel_For(int threads, size_t count, void (*body)(void *context, size_t index), void *context)
+{
+    if (threads <= 0) {
+        threads = parallel_GetDefaultThreads();
+    }
+
+    if ((size_t) threads > count) {
+        threads = count > 0 ? (int) count : 1;
+    }
+
+    // Small enough chunks that every thread gets several, so heavy items still spread out
+    size_t chunkSize = count / ((size_t) threads * 8);
+    chunkSize = chunkSize < 1 ? 1 : (chunkSize > PARALLEL_MAX_CHUNK_SIZE ? PARALLEL_MAX_CHUNK_SIZE : chunkSize);
+
+    _ParallelLoop loop = {
+            .count = count,
+            .chunkSize = chunkSize,
+            .next = 0,
+            .body = body,
+            .context = context,
+    };
+
+    // Threads that fail to start just leave more of the work to the others
+    pthread_t *workers = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    int numStarted = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&workers[numStarted], NULL, _parallel_Worker, &loop) == 0) {
+            numStarted++;
+        }
+    }
+
+    _parallel_Worker(&loop);
+
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+}
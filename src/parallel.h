@@ -0,0 +1,21 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_PARALLEL_H
+#define FIB_PERF_PARALLEL_H
+
+#include <stddef.h>
+
+// The number of online cores, used when a caller asks for 0 threads
+int parallel_GetDefaultThreads(void);
+
+// Call body(context, i) for every i in [0, count), on up to threads threads (the calling thread
+// included). Indices are handed out dynamically, so uneven items balance across the threads.
+void parallel_For(int threads, size_t count, void (*body)(void *context, size_t index), void *context);
+
+#endif //FIB_PERF_PARALLEL_H
+
+#ifdef __cplusplus
+}
+#endif
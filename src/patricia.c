@@ -5,6 +5,10 @@
 #include <parc/algol/parc_SafeMemory.h>
 
 #include "patricia.h"
+#include "allocator.h"
+
+// Number of nodes carved out of each allocator chunk
+const int PatriciaNodePoolChunkSize = 4096;
 
 typedef struct {
     void *value;
@@ -49,7 +53,7 @@ static void
 _patriciaNodeValue_Release(_PatriciaNodeValue **valueP)
 {
     _PatriciaNodeValue *value = (_PatriciaNodeValue *) *valueP;
-    if (value != NULL) {
+    if (value == NULL) {
         return;
     }
 
@@ -72,10 +76,88 @@ typedef struct _patricia_node {
 
     int numChildren;
     struct _patricia_node **children;
+
+    // Link in the pool's free list once the node is released
+    struct _patricia_node *nextFree;
 } _PatriciaNode;
 
+typedef struct _patricia_node_chunk {
+    struct _patricia_node_chunk *next;
+    _PatriciaNode *nodes;
+} _PatriciaNodeChunk;
+
+// Nodes come from large allocator chunks, so a trie's nodes are packed into a few (huge) pages
+typedef struct {
+    Allocator *allocator;
+    _PatriciaNodeChunk *chunks;
+    int numUsed;
+    _PatriciaNode *freeList;
+} _PatriciaNodePool;
+
+static _PatriciaNodePool *
+_patriciaNodePool_Create()
+{
+    _PatriciaNodePool *pool = (_PatriciaNodePool *) malloc(sizeof(_PatriciaNodePool));
+    if (pool != NULL) {
+        pool->allocator = allocator_GetDefault();
+        pool->chunks = NULL;
+        pool->numUsed = PatriciaNodePoolChunkSize;
+        pool->freeList = NULL;
+    }
+    return pool;
+}
+
+static void
+_patriciaNodePool_Destroy(_PatriciaNodePool **poolP)
+{
+    _PatriciaNodePool *pool = *poolP;
+    _PatriciaNodeChunk *chunk = pool->chunks;
+    while (chunk != NULL) {
+        _PatriciaNodeChunk *next = chunk->next;
+        allocator_Deallocate(pool->allocator, chunk->nodes, sizeof(_PatriciaNode) * PatriciaNodePoolChunkSize);
+        free(chunk);
+        chunk = next;
+    }
+    free(pool);
+    *poolP = NULL;
+}
+
+static _PatriciaNode *
+_patriciaNodePool_Get(_PatriciaNodePool *pool)
+{
+    if (pool->freeList != NULL) {
+        _PatriciaNode *node = pool->freeList;
+        pool->freeList = node->nextFree;
+        return node;
+    }
+
+    if (pool->numUsed == PatriciaNodePoolChunkSize) {
+        _PatriciaNodeChunk *chunk = (_PatriciaNodeChunk *) malloc(sizeof(_PatriciaNodeChunk));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->nodes = (_PatriciaNode *) allocator_Allocate(pool->allocator, sizeof(_PatriciaNode) * PatriciaNodePoolChunkSize);
+        if (chunk->nodes == NULL) {
+            free(chunk);
+            return NULL;
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        pool->numUsed = 0;
+    }
+
+    return &pool->chunks->nodes[pool->numUsed++];
+}
+
+static void
+_patriciaNodePool_Put(_PatriciaNodePool *pool, _PatriciaNode *node)
+{
+    node->nextFree = pool->freeList;
+    pool->freeList = node;
+}
+
 void
-_patriciaNode_Destroy(_PatriciaNode **nodeP)
+_patriciaNode_Destroy(_PatriciaNodePool *pool, _PatriciaNode **nodeP)
 {
     _PatriciaNode *node = *nodeP;
 
@@ -83,21 +165,23 @@ _patriciaNode_Destroy(_PatriciaNode **nodeP)
         parcBuffer_Release(&node->label);
     }
     for (int i = 0; i < node->numChildren; i++) {
-        _patriciaNode_Destroy(&node->children[i]);
+        _patriciaNode_Destroy(pool, &node->children[i]);
     }
+    free(node->children);
     if (node->value != NULL) {
         _patriciaNodeValue_Release(&(node->value));
     }
 
-    free(node);
+    _patriciaNodePool_Put(pool, node);
     *nodeP = NULL;
 }
 
 _PatriciaNode *
-_patriciaNode_CreateLeaf(PARCBuffer *label, _PatriciaNodeValue *value)
+_patriciaNode_CreateLeaf(_PatriciaNodePool *pool, PARCBuffer *label, _PatriciaNodeValue *value)
 {
-    _PatriciaNode *node = (_PatriciaNode *) malloc(sizeof(_PatriciaNode));
+    _PatriciaNode *node = _patriciaNodePool_Get(pool);
     if (node != NULL) {
+        node->nextFree = NULL;
         node->label = parcBuffer_Acquire(label);
         node->isLeaf = true;
         node->numChildren = 0;
@@ -138,6 +222,7 @@ _patriciaNode_Display(_PatriciaNode *node, int indentation)
 
 struct patricia {
     _PatriciaNode *head;
+    _PatriciaNodePool *pool;
     void (*valueDestructor)(void **valueP);
 };
 
@@ -147,7 +232,8 @@ patricia_Create(void (*valueDestructor)(void **valueP))
     Patricia *patricia = (Patricia *) malloc(sizeof(Patricia));
     if (patricia != NULL) {
         PARCBuffer *emptyLabel = parcBuffer_Allocate(1);
-        patricia->head = _patriciaNode_CreateLeaf(emptyLabel, NULL);
+        patricia->pool = _patriciaNodePool_Create();
+        patricia->head = _patriciaNode_CreateLeaf(patricia->pool, emptyLabel, NULL);
         patricia->valueDestructor = valueDestructor;
         parcBuffer_Release(&emptyLabel);
     }
@@ -158,7 +244,8 @@ void
 patricia_Destroy(Patricia **patriciaP)
 {
     Patricia *patricia = *patriciaP;
-    _patriciaNode_Destroy(&patricia->head);
+    _patriciaNode_Destroy(patricia->pool, &patricia->head);
+    _patriciaNodePool_Destroy(&patricia->pool);
     free(patricia);
     *patriciaP = NULL;
 }
@@ -189,142 +276,144 @@ _sharedPrefix(PARCBuffer *x, PARCBuffer *y)
     return shared;
 }
 
+// Index of the child whose label starts with the next byte of the key, or -1
+static int
+_patriciaNode_FindChild(_PatriciaNode *node, PARCBuffer *key)
+{
+    if (parcBuffer_Remaining(key) == 0) {
+        return -1;
+    }
+
+    // Sibling labels never share a first byte
+    uint8_t first = parcBuffer_GetAtIndex(key, parcBuffer_Position(key));
+    for (int i = 0; i < node->numChildren; i++) {
+        PARCBuffer *label = node->children[i]->label;
+        if (parcBuffer_GetAtIndex(label, parcBuffer_Position(label)) == first) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void
+_patriciaNode_SetValue(_PatriciaNode *node, _PatriciaNodeValue *value)
+{
+    _PatriciaNodeValue *old = node->value;
+    node->value = _patriciaNodeValue_Acquire(value);
+    _patriciaNodeValue_Release(&old);
+}
+
 void 
 patricia_Insert(Patricia *trie, PARCBuffer *key, void *opaqueValue)
 {
     _PatriciaNodeValue *value = _patriciaNodeValue_Create(opaqueValue, trie->valueDestructor);
 
+    PARCBuffer *rest = parcBuffer_Slice(key);
     _PatriciaNode *current = trie->head;
-    if (current->isLeaf) {
-        current = NULL;
-    }
 
-    PARCBuffer *prefix = parcBuffer_Duplicate(key);
-    _PatriciaNode *newEdge = _patriciaNode_CreateLeaf(prefix, value);
+    // The node at which the key ends, if the key does not end in a new leaf
+    _PatriciaNode *target = NULL;
 
-    // Base case, when we've got nothing in the trie
-    if (current == NULL) {
-        _patriciaNode_AddEdge(trie->head, newEdge);
-        parcBuffer_Release(&prefix);
-        return;
-    }
+    while (true) {
+        if (parcBuffer_Remaining(rest) == 0) {
+            target = current;
+            break;
+        }
 
-    // Otherwise, search for the insertion spot
-    size_t elementsFound = 0;
-    size_t prefixLength = parcBuffer_Remaining(prefix);
-    _PatriciaNode *prev = NULL;
-
-    while (elementsFound < prefixLength) {
-        // If we've reached a leaf and haven't added all of our symbols, then just tack it on to the current node
-        if (current->isLeaf) {
-            _patriciaNode_AddEdge(current, newEdge);
-            parcBuffer_Release(&prefix);
-            return;
+        // Nothing in common with any child, so the rest of the key becomes a new edge
+        int index = _patriciaNode_FindChild(current, rest);
+        if (index < 0) {
+            _patriciaNode_AddEdge(current, _patriciaNode_CreateLeaf(trie->pool, rest, value));
+            break;
         }
 
-        // Otherwise, traverse down the node's children
-        bool inserted = false;
-        for (int i = 0; i < current->numChildren; i++) {
-            prev = current;
-            _PatriciaNode *next = current->children[i];
-            int prefixCount = parcBuffer_Remaining(next->label);
-            int sharedCount = _sharedPrefix(prefix, next->label);
-
-            // If we consumed all of the current node, go to the next layer
-            if (sharedCount == prefixCount ) {
-                parcBuffer_SetPosition(prefix, parcBuffer_Position(prefix) + sharedCount);
-                elementsFound += sharedCount;
-                current = next;
-                inserted = true;
-                break;
-            } else if (sharedCount > 0) {
-                PARCBuffer *sharedPrefix = parcBuffer_Duplicate(next->label); // "ab"
-                PARCBuffer *leftPrefix = parcBuffer_Duplicate(sharedPrefix); // "c"
-                PARCBuffer *rightPrefix = parcBuffer_Duplicate(prefix); // "d"
-
-                parcBuffer_SetLimit(sharedPrefix, parcBuffer_Position(sharedPrefix) + sharedCount);
-                parcBuffer_SetPosition(leftPrefix, parcBuffer_Position(leftPrefix) + sharedCount);
-                parcBuffer_SetPosition(rightPrefix, parcBuffer_Position(rightPrefix) + sharedCount);
-
-                _PatriciaNode *newNode = _patriciaNode_CreateLeaf(sharedPrefix, NULL); // this becomes a non-leaf node
-                _PatriciaNode *splitRight = _patriciaNode_CreateLeaf(rightPrefix, value);
-                _PatriciaNode *splitLeft = _patriciaNode_CreateLeaf(leftPrefix, next->value);
-
-                current->children[i] = newNode;
-                _patriciaNode_AddEdge(newNode, splitLeft);
-                _patriciaNode_AddEdge(newNode, splitRight);
-
-                _patriciaNode_Destroy(&next);
-
-                parcBuffer_Release(&sharedPrefix);
-                parcBuffer_Release(&leftPrefix);
-                parcBuffer_Release(&rightPrefix);
-                _patriciaNode_Destroy(&newEdge);
-                parcBuffer_Release(&prefix);
-                return;
-            }
+        _PatriciaNode *next = current->children[index];
+        int labelLength = parcBuffer_Remaining(next->label);
+        int sharedCount = _sharedPrefix(rest, next->label);
+        parcBuffer_SetPosition(rest, parcBuffer_Position(rest) + sharedCount);
+
+        // If we consumed all of the child's label, go to the next layer
+        if (sharedCount == labelLength) {
+            current = next;
+            continue;
         }
 
-        if (!inserted) { // there's nothing in common with any child, so add to the previous edge
-            _patriciaNode_AddEdge(prev, newEdge);
-            parcBuffer_Release(&prefix);
-            return;
+        // Otherwise split the child's label: the shared part becomes a new node that keeps
+        // the child (and its subtree) under the unshared remainder of its label
+        PARCBuffer *sharedPrefix = parcBuffer_Duplicate(next->label);
+        parcBuffer_SetLimit(sharedPrefix, parcBuffer_Position(sharedPrefix) + sharedCount);
+        _PatriciaNode *split = _patriciaNode_CreateLeaf(trie->pool, sharedPrefix, NULL);
+        parcBuffer_Release(&sharedPrefix);
+
+        PARCBuffer *childLabel = parcBuffer_Duplicate(next->label);
+        parcBuffer_SetPosition(childLabel, parcBuffer_Position(childLabel) + sharedCount);
+        parcBuffer_Release(&next->label);
+        next->label = childLabel;
+
+        _patriciaNode_AddEdge(split, next);
+        current->children[index] = split;
+
+        if (parcBuffer_Remaining(rest) > 0) {
+            _patriciaNode_AddEdge(split, _patriciaNode_CreateLeaf(trie->pool, rest, value));
+        } else {
+            target = split;
         }
+        break;
+    }
+
+    if (target != NULL) {
+        _patriciaNode_SetValue(target, value);
     }
+
+    parcBuffer_Release(&rest);
+    _patriciaNodeValue_Release(&value);
 }
 
-void *
-patricia_Get(Patricia *trie, PARCBuffer *key)
+// Walk the trie along the key. Returns the value of the longest inserted key that is a
+// prefix of the key, and sets *isExact if that key is the whole key.
+static void *
+_patricia_Search(Patricia *trie, PARCBuffer *key, bool *isExact)
 {
-    int elementsFound = 0;
-    size_t labelLength = parcBuffer_Remaining(key);
+    PARCBuffer *rest = parcBuffer_Slice(key);
     _PatriciaNode *current = trie->head;
-    _PatriciaNode *prev = NULL;
-
-    PARCBuffer *prefix = parcBuffer_Slice(key);
-    while (current != NULL && !current->isLeaf && elementsFound < labelLength) {
-        _PatriciaNode *curr = current;
-        current = NULL;
-        for (int i = 0; i < curr->numChildren; i++) {
-            _PatriciaNode *next = curr->children[i];
-
-            int prefixCount = parcBuffer_Remaining(next->label);
-            int sharedCount = _sharedPrefix(prefix, next->label);
-
-            // If we consumed all of the current node, go to the next layer
-            if (sharedCount == prefixCount ) {
-                parcBuffer_SetPosition(prefix, parcBuffer_Position(prefix) + sharedCount);
-                elementsFound += sharedCount;
-                prev = curr;
-                current = next;
-                break;
-            }
-//            else if (sharedCount > 0) { // jump to the next level
-//                current = next;
-//                size_t nextLabelLength = parcBuffer_Remaining(next->label);
-//                if (sharedCount < nextLabelLength) {
-//                    parcBuffer_Release(&prefix);
-//                    return NULL;
-//                }
-//                elementsFound += sharedCount;
-//                parcBuffer_SetPosition(prefix, parcBuffer_Position(prefix) + sharedCount);
-//                prev = curr;
-//                break;
-//            }
+    void *longest = _patriciaNodeValue_Value(current->value);
+    *isExact = parcBuffer_Remaining(rest) == 0 && current->value != NULL;
+
+    while (parcBuffer_Remaining(rest) > 0) {
+        int index = _patriciaNode_FindChild(current, rest);
+        if (index < 0) {
+            break;
         }
-    }
 
-    parcBuffer_Release(&prefix);
-    
-    if (current == NULL && prev == NULL) {
-        return prev;
-    } else if (current == NULL) {
-        return _patriciaNodeValue_Value(prev->value);
-    } else if (current->isLeaf && elementsFound <= labelLength) {
-        return _patriciaNodeValue_Value(current->value);
-    } else {
-        return NULL;
+        _PatriciaNode *next = current->children[index];
+        int labelLength = parcBuffer_Remaining(next->label);
+        if (_sharedPrefix(rest, next->label) < labelLength) {
+            break;
+        }
+        parcBuffer_SetPosition(rest, parcBuffer_Position(rest) + labelLength);
+        current = next;
+
+        if (current->value != NULL) {
+            longest = _patriciaNodeValue_Value(current->value);
+            *isExact = parcBuffer_Remaining(rest) == 0;
+        }
     }
+
+    parcBuffer_Release(&rest);
+    return longest;
 }
 
+void *
+patricia_Get(Patricia *trie, PARCBuffer *key)
+{
+    bool isExact = false;
+    return _patricia_Search(trie, key, &isExact);
+}
 
+void *
+patricia_GetExact(Patricia *trie, PARCBuffer *key)
+{
+    bool isExact = false;
+    void *value = _patricia_Search(trie, key, &isExact);
+    return isExact ? value : NULL;
+}
@@ -16,8 +16,12 @@ void patricia_Destroy(Patricia **patricia);
 
 void patricia_Insert(Patricia *trie, PARCBuffer *key, void *item);
 
+// The value of the longest inserted key that is a prefix of key
 void *patricia_Get(Patricia *trie, PARCBuffer *key);
 
+// The value inserted with exactly this key
+void *patricia_GetExact(Patricia *trie, PARCBuffer *key);
+
 void patricia_Display(Patricia *trie);
 
 #endif // patricia_h_
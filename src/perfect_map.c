@@ -0,0 +1,363 @@
+#include "perfect_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "random.h"
+#include "siphasher.h"
+#include "wyhasher.h"
+
+// Keys still colliding after this many levels are kept in a small sorted overflow array
+#define PERFECT_MAP_MAX_LEVELS 32
+
+// Each rank counter covers this many 64-bit words of the level bit arrays
+#define PERFECT_MAP_RANK_BLOCK_WORDS 8
+
+const double PerfectMapDefaultGamma = 1.0;
+
+typedef struct {
+    uint64_t fingerprint;
+    size_t sequence;
+    void *item;
+} _PerfectMapKey;
+
+struct perfect_map {
+    Map *map;
+    WYHasher *hasher;
+
+    // Level i is levelBits[i] bits of the concatenated bit array, starting at levelOffsets[i]. A set
+    // bit marks the one key that hashed there alone; its slot is the number of set bits before it.
+    int numLevels;
+    uint64_t levelSeeds[PERFECT_MAP_MAX_LEVELS];
+    uint64_t levelBits[PERFECT_MAP_MAX_LEVELS];
+    uint64_t levelOffsets[PERFECT_MAP_MAX_LEVELS];
+
+    size_t numWords;
+    uint64_t *bits;
+
+    // ranks[b] counts the set bits before word b * PERFECT_MAP_RANK_BLOCK_WORDS
+    size_t numRanks;
+    uint32_t *ranks;
+
+    // Slots of the keys placed by the perfect hash
+    size_t numSlots;
+    uint64_t *fingerprints;
+    void **items;
+
+    // Keys no level placed, sorted by fingerprint
+    size_t numLeftovers;
+    _PerfectMapKey *leftovers;
+
+    Allocator *allocator;
+};
+
+static uint64_t
+_perfectMap_Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Map the fingerprint onto [0, range) without a division
+static uint64_t
+_perfectMap_Position(uint64_t fingerprint, uint64_t seed, uint64_t range)
+{
+    return (uint64_t) (((__uint128_t) _perfectMap_Mix(fingerprint ^ seed) * range) >> 64);
+}
+
+static bool
+_perfectMap_TestBit(const uint64_t *words, uint64_t bit)
+{
+    return (words[bit / 64] & (((uint64_t) 1) << (bit % 64))) != 0;
+}
+
+static void
+_perfectMap_SetBit(uint64_t *words, uint64_t bit)
+{
+    words[bit / 64] |= ((uint64_t) 1) << (bit % 64);
+}
+
+static void
+_perfectMap_ClearBit(uint64_t *words, uint64_t bit)
+{
+    words[bit / 64] &= ~(((uint64_t) 1) << (bit % 64));
+}
+
+static size_t
+_perfectMap_Rank(PerfectMap *map, uint64_t bit)
+{
+    size_t word = bit / 64;
+    size_t block = word / PERFECT_MAP_RANK_BLOCK_WORDS;
+    size_t rank = map->ranks[block];
+    for (size_t i = block * PERFECT_MAP_RANK_BLOCK_WORDS; i < word; i++) {
+        rank += __builtin_popcountll(map->bits[i]);
+    }
+    uint64_t below = (((uint64_t) 1) << (bit % 64)) - 1;
+    return rank + __builtin_popcountll(map->bits[word] & below);
+}
+
+// The slot of fingerprint, or numSlots if no level placed it
+static size_t
+_perfectMap_FindSlot(PerfectMap *map, uint64_t fingerprint)
+{
+    for (int level = 0; level < map->numLevels; level++) {
+        uint64_t bit = map->levelOffsets[level] +
+            _perfectMap_Position(fingerprint, map->levelSeeds[level], map->levelBits[level]);
+        if (_perfectMap_TestBit(map->bits, bit)) {
+            return _perfectMap_Rank(map, bit);
+        }
+    }
+    return map->numSlots;
+}
+
+// Raw keys are stored as their SipHash digests, which serve as fingerprints as they are, so a
+// lookup hashes the key only once. Only longer stored keys are hashed down to 8 bytes.
+static uint64_t
+_perfectMap_Fingerprint(PerfectMap *map, size_t length, const uint8_t key[])
+{
+    if (length == SIPHASH_HASH_LENGTH) {
+        uint64_t fingerprint;
+        memcpy(&fingerprint, key, sizeof(fingerprint));
+        return fingerprint;
+    }
+    return wyhasher_Hash64(map->hasher, length, key);
+}
+
+typedef struct {
+    PerfectMap *map;
+    size_t count;
+    size_t capacity;
+    _PerfectMapKey *keys;
+} _PerfectMapCollector;
+
+static void
+_perfectMap_CollectKey(void *context, PARCBuffer *storedKey, void *item)
+{
+    _PerfectMapCollector *collector = (_PerfectMapCollector *) context;
+    if (collector->count == collector->capacity) {
+        collector->capacity *= 2;
+        collector->keys = (_PerfectMapKey *) realloc(collector->keys, collector->capacity * sizeof(_PerfectMapKey));
+    }
+
+    _PerfectMapKey *key = &collector->keys[collector->count];
+    key->fingerprint = _perfectMap_Fingerprint(collector->map, parcBuffer_Remaining(storedKey),
+                                               parcBuffer_Overlay(storedKey, 0));
+    key->sequence = collector->count;
+    key->item = item;
+    collector->count++;
+}
+
+static int
+_perfectMap_CompareKeys(const void *a, const void *b)
+{
+    const _PerfectMapKey *x = (const _PerfectMapKey *) a;
+    const _PerfectMapKey *y = (const _PerfectMapKey *) b;
+    if (x->fingerprint != y->fingerprint) {
+        return x->fingerprint < y->fingerprint ? -1 : 1;
+    } else if (x->sequence != y->sequence) {
+        return x->sequence < y->sequence ? -1 : 1;
+    }
+    return 0;
+}
+
+// Hash the keys into successive levels. Each level keeps the keys that landed alone in their bit
+// and passes the colliding ones on, so the keys array is left holding those no level placed.
+static size_t
+_perfectMap_BuildLevels(PerfectMap *map, size_t count, _PerfectMapKey keys[count], double gamma, uint64_t seed,
+                        uint64_t *levels[PERFECT_MAP_MAX_LEVELS])
+{
+    while (count > 0 && map->numLevels < PERFECT_MAP_MAX_LEVELS) {
+        int level = map->numLevels;
+        size_t numWords = ((size_t) (gamma * count) + 63) / 64;
+        numWords = numWords > 0 ? numWords : 1;
+
+        map->levelSeeds[level] = _perfectMap_Mix(seed + level);
+        map->levelBits[level] = numWords * 64;
+        levels[level] = (uint64_t *) calloc(numWords, sizeof(uint64_t));
+        uint64_t *collisions = (uint64_t *) calloc(numWords, sizeof(uint64_t));
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t bit = _perfectMap_Position(keys[i].fingerprint, map->levelSeeds[level], map->levelBits[level]);
+            if (_perfectMap_TestBit(collisions, bit)) {
+                continue;
+            } else if (_perfectMap_TestBit(levels[level], bit)) {
+                _perfectMap_ClearBit(levels[level], bit);
+                _perfectMap_SetBit(collisions, bit);
+            } else {
+                _perfectMap_SetBit(levels[level], bit);
+            }
+        }
+        free(collisions);
+
+        // Keep the unplaced keys in fingerprint order for the overflow array
+        size_t remaining = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t bit = _perfectMap_Position(keys[i].fingerprint, map->levelSeeds[level], map->levelBits[level]);
+            if (!_perfectMap_TestBit(levels[level], bit)) {
+                keys[remaining++] = keys[i];
+            }
+        }
+        count = remaining;
+        map->numLevels++;
+    }
+    return count;
+}
+
+PerfectMap *
+perfectMap_CreateFromMap(Map *source, double gamma)
+{
+    PerfectMap *map = (PerfectMap *) malloc(sizeof(PerfectMap));
+    if (map == NULL) {
+        return NULL;
+    }
+
+    map->map = source;
+    map->allocator = allocator_GetDefault();
+    map->numLevels = 0;
+
+    PARCBuffer *seeds = random_Bytes(parcBuffer_Allocate(2 * sizeof(uint64_t)));
+    map->hasher = wyhasher_Create(parcBuffer_GetUint64(seeds));
+    uint64_t levelSeed = parcBuffer_GetUint64(seeds);
+    parcBuffer_Release(&seeds);
+
+    _PerfectMapCollector collector = {
+            .map = map,
+            .count = 0,
+            .capacity = 64,
+            .keys = (_PerfectMapKey *) malloc(64 * sizeof(_PerfectMapKey)),
+    };
+    map_ForEach(source, _perfectMap_CollectKey, &collector);
+
+    // Repeats of a key keep the item stored first, which is the one the map returns
+    qsort(collector.keys, collector.count, sizeof(_PerfectMapKey), _perfectMap_CompareKeys);
+    size_t numKeys = 0;
+    for (size_t i = 0; i < collector.count; i++) {
+        if (numKeys == 0 || collector.keys[numKeys - 1].fingerprint != collector.keys[i].fingerprint) {
+            collector.keys[numKeys++] = collector.keys[i];
+        }
+    }
+
+    _PerfectMapKey *unplaced = (_PerfectMapKey *) malloc((numKeys > 0 ? numKeys : 1) * sizeof(_PerfectMapKey));
+    memcpy(unplaced, collector.keys, numKeys * sizeof(_PerfectMapKey));
+    uint64_t *levels[PERFECT_MAP_MAX_LEVELS];
+    map->numLeftovers = _perfectMap_BuildLevels(map, numKeys, unplaced, gamma, levelSeed, levels);
+    map->leftovers = (_PerfectMapKey *) realloc(unplaced, (map->numLeftovers > 0 ? map->numLeftovers : 1) * sizeof(_PerfectMapKey));
+
+    // Concatenate the levels and count the set bits before every block
+    map->numWords = 0;
+    for (int level = 0; level < map->numLevels; level++) {
+        map->levelOffsets[level] = map->numWords * 64;
+        map->numWords += map->levelBits[level] / 64;
+    }
+    map->bits = (uint64_t *) allocator_Allocate(map->allocator, (map->numWords > 0 ? map->numWords : 1) * sizeof(uint64_t));
+    for (int level = 0; level < map->numLevels; level++) {
+        memcpy(map->bits + map->levelOffsets[level] / 64, levels[level], map->levelBits[level] / 8);
+        free(levels[level]);
+    }
+
+    map->numRanks = map->numWords / PERFECT_MAP_RANK_BLOCK_WORDS + 1;
+    map->ranks = (uint32_t *) allocator_Allocate(map->allocator, map->numRanks * sizeof(uint32_t));
+    size_t rank = 0;
+    for (size_t i = 0; i < map->numWords; i++) {
+        if (i % PERFECT_MAP_RANK_BLOCK_WORDS == 0) {
+            map->ranks[i / PERFECT_MAP_RANK_BLOCK_WORDS] = (uint32_t) rank;
+        }
+        rank += __builtin_popcountll(map->bits[i]);
+    }
+    map->numSlots = rank;
+
+    size_t numSlots = map->numSlots > 0 ? map->numSlots : 1;
+    map->fingerprints = (uint64_t *) allocator_Allocate(map->allocator, numSlots * sizeof(uint64_t));
+    map->items = (void **) allocator_Allocate(map->allocator, numSlots * sizeof(void *));
+    for (size_t i = 0; i < numKeys; i++) {
+        size_t slot = _perfectMap_FindSlot(map, collector.keys[i].fingerprint);
+        if (slot < map->numSlots) {
+            map->fingerprints[slot] = collector.keys[i].fingerprint;
+            map->items[slot] = collector.keys[i].item;
+        }
+    }
+
+    free(collector.keys);
+    return map;
+}
+
+void
+perfectMap_Destroy(PerfectMap **mapP)
+{
+    PerfectMap *map = *mapP;
+    size_t numSlots = map->numSlots > 0 ? map->numSlots : 1;
+    allocator_Deallocate(map->allocator, map->bits, (map->numWords > 0 ? map->numWords : 1) * sizeof(uint64_t));
+    allocator_Deallocate(map->allocator, map->ranks, map->numRanks * sizeof(uint32_t));
+    allocator_Deallocate(map->allocator, map->fingerprints, numSlots * sizeof(uint64_t));
+    allocator_Deallocate(map->allocator, map->items, numSlots * sizeof(void *));
+    free(map->leftovers);
+    wyhasher_Destroy(&map->hasher);
+    free(map);
+    *mapP = NULL;
+}
+
+static void *
+_perfectMap_Lookup(PerfectMap *map, uint64_t fingerprint)
+{
+    size_t slot = _perfectMap_FindSlot(map, fingerprint);
+    if (slot < map->numSlots) {
+        return map->fingerprints[slot] == fingerprint ? map->items[slot] : NULL;
+    }
+
+    size_t low = 0;
+    size_t high = map->numLeftovers;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (map->leftovers[middle].fingerprint < fingerprint) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < map->numLeftovers && map->leftovers[low].fingerprint == fingerprint) {
+        return map->leftovers[low].item;
+    }
+    return NULL;
+}
+
+void *
+perfectMap_Get(PerfectMap *map, PARCBuffer *key)
+{
+    uint8_t digest[SIPHASH_HASH_LENGTH];
+    map_DigestKey(map->map, key, digest);
+    return _perfectMap_Lookup(map, _perfectMap_Fingerprint(map, SIPHASH_HASH_LENGTH, digest));
+}
+
+void *
+perfectMap_GetHashed(PerfectMap *map, PARCBuffer *key)
+{
+    return _perfectMap_Lookup(map, _perfectMap_Fingerprint(map, parcBuffer_Remaining(key), parcBuffer_Overlay(key, 0)));
+}
+
+size_t
+perfectMap_GetCount(PerfectMap *map)
+{
+    return map->numSlots + map->numLeftovers;
+}
+
+double
+perfectMap_GetBitsPerKey(PerfectMap *map)
+{
+    size_t count = perfectMap_GetCount(map);
+    if (count == 0) {
+        return 0.0;
+    }
+    return (double) (map->numWords * 64 + map->numRanks * 32) / count;
+}
+
+size_t
+perfectMap_GetSizeInBytes(PerfectMap *map)
+{
+    return map->numWords * sizeof(uint64_t) + map->numRanks * sizeof(uint32_t) +
+        map->numSlots * (sizeof(uint64_t) + sizeof(void *)) + map->numLeftovers * sizeof(_PerfectMapKey);
+}
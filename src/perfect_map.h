@@ -0,0 +1,50 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef perfect_map_h_
+#define perfect_map_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <parc/algol/parc_Buffer.h>
+
+#include "map.h"
+
+struct perfect_map;
+typedef struct perfect_map PerfectMap;
+
+// Bits per key of the first level of the perfect hash; larger values trade space for fewer levels
+extern const double PerfectMapDefaultGamma;
+
+// A frozen copy of a map: a minimal perfect hash (BBHash) of its keys to a dense array of
+// 8-byte key fingerprints and items. A lookup hashes the key once and, for most keys, reads one
+// bit, one rank counter and one slot. Absent keys are rejected by the fingerprint, so two keys
+// whose fingerprints collide (about n^2 / 2^65 for n keys) are treated as one. Where a key is
+// stored more than once, the first item stored is kept, as map_Get would return it.
+//
+// The map is not copied and must outlive the perfect map: raw keys are digested with its hasher.
+PerfectMap *perfectMap_CreateFromMap(Map *map, double gamma);
+
+void perfectMap_Destroy(PerfectMap **mapP);
+
+// As map_Get
+void *perfectMap_Get(PerfectMap *map, PARCBuffer *key);
+
+// As map_GetHashed
+void *perfectMap_GetHashed(PerfectMap *map, PARCBuffer *key);
+
+size_t perfectMap_GetCount(PerfectMap *map);
+
+// Bits of perfect hash metadata (level bit arrays and rank counters) per key
+double perfectMap_GetBitsPerKey(PerfectMap *map);
+
+// Bytes held by the perfect hash, fingerprints and item slots
+size_t perfectMap_GetSizeInBytes(PerfectMap *map);
+
+#endif // perfect_map_h_
+
+#ifdef __cplusplus
+}
+#endif
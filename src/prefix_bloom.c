@@ -3,67 +3,137 @@
 //
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <parc/algol/parc_Memory.h>
 
 #include "prefix_bloom.h"
 
 #include "bloom.h"
+#include "cuckoo_filter.h"
 #include "siphasher.h"
+#include "parallel.h"
 
 // debug
 #include <stdio.h>
 #include "timer.h"
 
+// Target number of bits per block when the block count is derived from the load
+const int PrefixBloomDefaultBlockSize = 1 << 16;
+
 struct prefix_bloom_filter {
     int k;
     int m;
     int b;
 
     PARCBuffer **keys;
-    BloomFilter **filterBlocks;
     SipHasher *hasher;
+
+    // Exactly one of the block arrays is used, depending on the filter type
+    FilterType type;
+    BloomFilter **filterBlocks;
+    CuckooFilter **cuckooBlocks;
 };
 
-PrefixBloomFilter *
-prefixBloomFilter_Create(int b, int m, int k)
+static PrefixBloomFilter *
+_prefixBloomFilter_Create(int b, int m, int k, int blockEntries, double targetFPR, FilterType type)
 {
     PrefixBloomFilter *filter = parcMemory_Allocate(sizeof(PrefixBloomFilter));
     if (filter != NULL) {
         filter->b = b;
         filter->m = m;
         filter->k = k;
+        filter->type = type;
+        filter->filterBlocks = NULL;
+        filter->cuckooBlocks = NULL;
 
-        filter->filterBlocks = parcMemory_Allocate(b * sizeof(PrefixBloomFilter *));
-        for (int i = 0; i < b; i++) {
-            filter->filterBlocks[i] = bloom_Create(m, k);
+        if (type == FilterType_Bloom) {
+            filter->filterBlocks = parcMemory_Allocate(b * sizeof(BloomFilter *));
+            for (int i = 0; i < b; i++) {
+                if (blockEntries > 0) {
+                    filter->filterBlocks[i] = bloom_CreateOptimal(blockEntries, targetFPR);
+                } else {
+                    filter->filterBlocks[i] = bloom_Create(m, k);
+                }
+            }
         }
 
         filter->keys = (PARCBuffer **) malloc(sizeof(PARCBuffer **) * k);
         for (int i = 0; i < k; i++) {
             filter->keys[i] = parcBuffer_Allocate(SIPHASH_KEY_LENGTH);
-            parcBuffer_PutUint32(filter->keys[i], k);
+            parcBuffer_PutUint32(filter->keys[i], i);
             parcBuffer_Flip(filter->keys[i]);
         }
         filter->hasher = siphasher_CreateWithKeys(k, filter->keys);
+
+        // Cuckoo blocks hash with the first key of the shared hasher
+        if (type == FilterType_Cuckoo) {
+            filter->cuckooBlocks = parcMemory_Allocate(b * sizeof(CuckooFilter *));
+            for (int i = 0; i < b; i++) {
+                filter->cuckooBlocks[i] = cuckooFilter_CreateWithHasher(blockEntries, false, filter->hasher);
+            }
+        }
     }
     return filter;
 }
 
+PrefixBloomFilter *
+prefixBloomFilter_Create(int b, int m, int k)
+{
+    return _prefixBloomFilter_Create(b, m, k, 0, 0.0, FilterType_Bloom);
+}
+
+PrefixBloomFilter *
+prefixBloomFilter_CreateOptimal(int expectedEntries, double targetFPR)
+{
+    return prefixBloomFilter_CreateOptimalWithFilter(expectedEntries, targetFPR, FilterType_Bloom);
+}
+
+PrefixBloomFilter *
+prefixBloomFilter_CreateOptimalWithFilter(int expectedEntries, double targetFPR, FilterType type)
+{
+    // Derive the total filter size, then split it into blocks of roughly PrefixBloomDefaultBlockSize bits
+    size_t totalSize = bloom_OptimalSize(expectedEntries, targetFPR);
+    int b = (int) ((totalSize + PrefixBloomDefaultBlockSize - 1) / PrefixBloomDefaultBlockSize);
+    int blockEntries = (expectedEntries + b - 1) / b;
+
+    int m = bloom_OptimalSize(blockEntries, targetFPR);
+    int k = bloom_OptimalHashCount(m, blockEntries);
+
+    return _prefixBloomFilter_Create(b, m, k, blockEntries, targetFPR, type);
+}
+
+void
+prefixBloomFilter_SetMaxFillRatio(PrefixBloomFilter *filter, double maxFillRatio)
+{
+    // Cuckoo blocks grow when they run out of slots
+    for (int i = 0; filter->filterBlocks != NULL && i < filter->b; i++) {
+        bloom_SetMaxFillRatio(filter->filterBlocks[i], maxFillRatio);
+    }
+}
+
 void
 prefixBloomFilter_Destroy(PrefixBloomFilter **bfP)
 {
     PrefixBloomFilter *filter = *bfP;
 
     for (int i = 0; i < filter->b; i++) {
-        bloom_Destroy(&filter->filterBlocks[i]);
+        if (filter->type == FilterType_Cuckoo) {
+            cuckooFilter_Destroy(&filter->cuckooBlocks[i]);
+        } else {
+            bloom_Destroy(&filter->filterBlocks[i]);
+        }
     }
     for (int i = 0; i < filter->k; i++) {
         parcBuffer_Release(&filter->keys[i]);
     }
 
     free(filter->keys);
-    parcMemory_Deallocate(&filter->filterBlocks);
+    if (filter->type == FilterType_Cuckoo) {
+        parcMemory_Deallocate(&filter->cuckooBlocks);
+    } else {
+        parcMemory_Deallocate(&filter->filterBlocks);
+    }
     siphasher_Destroy(&filter->hasher);
 
     parcMemory_Deallocate(bfP);
@@ -80,14 +150,13 @@ _djb(size_t length, uint8_t *buffer) {
     return hash;
 }
 
-static int
-_checkSum(size_t length, uint8_t *buffer)
+static uint64_t
+_digestIndex(size_t length, uint8_t *buffer)
 {
-    int sum = 0;
-    for (size_t i = 0; i < length; i++) {
-        sum += buffer[i];
-    }
-    return sum;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    bloom_DigestToHashPair(length, buffer, &h1, &h2);
+    return h1;
 }
 
 static uint64_t
@@ -97,7 +166,7 @@ _computeBlockIndex(PrefixBloomFilter *filter, const Name *name)
     uint64_t blockIndex = 0;
     if (name_IsHashed(name)) {
         firstSegmentHash = name_GetWireFormat(name, 1);
-        blockIndex = _checkSum(parcBuffer_Remaining(firstSegmentHash), parcBuffer_Overlay(firstSegmentHash, 0)) % filter->b;
+        blockIndex = _digestIndex(parcBuffer_Remaining(firstSegmentHash), parcBuffer_Overlay(firstSegmentHash, 0)) % filter->b;
     } else {
         firstSegmentHash = name_GetWireFormat(name, 1);
         blockIndex = _djb(parcBuffer_Remaining(firstSegmentHash), parcBuffer_Overlay(firstSegmentHash, 0)) % filter->b;
@@ -107,11 +176,34 @@ _computeBlockIndex(PrefixBloomFilter *filter, const Name *name)
     return blockIndex;
 }
 
+// Hashed names are digested already; other prefixes are hashed whole
+static void
+_prefixBloomFilter_HashPrefix(PrefixBloomFilter *filter, const Name *name, int count, uint64_t *h1, uint64_t *h2)
+{
+    PARCBuffer *prefix = name_GetWireFormat(name, count);
+    if (name_IsHashed(name)) {
+        bloom_DigestToHashPair(parcBuffer_Remaining(prefix), parcBuffer_Overlay(prefix, 0), h1, h2);
+    } else {
+        uint8_t digest[SIPHASH_HASH_LENGTH];
+        siphasher_Digest(filter->hasher, parcBuffer_Remaining(prefix), parcBuffer_Overlay(prefix, 0), digest);
+        bloom_DigestToHashPair(SIPHASH_HASH_LENGTH, digest, h1, h2);
+    }
+    parcBuffer_Release(&prefix);
+}
+
 void
 prefixBloomFilter_Add(PrefixBloomFilter *filter, const Name *name)
 {
     uint64_t blockIndex = _computeBlockIndex(filter, name);
-    if (!name_IsHashed(name)) {
+    if (filter->type == FilterType_Cuckoo) {
+        // A name already reported present is not stored again, so repeated names take one slot
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+        _prefixBloomFilter_HashPrefix(filter, name, name_GetSegmentCount(name), &h1, &h2);
+        if (!cuckooFilter_TestHashPair(filter->cuckooBlocks[blockIndex], h1, h2)) {
+            cuckooFilter_AddHashPair(filter->cuckooBlocks[blockIndex], h1, h2);
+        }
+    } else if (!name_IsHashed(name)) {
         return bloom_AddName(filter->filterBlocks[blockIndex], (Name *) name);
     } else {
         PARCBuffer *nameValue = name_GetWireFormat((Name *) name, name_GetSegmentCount(name));
@@ -120,6 +212,117 @@ prefixBloomFilter_Add(PrefixBloomFilter *filter, const Name *name)
     }
 }
 
+bool
+prefixBloomFilter_Remove(PrefixBloomFilter *filter, const Name *name)
+{
+    if (filter->type != FilterType_Cuckoo) {
+        return false;
+    }
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    _prefixBloomFilter_HashPrefix(filter, name, name_GetSegmentCount(name), &h1, &h2);
+    return cuckooFilter_RemoveHashPair(filter->cuckooBlocks[_computeBlockIndex(filter, name)], h1, h2);
+}
+
+typedef struct {
+    PrefixBloomFilter *filter;
+    Name **names;
+    uint64_t *blockIndexes;
+    size_t *order;
+    size_t *blockStarts;
+} _PrefixBloomBulkAdd;
+
+static void
+_prefixBloomFilter_ComputeBlock(void *context, size_t i)
+{
+    _PrefixBloomBulkAdd *bulk = (_PrefixBloomBulkAdd *) context;
+    bulk->blockIndexes[i] = _computeBlockIndex(bulk->filter, bulk->names[i]);
+}
+
+// Every name of a block is added by the same thread, so the blocks need no locking
+static void
+_prefixBloomFilter_AddBlock(void *context, size_t block)
+{
+    _PrefixBloomBulkAdd *bulk = (_PrefixBloomBulkAdd *) context;
+    for (size_t i = bulk->blockStarts[block]; i < bulk->blockStarts[block + 1]; i++) {
+        prefixBloomFilter_Add(bulk->filter, bulk->names[bulk->order[i]]);
+    }
+}
+
+void
+prefixBloomFilter_AddMany(PrefixBloomFilter *filter, size_t n, Name *names[], int threads)
+{
+    _PrefixBloomBulkAdd bulk = {
+            .filter = filter,
+            .names = names,
+            .blockIndexes = (uint64_t *) malloc((n > 0 ? n : 1) * sizeof(uint64_t)),
+            .order = (size_t *) malloc((n > 0 ? n : 1) * sizeof(size_t)),
+            .blockStarts = (size_t *) calloc(filter->b + 1, sizeof(size_t)),
+    };
+
+    parallel_For(threads, n, _prefixBloomFilter_ComputeBlock, &bulk);
+
+    for (size_t i = 0; i < n; i++) {
+        bulk.blockStarts[bulk.blockIndexes[i] + 1]++;
+    }
+    for (int block = 0; block < filter->b; block++) {
+        bulk.blockStarts[block + 1] += bulk.blockStarts[block];
+    }
+    size_t *next = (size_t *) malloc(filter->b * sizeof(size_t));
+    memcpy(next, bulk.blockStarts, filter->b * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        bulk.order[next[bulk.blockIndexes[i]]++] = i;
+    }
+    free(next);
+
+    parallel_For(threads, filter->b, _prefixBloomFilter_AddBlock, &bulk);
+
+    free(bulk.blockStarts);
+    free(bulk.order);
+    free(bulk.blockIndexes);
+}
+
+static int
+_prefixBloomFilter_TestCuckooPrefixes(PrefixBloomFilter *filter, CuckooFilter *block, const Name *name, bool present[])
+{
+    int longest = -1;
+    for (int count = name_GetSegmentCount(name); count > 0; count--) {
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+        _prefixBloomFilter_HashPrefix(filter, name, count, &h1, &h2);
+        present[count - 1] = cuckooFilter_TestHashPair(block, h1, h2);
+
+        if (present[count - 1] && longest < 0) {
+            longest = count;
+        }
+    }
+    return longest;
+}
+
+int
+prefixBloomFilter_TestPrefixes(PrefixBloomFilter *filter, const Name *name, bool present[])
+{
+    uint64_t blockIndex = _computeBlockIndex(filter, name);
+    if (filter->type == FilterType_Cuckoo) {
+        return _prefixBloomFilter_TestCuckooPrefixes(filter, filter->cuckooBlocks[blockIndex], name, present);
+    } else if (!name_IsHashed(name)) {
+        return bloom_TestNamePrefixes(filter->filterBlocks[blockIndex], (Name *) name, present);
+    } else {
+        int longest = -1;
+        for (int count = name_GetSegmentCount(name); count > 0; count--) {
+            PARCBuffer *nameValue = name_GetWireFormat(name, count);
+            present[count - 1] = bloom_TestHashed(filter->filterBlocks[blockIndex], nameValue);
+            parcBuffer_Release(&nameValue);
+
+            if (present[count - 1] && longest < 0) {
+                longest = count;
+            }
+        }
+        return longest;
+    }
+}
+
 int
 prefixBloomFilter_LPM(PrefixBloomFilter *filter, const Name *name)
 {
@@ -127,7 +330,17 @@ prefixBloomFilter_LPM(PrefixBloomFilter *filter, const Name *name)
     uint64_t blockIndex = _computeBlockIndex(filter, name);
     long elapsed = timerEnd(start);
 //    printf("Block: %ld\n", elapsed);
-    if (!name_IsHashed(name)) {
+    if (filter->type == FilterType_Cuckoo) {
+        for (int count = name_GetSegmentCount(name); count > 0; count--) {
+            uint64_t h1 = 0;
+            uint64_t h2 = 0;
+            _prefixBloomFilter_HashPrefix(filter, name, count, &h1, &h2);
+            if (cuckooFilter_TestHashPair(filter->cuckooBlocks[blockIndex], h1, h2)) {
+                return count;
+            }
+        }
+        return -1;
+    } else if (!name_IsHashed(name)) {
         start = timerStart();
         int other = bloom_TestName(filter->filterBlocks[blockIndex], (Name *) name);
         elapsed = timerEnd(start);
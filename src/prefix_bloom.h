@@ -6,6 +6,7 @@ extern "C" {
 #define FIB_PERF_PREFIX_BLOOM_H
 
 #include "name.h"
+#include "cuckoo_filter.h"
 
 // A Prefix Bloom Filter, as described by Varvello et al. in
 //   http://conferences.sigcomm.org/sigcomm/2012/paper/icn/p73.pdf
@@ -18,12 +19,37 @@ typedef struct prefix_bloom_filter PrefixBloomFilter;
 
 PrefixBloomFilter *prefixBloomFilter_Create(int b, int m, int k);
 
+// Derive the number of blocks and the per-block size and hash count from the
+// expected number of prefixes and the target false positive rate.
+PrefixBloomFilter *prefixBloomFilter_CreateOptimal(int expectedEntries, double targetFPR);
+
+// As prefixBloomFilter_CreateOptimal, with blocks of the given filter type. Cuckoo blocks hold
+// each prefix once, keep their own false positive rate (see cuckoo_filter.h) as they grow, and
+// can remove names.
+PrefixBloomFilter *prefixBloomFilter_CreateOptimalWithFilter(int expectedEntries, double targetFPR, FilterType type);
+
+void prefixBloomFilter_SetMaxFillRatio(PrefixBloomFilter *filter, double maxFillRatio);
+
 void prefixBloomFilter_Destroy(PrefixBloomFilter **bfP);
 
 void prefixBloomFilter_Add(PrefixBloomFilter *filter, const Name *name);
 
+// Forget name, however often it was added. Only cuckoo blocks can forget a name: returns false
+// for Bloom blocks, or if the name was not found. Cuckoo blocks hold each fingerprint once, so
+// this also forgets any other name with the same fingerprint, at about the filter's false
+// positive rate.
+bool prefixBloomFilter_Remove(PrefixBloomFilter *filter, const Name *name);
+
+// Add every name, on up to threads threads: the names are grouped by block, and each block is
+// filled by one thread
+void prefixBloomFilter_AddMany(PrefixBloomFilter *filter, size_t n, Name *names[], int threads);
+
 int prefixBloomFilter_LPM(PrefixBloomFilter *filter, const Name *name);
 
+// Set present[i] for every prefix of i + 1 segments that the filter reports, so that callers
+// can fall back to shorter lengths after a false positive. Returns the longest such length, or -1.
+int prefixBloomFilter_TestPrefixes(PrefixBloomFilter *filter, const Name *name, bool present[]);
+
 #endif //FIB_PERF_PREFIX_BLOOM_H
 
 #ifdef __cplusplus
@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "prefix_length_filter.h"
+
+#include "bloom.h"
+#include "random.h"
+#include "siphash24.h"
+#include "siphasher.h"
+
+#define MAX_FILTERED_LENGTH 64
+
+const int PrefixLengthFilterMaxLength = MAX_FILTERED_LENGTH;
+
+const uint64_t PrefixLengthFilterAllLengths = UINT64_MAX;
+
+const int PrefixLengthFilterDefaultCapacity = 64;
+
+struct prefix_length_filter {
+    size_t m;
+    int k;
+    double targetFPR;
+
+    // filters[d - 1] holds the prefixes of d segments, created on first use
+    BloomFilter *filters[MAX_FILTERED_LENGTH];
+    int maxLength;
+
+    // Keys the per-segment hashes that are chained into the prefix hashes
+    uint8_t key[SIPHASH_KEY_LENGTH];
+
+    // Shared by every per-length filter
+    SipHasher *hasher;
+};
+
+static PrefixLengthFilter *
+_prefixLengthFilter_Create(size_t m, int k, double targetFPR)
+{
+    PrefixLengthFilter *filter = (PrefixLengthFilter *) malloc(sizeof(PrefixLengthFilter));
+    if (filter != NULL) {
+        filter->m = m;
+        filter->k = k;
+        filter->targetFPR = targetFPR;
+        memset(filter->filters, 0, sizeof(filter->filters));
+        filter->maxLength = 0;
+
+        PARCBuffer *key = random_Bytes(parcBuffer_Allocate(SIPHASH_KEY_LENGTH));
+        memcpy(filter->key, parcBuffer_Overlay(key, 0), SIPHASH_KEY_LENGTH);
+        parcBuffer_Release(&key);
+
+        filter->hasher = bloom_CreateHasher();
+    }
+    return filter;
+}
+
+PrefixLengthFilter *
+prefixLengthFilter_Create(size_t m, int k)
+{
+    return _prefixLengthFilter_Create(m, k, 0.0);
+}
+
+PrefixLengthFilter *
+prefixLengthFilter_CreateOptimal(double targetFPR)
+{
+    return _prefixLengthFilter_Create(0, 0, targetFPR);
+}
+
+void
+prefixLengthFilter_Destroy(PrefixLengthFilter **filterP)
+{
+    PrefixLengthFilter *filter = *filterP;
+
+    for (int i = 0; i < filter->maxLength; i++) {
+        if (filter->filters[i] != NULL) {
+            bloom_Destroy(&filter->filters[i]);
+        }
+    }
+    siphasher_Destroy(&filter->hasher);
+
+    free(filter);
+    *filterP = NULL;
+}
+
+static BloomFilter *
+_prefixLengthFilter_CreateFilter(PrefixLengthFilter *filter)
+{
+    if (filter->targetFPR > 0) {
+        BloomFilter *bf = bloom_CreateOptimalWithHasher(PrefixLengthFilterDefaultCapacity, filter->targetFPR, filter->hasher);
+        bloom_SetMaxFillRatio(bf, BloomDefaultMaxFillRatio);
+        return bf;
+    }
+    return bloom_CreateWithHasher(filter->m, filter->k, filter->hasher);
+}
+
+// Extend the hash of the first d - 1 segments by segment d. The result is the h1 of the
+// length-d prefix; chaining through the mix keeps the prefix hash dependent on segment order.
+static uint64_t
+_prefixLengthFilter_ExtendHash(PrefixLengthFilter *filter, const uint8_t *buffer, const Name *name, int d,
+                               uint64_t prefixHash, uint64_t *h2)
+{
+    int start = name_GetPrefixLength(name, d - 1);
+    int end = name_GetPrefixLength(name, d);
+
+    uint64_t segmentHash = 0;
+    uint8_t digest[SIPHASH_HASH_LENGTH];
+    siphash(digest, buffer + start, end - start, filter->key);
+    memcpy(&segmentHash, digest, sizeof(segmentHash));
+
+    uint64_t h1 = 0;
+    uint64_t chained = prefixHash ^ segmentHash;
+    bloom_DigestToHashPair(sizeof(chained), (uint8_t *) &chained, &h1, h2);
+    return h1;
+}
+
+void
+prefixLengthFilter_Add(PrefixLengthFilter *filter, const Name *name)
+{
+    int numSegments = name_GetSegmentCount(name);
+    if (numSegments < 1 || numSegments > MAX_FILTERED_LENGTH) {
+        return;
+    }
+
+    if (filter->filters[numSegments - 1] == NULL) {
+        filter->filters[numSegments - 1] = _prefixLengthFilter_CreateFilter(filter);
+        if (numSegments > filter->maxLength) {
+            filter->maxLength = numSegments;
+        }
+    }
+
+    const uint8_t *buffer = name_GetBuffer(name);
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    for (int d = 1; d <= numSegments; d++) {
+        h1 = _prefixLengthFilter_ExtendHash(filter, buffer, name, d, h1, &h2);
+    }
+    bloom_AddHashPair(filter->filters[numSegments - 1], h1, h2);
+}
+
+uint64_t
+prefixLengthFilter_Candidates(PrefixLengthFilter *filter, const Name *name)
+{
+    int numSegments = name_GetSegmentCount(name);
+    int count = numSegments < filter->maxLength ? numSegments : filter->maxLength;
+
+    const uint8_t *buffer = name_GetBuffer(name);
+    uint64_t candidates = 0;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    for (int d = 1; d <= count; d++) {
+        h1 = _prefixLengthFilter_ExtendHash(filter, buffer, name, d, h1, &h2);
+        BloomFilter *bf = filter->filters[d - 1];
+        if (bf != NULL && bloom_TestHashPair(bf, h1, h2)) {
+            candidates |= ((uint64_t) 1) << (d - 1);
+        }
+    }
+    return candidates;
+}
+
+bool
+prefixLengthFilter_IsCandidate(uint64_t candidates, int length)
+{
+    if (length > MAX_FILTERED_LENGTH) {
+        return true;
+    }
+    return (candidates & (((uint64_t) 1) << (length - 1))) != 0;
+}
+
+bool
+prefixLengthFilter_HasCandidate(uint64_t candidates, int fromLength, int toLength)
+{
+    if (fromLength > toLength) {
+        return false;
+    } else if (toLength > MAX_FILTERED_LENGTH) {
+        return true;
+    }
+
+    uint64_t below = toLength == MAX_FILTERED_LENGTH ? UINT64_MAX : (((uint64_t) 1) << toLength) - 1;
+    uint64_t range = below & ~((((uint64_t) 1) << (fromLength - 1)) - 1);
+    return (candidates & range) != 0;
+}
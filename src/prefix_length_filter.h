@@ -0,0 +1,50 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef prefix_length_filter_h_
+#define prefix_length_filter_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "name.h"
+
+struct prefix_length_filter;
+typedef struct prefix_length_filter PrefixLengthFilter;
+
+// Candidate sets cover prefixes of 1 to PrefixLengthFilterMaxLength segments; longer prefixes
+// are never filtered, so engines must probe them unconditionally.
+extern const int PrefixLengthFilterMaxLength;
+
+// The candidate set that prunes nothing, used when no filter is enabled
+extern const uint64_t PrefixLengthFilterAllLengths;
+
+// Initial capacity of each auto-sized per-length filter -- filters grow with their actual load
+extern const int PrefixLengthFilterDefaultCapacity;
+
+// One Bloom filter of m bits and k hash functions per prefix length
+PrefixLengthFilter *prefixLengthFilter_Create(size_t m, int k);
+
+// Per-length filters sized for the target false positive rate, growing as prefixes are added
+PrefixLengthFilter *prefixLengthFilter_CreateOptimal(double targetFPR);
+
+void prefixLengthFilter_Destroy(PrefixLengthFilter **filterP);
+
+// Add the whole name as a prefix of its own length
+void prefixLengthFilter_Add(PrefixLengthFilter *filter, const Name *name);
+
+// Bit (d - 1) is set if a prefix of name with d segments may be in the table. Clear bits are
+// definitely absent. Every prefix is hashed in one pass over the name's segments.
+uint64_t prefixLengthFilter_Candidates(PrefixLengthFilter *filter, const Name *name);
+
+bool prefixLengthFilter_IsCandidate(uint64_t candidates, int length);
+
+// Whether any length from fromLength to toLength (inclusive) is a candidate
+bool prefixLengthFilter_HasCandidate(uint64_t candidates, int fromLength, int toLength);
+
+#endif // prefix_length_filter_h_
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,18 +4,391 @@
 
 #include "sha256hasher.h"
 
-#include <parc/security/parc_CryptoHasher.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SHA256_HAS_X86 1
+#endif
+
+#define SHA256_BLOCK_LENGTH 64
+#define SHA256_AVX2_LANES 8
 
 struct sha256hasher {
-    PARCCryptoHasher *hasher;
+    SHA256Implementation implementation;
+};
+
+static const uint32_t _sha256K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t _sha256IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
 };
 
+typedef void (*_SHA256Compress)(uint32_t state[8], const uint8_t *blocks, size_t numBlocks);
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static uint32_t
+_sha256_LoadBigEndian(const uint8_t *bytes)
+{
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+static void
+_sha256_StoreDigest(const uint32_t state[8], uint8_t digest[SHA256_HASH_LENGTH])
+{
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t) (state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t) (state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t) (state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t) state[i];
+    }
+}
+
+// The final one or two blocks: the tail of the input, the 0x80 terminator and the bit length
+static size_t
+_sha256_PadTail(size_t length, const uint8_t *input, uint8_t tail[2 * SHA256_BLOCK_LENGTH])
+{
+    size_t remainder = length % SHA256_BLOCK_LENGTH;
+    size_t tailLength = remainder + 9 <= SHA256_BLOCK_LENGTH ? SHA256_BLOCK_LENGTH : 2 * SHA256_BLOCK_LENGTH;
+
+    memset(tail, 0, tailLength);
+    memcpy(tail, input + (length - remainder), remainder);
+    tail[remainder] = 0x80;
+
+    uint64_t bits = (uint64_t) length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tailLength - 1 - i] = (uint8_t) (bits >> (8 * i));
+    }
+    return tailLength / SHA256_BLOCK_LENGTH;
+}
+
+static void
+_sha256_CompressGeneric(uint32_t state[8], const uint8_t *blocks, size_t numBlocks)
+{
+    uint32_t w[64];
+    for (size_t n = 0; n < numBlocks; n++, blocks += SHA256_BLOCK_LENGTH) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = _sha256_LoadBigEndian(blocks + 4 * i);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25)) + ((e & f) ^ (~e & g)) + _sha256K[i] + w[i];
+            uint32_t t2 = (ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef SHA256_HAS_X86
+// Intel SHA extensions: two rounds per sha256rnds2, with the message schedule in sha256msg1/2
+__attribute__((target("sha,sse4.1")))
+static void
+_sha256_CompressSHANI(uint32_t state[8], const uint8_t *blocks, size_t numBlocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // Reorder the state into the ABEF/CDGH layout the instructions expect
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (size_t n = 0; n < numBlocks; n++, blocks += SHA256_BLOCK_LENGTH) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i msgs[4];
+
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; g++) {
+            if (g < 4) {
+                msgs[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (blocks + 16 * g)), byteSwap);
+            }
+            __m128i current = msgs[g % 4];
+
+            __m128i msg = _mm_add_epi32(current, _mm_loadu_si128((const __m128i *) &_sha256K[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+            // Finish the schedule words for the next group of four rounds
+            if (g >= 3 && g < 15) {
+                __m128i next = _mm_add_epi32(msgs[(g + 1) % 4], _mm_alignr_epi8(current, msgs[(g + 3) % 4], 4));
+                msgs[(g + 1) % 4] = _mm_sha256msg2_epu32(next, current);
+            }
+
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+            // And start those of the group after three more
+            if (g >= 1 && g < 13) {
+                msgs[(g + 3) % 4] = _mm_sha256msg1_epu32(msgs[(g + 3) % 4], current);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *) &state[0], state0);
+    _mm_storeu_si128((__m128i *) &state[4], state1);
+}
+
+#define ROTR256(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// Multi-buffer SHA-256: one 32-bit lane per input. Lanes past their final block keep their state.
+__attribute__((target("avx2")))
+static void
+_sha256_DigestManyAVX2(int count, size_t lengths[count], uint8_t *inputs[count], uint8_t *digests[count])
+{
+    const __m256i byteSwap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                             12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    for (int base = 0; base < count; base += SHA256_AVX2_LANES) {
+        int lanes = count - base < SHA256_AVX2_LANES ? count - base : SHA256_AVX2_LANES;
+
+        uint8_t tails[SHA256_AVX2_LANES][2 * SHA256_BLOCK_LENGTH];
+        size_t fullBlocks[SHA256_AVX2_LANES] = { 0 };
+        size_t numBlocks[SHA256_AVX2_LANES] = { 0 };
+        size_t maxBlocks = 0;
+        for (int l = 0; l < lanes; l++) {
+            fullBlocks[l] = lengths[base + l] / SHA256_BLOCK_LENGTH;
+            numBlocks[l] = fullBlocks[l] + _sha256_PadTail(lengths[base + l], inputs[base + l], tails[l]);
+            maxBlocks = numBlocks[l] > maxBlocks ? numBlocks[l] : maxBlocks;
+        }
+
+        __m256i state[8];
+        for (int i = 0; i < 8; i++) {
+            state[i] = _mm256_set1_epi32((int) _sha256IV[i]);
+        }
+
+        for (size_t t = 0; t < maxBlocks; t++) {
+            const uint8_t *blocks[SHA256_AVX2_LANES];
+            uint32_t active[SHA256_AVX2_LANES] = { 0 };
+            for (int l = 0; l < SHA256_AVX2_LANES; l++) {
+                if (l < lanes && t < numBlocks[l]) {
+                    blocks[l] = t < fullBlocks[l] ? inputs[base + l] + SHA256_BLOCK_LENGTH * t
+                                                  : tails[l] + SHA256_BLOCK_LENGTH * (t - fullBlocks[l]);
+                    active[l] = UINT32_MAX;
+                } else {
+                    blocks[l] = tails[0];
+                }
+            }
+
+            __m256i w[16];
+            for (int i = 0; i < 16; i++) {
+                uint32_t words[SHA256_AVX2_LANES];
+                for (int l = 0; l < SHA256_AVX2_LANES; l++) {
+                    memcpy(&words[l], blocks[l] + 4 * i, sizeof(uint32_t));
+                }
+                w[i] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *) words), byteSwap);
+            }
+
+            __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+            __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; i++) {
+                if (i >= 16) {
+                    __m256i w15 = w[(i - 15) & 15];
+                    __m256i w2 = w[(i - 2) & 15];
+                    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(w15, 7), ROTR256(w15, 18)), _mm256_srli_epi32(w15, 3));
+                    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(w2, 17), ROTR256(w2, 19)), _mm256_srli_epi32(w2, 10));
+                    w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+                }
+
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(e, 6), ROTR256(e, 11)), ROTR256(e, 25));
+                __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+                __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1), _mm256_add_epi32(ch, w[i & 15]));
+                t1 = _mm256_add_epi32(t1, _mm256_set1_epi32((int) _sha256K[i]));
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROTR256(a, 2), ROTR256(a, 13)), ROTR256(a, 22));
+                __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+                __m256i t2 = _mm256_add_epi32(s0, maj);
+                h = g;
+                g = f;
+                f = e;
+                e = _mm256_add_epi32(d, t1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm256_add_epi32(t1, t2);
+            }
+
+            __m256i mask = _mm256_loadu_si256((const __m256i *) active);
+            __m256i working[8] = { a, b, c, d, e, f, g, h };
+            for (int i = 0; i < 8; i++) {
+                state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], working[i]), mask);
+            }
+        }
+
+        uint32_t words[8][SHA256_AVX2_LANES];
+        for (int i = 0; i < 8; i++) {
+            _mm256_storeu_si256((__m256i *) words[i], state[i]);
+        }
+        for (int l = 0; l < lanes; l++) {
+            uint32_t laneState[8];
+            for (int i = 0; i < 8; i++) {
+                laneState[i] = words[i][l];
+            }
+            _sha256_StoreDigest(laneState, digests[base + l]);
+        }
+    }
+}
+#endif
+
+bool
+sha256hasher_IsSupported(SHA256Implementation implementation)
+{
+    switch (implementation) {
+        case SHA256Implementation_Best:
+        case SHA256Implementation_Generic:
+            return true;
+#ifdef SHA256_HAS_X86
+        case SHA256Implementation_SHANI:
+            return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+        case SHA256Implementation_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static SHA256Implementation
+_sha256_Resolve(SHA256Implementation implementation)
+{
+    if (implementation != SHA256Implementation_Best) {
+        return sha256hasher_IsSupported(implementation) ? implementation : SHA256Implementation_Generic;
+    }
+    if (sha256hasher_IsSupported(SHA256Implementation_SHANI)) {
+        return SHA256Implementation_SHANI;
+    } else if (sha256hasher_IsSupported(SHA256Implementation_AVX2)) {
+        return SHA256Implementation_AVX2;
+    }
+    return SHA256Implementation_Generic;
+}
+
+static void
+_sha256_DigestWith(_SHA256Compress compress, size_t length, const uint8_t *input, uint8_t digest[SHA256_HASH_LENGTH])
+{
+    uint32_t state[8];
+    memcpy(state, _sha256IV, sizeof(state));
+
+    compress(state, input, length / SHA256_BLOCK_LENGTH);
+
+    uint8_t tail[2 * SHA256_BLOCK_LENGTH];
+    size_t tailBlocks = _sha256_PadTail(length, input, tail);
+    compress(state, tail, tailBlocks);
+
+    _sha256_StoreDigest(state, digest);
+}
+
+void
+sha256hasher_Digest(SHA256Implementation implementation, size_t length, const uint8_t *input,
+                    uint8_t digest[SHA256_HASH_LENGTH])
+{
+    implementation = _sha256_Resolve(implementation);
+#ifdef SHA256_HAS_X86
+    if (implementation == SHA256Implementation_SHANI) {
+        _sha256_DigestWith(_sha256_CompressSHANI, length, input, digest);
+        return;
+    } else if (implementation == SHA256Implementation_AVX2) {
+        uint8_t *inputs[1] = { (uint8_t *) input };
+        uint8_t *digests[1] = { digest };
+        _sha256_DigestManyAVX2(1, &length, inputs, digests);
+        return;
+    }
+#endif
+    _sha256_DigestWith(_sha256_CompressGeneric, length, input, digest);
+}
+
+void
+sha256hasher_DigestMany(SHA256Implementation implementation, int count, size_t lengths[],
+                        uint8_t *inputs[], uint8_t *outputs[], size_t outputLength)
+{
+    implementation = _sha256_Resolve(implementation);
+
+    // Short outputs are staged through full-size digests
+    uint8_t *digests = NULL;
+    uint8_t **targets = outputs;
+    if (outputLength < SHA256_HASH_LENGTH) {
+        digests = (uint8_t *) malloc(count * SHA256_HASH_LENGTH);
+        targets = (uint8_t **) malloc(count * sizeof(uint8_t *));
+        for (int i = 0; i < count; i++) {
+            targets[i] = digests + i * SHA256_HASH_LENGTH;
+        }
+    }
+
+#ifdef SHA256_HAS_X86
+    if (implementation == SHA256Implementation_AVX2) {
+        _sha256_DigestManyAVX2(count, lengths, inputs, targets);
+    } else
+#endif
+    {
+        for (int i = 0; i < count; i++) {
+            sha256hasher_Digest(implementation, lengths[i], inputs[i], targets[i]);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (digests != NULL) {
+            memcpy(outputs[i], targets[i], outputLength);
+        } else if (outputLength > SHA256_HASH_LENGTH) {
+            memset(outputs[i] + SHA256_HASH_LENGTH, 0, outputLength - SHA256_HASH_LENGTH);
+        }
+    }
+
+    if (digests != NULL) {
+        free(targets);
+        free(digests);
+    }
+}
+
 SHA256Hasher *
 sha256hasher_Create()
+{
+    return sha256hasher_CreateWithImplementation(SHA256Implementation_Best);
+}
+
+SHA256Hasher *
+sha256hasher_CreateWithImplementation(SHA256Implementation implementation)
 {
     SHA256Hasher *hasher = (SHA256Hasher *) malloc(sizeof(SHA256Hasher));
     if (hasher != NULL) {
-        hasher->hasher = parcCryptoHasher_Create(PARCCryptoHashType_SHA256);
+        hasher->implementation = _sha256_Resolve(implementation);
     }
     return hasher;
 }
@@ -24,7 +397,6 @@ void
 sha256hasher_Destroy(SHA256Hasher **hasherP)
 {
     SHA256Hasher *hasher = *hasherP;
-    parcCryptoHasher_Release(&hasher->hasher);
     free(hasher);
     *hasherP = NULL;
 }
@@ -32,25 +404,24 @@ sha256hasher_Destroy(SHA256Hasher **hasherP)
 PARCBuffer *
 sha256hasher_Hash(SHA256Hasher *hasher, PARCBuffer *input)
 {
-    parcCryptoHasher_Init(hasher->hasher);
-    parcCryptoHasher_UpdateBuffer(hasher->hasher, input);
-    PARCCryptoHash *hash = parcCryptoHasher_Finalize(hasher->hasher);
-    PARCBuffer *digest = parcBuffer_Acquire(parcCryptoHash_GetDigest(hash));
-    parcCryptoHash_Release(&hash);
-    return digest;
+    return sha256hasher_HashArray(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0));
 }
 
 PARCBuffer *
-sha256hasher_HashArray(SHA256Hasher *hasher, size_t length, uint8_t input[length])
+sha256hasher_HashArray(SHA256Hasher *hasher, size_t length, uint8_t input[])
 {
-    parcCryptoHasher_Init(hasher->hasher);
-    parcCryptoHasher_UpdateBytes(hasher->hasher, input, length);
-    PARCCryptoHash *hash = parcCryptoHasher_Finalize(hasher->hasher);
-    PARCBuffer *digest = parcBuffer_Acquire(parcCryptoHash_GetDigest(hash));
-    parcCryptoHash_Release(&hash);
+    PARCBuffer *digest = parcBuffer_Allocate(SHA256_HASH_LENGTH);
+    sha256hasher_Digest(hasher->implementation, length, input, parcBuffer_Overlay(digest, 0));
     return digest;
 }
 
+void
+sha256hasher_HashMany(SHA256Hasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                      uint8_t *outputs[], size_t outputLength)
+{
+    sha256hasher_DigestMany(hasher->implementation, count, lengths, inputs, outputs, outputLength);
+}
+
 Bitmap *
 sha256hasher_HashToVector(SHA256Hasher *hasher, PARCBuffer *input, int range)
 {
@@ -65,7 +436,7 @@ sha256hasher_HashToVector(SHA256Hasher *hasher, PARCBuffer *input, int range)
 }
 
 Bitmap *
-sha256hasher_HashArrayToVector(SHA256Hasher *hasher, size_t length, uint8_t input[length], int range)
+sha256hasher_HashArrayToVector(SHA256Hasher *hasher, size_t length, uint8_t input[], int range)
 {
     Bitmap *vector = bitmap_Create(range);
 
@@ -82,5 +453,6 @@ HasherInterface *SHA256HashAsHasher = &(HasherInterface) {
         .HashArray = (PARCBuffer *(*)(void *hasher, size_t length, uint8_t *input)) sha256hasher_HashArray,
         .HashToVector = (Bitmap *(*)(void*hasher, PARCBuffer *input, int range)) sha256hasher_HashToVector,
         .HashArrayToVector = (Bitmap *(*)(void*hasher, size_t length, uint8_t *input, int range)) sha256hasher_HashArrayToVector,
+        .HashMany = (void (*)(void *hasher, int count, size_t *lengths, uint8_t **inputs, uint8_t **outputs, size_t outputLength)) sha256hasher_HashMany,
         .Destroy = (void (*)(void **instance)) sha256hasher_Destroy,
 };
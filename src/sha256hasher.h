@@ -7,8 +7,21 @@ extern "C" {
 
 #include <parc/algol/parc_Buffer.h>
 
+#include <stdbool.h>
+
 #include "hasher.h"
 
+#define SHA256_HASH_LENGTH 32
+
+// The SHA-256 compression function: the fastest the CPU supports, or a specific one (for testing
+// and benchmarking). Unsupported choices fall back to the generic C implementation.
+typedef enum {
+    SHA256Implementation_Best,
+    SHA256Implementation_Generic,
+    SHA256Implementation_SHANI, // Intel SHA extensions
+    SHA256Implementation_AVX2   // 8-lane multi-buffer; only batches fill the lanes
+} SHA256Implementation;
+
 struct sha256hasher;
 typedef struct sha256hasher SHA256Hasher;
 
@@ -16,14 +29,30 @@ extern HasherInterface *SHA256HashAsHasher;
 
 SHA256Hasher *sha256hasher_Create();
 
+SHA256Hasher *sha256hasher_CreateWithImplementation(SHA256Implementation implementation);
+
 void sha256hasher_Destroy(SHA256Hasher **hasherP);
 
 PARCBuffer *sha256hasher_Hash(SHA256Hasher *hasher, PARCBuffer *input);
 
-PARCBuffer *sha256hasher_HashArray(SHA256Hasher *hasher, size_t length, uint8_t input[length]);
+PARCBuffer *sha256hasher_HashArray(SHA256Hasher *hasher, size_t length, uint8_t input[]);
+
+// Hash count inputs, writing each digest, truncated or zero-padded to outputLength bytes, into outputs[i]
+void sha256hasher_HashMany(SHA256Hasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                           uint8_t *outputs[], size_t outputLength);
 
 Bitmap *sha256hasher_HashToVector(SHA256Hasher *hasher, PARCBuffer *input, int range);
 
+Bitmap *sha256hasher_HashArrayToVector(SHA256Hasher *hasher, size_t length, uint8_t input[], int range);
+
+bool sha256hasher_IsSupported(SHA256Implementation implementation);
+
+void sha256hasher_Digest(SHA256Implementation implementation, size_t length, const uint8_t *input,
+                         uint8_t digest[SHA256_HASH_LENGTH]);
+
+void sha256hasher_DigestMany(SHA256Implementation implementation, int count, size_t lengths[],
+                             uint8_t *inputs[], uint8_t *outputs[], size_t outputLength);
+
 #endif //FIB_PERF_SHA256HASHER_H
 
 #ifdef __cplusplus
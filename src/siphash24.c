@@ -18,7 +18,7 @@
 #include <stdio.h>
 #include <string.h>
 
-/* default: SipHash-2-4 */
+/* default: SipHash-2-4; siphash_rounds also runs reduced variants such as SipHash-1-3 */
 #define cROUNDS 2
 #define dROUNDS 4
 
@@ -74,7 +74,8 @@
 #define TRACE
 #endif
 
-int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
+int siphash_rounds(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k,
+                   int cRounds, int dRounds) {
   /* "somepseudorandomlygeneratedbytes" */
   uint64_t v0 = 0x736f6d6570736575ULL;
   uint64_t v1 = 0x646f72616e646f6dULL;
@@ -102,7 +103,7 @@ int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
     v3 ^= m;
 
     TRACE;
-    for (i = 0; i < cROUNDS; ++i)
+    for (i = 0; i < cRounds; ++i)
       SIPROUND;
 
     v0 ^= m;
@@ -131,7 +132,7 @@ int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
   v3 ^= b;
 
   TRACE;
-  for (i = 0; i < cROUNDS; ++i)
+  for (i = 0; i < cRounds; ++i)
     SIPROUND;
 
   v0 ^= b;
@@ -143,7 +144,7 @@ int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
 #endif
 
   TRACE;
-  for (i = 0; i < dROUNDS; ++i)
+  for (i = 0; i < dRounds; ++i)
     SIPROUND;
 
   b = v0 ^ v1 ^ v2 ^ v3;
@@ -153,7 +154,7 @@ int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
   v1 ^= 0xdd;
 
   TRACE;
-  for (i = 0; i < dROUNDS; ++i)
+  for (i = 0; i < dRounds; ++i)
     SIPROUND;
 
   b = v0 ^ v1 ^ v2 ^ v3;
@@ -162,3 +163,240 @@ int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
 
   return 0;
 }
+
+int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k) {
+  return siphash_rounds(out, in, inlen, k, cROUNDS, dROUNDS);
+}
+
+/*
+   Multi-buffer SipHash: independent inputs (of any lengths, under any keys)
+   are hashed in parallel SIMD lanes. A lane whose message is exhausted keeps
+   its state while the longer lanes compress, so every digest is bit-identical
+   to siphash_rounds() on the same input.
+ */
+
+/* The t-th compression word of a message: a full block, or the length-tagged tail */
+static uint64_t siphash_word(const uint8_t *in, uint64_t inlen, uint64_t t) {
+  uint64_t numBlocks = inlen / 8;
+  if (t < numBlocks) {
+    return U8TO64_LE(in + 8 * t);
+  }
+
+  uint64_t b = ((uint64_t)inlen) << 56;
+  const uint8_t *tail = in + 8 * numBlocks;
+  for (int i = (int)(inlen & 7) - 1; i >= 0; i--) {
+    b |= ((uint64_t)tail[i]) << (8 * i);
+  }
+  return b;
+}
+
+static void siphash_many_scalar(int count, uint8_t *out[], const uint8_t *in[],
+                                const uint64_t inlen[], const uint8_t *k[],
+                                int cRounds, int dRounds) {
+  for (int i = 0; i < count; i++) {
+    siphash_rounds(out[i], in[i], inlen[i], k[i], cRounds, dRounds);
+  }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+#define SIPHASH_HAS_SIMD 1
+
+#define ROTL256(x, b)                                                          \
+  _mm256_or_si256(_mm256_slli_epi64((x), (b)), _mm256_srli_epi64((x), 64 - (b)))
+
+#define SIPROUND256                                                            \
+  do {                                                                         \
+    v0 = _mm256_add_epi64(v0, v1);                                             \
+    v1 = ROTL256(v1, 13);                                                      \
+    v1 = _mm256_xor_si256(v1, v0);                                             \
+    v0 = _mm256_shuffle_epi32(v0, _MM_SHUFFLE(2, 3, 0, 1));                    \
+    v2 = _mm256_add_epi64(v2, v3);                                             \
+    v3 = ROTL256(v3, 16);                                                      \
+    v3 = _mm256_xor_si256(v3, v2);                                             \
+    v0 = _mm256_add_epi64(v0, v3);                                             \
+    v3 = ROTL256(v3, 21);                                                      \
+    v3 = _mm256_xor_si256(v3, v0);                                             \
+    v2 = _mm256_add_epi64(v2, v1);                                             \
+    v1 = ROTL256(v1, 17);                                                      \
+    v1 = _mm256_xor_si256(v1, v2);                                             \
+    v2 = _mm256_shuffle_epi32(v2, _MM_SHUFFLE(2, 3, 0, 1));                    \
+  } while (0)
+
+__attribute__((target("avx2")))
+static void siphash_many_avx2(int count, uint8_t *out[], const uint8_t *in[],
+                              const uint64_t inlen[], const uint8_t *k[],
+                              int cRounds, int dRounds) {
+  for (int base = 0; base < count; base += 4) {
+    int lanes = count - base < 4 ? count - base : 4;
+    uint64_t k0[4] = {0}, k1[4] = {0}, numWords[4] = {0};
+    uint64_t maxWords = 0;
+    for (int l = 0; l < lanes; l++) {
+      k0[l] = U8TO64_LE(k[base + l]);
+      k1[l] = U8TO64_LE(k[base + l] + 8);
+      numWords[l] = inlen[base + l] / 8 + 1;
+      maxWords = numWords[l] > maxWords ? numWords[l] : maxWords;
+    }
+
+    __m256i key0 = _mm256_loadu_si256((const __m256i *)k0);
+    __m256i key1 = _mm256_loadu_si256((const __m256i *)k1);
+    __m256i v0 = _mm256_xor_si256(_mm256_set1_epi64x(0x736f6d6570736575ULL), key0);
+    __m256i v1 = _mm256_xor_si256(_mm256_set1_epi64x(0x646f72616e646f6dULL), key1);
+    __m256i v2 = _mm256_xor_si256(_mm256_set1_epi64x(0x6c7967656e657261ULL), key0);
+    __m256i v3 = _mm256_xor_si256(_mm256_set1_epi64x(0x7465646279746573ULL), key1);
+
+    for (uint64_t t = 0; t < maxWords; t++) {
+      uint64_t words[4] = {0}, active[4] = {0};
+      for (int l = 0; l < lanes; l++) {
+        if (t < numWords[l]) {
+          words[l] = siphash_word(in[base + l], inlen[base + l], t);
+          active[l] = ~0ULL;
+        }
+      }
+      __m256i m = _mm256_loadu_si256((const __m256i *)words);
+      __m256i mask = _mm256_loadu_si256((const __m256i *)active);
+      __m256i s0 = v0, s1 = v1, s2 = v2, s3 = v3;
+
+      v3 = _mm256_xor_si256(v3, m);
+      for (int i = 0; i < cRounds; ++i)
+        SIPROUND256;
+      v0 = _mm256_xor_si256(v0, m);
+
+      v0 = _mm256_blendv_epi8(s0, v0, mask);
+      v1 = _mm256_blendv_epi8(s1, v1, mask);
+      v2 = _mm256_blendv_epi8(s2, v2, mask);
+      v3 = _mm256_blendv_epi8(s3, v3, mask);
+    }
+
+    v2 = _mm256_xor_si256(v2, _mm256_set1_epi64x(0xff));
+    for (int i = 0; i < dRounds; ++i)
+      SIPROUND256;
+
+    uint64_t result[4];
+    __m256i b = _mm256_xor_si256(_mm256_xor_si256(v0, v1), _mm256_xor_si256(v2, v3));
+    _mm256_storeu_si256((__m256i *)result, b);
+    for (int l = 0; l < lanes; l++) {
+      U64TO8_LE(out[base + l], result[l]);
+    }
+  }
+}
+
+#define SIPROUND512                                                            \
+  do {                                                                         \
+    v0 = _mm512_add_epi64(v0, v1);                                             \
+    v1 = _mm512_rol_epi64(v1, 13);                                             \
+    v1 = _mm512_xor_si512(v1, v0);                                             \
+    v0 = _mm512_rol_epi64(v0, 32);                                             \
+    v2 = _mm512_add_epi64(v2, v3);                                             \
+    v3 = _mm512_rol_epi64(v3, 16);                                             \
+    v3 = _mm512_xor_si512(v3, v2);                                             \
+    v0 = _mm512_add_epi64(v0, v3);                                             \
+    v3 = _mm512_rol_epi64(v3, 21);                                             \
+    v3 = _mm512_xor_si512(v3, v0);                                             \
+    v2 = _mm512_add_epi64(v2, v1);                                             \
+    v1 = _mm512_rol_epi64(v1, 17);                                             \
+    v1 = _mm512_xor_si512(v1, v2);                                             \
+    v2 = _mm512_rol_epi64(v2, 32);                                             \
+  } while (0)
+
+__attribute__((target("avx512f")))
+static void siphash_many_avx512(int count, uint8_t *out[], const uint8_t *in[],
+                                const uint64_t inlen[], const uint8_t *k[],
+                                int cRounds, int dRounds) {
+  for (int base = 0; base < count; base += 8) {
+    int lanes = count - base < 8 ? count - base : 8;
+    uint64_t k0[8] = {0}, k1[8] = {0}, numWords[8] = {0};
+    uint64_t maxWords = 0;
+    for (int l = 0; l < lanes; l++) {
+      k0[l] = U8TO64_LE(k[base + l]);
+      k1[l] = U8TO64_LE(k[base + l] + 8);
+      numWords[l] = inlen[base + l] / 8 + 1;
+      maxWords = numWords[l] > maxWords ? numWords[l] : maxWords;
+    }
+
+    __m512i key0 = _mm512_loadu_si512(k0);
+    __m512i key1 = _mm512_loadu_si512(k1);
+    __m512i v0 = _mm512_xor_si512(_mm512_set1_epi64(0x736f6d6570736575ULL), key0);
+    __m512i v1 = _mm512_xor_si512(_mm512_set1_epi64(0x646f72616e646f6dULL), key1);
+    __m512i v2 = _mm512_xor_si512(_mm512_set1_epi64(0x6c7967656e657261ULL), key0);
+    __m512i v3 = _mm512_xor_si512(_mm512_set1_epi64(0x7465646279746573ULL), key1);
+
+    for (uint64_t t = 0; t < maxWords; t++) {
+      uint64_t words[8] = {0};
+      __mmask8 active = 0;
+      for (int l = 0; l < lanes; l++) {
+        if (t < numWords[l]) {
+          words[l] = siphash_word(in[base + l], inlen[base + l], t);
+          active |= (__mmask8)(1 << l);
+        }
+      }
+      __m512i m = _mm512_loadu_si512(words);
+      __m512i s0 = v0, s1 = v1, s2 = v2, s3 = v3;
+
+      v3 = _mm512_xor_si512(v3, m);
+      for (int i = 0; i < cRounds; ++i)
+        SIPROUND512;
+      v0 = _mm512_xor_si512(v0, m);
+
+      v0 = _mm512_mask_mov_epi64(s0, active, v0);
+      v1 = _mm512_mask_mov_epi64(s1, active, v1);
+      v2 = _mm512_mask_mov_epi64(s2, active, v2);
+      v3 = _mm512_mask_mov_epi64(s3, active, v3);
+    }
+
+    v2 = _mm512_xor_si512(v2, _mm512_set1_epi64(0xff));
+    for (int i = 0; i < dRounds; ++i)
+      SIPROUND512;
+
+    uint64_t result[8];
+    __m512i b = _mm512_xor_si512(_mm512_xor_si512(v0, v1), _mm512_xor_si512(v2, v3));
+    _mm512_storeu_si512(result, b);
+    for (int l = 0; l < lanes; l++) {
+      U64TO8_LE(out[base + l], result[l]);
+    }
+  }
+}
+#endif
+
+int siphash_max_lanes(void) {
+#ifdef SIPHASH_HAS_SIMD
+  if (__builtin_cpu_supports("avx512f")) {
+    return 8;
+  } else if (__builtin_cpu_supports("avx2")) {
+    return 4;
+  }
+#endif
+  return 1;
+}
+
+int siphash_many_lanes(int lanes, int cRounds, int dRounds, int count,
+                       uint8_t *out[], const uint8_t *in[],
+                       const uint64_t inlen[], const uint8_t *k[]) {
+  int maxLanes = siphash_max_lanes();
+  if (lanes <= 0 || lanes > maxLanes) {
+    lanes = maxLanes;
+  }
+
+  /* A single input gains nothing from the lanes */
+  if (count < 2) {
+    lanes = 1;
+  }
+
+#ifdef SIPHASH_HAS_SIMD
+  if (lanes >= 8) {
+    siphash_many_avx512(count, out, in, inlen, k, cRounds, dRounds);
+    return 0;
+  } else if (lanes >= 4) {
+    siphash_many_avx2(count, out, in, inlen, k, cRounds, dRounds);
+    return 0;
+  }
+#endif
+  siphash_many_scalar(count, out, in, inlen, k, cRounds, dRounds);
+  return 0;
+}
+
+int siphash_many(int count, uint8_t *out[], const uint8_t *in[],
+                 const uint64_t inlen[], const uint8_t *k[]) {
+  return siphash_many_lanes(0, cROUNDS, dROUNDS, count, out, in, inlen, k);
+}
@@ -7,6 +7,21 @@ extern "C" {
 
 int siphash(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k);
 
+// SipHash-c-d, e.g., 1 and 3 for the reduced-round SipHash-1-3
+int siphash_rounds(uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k, int cRounds, int dRounds);
+
+// Hash count independent inputs, out[i] = siphash(in[i], inlen[i], k[i]), in parallel
+// AVX-512 (8-lane) or AVX2 (4-lane) SIMD lanes when the CPU has them. Digests are
+// bit-identical to the scalar siphash.
+int siphash_many(int count, uint8_t *out[], const uint8_t *in[], const uint64_t inlen[], const uint8_t *k[]);
+
+// The widest lane count available: 8, 4 or 1 (scalar)
+int siphash_max_lanes(void);
+
+// siphash_many with SipHash-c-d, using at most lanes lanes (0 for the widest available)
+int siphash_many_lanes(int lanes, int cRounds, int dRounds, int count,
+                       uint8_t *out[], const uint8_t *in[], const uint64_t inlen[], const uint8_t *k[]);
+
 #endif // siphash24_h_
 
 #ifdef __cplusplus
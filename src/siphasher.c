@@ -5,9 +5,18 @@
 #include "siphasher.h"
 #include "siphash24.h"
 
+#include <string.h>
+
 struct siphasher {
     int numKeys;
     PARCBuffer **keys;
+
+    // Resolved once so that concurrent hashes never touch the key buffers' positions
+    const uint8_t **keyBytes;
+
+    // SipHash-c-d rounds
+    int cRounds;
+    int dRounds;
 };
 
 SipHasher *
@@ -17,21 +26,40 @@ siphasher_Create(PARCBuffer *key)
     if (hasher != NULL) {
         hasher->keys = (PARCBuffer **) malloc(sizeof(PARCBuffer *));
         hasher->keys[0] = parcBuffer_Acquire(key);
+        hasher->keyBytes = (const uint8_t **) malloc(sizeof(uint8_t *));
+        hasher->keyBytes[0] = parcBuffer_Overlay(key, 0);
         hasher->numKeys = 1;
+        hasher->cRounds = 2;
+        hasher->dRounds = 4;
+    }
+    return hasher;
+}
+
+SipHasher *
+siphasher_CreateReduced(PARCBuffer *key)
+{
+    SipHasher *hasher = siphasher_Create(key);
+    if (hasher != NULL) {
+        hasher->cRounds = 1;
+        hasher->dRounds = 3;
     }
     return hasher;
 }
 
 SipHasher *
-siphasher_CreateWithKeys(int numKeys, PARCBuffer *keys[numKeys])
+siphasher_CreateWithKeys(int numKeys, PARCBuffer *keys[])
 {
     SipHasher *hasher = (SipHasher *) malloc(sizeof(SipHasher));
     if (hasher != NULL) {
         hasher->numKeys = numKeys;
         hasher->keys = (PARCBuffer **) malloc(numKeys * sizeof(PARCBuffer *));
+        hasher->keyBytes = (const uint8_t **) malloc(numKeys * sizeof(uint8_t *));
         for (int i = 0; i < numKeys; i++) {
             hasher->keys[i] = parcBuffer_Acquire(keys[i]);
+            hasher->keyBytes[i] = parcBuffer_Overlay(keys[i], 0);
         }
+        hasher->cRounds = 2;
+        hasher->dRounds = 4;
     }
     return hasher;
 }
@@ -44,58 +72,124 @@ siphasher_Destroy(SipHasher **hasherP)
         parcBuffer_Release(&hasher->keys[i]);
     }
     free(hasher->keys);
+    free(hasher->keyBytes);
     free(hasher);
     *hasherP = NULL;
 }
 
+static uint64_t
+_siphasher_HashWithKey(SipHasher *hasher, int keyIndex, size_t length, uint8_t input[length])
+{
+    uint8_t output[SIPHASH_HASH_LENGTH];
+    siphash_rounds(output, input, length, hasher->keyBytes[keyIndex], hasher->cRounds, hasher->dRounds);
+
+    // Match parcBuffer_GetUint64, which reads network byte order
+    uint64_t value = 0;
+    for (int i = 0; i < SIPHASH_HASH_LENGTH; i++) {
+        value = (value << 8) | output[i];
+    }
+    return value;
+}
+
 PARCBuffer *
 siphasher_Hash(SipHasher *hasher, PARCBuffer *input)
 {
     PARCBuffer *hashOutput = parcBuffer_Allocate(SIPHASH_HASH_LENGTH);
     uint8_t *outputOverlay = parcBuffer_Overlay(hashOutput, 0);
     uint8_t *inputOverlay = parcBuffer_Overlay(input, 0);
-    uint8_t *keyOverlay = parcBuffer_Overlay(hasher->keys[0], 0);
+    const uint8_t *keyOverlay = hasher->keyBytes[0];
     size_t inputSize = parcBuffer_Remaining(input);
 
-    siphash(outputOverlay, inputOverlay, inputSize, keyOverlay);
+    siphash_rounds(outputOverlay, inputOverlay, inputSize, keyOverlay, hasher->cRounds, hasher->dRounds);
 
     return hashOutput;
 }
 
+void
+siphasher_Digest(SipHasher *hasher, size_t length, const uint8_t input[], uint8_t output[SIPHASH_HASH_LENGTH])
+{
+    siphash_rounds(output, input, length, hasher->keyBytes[0], hasher->cRounds, hasher->dRounds);
+}
+
 PARCBuffer *
-siphasher_HashArray(SipHasher *hasher, size_t length, uint8_t input[length])
+siphasher_HashArray(SipHasher *hasher, size_t length, uint8_t input[])
 {
     PARCBuffer *hashOutput = parcBuffer_Allocate(SIPHASH_HASH_LENGTH);
-    siphash(parcBuffer_Overlay(hashOutput, 0), input,
-            length, parcBuffer_Overlay(hasher->keys[0], 0));
+    siphash_rounds(parcBuffer_Overlay(hashOutput, 0), input,
+            length, hasher->keyBytes[0], hasher->cRounds, hasher->dRounds);
     return hashOutput;
 }
 
+void
+siphasher_HashMany(SipHasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                   uint8_t *outputs[], size_t outputLength)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const uint8_t **keys = (const uint8_t **) malloc(count * sizeof(uint8_t *));
+    uint64_t *inputLengths = (uint64_t *) malloc(count * sizeof(uint64_t));
+    const uint8_t *key = hasher->keyBytes[0];
+    for (int i = 0; i < count; i++) {
+        keys[i] = key;
+        inputLengths[i] = lengths[i];
+    }
+
+    // Short outputs are staged through full-size digests
+    uint8_t *digests = NULL;
+    uint8_t **targets = outputs;
+    if (outputLength < SIPHASH_HASH_LENGTH) {
+        digests = (uint8_t *) malloc(count * SIPHASH_HASH_LENGTH);
+        targets = (uint8_t **) malloc(count * sizeof(uint8_t *));
+        for (int i = 0; i < count; i++) {
+            targets[i] = digests + i * SIPHASH_HASH_LENGTH;
+        }
+    }
+
+    siphash_many_lanes(0, hasher->cRounds, hasher->dRounds, count, targets,
+                       (const uint8_t **) inputs, inputLengths, keys);
+
+    for (int i = 0; i < count; i++) {
+        if (digests != NULL) {
+            memcpy(outputs[i], targets[i], outputLength);
+        } else if (outputLength > SIPHASH_HASH_LENGTH) {
+            memset(outputs[i] + SIPHASH_HASH_LENGTH, 0, outputLength - SIPHASH_HASH_LENGTH);
+        }
+    }
+
+    if (digests != NULL) {
+        free(targets);
+        free(digests);
+    }
+    free(inputLengths);
+    free(keys);
+}
+
 Bitmap *
 siphasher_HashToVector(SipHasher *hasher, PARCBuffer *input, int range)
 {
     Bitmap *vector = bitmap_Create(range);
 
+    // Each key yields an independent hash function
+    uint8_t *inputOverlay = parcBuffer_Overlay(input, 0);
+    size_t inputSize = parcBuffer_Remaining(input);
     for (int i = 0; i < hasher->numKeys; i++) {
-        PARCBuffer *hashOutput = siphasher_Hash(hasher, input);
-        size_t index = parcBuffer_GetUint64(hashOutput) % range;
+        size_t index = _siphasher_HashWithKey(hasher, i, inputSize, inputOverlay) % range;
         bitmap_Set(vector, index);
-        parcBuffer_Release(&hashOutput);
     }
 
     return vector;
 }
 
 Bitmap *
-siphasher_HashArrayToVector(SipHasher *hasher, size_t length, uint8_t input[length], int range)
+siphasher_HashArrayToVector(SipHasher *hasher, size_t length, uint8_t input[], int range)
 {
     Bitmap *vector = bitmap_Create(range);
 
     for (int i = 0; i < hasher->numKeys; i++) {
-        PARCBuffer *hashOutput = siphasher_HashArray(hasher, length, input);
-        size_t index = parcBuffer_GetUint64(hashOutput) % range;
+        size_t index = _siphasher_HashWithKey(hasher, i, length, input) % range;
         bitmap_Set(vector, index);
-        parcBuffer_Release(&hashOutput);
     }
 
     return vector;
@@ -106,5 +200,6 @@ HasherInterface *SipHashAsHasher = &(HasherInterface) {
         .HashArray = (PARCBuffer *(*)(void *hasher, size_t length, uint8_t *input)) siphasher_HashArray,
         .HashToVector = (Bitmap *(*)(void*hasher, PARCBuffer *input, int range)) siphasher_HashToVector,
         .HashArrayToVector = (Bitmap *(*)(void*hasher, size_t length, uint8_t *input, int range)) siphasher_HashArrayToVector,
+        .HashMany = (void (*)(void *hasher, int count, size_t *lengths, uint8_t **inputs, uint8_t **outputs, size_t outputLength)) siphasher_HashMany,
         .Destroy = (void (*)(void **instance)) siphasher_Destroy,
 };
\ No newline at end of file
@@ -17,17 +17,28 @@ extern HasherInterface *SipHashAsHasher;
 
 SipHasher *siphasher_Create(PARCBuffer *key);
 
-SipHasher *siphasher_CreateWithKeys(int numKeys, PARCBuffer *keys[numKeys]);
+SipHasher *siphasher_CreateWithKeys(int numKeys, PARCBuffer *keys[]);
+
+// SipHash-1-3: fewer rounds for fabrics that do not need SipHash-2-4's security margin
+SipHasher *siphasher_CreateReduced(PARCBuffer *key);
 
 void siphasher_Destroy(SipHasher **hasherP);
 
 PARCBuffer *siphasher_Hash(SipHasher *hasher, PARCBuffer *input);
 
-PARCBuffer *siphasher_HashArray(SipHasher *hasher, size_t length, uint8_t input[length]);
+PARCBuffer *siphasher_HashArray(SipHasher *hasher, size_t length, uint8_t input[]);
+
+// The siphasher_Hash digest of input with the first key, written to output without allocating
+void siphasher_Digest(SipHasher *hasher, size_t length, const uint8_t input[], uint8_t output[SIPHASH_HASH_LENGTH]);
+
+// Hash count inputs with the first key, in parallel SIMD lanes where the CPU allows. Each
+// output receives the SipHash digest truncated or zero-padded to outputLength bytes.
+void siphasher_HashMany(SipHasher *hasher, int count, size_t lengths[], uint8_t *inputs[],
+                        uint8_t *outputs[], size_t outputLength);
 
 Bitmap *siphasher_HashToVector(SipHasher *hasher, PARCBuffer *input, int range);
 
-Bitmap *siphasher_HashArrayToVector(SipHasher *hasher, size_t length, uint8_t input[length], int range);
+Bitmap *siphasher_HashArrayToVector(SipHasher *hasher, size_t length, uint8_t input[], int range);
 
 #endif //FIB_PERF_SIPHASHER_H
 
@@ -0,0 +1,136 @@
+#include "../allocator.h"
+#include "../hugepage_allocator.h"
+#include "../numa_allocator.h"
+#include "../bitmap.h"
+#include "../patricia.h"
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(allocator)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(allocator)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(allocator)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, allocator_System);
+    LONGBOW_RUN_TEST_CASE(Core, allocator_HugePage);
+    LONGBOW_RUN_TEST_CASE(Core, allocator_NUMA);
+    LONGBOW_RUN_TEST_CASE(Core, allocator_SetDefault);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    allocator_SetDefault(NULL);
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+static void
+_assertAllocations(Allocator *allocator)
+{
+    size_t sizes[] = { 1, 100, 4096, 512 * 1024, 3 * 1024 * 1024 };
+    for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint8_t *memory = allocator_Allocate(allocator, sizes[i]);
+        assertNotNull(memory, "Expected a %zu byte allocation to succeed", sizes[i]);
+        assertTrue(((uintptr_t) memory % 64) == 0, "Expected cache-line aligned memory");
+        assertTrue(memory[0] == 0 && memory[sizes[i] - 1] == 0, "Expected zeroed memory");
+
+        memory[0] = 1;
+        memory[sizes[i] - 1] = 1;
+        allocator_Deallocate(allocator, memory, sizes[i]);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, allocator_System)
+{
+    _assertAllocations(allocator_GetDefault());
+}
+
+LONGBOW_TEST_CASE(Core, allocator_HugePage)
+{
+    HugePageAllocator *hugePages = hugePageAllocator_Create(HugePageAllocatorDefaultMinimumSize);
+    Allocator *allocator = allocator_Create(hugePages, HugePageAsAllocator);
+    assertNotNull(allocator, "Expected a non-NULL allocator to be created");
+
+    _assertAllocations(allocator);
+
+    allocator_Destroy(&allocator);
+    assertNull(allocator, "Expected a NULL allocator after allocator_Destroy");
+}
+
+LONGBOW_TEST_CASE(Core, allocator_NUMA)
+{
+    // Node 0 always exists, even on non-NUMA machines
+    NUMAAllocator *numa = numaAllocator_Create(0, false);
+    Allocator *allocator = allocator_Create(numa, NUMAAsAllocator);
+    assertNotNull(allocator, "Expected a non-NULL allocator to be created");
+
+    _assertAllocations(allocator);
+
+    allocator_Destroy(&allocator);
+}
+
+LONGBOW_TEST_CASE(Core, allocator_SetDefault)
+{
+    HugePageAllocator *hugePages = hugePageAllocator_Create(HugePageAllocatorDefaultMinimumSize);
+    Allocator *allocator = allocator_Create(hugePages, HugePageAsAllocator);
+    allocator_SetDefault(allocator);
+    assertTrue(allocator_GetDefault() == allocator, "Expected the default allocator to be replaced");
+
+    // A multi-megabyte bitmap and a trie now come from the huge page allocator
+    uint64_t size = 64 * 1024 * 1024;
+    Bitmap *map = bitmap_Create(size);
+    bitmap_Set(map, size - 1);
+    assertTrue(bitmap_Get(map, size - 1), "Expected the last bit to be set");
+    assertTrue(bitmap_Count(map) == 1, "Expected exactly one bit to be set");
+
+    Patricia *trie = patricia_Create(NULL);
+    PARCBuffer *key = parcBuffer_AllocateCString("foo");
+    patricia_Insert(trie, key, key);
+    assertTrue(patricia_Get(trie, key) == key, "Expected the inserted key to be found");
+
+    // Structures remember their allocator, so restoring the default does not affect them
+    allocator_SetDefault(NULL);
+    bitmap_Destroy(&map);
+    patricia_Destroy(&trie);
+    parcBuffer_Release(&key);
+
+    allocator_Destroy(&allocator);
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(allocator);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
@@ -1,5 +1,7 @@
 #include "../bitmap.h"
 
+#include <inttypes.h>
+
 #include <LongBow/testing.h>
 #include <LongBow/debugging.h>
 
@@ -29,6 +31,8 @@ LONGBOW_TEST_FIXTURE(Core)
 {
     LONGBOW_RUN_TEST_CASE(Core, bitmap_Create);
     LONGBOW_RUN_TEST_CASE(Core, bitmap_Stress);
+    LONGBOW_RUN_TEST_CASE(Core, bitmap_UnalignedSize);
+    LONGBOW_RUN_TEST_CASE(Core, bitmap_HugeSize);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -94,6 +98,52 @@ LONGBOW_TEST_CASE(Core, bitmap_Stress)
     bitmap_Destroy(&map);
 }
 
+LONGBOW_TEST_CASE(Core, bitmap_UnalignedSize)
+{
+    int sizes[] = {1, 31, 33, 63, 65, 9586};
+    int numSizes = sizeof(sizes) / sizeof(int);
+
+    for (int i = 0; i < numSizes; i++) {
+        int size = sizes[i];
+        Bitmap *map = bitmap_Create(size);
+        assertNotNull(map, "Expected a non-NULL bitmap to be created");
+
+        for (int bit = 0; bit < size; bit++) {
+            bitmap_Set(map, bit);
+        }
+        assertTrue(bitmap_Count(map) == size, "Expected %d set bits, got %" PRIu64, size, bitmap_Count(map));
+        assertTrue(bitmap_Get(map, size - 1), "Expected the last bit to be set");
+
+        // The bit one past the end is out of bounds
+        bitmap_Set(map, size);
+        assertFalse(bitmap_Get(map, size), "Expected an out of bounds bit to be unset");
+        assertTrue(bitmap_Count(map) == size, "Expected an out of bounds set to be ignored");
+
+        bitmap_Destroy(&map);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, bitmap_HugeSize)
+{
+    // Larger than 2^32 bits, i.e., beyond what int indexes could address
+    uint64_t size = (((uint64_t) 1) << 32) + 17;
+    Bitmap *map = bitmap_Create(size);
+    assertNotNull(map, "Expected a non-NULL bitmap to be created");
+    assertTrue(bitmap_GetSize(map) == size, "Expected the bitmap size to be preserved");
+
+    uint64_t high = size - 1;
+    uint64_t aliased = high & 0xFFFFFFFF;
+
+    bitmap_Set(map, high);
+    assertTrue(bitmap_Get(map, high), "Expected the high bit to be set");
+    assertFalse(bitmap_Get(map, aliased), "Expected the high bit not to alias a low bit");
+
+    bitmap_Clear(map, high);
+    assertFalse(bitmap_Get(map, high), "Expected the high bit to be cleared");
+
+    bitmap_Destroy(&map);
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -1,4 +1,5 @@
 #include "../bloom.h"
+#include "../sha256hasher.h"
 
 #include <LongBow/testing.h>
 #include <LongBow/debugging.h>
@@ -32,6 +33,11 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, bloom_AddHashed);
     LONGBOW_RUN_TEST_CASE(Core, bloom_AddTest);
     LONGBOW_RUN_TEST_CASE(Core, bloom_AddHashedTest);
+    LONGBOW_RUN_TEST_CASE(Core, bloom_AddSaltedSharedHasher);
+    LONGBOW_RUN_TEST_CASE(Core, bloom_OptimalSize);
+    LONGBOW_RUN_TEST_CASE(Core, bloom_CreateOptimal);
+    LONGBOW_RUN_TEST_CASE(Core, bloom_CreateOptimalGrowth);
+    LONGBOW_RUN_TEST_CASE(Core, bloom_HashedFalsePositiveRate);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -120,6 +126,27 @@ LONGBOW_TEST_CASE(Core, bloom_AddTest)
     bloom_Destroy(&bf);
 }
 
+LONGBOW_TEST_CASE(Core, bloom_AddSaltedSharedHasher)
+{
+    SipHasher *hasher = bloom_CreateHasher();
+    BloomFilter *bf = bloom_CreateWithHasher(1024, 3, hasher);
+    BloomFilter *other = bloom_CreateWithHasher(1024, 3, hasher);
+
+    PARCBuffer *x = parcBuffer_AllocateCString("foo");
+
+    bloom_AddSalted(bf, 1, x);
+    assertTrue(bloom_TestSalted(bf, 1, x), "Item x not detected with its salt");
+    assertFalse(bloom_TestSalted(bf, 2, x), "Item x detected with a different salt");
+    assertFalse(bloom_Test(bf, x), "Item x detected without its salt");
+    assertFalse(bloom_TestSalted(other, 1, x), "Item x detected in a filter sharing only the hasher");
+
+    parcBuffer_Release(&x);
+
+    bloom_Destroy(&bf);
+    bloom_Destroy(&other);
+    siphasher_Destroy(&hasher);
+}
+
 LONGBOW_TEST_CASE(Core, bloom_AddHashedTest)
 {
     BloomFilter *bf = bloom_Create(128, 3);
@@ -139,9 +166,9 @@ LONGBOW_TEST_CASE(Core, bloom_AddHashedTest)
     bool inFilter = bloom_TestHashed(bf, z);
     assertFalse(inFilter, "Item z detected in the filter when really it should not have been");
 
-    // x2 will be in the filter since it's just x rearranged
+    // x2 is just x rearranged, which must not map to the same bits
     inFilter = bloom_TestHashed(bf, x2);
-    assertTrue(inFilter, "Item x not detected in the filter when it should have collided with x");
+    assertFalse(inFilter, "Item x2 detected in the filter when it should not have collided with x");
 
     parcBuffer_Release(&x);
     parcBuffer_Release(&y);
@@ -151,6 +178,118 @@ LONGBOW_TEST_CASE(Core, bloom_AddHashedTest)
     bloom_Destroy(&bf);
 }
 
+LONGBOW_TEST_CASE(Core, bloom_OptimalSize)
+{
+    // m = -n ln(p) / ln(2)^2, k = (m / n) ln(2)
+    size_t m = bloom_OptimalSize(1000, 0.01);
+    assertTrue(m == 9586, "Expected m = 9586, got %zu", m);
+
+    int k = bloom_OptimalHashCount(m, 1000);
+    assertTrue(k == 7, "Expected k = 7, got %d", k);
+}
+
+LONGBOW_TEST_CASE(Core, bloom_CreateOptimal)
+{
+    BloomFilter *bf = bloom_CreateOptimal(1000, 0.01);
+    assertNotNull(bf, "Expected a non-NULL bloom to be created");
+    assertTrue(bloom_GetSize(bf) == 9586, "Expected m = 9586, got %zu", bloom_GetSize(bf));
+    assertTrue(bloom_GetHashCount(bf) == 7, "Expected k = 7, got %d", bloom_GetHashCount(bf));
+    bloom_Destroy(&bf);
+}
+
+LONGBOW_TEST_CASE(Core, bloom_CreateOptimalGrowth)
+{
+    int capacity = 64;
+    int numEntries = 16 * capacity;
+    BloomFilter *bf = bloom_CreateOptimal(capacity, 0.01);
+    bloom_SetMaxFillRatio(bf, BloomDefaultMaxFillRatio);
+    size_t initialSize = bloom_GetSize(bf);
+
+    char key[32];
+    for (int i = 0; i < numEntries; i++) {
+        sprintf(key, "key-%d", i);
+        PARCBuffer *x = parcBuffer_AllocateCString(key);
+        bloom_Add(bf, x);
+        parcBuffer_Release(&x);
+    }
+
+    assertTrue(bloom_GetSize(bf) > initialSize, "Expected the filter to grow past its initial capacity");
+    assertTrue(bloom_FillRatio(bf) <= 0.75, "Expected the fill ratio to stay bounded, got %f", bloom_FillRatio(bf));
+
+    for (int i = 0; i < numEntries; i++) {
+        sprintf(key, "key-%d", i);
+        PARCBuffer *x = parcBuffer_AllocateCString(key);
+        assertTrue(bloom_Test(bf, x), "Item %s not detected in the grown filter", key);
+        parcBuffer_Release(&x);
+    }
+
+    bloom_Destroy(&bf);
+}
+
+static PARCBuffer *
+_createDigest(Hasher *hasher, const char *prefix, int index, int length)
+{
+    char key[64];
+    sprintf(key, "%s-%d", prefix, index);
+    PARCBuffer *input = parcBuffer_AllocateCString(key);
+    PARCBuffer *hash = hasher_Hash(hasher, input);
+    parcBuffer_Release(&input);
+
+    // Truncate to the digest size used by hashed names
+    PARCBuffer *digest = parcBuffer_Allocate(length);
+    parcBuffer_PutArray(digest, length, parcBuffer_Overlay(hash, 0));
+    parcBuffer_Flip(digest);
+    parcBuffer_Release(&hash);
+
+    return digest;
+}
+
+LONGBOW_TEST_CASE(Core, bloom_HashedFalsePositiveRate)
+{
+    SHA256Hasher *sha256 = sha256hasher_Create();
+    Hasher *hasher = hasher_Create(sha256, SHA256HashAsHasher);
+
+    int capacity = 1000;
+    int numProbes = 10000;
+    double targetFPR = 0.01;
+    double loads[] = { 0.25, 0.5, 1.0, 2.0 };
+
+    // The keys are fixed, so the measured rates are reproducible from run to run
+    printf("load,fpr,expected\n");
+    for (int l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+        BloomFilter *bf = bloom_CreateOptimal(capacity, targetFPR);
+        size_t m = bloom_GetSize(bf);
+        int k = bloom_GetHashCount(bf);
+        int numEntries = (int) (loads[l] * capacity);
+
+        for (int i = 0; i < numEntries; i++) {
+            PARCBuffer *digest = _createDigest(hasher, "member", i, 8);
+            bloom_AddHashed(bf, digest);
+            parcBuffer_Release(&digest);
+        }
+
+        int falsePositives = 0;
+        for (int i = 0; i < numProbes; i++) {
+            PARCBuffer *digest = _createDigest(hasher, "probe", i, 8);
+            if (bloom_TestHashed(bf, digest)) {
+                falsePositives++;
+            }
+            parcBuffer_Release(&digest);
+        }
+
+        // p = (1 - e^(-kn/m))^k
+        double fpr = (double) falsePositives / numProbes;
+        double expected = pow(1.0 - exp(-((double) k * numEntries) / m), k);
+        printf("%.2f,%f,%f\n", loads[l], fpr, expected);
+
+        assertTrue(fpr <= 2 * expected + 0.005, "FPR %f at load %.2f is far above the expected %f", fpr, loads[l], expected);
+
+        bloom_Destroy(&bf);
+    }
+
+    hasher_Destroy(&hasher);
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -0,0 +1,201 @@
+#include "../fib_cached.h"
+#include "../fib_naive.h"
+#include "../fib_caesar_filter.h"
+
+#include <inttypes.h>
+
+#include <LongBow/testing.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+#include "test_fib.c"
+
+LONGBOW_TEST_RUNNER(fibCached)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(fibCached)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(fibCached)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_LookupSimple);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_BulkLoad);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_Hits);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_InsertInvalidates);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_Eviction);
+    LONGBOW_RUN_TEST_CASE(Core, fibCached_RefusesOwnedResults);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+static FIBCached *
+_createCachedFIB(size_t capacity)
+{
+    FIBNaive *native = fibNative_Create();
+    return fibCached_Create(fib_Create(native, NativeFIBAsFIB), capacity);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_LookupSimple)
+{
+    FIB *fib = fib_Create(_createCachedFIB(64), CachedFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_LookupHashed)
+{
+    FIB *fib = fib_Create(_createCachedFIB(64), CachedFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_hash_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_BulkLoad)
+{
+    // A small cache, so that the bulk-load queries also exercise eviction
+    FIB *fib = fib_Create(_createCachedFIB(16), CachedFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_bulk_load(fib, 1);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_Hits)
+{
+    FIBCached *cache = _createCachedFIB(64);
+    assertTrue(fibCached_GetCapacity(cache) == 64, "Expected 64 entries, got %zu", fibCached_GetCapacity(cache));
+
+    Name *prefix = name_CreateFromCString("ccnx:/a/b");
+    Name *query = name_CreateFromCString("ccnx:/a/b/c");
+    Name *miss = name_CreateFromCString("ccnx:/x/y");
+    Bitmap *vector = bitmap_Create(128);
+    bitmap_Set(vector, 1);
+    fibCached_Insert(cache, prefix, vector);
+
+    for (int i = 0; i < 10; i++) {
+        assertTrue(fibCached_LPM(cache, query) == vector, "Expected lookup %d to return the /a/b vector", i);
+        assertNull(fibCached_LPM(cache, miss), "Expected lookup %d of /x/y to find nothing", i);
+    }
+
+    // Only the first lookup of each name reaches the FIB
+    assertTrue(fibCached_GetNumLookups(cache) == 20, "Expected 20 lookups, got %" PRIu64, fibCached_GetNumLookups(cache));
+    assertTrue(fibCached_GetNumHits(cache) == 18, "Expected 18 hits, got %" PRIu64, fibCached_GetNumHits(cache));
+
+    fibCached_Destroy(&cache);
+    bitmap_Destroy(&vector);
+    name_Destroy(&prefix);
+    name_Destroy(&query);
+    name_Destroy(&miss);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_InsertInvalidates)
+{
+    FIBCached *cache = _createCachedFIB(64);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b");
+    Name *query = name_CreateFromCString("ccnx:/a/b/c");
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+
+    assertNull(fibCached_LPM(cache, query), "Expected no match in an empty FIB");
+
+    fibCached_Insert(cache, shortPrefix, vector1);
+    assertTrue(fibCached_LPM(cache, query) == vector1, "Expected the cached miss to be dropped by the insertion");
+
+    fibCached_Insert(cache, longPrefix, vector2);
+    assertTrue(fibCached_LPM(cache, query) == vector2, "Expected the longer prefix after the insertion");
+    assertTrue(fibCached_LPM(cache, query) == vector2, "Expected the longer prefix from the cache");
+    assertTrue(fibCached_GetNumHits(cache) == 1, "Expected only the last lookup to hit, got %" PRIu64, fibCached_GetNumHits(cache));
+
+    fibCached_Destroy(&cache);
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&query);
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_Eviction)
+{
+    // One set: a name hit between misses keeps its entry, while the others cycle through the rest
+    FIBCached *cache = _createCachedFIB(CachedFIBWays);
+
+    char uri[64];
+    Name *names[32];
+    Bitmap *vectors[32];
+    for (int i = 0; i < 32; i++) {
+        snprintf(uri, sizeof(uri), "ccnx:/name/%d", i);
+        names[i] = name_CreateFromCString(uri);
+        vectors[i] = bitmap_Create(128);
+        bitmap_Set(vectors[i], i);
+        fibCached_Insert(cache, names[i], vectors[i]);
+    }
+
+    fibCached_LPM(cache, names[0]);
+    for (int i = 1; i < 32; i++) {
+        assertTrue(fibCached_LPM(cache, names[0]) == vectors[0], "Expected the hot name's vector");
+        assertTrue(fibCached_LPM(cache, names[i]) == vectors[i], "Expected the vector of name %d", i);
+    }
+    assertTrue(fibCached_GetNumHits(cache) == 31, "Expected every hot lookup to hit, got %" PRIu64, fibCached_GetNumHits(cache));
+
+    fibCached_Destroy(&cache);
+    for (int i = 0; i < 32; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, fibCached_RefusesOwnedResults)
+{
+    // Caesar-filter lookups return a new vector each time, which the cache would hand out again after it was freed
+    FIB *fib = fib_Create(fibCaesarFilter_CreateOptimal(128, 128, 0.01), CaesarFilterFIBAsFIB);
+    assertTrue(fib_CallerOwnsResults(fib), "Expected Caesar-filter lookups to return vectors the caller owns");
+    assertNull(fibCached_Create(fib, 64), "Expected the cache to refuse the FIB");
+    fib_Destroy(&fib);
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(fibCached);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
@@ -35,6 +35,10 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_Create);
     LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_LookupSimple);
     LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_LookupPorts);
+    LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_LookupCuckoo);
+    LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_LookupPortsCuckoo);
+    LONGBOW_RUN_TEST_CASE(Core, fibCaesarFilter_RemoveCuckoo);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -86,6 +90,125 @@ LONGBOW_TEST_CASE(Core, fibCaesarFilter_LookupHashed)
     fib_Destroy(&fib);
 }
 
+static void
+_test_lookup_ports(FilterType type)
+{
+    // Ports span several words, and the tiny per-port capacity forces growth stages.
+    // The low target rate keeps false positive ports out of the exact comparison.
+    int numPorts = 200;
+    FIBCaesarFilter *filterFIB = fibCaesarFilter_CreateOptimalWithFilter(numPorts, numPorts, 1e-9, type);
+
+    char uri[64];
+    Name *names[64];
+    Bitmap *vectors[64];
+    for (int i = 0; i < 64; i++) {
+        snprintf(uri, sizeof(uri), "ccnx:/port/%d", i);
+        names[i] = name_CreateFromCString(uri);
+        vectors[i] = bitmap_Create(numPorts);
+        bitmap_Set(vectors[i], (i * 7) % numPorts);
+        bitmap_Set(vectors[i], numPorts - 1 - (i % 3));
+        fibCaesarFilter_Insert(filterFIB, names[i], vectors[i]);
+    }
+
+    for (int i = 0; i < 64; i++) {
+        Bitmap *result = fibCaesarFilter_LPM(filterFIB, names[i]);
+        assertNotNull(result, "Expected a match for name %d", i);
+        assertTrue(bitmap_Contains(result, vectors[i]), "Expected every port of name %d to be set", i);
+        assertTrue(bitmap_Count(result) == bitmap_Count(vectors[i]), "Expected no extra ports for name %d", i);
+        bitmap_Destroy(&result);
+    }
+
+    fibCaesarFilter_Destroy(&filterFIB);
+
+    for (int i = 0; i < 64; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, fibCaesarFilter_LookupPorts)
+{
+    _test_lookup_ports(FilterType_Bloom);
+}
+
+LONGBOW_TEST_CASE(Core, fibCaesarFilter_LookupCuckoo)
+{
+    FIBCaesarFilter *filterFIB = fibCaesarFilter_CreateOptimalWithFilter(128, 128, 0.01, FilterType_Cuckoo);
+    FIB *fib = fib_Create(filterFIB, CaesarFilterFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_lookup(fib);
+    fib_Destroy(&fib);
+
+    filterFIB = fibCaesarFilter_CreateOptimalWithFilter(128, 128, 0.01, FilterType_Cuckoo);
+    fib = fib_Create(filterFIB, CaesarFilterFIBAsFIB);
+
+    test_fib_hash_lookup(fib);
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibCaesarFilter_LookupPortsCuckoo)
+{
+    // The ports of a name are stored as fingerprint payloads, and a stage grows past the capacity
+    _test_lookup_ports(FilterType_Cuckoo);
+}
+
+static void
+_test_assert_ports(FIBCaesarFilter *filterFIB, const Name *name, int numPorts, const int ports[numPorts], const char *message)
+{
+    Bitmap *result = fibCaesarFilter_LPM(filterFIB, name);
+    assertNotNull(result, "%s: expected a match", message);
+    assertTrue(bitmap_Count(result) == numPorts, "%s: expected %d ports", message, numPorts);
+    for (int i = 0; i < numPorts; i++) {
+        assertTrue(bitmap_Get(result, ports[i]), "%s: expected port %d", message, ports[i]);
+    }
+    bitmap_Destroy(&result);
+}
+
+LONGBOW_TEST_CASE(Core, fibCaesarFilter_RemoveCuckoo)
+{
+    FIBCaesarFilter *filterFIB = fibCaesarFilter_CreateOptimalWithFilter(8, 64, 1e-9, FilterType_Cuckoo);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b");
+    Name *query = name_CreateFromCString("ccnx:/a/b/c");
+
+    Bitmap *vectors[3];
+    for (int i = 0; i < 3; i++) {
+        vectors[i] = bitmap_Create(8);
+        bitmap_Set(vectors[i], i + 1);
+    }
+
+    // Repeated inserts store each (name, port) pair once
+    fibCaesarFilter_Insert(filterFIB, shortPrefix, vectors[0]);
+    for (int i = 0; i < 20; i++) {
+        fibCaesarFilter_Insert(filterFIB, longPrefix, vectors[1]);
+        fibCaesarFilter_Insert(filterFIB, longPrefix, vectors[2]);
+    }
+    _test_assert_ports(filterFIB, query, 2, (int[]) { 2, 3 }, "Both inserts of the longer prefix");
+
+    // Each remove takes back the ports of its vector, and the shorter prefix matches once none are left
+    assertTrue(fibCaesarFilter_Remove(filterFIB, longPrefix, vectors[1]), "Expected the first port to be removed");
+    _test_assert_ports(filterFIB, query, 1, (int[]) { 3 }, "The second port of the longer prefix");
+    assertTrue(fibCaesarFilter_Remove(filterFIB, longPrefix, vectors[2]), "Expected the second port to be removed");
+    _test_assert_ports(filterFIB, query, 1, (int[]) { 1 }, "The shorter prefix");
+    assertFalse(fibCaesarFilter_Remove(filterFIB, longPrefix, vectors[2]), "Expected nothing left to remove");
+
+    fibCaesarFilter_Destroy(&filterFIB);
+
+    // The Bloom-filter FIB cannot forget a name
+    filterFIB = fibCaesarFilter_CreateOptimal(8, 64, 0.01);
+    fibCaesarFilter_Insert(filterFIB, shortPrefix, vectors[0]);
+    assertFalse(fibCaesarFilter_Remove(filterFIB, shortPrefix, vectors[0]), "Expected Bloom filters to refuse removal");
+    fibCaesarFilter_Destroy(&filterFIB);
+
+    for (int i = 0; i < 3; i++) {
+        bitmap_Destroy(&vectors[i]);
+    }
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&query);
+}
 
 int
 main(int argc, char *argv[argc])
@@ -4,6 +4,8 @@
 
 #include "../fib_caesar.h"
 
+#include <inttypes.h>
+
 #include <LongBow/testing.h>
 
 #include <parc/algol/parc_Memory.h>
@@ -16,6 +18,7 @@
 LONGBOW_TEST_RUNNER(fibCaesar)
 {
     LONGBOW_RUN_TEST_FIXTURE(Core);
+    LONGBOW_RUN_TEST_FIXTURE(Bulk);
 }
 
 // The Test Runner calls this function once before any Test Fixtures are run.
@@ -35,6 +38,7 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, fibCaesar_Create);
     LONGBOW_RUN_TEST_CASE(Core, fibCaesar_LookupSimple);
     LONGBOW_RUN_TEST_CASE(Core, fibCaesar_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibCaesar_LookupFalsePositive);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -86,6 +90,75 @@ LONGBOW_TEST_CASE(Core, fibCaesar_LookupHashed)
     fib_Destroy(&fib);
 }
 
+LONGBOW_TEST_CASE(Core, fibCaesar_LookupFalsePositive)
+{
+    // A single-bit filter reports every prefix, so every match has to be verified
+    FIBCaesar *caesar = fibCaesar_Create(1, 1, 1);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b/c");
+    Name *query = name_CreateFromCString("ccnx:/a/b/x");
+
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+
+    fibCaesar_Insert(caesar, shortPrefix, vector1);
+    fibCaesar_Insert(caesar, longPrefix, vector2);
+
+    // Lengths 3 and 2 are false positives
+    Bitmap *result = fibCaesar_LPM(caesar, query);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected the /a vector");
+    assertTrue(fibCaesar_GetNumLookups(caesar) == 1, "Expected one lookup");
+    assertTrue(fibCaesar_GetNumFalsePositives(caesar) == 2, "Expected two false positives, got %" PRIu64, fibCaesar_GetNumFalsePositives(caesar));
+    assertTrue(fibCaesar_GetNumFalsePositiveLookups(caesar) == 1, "Expected one lookup with false positives");
+
+    result = fibCaesar_LPM(caesar, longPrefix);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b/c vector");
+    assertTrue(fibCaesar_GetNumFalsePositiveLookups(caesar) == 1, "Expected an exact match to have no false positives");
+
+    fibCaesar_Destroy(&caesar);
+
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&query);
+}
+
+LONGBOW_TEST_FIXTURE(Bulk)
+{
+    LONGBOW_RUN_TEST_CASE(Bulk, fibCaesar_BulkLoad);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Bulk)
+{
+    return test_fib_bulk_setup();
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Bulk)
+{
+    return test_fib_bulk_teardown(testCase);
+}
+
+// An insert also merges the vector into the name's longest prefix already in the table, so a bulk
+// load has to end up where inserting the names shortest first would
+LONGBOW_TEST_CASE(Bulk, fibCaesar_BulkLoad)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBCaesar *caesar = fibCaesar_Create(100, 128, 3);
+        FIB *fib = fib_Create(caesar, CaesarFIBAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+        FIB *sequential = fib_Create(fibCaesar_Create(100, 128, 3), CaesarFIBAsFIB);
+
+        test_fib_bulk_load_as_inserts(fib, sequential, threads);
+
+        fib_Destroy(&sequential);
+        fib_Destroy(&fib);
+    }
+}
+
 int
 main(int argc, char *argv[argc])
 {
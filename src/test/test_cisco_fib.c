@@ -4,6 +4,8 @@
 
 #include "../fib_cisco.h"
 
+#include <inttypes.h>
+
 #include <LongBow/testing.h>
 #include <LongBow/debugging.h>
 
@@ -17,6 +19,7 @@
 LONGBOW_TEST_RUNNER(fibCisco)
 {
     LONGBOW_RUN_TEST_FIXTURE(Core);
+    LONGBOW_RUN_TEST_FIXTURE(Bulk);
 }
 
 // The Test Runner calls this function once before any Test Fixtures are run.
@@ -36,6 +39,12 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, fibCisco_Create);
     LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupSimple);
     LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupFrozen);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupVirtualAncestor);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupLateAncestor);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_OptimalM);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_RebuildHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibCisco_LookupLengthFilter);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -87,6 +96,294 @@ LONGBOW_TEST_CASE(Core, fibCisco_LookupHashed)
     fib_Destroy(&fib);
 }
 
+LONGBOW_TEST_CASE(Core, fibCisco_LookupVirtualAncestor)
+{
+    FIBCisco *cisco = fibCisco_Create(3);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *middlePrefix = name_CreateFromCString("ccnx:/a/b");
+    Name *deepPrefix = name_CreateFromCString("ccnx:/a/b/c/d/e/f");
+    Name *deepMiss = name_CreateFromCString("ccnx:/a/b/c/d/x/y/z");
+    Name *deepHit = name_CreateFromCString("ccnx:/a/b/c/d/e/f/g");
+
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+    Bitmap *vector3 = bitmap_Create(128);
+    bitmap_Set(vector3, 3);
+
+    fibCisco_Insert(cisco, shortPrefix, vector1);
+    fibCisco_Insert(cisco, deepPrefix, vector2);
+
+    // The virtual /a/b/c entry resolves to /a without probing lengths 2 and 1:
+    // one probe at M, then lengths 6, 5 and 4
+    uint64_t probes = fibCisco_GetNumProbes(cisco);
+    Bitmap *result = fibCisco_LPM(cisco, deepMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected the /a vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 4, "Expected 4 probes, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    probes = fibCisco_GetNumProbes(cisco);
+    result = fibCisco_LPM(cisco, deepHit);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b/c/d/e/f vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 2, "Expected 2 probes, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    // A longer ancestor inserted later takes over without costing lookups any probes
+    fibCisco_Insert(cisco, middlePrefix, vector3);
+    probes = fibCisco_GetNumProbes(cisco);
+    result = fibCisco_LPM(cisco, deepMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector3), "Expected the /a/b vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 4, "Expected 4 probes, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    fibCisco_Destroy(&cisco);
+
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    bitmap_Destroy(&vector3);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&middlePrefix);
+    name_Destroy(&deepPrefix);
+    name_Destroy(&deepMiss);
+    name_Destroy(&deepHit);
+}
+
+LONGBOW_TEST_CASE(Core, fibCisco_LookupLateAncestor)
+{
+    FIBCisco *cisco = fibCisco_Create(3);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *middlePrefix = name_CreateFromCString("ccnx:/a/b");
+    Name *deepPrefix = name_CreateFromCString("ccnx:/a/b/c/d");
+    Name *deepMiss = name_CreateFromCString("ccnx:/a/b/c/x/y");
+
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+    Bitmap *vector3 = bitmap_Create(128);
+    bitmap_Set(vector3, 3);
+
+    // The ancestors arrive after the virtual /a/b/c entry, longest first
+    fibCisco_Insert(cisco, deepPrefix, vector3);
+    Bitmap *result = fibCisco_LPM(cisco, deepMiss);
+    assertNull(result, "Expected no match before the ancestors are inserted");
+
+    fibCisco_Insert(cisco, middlePrefix, vector2);
+    fibCisco_Insert(cisco, shortPrefix, vector1);
+
+    uint64_t probes = fibCisco_GetNumProbes(cisco);
+    result = fibCisco_LPM(cisco, deepMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 2, "Expected 2 probes, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    result = fibCisco_LPM(cisco, middlePrefix);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected /a/b to match itself");
+    result = fibCisco_LPM(cisco, shortPrefix);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected /a to match itself");
+
+    fibCisco_Destroy(&cisco);
+
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    bitmap_Destroy(&vector3);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&middlePrefix);
+    name_Destroy(&deepPrefix);
+    name_Destroy(&deepMiss);
+}
+
+LONGBOW_TEST_CASE(Core, fibCisco_OptimalM)
+{
+    FIBCisco *cisco = fibCisco_Create(3);
+
+    Name *prefixes[] = {
+        name_CreateFromCString("ccnx:/a/b"),
+        name_CreateFromCString("ccnx:/c/d"),
+        name_CreateFromCString("ccnx:/e/f"),
+        name_CreateFromCString("ccnx:/g/h/i/j"),
+    };
+    Name *query = name_CreateFromCString("ccnx:/c/d/x/y");
+    Name *deepQuery = name_CreateFromCString("ccnx:/g/h/i/j/k");
+    Bitmap *vectors[4];
+
+    for (int i = 0; i < 4; i++) {
+        vectors[i] = bitmap_Create(128);
+        bitmap_Set(vectors[i], i);
+        fibCisco_Insert(cisco, prefixes[i], vectors[i]);
+    }
+
+    assertTrue(fibCisco_GetPrefixLengthCount(cisco, 2) == 3, "Expected three 2-segment prefixes");
+    assertTrue(fibCisco_GetPrefixLengthCount(cisco, 4) == 1, "Expected one 4-segment prefix");
+
+    // /g/h/i/j takes a virtual entry for each of /g, /g/h and /g/h/i at or above M
+    uint64_t expectedVirtualEntries[] = {4, 2, 3, 0};
+    for (int M = 1; M <= 4; M++) {
+        uint64_t count = fibCisco_CountVirtualEntries(cisco, M);
+        assertTrue(count == expectedVirtualEntries[M - 1], "Expected %" PRIu64 " virtual entries with M = %d, got %" PRIu64,
+            expectedVirtualEntries[M - 1], M, count);
+    }
+
+    // Most prefixes have two segments, so an M of 2 resolves them with a single probe
+    double queries[] = {0, 3, 0, 1};
+    assertTrue(fibCisco_ExpectedProbes(cisco, 2, 4, queries) < fibCisco_ExpectedProbes(cisco, 3, 4, queries),
+        "Expected M = 2 to be cheaper than M = 3");
+    int M = fibCisco_OptimalM(cisco, 4, queries);
+    assertTrue(M == 2, "Expected M = 2, got %d", M);
+
+    // Without a query distribution the prefix lengths are used
+    assertTrue(fibCisco_OptimalM(cisco, 0, NULL) == 2, "Expected M = 2 from the prefix histogram");
+
+    fibCisco_Rebuild(cisco, M);
+    assertTrue(fibCisco_GetM(cisco) == 2, "Expected the rebuilt table to use M = 2");
+    assertTrue(fibCisco_GetPrefixLengthCount(cisco, 2) == 3, "Expected the histogram to survive the rebuild");
+
+    for (int i = 0; i < 4; i++) {
+        Bitmap *result = fibCisco_LPM(cisco, prefixes[i]);
+        assertTrue(result != NULL && bitmap_Equals(result, vectors[i]), "Expected prefix %d to match itself after the rebuild", i);
+    }
+    Bitmap *result = fibCisco_LPM(cisco, query);
+    assertTrue(result != NULL && bitmap_Equals(result, vectors[1]), "Expected the /c/d vector");
+    result = fibCisco_LPM(cisco, deepQuery);
+    assertTrue(result != NULL && bitmap_Equals(result, vectors[3]), "Expected the /g/h/i/j vector");
+
+    fibCisco_Destroy(&cisco);
+
+    for (int i = 0; i < 4; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&prefixes[i]);
+    }
+    name_Destroy(&query);
+    name_Destroy(&deepQuery);
+}
+
+LONGBOW_TEST_CASE(Core, fibCisco_RebuildHashed)
+{
+    SHA256Hasher *nameHasher = sha256hasher_Create();
+    Hasher *hasher = hasher_Create(nameHasher, SHA256HashAsHasher);
+
+    FIBCisco *cisco = fibCisco_Create(3);
+
+    char *uris[] = {"ccnx:/a", "ccnx:/a/b/c/d", "ccnx:/e/f"};
+    Name *prefixes[3];
+    Bitmap *vectors[3];
+    for (int i = 0; i < 3; i++) {
+        Name *name = name_CreateFromCString(uris[i]);
+        prefixes[i] = name_Hash(name, hasher, 8);
+        name_Destroy(&name);
+        vectors[i] = bitmap_Create(128);
+        bitmap_Set(vectors[i], i);
+        fibCisco_Insert(cisco, prefixes[i], vectors[i]);
+    }
+    Name *name = name_CreateFromCString("ccnx:/a/b/c/d/e");
+    Name *query = name_Hash(name, hasher, 8);
+    name_Destroy(&name);
+
+    // The prefixes are read back from the hashed keys
+    for (int M = 1; M <= 4; M++) {
+        fibCisco_Rebuild(cisco, M);
+        for (int i = 0; i < 3; i++) {
+            Bitmap *result = fibCisco_LPM(cisco, prefixes[i]);
+            assertTrue(result != NULL && bitmap_Equals(result, vectors[i]), "Expected prefix %d to match itself with M = %d", i, M);
+        }
+        Bitmap *result = fibCisco_LPM(cisco, query);
+        assertTrue(result != NULL && bitmap_Equals(result, vectors[1]), "Expected the /a/b/c/d vector with M = %d", M);
+    }
+
+    fibCisco_Destroy(&cisco);
+
+    for (int i = 0; i < 3; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&prefixes[i]);
+    }
+    name_Destroy(&query);
+    hasher_Destroy(&hasher);
+}
+
+LONGBOW_TEST_CASE(Core, fibCisco_LookupLengthFilter)
+{
+    FIBCisco *cisco = fibCisco_Create(3);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *deepPrefix = name_CreateFromCString("ccnx:/a/b/c/d/e/f");
+    Name *deepMiss = name_CreateFromCString("ccnx:/a/b/c/d/x/y/z");
+    Name *deepHit = name_CreateFromCString("ccnx:/a/b/c/d/e/f/g");
+
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+
+    // The filter picks up /a, inserted before it was set
+    fibCisco_Insert(cisco, shortPrefix, vector1);
+    fibCisco_SetLengthFilter(cisco, prefixLengthFilter_CreateOptimal(0.0001));
+    fibCisco_Insert(cisco, deepPrefix, vector2);
+
+    // Only /a is a candidate, so neither the M-level entry nor lengths 2 to 6 are probed
+    uint64_t probes = fibCisco_GetNumProbes(cisco);
+    Bitmap *result = fibCisco_LPM(cisco, deepMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected the /a vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 1, "Expected 1 probe, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    // The M-level entry is still needed to reach the 6-segment prefix
+    probes = fibCisco_GetNumProbes(cisco);
+    result = fibCisco_LPM(cisco, deepHit);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b/c/d/e/f vector");
+    assertTrue(fibCisco_GetNumProbes(cisco) - probes == 2, "Expected 2 probes, got %" PRIu64, fibCisco_GetNumProbes(cisco) - probes);
+
+    // The filter survives a rebuild for a different M
+    fibCisco_Rebuild(cisco, 2);
+    result = fibCisco_LPM(cisco, deepHit);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b/c/d/e/f vector after the rebuild");
+
+    fibCisco_Destroy(&cisco);
+
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&deepPrefix);
+    name_Destroy(&deepMiss);
+    name_Destroy(&deepHit);
+}
+
+LONGBOW_TEST_CASE(Core, fibCisco_LookupFrozen)
+{
+    FIBCisco *cisco = fibCisco_Create(2);
+    FIB *fib = fib_Create(cisco, CiscoFIBAsFIB);
+
+    test_fib_freeze(fib, (void (*)(void *instance)) fibCisco_Freeze, cisco);
+    assertTrue(fibCisco_IsFrozen(cisco), "Expected the FIB to be left frozen");
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_FIXTURE(Bulk)
+{
+    LONGBOW_RUN_TEST_CASE(Bulk, fibCisco_BulkLoad);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Bulk)
+{
+    return test_fib_bulk_setup();
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Bulk)
+{
+    return test_fib_bulk_teardown(testCase);
+}
+
+LONGBOW_TEST_CASE(Bulk, fibCisco_BulkLoad)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBCisco *cisco = fibCisco_Create(2);
+        FIB *fib = fib_Create(cisco, CiscoFIBAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+    }
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -0,0 +1,165 @@
+#include "../component_dictionary.h"
+#include "../parallel.h"
+
+#include <stdio.h>
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(componentDictionary)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(componentDictionary)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(componentDictionary)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, componentDictionary_Create);
+    LONGBOW_RUN_TEST_CASE(Core, componentDictionary_Intern);
+    LONGBOW_RUN_TEST_CASE(Core, componentDictionary_Growth);
+    LONGBOW_RUN_TEST_CASE(Core, componentDictionary_Concurrent);
+    LONGBOW_RUN_TEST_CASE(Core, componentDictionary_Shared);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_CASE(Core, componentDictionary_Create)
+{
+    ComponentDictionary *dictionary = componentDictionary_Create();
+    assertNotNull(dictionary, "Expected a non-NULL dictionary to be created");
+    assertTrue(componentDictionary_GetCount(dictionary) == 0, "Expected an empty dictionary");
+    componentDictionary_Destroy(&dictionary);
+    assertNull(dictionary, "Expected a NULL dictionary after componentDictionary_Destroy");
+}
+
+LONGBOW_TEST_CASE(Core, componentDictionary_Intern)
+{
+    ComponentDictionary *dictionary = componentDictionary_Create();
+    const uint8_t com[] = "com";
+    const uint8_t edu[] = "edu";
+    const uint8_t prefix[] = "co";
+
+    assertTrue(componentDictionary_Find(dictionary, 3, com) == ComponentDictionaryNoID, "Expected no ID before interning");
+
+    uint32_t comID = componentDictionary_Intern(dictionary, 3, com);
+    uint32_t eduID = componentDictionary_Intern(dictionary, 3, edu);
+    assertTrue(comID != ComponentDictionaryNoID && eduID != ComponentDictionaryNoID, "Expected interned components to get IDs");
+    assertTrue(comID != eduID, "Expected distinct components to get distinct IDs");
+    assertTrue(componentDictionary_Intern(dictionary, 3, com) == comID, "Expected interning again to return the same ID");
+    assertTrue(componentDictionary_Find(dictionary, 3, edu) == eduID, "Expected to find the interned ID");
+    assertTrue(componentDictionary_Find(dictionary, 2, prefix) == ComponentDictionaryNoID, "Expected a prefix of a component to be unknown");
+    assertTrue(componentDictionary_GetCount(dictionary) == 2, "Expected 2 components, got %zu", componentDictionary_GetCount(dictionary));
+
+    size_t length = 0;
+    const uint8_t *bytes = componentDictionary_GetComponent(dictionary, comID, &length);
+    assertTrue(length == 3 && memcmp(bytes, com, 3) == 0, "Expected the bytes interned under the ID");
+
+    componentDictionary_Destroy(&dictionary);
+}
+
+LONGBOW_TEST_CASE(Core, componentDictionary_Growth)
+{
+    // Enough components to grow the slot table and span several entry chunks
+    ComponentDictionary *dictionary = componentDictionary_Create();
+    char component[32];
+    const int count = 20000;
+
+    for (int i = 0; i < count; i++) {
+        int length = snprintf(component, sizeof(component), "component-%d", i);
+        uint32_t id = componentDictionary_Intern(dictionary, length, (uint8_t *) component);
+        assertTrue(id == (uint32_t) i + 1, "Expected dense IDs, got %u for component %d", id, i);
+    }
+    assertTrue(componentDictionary_GetCount(dictionary) == count, "Expected %d components, got %zu", count, componentDictionary_GetCount(dictionary));
+
+    for (int i = 0; i < count; i++) {
+        int length = snprintf(component, sizeof(component), "component-%d", i);
+        assertTrue(componentDictionary_Find(dictionary, length, (uint8_t *) component) == (uint32_t) i + 1, "Expected component %d to keep its ID", i);
+
+        size_t storedLength = 0;
+        const uint8_t *bytes = componentDictionary_GetComponent(dictionary, (uint32_t) i + 1, &storedLength);
+        assertTrue(storedLength == length && memcmp(bytes, component, length) == 0, "Expected the bytes of component %d", i);
+    }
+
+    componentDictionary_Destroy(&dictionary);
+}
+
+typedef struct {
+    ComponentDictionary *dictionary;
+    int numComponents;
+    uint32_t *ids;
+} _ConcurrentContext;
+
+static void
+_internComponent(void *context, size_t index)
+{
+    // Every component is interned by several indices, which race on it
+    _ConcurrentContext *concurrent = (_ConcurrentContext *) context;
+    char component[32];
+    int which = (int) (index % concurrent->numComponents);
+    int length = snprintf(component, sizeof(component), "site-%d", which);
+    concurrent->ids[index] = componentDictionary_Intern(concurrent->dictionary, length, (uint8_t *) component);
+}
+
+LONGBOW_TEST_CASE(Core, componentDictionary_Concurrent)
+{
+    _ConcurrentContext context = { .dictionary = componentDictionary_Create(), .numComponents = 5000 };
+    size_t count = 4 * context.numComponents;
+    context.ids = (uint32_t *) malloc(count * sizeof(uint32_t));
+
+    parallel_For(4, count, _internComponent, &context);
+
+    assertTrue(componentDictionary_GetCount(context.dictionary) == context.numComponents,
+               "Expected %d components, got %zu", context.numComponents, componentDictionary_GetCount(context.dictionary));
+    for (size_t i = 0; i < count; i++) {
+        assertTrue(context.ids[i] != ComponentDictionaryNoID, "Expected an ID for index %zu", i);
+        assertTrue(context.ids[i] == context.ids[i % context.numComponents], "Expected one ID per component at index %zu", i);
+    }
+
+    free(context.ids);
+    componentDictionary_Destroy(&context.dictionary);
+}
+
+LONGBOW_TEST_CASE(Core, componentDictionary_Shared)
+{
+    ComponentDictionary *shared = componentDictionary_GetShared();
+    assertNotNull(shared, "Expected a shared dictionary");
+    assertTrue(componentDictionary_GetShared() == shared, "Expected one shared dictionary");
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(componentDictionary);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
@@ -0,0 +1,355 @@
+#include "../cuckoo_filter.h"
+#include "../bloom.h"
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(cuckooFilter)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(cuckooFilter)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(cuckooFilter)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_Create);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_AddTest);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_AddHashedTest);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_Remove);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_SaltedMatchesBloom);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_Payload);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_Growth);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_RepeatedAdds);
+    LONGBOW_RUN_TEST_CASE(Core, cuckooFilter_FalsePositiveRate);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+static PARCBuffer *
+_createKey(const char *prefix, int i)
+{
+    char key[64];
+    sprintf(key, "%s-%d", prefix, i);
+    return parcBuffer_AllocateCString(key);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_Create)
+{
+    CuckooFilter *filter = cuckooFilter_Create(1000, false);
+    assertNotNull(filter, "Expected a non-NULL cuckoo filter to be created");
+    assertTrue(cuckooFilter_GetCount(filter) == 0, "Expected an empty filter");
+
+    // 1000 entries at 95% load need 264 buckets of four 2-byte slots
+    assertTrue(cuckooFilter_GetSizeInBytes(filter) == 264 * 8, "Expected 2112 bytes, got %zu", cuckooFilter_GetSizeInBytes(filter));
+
+    cuckooFilter_Destroy(&filter);
+    assertNull(filter, "Expected a NULL cuckoo filter after cuckooFilter_Destroy");
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_AddTest)
+{
+    CuckooFilter *filter = cuckooFilter_Create(128, false);
+
+    PARCBuffer *x = parcBuffer_AllocateCString("foo");
+    PARCBuffer *y = parcBuffer_AllocateCString("bar");
+    PARCBuffer *z = parcBuffer_AllocateCString("baz");
+
+    cuckooFilter_Add(filter, x);
+    assertTrue(cuckooFilter_Test(filter, x), "Item x not detected in the filter");
+
+    cuckooFilter_Add(filter, y);
+    assertTrue(cuckooFilter_Test(filter, y), "Item y not detected in the filter");
+
+    assertFalse(cuckooFilter_Test(filter, z), "Item z detected in the filter when really it should not have been");
+    assertTrue(cuckooFilter_GetCount(filter) == 2, "Expected 2 entries, got %zu", cuckooFilter_GetCount(filter));
+
+    parcBuffer_Release(&x);
+    parcBuffer_Release(&y);
+    parcBuffer_Release(&z);
+
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_AddHashedTest)
+{
+    CuckooFilter *filter = cuckooFilter_Create(128, false);
+
+    PARCBuffer *x = parcBuffer_AllocateCString("foo");
+    PARCBuffer *x2 = parcBuffer_AllocateCString("oof");
+
+    cuckooFilter_AddHashed(filter, x);
+    assertTrue(cuckooFilter_TestHashed(filter, x), "Item x not detected in the filter");
+    assertFalse(cuckooFilter_TestHashed(filter, x2), "Item x2 detected in the filter when it should not have collided with x");
+
+    assertTrue(cuckooFilter_RemoveHashed(filter, x), "Expected item x to be removed");
+    assertFalse(cuckooFilter_TestHashed(filter, x), "Item x detected after its removal");
+
+    parcBuffer_Release(&x);
+    parcBuffer_Release(&x2);
+
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_Remove)
+{
+    const int numEntries = 2000;
+    CuckooFilter *filter = cuckooFilter_Create(numEntries, false);
+
+    for (int i = 0; i < numEntries; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        cuckooFilter_Add(filter, key);
+        parcBuffer_Release(&key);
+    }
+
+    // Remove the even keys; the odd ones must survive the evictions that placed them
+    for (int i = 0; i < numEntries; i += 2) {
+        PARCBuffer *key = _createKey("key", i);
+        assertTrue(cuckooFilter_Remove(filter, key), "Expected key %d to be removed", i);
+        parcBuffer_Release(&key);
+    }
+    assertTrue(cuckooFilter_GetCount(filter) == numEntries / 2, "Expected %d entries, got %zu", numEntries / 2, cuckooFilter_GetCount(filter));
+
+    int numPresent = 0;
+    for (int i = 0; i < numEntries; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        bool isPresent = cuckooFilter_Test(filter, key);
+        if (i % 2 == 1) {
+            assertTrue(isPresent, "Key %d not detected after the removals", i);
+        } else if (isPresent) {
+            numPresent++;
+        }
+        parcBuffer_Release(&key);
+    }
+    assertTrue(numPresent <= 2, "Expected the removed keys to be gone, but %d were detected", numPresent);
+
+    // A value added twice is counted twice
+    PARCBuffer *key = _createKey("twice", 0);
+    cuckooFilter_Add(filter, key);
+    cuckooFilter_Add(filter, key);
+    assertTrue(cuckooFilter_Remove(filter, key), "Expected the first copy to be removed");
+    assertTrue(cuckooFilter_Test(filter, key), "Expected the second copy to remain");
+    assertTrue(cuckooFilter_Remove(filter, key), "Expected the second copy to be removed");
+    assertFalse(cuckooFilter_Remove(filter, key), "Expected nothing left to remove");
+    parcBuffer_Release(&key);
+
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_SaltedMatchesBloom)
+{
+    SipHasher *hasher = bloom_CreateHasher();
+    CuckooFilter *filter = cuckooFilter_CreateWithHasher(64, false, hasher);
+    BloomFilter *bf = bloom_CreateWithHasher(1024, 3, hasher);
+
+    PARCBuffer *x = parcBuffer_AllocateCString("foo");
+
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    uint64_t b1 = 0;
+    uint64_t b2 = 0;
+    cuckooFilter_HashSalted(filter, 1, x, &h1, &h2);
+    bloom_HashSalted(bf, 1, x, &b1, &b2);
+    assertTrue(h1 == b1 && h2 == b2, "Expected the salted pairs of both filters to match");
+
+    cuckooFilter_AddHashPair(filter, h1, h2);
+    assertTrue(cuckooFilter_TestHashPair(filter, h1, h2), "Item x not detected with its salt");
+
+    cuckooFilter_HashSalted(filter, 2, x, &h1, &h2);
+    assertFalse(cuckooFilter_TestHashPair(filter, h1, h2), "Item x detected with a different salt");
+
+    parcBuffer_Release(&x);
+
+    cuckooFilter_Destroy(&filter);
+    bloom_Destroy(&bf);
+    siphasher_Destroy(&hasher);
+}
+
+typedef struct {
+    int count;
+    uint16_t payloads[16];
+} _PayloadList;
+
+static void
+_collectPayload(void *context, uint16_t payload)
+{
+    _PayloadList *list = (_PayloadList *) context;
+    list->payloads[list->count++] = payload;
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_Payload)
+{
+    CuckooFilter *filter = cuckooFilter_Create(1000, true);
+
+    for (int i = 0; i < 1000; i++) {
+        PARCBuffer *key = _createKey("prefix", i);
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+        cuckooFilter_HashSalted(filter, 0, key, &h1, &h2);
+        cuckooFilter_AddHashPairWithPayload(filter, h1, h2, (uint16_t) (i % 64));
+        if (i % 10 == 0) {
+            cuckooFilter_AddHashPairWithPayload(filter, h1, h2, 100);
+        }
+        parcBuffer_Release(&key);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        PARCBuffer *key = _createKey("prefix", i);
+        uint64_t h1 = 0;
+        uint64_t h2 = 0;
+        cuckooFilter_HashSalted(filter, 0, key, &h1, &h2);
+        parcBuffer_Release(&key);
+
+        _PayloadList list = { .count = 0 };
+        int count = cuckooFilter_ForEachPayload(filter, h1, h2, _collectPayload, &list);
+        assertTrue(count == list.count, "Expected every payload to be visited");
+
+        bool hasPort = false;
+        bool hasExtra = false;
+        for (int p = 0; p < list.count; p++) {
+            hasPort = hasPort || list.payloads[p] == i % 64;
+            hasExtra = hasExtra || list.payloads[p] == 100;
+        }
+        assertTrue(hasPort, "Expected prefix %d to carry payload %d", i, i % 64);
+        assertTrue(hasExtra == (i % 10 == 0), "Expected prefix %d to carry payload 100 only if it was added", i);
+
+        if (i % 10 == 0) {
+            assertTrue(cuckooFilter_RemoveHashPairWithPayload(filter, h1, h2, 100), "Expected payload 100 of prefix %d to be removed", i);
+            list.count = 0;
+            cuckooFilter_ForEachPayload(filter, h1, h2, _collectPayload, &list);
+            for (int p = 0; p < list.count; p++) {
+                assertTrue(list.payloads[p] != 100, "Expected payload 100 of prefix %d to be gone", i);
+            }
+        }
+    }
+
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_Growth)
+{
+    int capacity = 64;
+    int numEntries = 16 * capacity;
+    CuckooFilter *filter = cuckooFilter_Create(capacity, false);
+    size_t initialSize = cuckooFilter_GetSizeInBytes(filter);
+
+    for (int i = 0; i < numEntries; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        cuckooFilter_Add(filter, key);
+        parcBuffer_Release(&key);
+    }
+
+    assertTrue(cuckooFilter_GetSizeInBytes(filter) > initialSize, "Expected the filter to grow past its initial capacity");
+    assertTrue(cuckooFilter_GetCount(filter) == numEntries, "Expected %d entries, got %zu", numEntries, cuckooFilter_GetCount(filter));
+    assertTrue(cuckooFilter_LoadFactor(filter) <= CuckooFilterMaxLoadFactor, "Expected the load to stay bounded, got %f",
+               cuckooFilter_LoadFactor(filter));
+
+    for (int i = 0; i < numEntries; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        assertTrue(cuckooFilter_Test(filter, key), "Key %d not detected in the grown filter", i);
+        parcBuffer_Release(&key);
+    }
+
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_RepeatedAdds)
+{
+    CuckooFilter *filter = cuckooFilter_Create(1000, false);
+    size_t initialSize = cuckooFilter_GetSizeInBytes(filter);
+
+    // Copies of one value stop at CuckooFilterMaxCopies instead of growing the filter
+    uint64_t h1 = 0x0123456789ABCDEFULL;
+    uint64_t h2 = 0xFEDCBA9876543211ULL;
+    for (int i = 0; i < 160; i++) {
+        cuckooFilter_AddHashPair(filter, h1, h2);
+    }
+    assertTrue(cuckooFilter_GetSizeInBytes(filter) == initialSize, "Expected repeated adds not to grow the filter");
+    assertTrue(cuckooFilter_GetCount(filter) == (size_t) CuckooFilterMaxCopies,
+               "Expected %d copies, got %zu", CuckooFilterMaxCopies, cuckooFilter_GetCount(filter));
+    for (int i = 0; i < CuckooFilterMaxCopies; i++) {
+        assertTrue(cuckooFilter_RemoveHashPair(filter, h1, h2), "Expected copy %d to be removed", i);
+    }
+    assertFalse(cuckooFilter_TestHashPair(filter, h1, h2), "Expected every copy to be gone");
+    cuckooFilter_Destroy(&filter);
+
+    // Copies are counted per payload
+    filter = cuckooFilter_Create(1000, true);
+    for (int i = 0; i < 160; i++) {
+        cuckooFilter_AddHashPairWithPayload(filter, h1, h2, (uint16_t) (i % 2));
+    }
+    assertTrue(cuckooFilter_GetSizeInBytes(filter) == 2 * initialSize, "Expected repeated adds not to grow the filter");
+    assertTrue(cuckooFilter_GetCount(filter) == (size_t) CuckooFilterMaxCopies,
+               "Expected %d copies, got %zu", CuckooFilterMaxCopies, cuckooFilter_GetCount(filter));
+    assertTrue(cuckooFilter_RemoveHashPairWithPayload(filter, h1, h2, 1), "Expected a copy with payload 1");
+    cuckooFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, cuckooFilter_FalsePositiveRate)
+{
+    int capacity = 10000;
+    int numProbes = 200000;
+    CuckooFilter *filter = cuckooFilter_Create(capacity, false);
+
+    for (int i = 0; i < capacity; i++) {
+        PARCBuffer *key = _createKey("member", i);
+        cuckooFilter_Add(filter, key);
+        parcBuffer_Release(&key);
+    }
+
+    int falsePositives = 0;
+    for (int i = 0; i < numProbes; i++) {
+        PARCBuffer *key = _createKey("probe", i);
+        if (cuckooFilter_Test(filter, key)) {
+            falsePositives++;
+        }
+        parcBuffer_Release(&key);
+    }
+
+    // Each lookup compares at most 8 slots with a 16-bit fingerprint: p <= 8 / 2^16
+    double fpr = (double) falsePositives / numProbes;
+    double bitsPerEntry = 8.0 * cuckooFilter_GetSizeInBytes(filter) / capacity;
+    printf("fpr,expected,bits per entry\n%f,%f,%f\n", fpr, 8.0 / 65536, bitsPerEntry);
+
+    assertTrue(fpr <= 2 * 8.0 / 65536, "FPR %f is far above the expected %f", fpr, 8.0 / 65536);
+    assertTrue(bitsPerEntry < 18.0, "Expected under 18 bits per entry, got %f", bitsPerEntry);
+
+    cuckooFilter_Destroy(&filter);
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(cuckooFilter);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
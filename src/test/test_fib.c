@@ -5,6 +5,10 @@
 #include <LongBow/testing.h>
 #include <LongBow/debugging.h>
 
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_StdlibMemory.h>
+#include <parc/testing/parc_MemoryTesting.h>
+
 #include "../sha256hasher.h"
 
 void test_fib_lookup(FIB *fib)
@@ -118,3 +122,226 @@ void test_fib_hash_lookup(FIB *fib)
 
     hasher_Destroy(&hasher);
 }
+
+// The vector a lookup of query should return: the OR of the vectors of the longest loaded names
+// that are a prefix of it, or NULL
+static Bitmap *
+_test_fib_ExpectedLPM(const Name *query, int numNames, Name *names[numNames], Bitmap *vectors[numNames])
+{
+    for (int length = name_GetSegmentCount(query); length > 0; length--) {
+        PARCBuffer *prefix = name_GetWireFormat(query, length);
+        Bitmap *expected = NULL;
+        for (int i = 0; i < numNames; i++) {
+            if (name_GetSegmentCount(names[i]) != length) {
+                continue;
+            }
+            PARCBuffer *candidate = name_GetWireFormat(names[i], length);
+            if (parcBuffer_Equals(prefix, candidate)) {
+                if (expected == NULL) {
+                    expected = bitmap_Create(bitmap_GetSize(vectors[i]));
+                }
+                bitmap_SetVector(expected, vectors[i]);
+            }
+            parcBuffer_Release(&candidate);
+        }
+        parcBuffer_Release(&prefix);
+
+        if (expected != NULL) {
+            return expected;
+        }
+    }
+    return NULL;
+}
+
+// Bulk loads allocate from several threads at once, so each FIB's Bulk fixture sets up and tears
+// down with these, which run its test cases on the thread-safe stdlib allocator
+LongBowStatus test_fib_bulk_setup(void)
+{
+    parcMemory_SetInterface(&PARCStdlibMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LongBowStatus test_fib_bulk_teardown(const LongBowTestCase *testCase)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The i-th of the overlapping names the bulk loads take: every run of six names is one chain of
+// nested prefixes, and chains share their heads, so there are repeats too
+static Name *
+_test_fib_CreateBulkName(int i)
+{
+    char uri[128] = "ccnx:";
+    int numSegments = 1 + i % 6;
+    for (int j = 0; j < numSegments; j++) {
+        sprintf(uri + strlen(uri), "/c%d", (i / 6 / (j + 1)) % 3);
+    }
+    return name_CreateFromCString(uri);
+}
+
+// The i-th query after a bulk load of numNames names: the names themselves, then longer names
+// and names under a prefix that was never loaded
+static Name *
+_test_fib_CreateBulkQuery(int numNames, Name *names[numNames], int i)
+{
+    if (i < numNames) {
+        return name_Copy(names[i]);
+    }
+
+    char uri[128];
+    sprintf(uri, i % 2 == 0 ? "ccnx:/c%d/c%d/c%d/c%d/c%d/c%d/x" : "ccnx:/x/c%d/c%d/c%d/c%d/c%d/c%d",
+        i % 4, (i / 2) % 4, (i / 3) % 4, (i / 4) % 4, (i / 5) % 4, (i / 6) % 4);
+    return name_CreateFromCString(uri);
+}
+
+// Bulk-load overlapping names (with repeats) and check every lookup against a linear scan
+void test_fib_bulk_load(FIB *fib, int threads)
+{
+    const int numNames = 300;
+    Name *names[numNames];
+    Bitmap *vectors[numNames];
+    Bitmap *loadedVectors[numNames];
+
+    for (int i = 0; i < numNames; i++) {
+        names[i] = _test_fib_CreateBulkName(i);
+        vectors[i] = bitmap_Create(numNames);
+        bitmap_Set(vectors[i], i);
+
+        // Repeated names are merged into the first one's vector, so keep a pristine copy
+        loadedVectors[i] = bitmap_Create(numNames);
+        bitmap_Set(loadedVectors[i], i);
+    }
+
+    assertTrue(fib_BulkLoad(fib, names, loadedVectors, numNames, threads), "Expected the bulk load to succeed");
+
+    for (int i = 0; i < 2 * numNames; i++) {
+        Name *query = _test_fib_CreateBulkQuery(numNames, names, i);
+        Bitmap *expected = _test_fib_ExpectedLPM(query, numNames, names, vectors);
+        Bitmap *result = fib_LPM(fib, query);
+        if (expected == NULL) {
+            assertNull(result, "Expected query %d to miss", i);
+        } else {
+            assertNotNull(result, "Expected query %d to match", i);
+            assertTrue(bitmap_Equals(result, expected), "Expected query %d to return the merged longest match", i);
+            bitmap_Destroy(&expected);
+        }
+        name_Destroy(&query);
+    }
+
+    // The FIB never frees the vectors it returns, so they can go before it is destroyed
+    for (int i = 0; i < numNames; i++) {
+        bitmap_Destroy(&vectors[i]);
+        bitmap_Destroy(&loadedVectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
+
+// Bulk-load the overlapping names into fib, insert them one at a time into sequential, shortest
+// first and otherwise in order, and check that every lookup agrees. For FIBs whose inserts
+// change the vectors already loaded, e.g., by merging into the longest prefix.
+void test_fib_bulk_load_as_inserts(FIB *fib, FIB *sequential, int threads)
+{
+    const int numNames = 300;
+    Name *names[numNames];
+    Bitmap *loadedVectors[numNames];
+    Bitmap *insertedVectors[numNames];
+
+    for (int i = 0; i < numNames; i++) {
+        names[i] = _test_fib_CreateBulkName(i);
+        loadedVectors[i] = bitmap_Create(numNames);
+        bitmap_Set(loadedVectors[i], i);
+        insertedVectors[i] = bitmap_Create(numNames);
+        bitmap_Set(insertedVectors[i], i);
+    }
+
+    assertTrue(fib_BulkLoad(fib, names, loadedVectors, numNames, threads), "Expected the bulk load to succeed");
+    for (int length = 1; length <= 6; length++) {
+        for (int i = 0; i < numNames; i++) {
+            if (name_GetSegmentCount(names[i]) == length) {
+                fib_Insert(sequential, names[i], insertedVectors[i]);
+            }
+        }
+    }
+
+    for (int i = 0; i < 2 * numNames; i++) {
+        Name *query = _test_fib_CreateBulkQuery(numNames, names, i);
+        Bitmap *expected = fib_LPM(sequential, query);
+        Bitmap *result = fib_LPM(fib, query);
+        if (expected == NULL) {
+            assertNull(result, "Expected query %d to miss", i);
+        } else {
+            assertNotNull(result, "Expected query %d to match", i);
+            assertTrue(bitmap_Equals(result, expected), "Expected query %d to return the vector the inserts left", i);
+        }
+        name_Destroy(&query);
+    }
+
+    for (int i = 0; i < numNames; i++) {
+        bitmap_Destroy(&loadedVectors[i]);
+        bitmap_Destroy(&insertedVectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
+
+// Freezing must not change any lookup, and an insert after freezing must still be found
+void test_fib_freeze(FIB *fib, void (*freeze)(void *instance), void *instance)
+{
+    const int numNames = 120;
+    Name *names[numNames];
+    Bitmap *vectors[numNames];
+    for (int i = 0; i < numNames; i++) {
+        char uri[128] = "ccnx:";
+        int numSegments = 1 + i % 6;
+        for (int j = 0; j < numSegments; j++) {
+            sprintf(uri + strlen(uri), "/c%d", (i / 6 / (j + 1)) % 3);
+        }
+        names[i] = name_CreateFromCString(uri);
+        vectors[i] = bitmap_Create(numNames);
+        bitmap_Set(vectors[i], i);
+        fib_Insert(fib, names[i], vectors[i]);
+    }
+
+    Name *queries[2 * numNames];
+    Bitmap *expected[2 * numNames];
+    for (int i = 0; i < 2 * numNames; i++) {
+        if (i < numNames) {
+            queries[i] = name_Copy(names[i]);
+        } else {
+            char uri[128];
+            sprintf(uri, i % 2 == 0 ? "ccnx:/c%d/c%d/c%d/c%d/c%d/c%d/x" : "ccnx:/x/c%d/c%d",
+                i % 3, (i / 2) % 3, (i / 3) % 3, (i / 4) % 3, (i / 5) % 3, (i / 6) % 3);
+            queries[i] = name_CreateFromCString(uri);
+        }
+        expected[i] = fib_LPM(fib, queries[i]);
+    }
+
+    freeze(instance);
+    for (int i = 0; i < 2 * numNames; i++) {
+        assertTrue(fib_LPM(fib, queries[i]) == expected[i], "Expected query %d to be unchanged by freezing", i);
+    }
+
+    Name *added = name_CreateFromCString("ccnx:/c0/c0/added");
+    Bitmap *addedVector = bitmap_Create(numNames);
+    fib_Insert(fib, added, addedVector);
+    assertTrue(fib_LPM(fib, added) == addedVector, "Expected a name inserted after freezing to be found");
+
+    freeze(instance);
+    assertTrue(fib_LPM(fib, added) == addedVector, "Expected the refrozen FIB to find the inserted name");
+    for (int i = 0; i < numNames; i++) {
+        assertTrue(fib_LPM(fib, queries[i]) == expected[i], "Expected query %d to be unchanged by refreezing", i);
+    }
+
+    bitmap_Destroy(&addedVector);
+    name_Destroy(&added);
+    for (int i = 0; i < 2 * numNames; i++) {
+        name_Destroy(&queries[i]);
+    }
+    for (int i = 0; i < numNames; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
@@ -0,0 +1,324 @@
+#include "../hasher.h"
+#include "../siphasher.h"
+#include "../sha256hasher.h"
+#include "../xxhasher.h"
+#include "../wyhasher.h"
+#include "../crc32chasher.h"
+#include "../siphash24.h"
+#include "../name.h"
+
+#include <inttypes.h>
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(hasher)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(hasher)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(hasher)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, hasher_SipHashVectors);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_XXHashVectors);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_WYHashVectors);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_CRC32CVectors);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_CreateNamed);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_NameHashShortDigest);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_SipHashMany);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_HashMany);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_SHA256Vectors);
+    LONGBOW_RUN_TEST_CASE(Core, hasher_SHA256Implementations);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_CASE(Core, hasher_SipHashVectors)
+{
+    // The reference vector for a 15-byte message under the key 00 01 .. 0f
+    PARCBuffer *key = parcBuffer_Allocate(SIPHASH_KEY_LENGTH);
+    uint8_t message[15];
+    for (int i = 0; i < SIPHASH_KEY_LENGTH; i++) {
+        parcBuffer_PutUint8(key, i);
+    }
+    parcBuffer_Flip(key);
+    for (int i = 0; i < sizeof(message); i++) {
+        message[i] = i;
+    }
+
+    SipHasher *full = siphasher_Create(key);
+    SipHasher *reduced = siphasher_CreateReduced(key);
+
+    // siphasher digests are the little-endian output bytes
+    uint8_t expected[] = { 0xe5, 0x45, 0xbe, 0x49, 0x61, 0xca, 0x29, 0xa1 };
+    PARCBuffer *digest = siphasher_HashArray(full, sizeof(message), message);
+    assertTrue(memcmp(parcBuffer_Overlay(digest, 0), expected, sizeof(expected)) == 0, "Expected the SipHash-2-4 reference digest");
+    parcBuffer_Release(&digest);
+
+    digest = siphasher_HashArray(reduced, sizeof(message), message);
+    assertTrue(memcmp(parcBuffer_Overlay(digest, 0), expected, sizeof(expected)) != 0, "Expected SipHash-1-3 to differ from SipHash-2-4");
+    parcBuffer_Release(&digest);
+
+    siphasher_Destroy(&full);
+    siphasher_Destroy(&reduced);
+    parcBuffer_Release(&key);
+}
+
+LONGBOW_TEST_CASE(Core, hasher_XXHashVectors)
+{
+    XXHasher *hasher = xxhasher_Create(0);
+
+    assertTrue(xxhasher_Hash64(hasher, 0, (const uint8_t *) "") == 0xef46db3751d8e999ULL, "Expected the XXH64 digest of the empty string");
+    assertTrue(xxhasher_Hash64(hasher, 3, (const uint8_t *) "abc") == 0x44bc2cf5ad770999ULL, "Expected the XXH64 digest of abc");
+    const char *longer = "Nobody inspects the spammish repetition";
+    assertTrue(xxhasher_Hash64(hasher, strlen(longer), (const uint8_t *) longer) == 0xfbcea83c8a378bf1ULL,
+        "Expected the XXH64 digest of a 39-byte string");
+
+    xxhasher_Destroy(&hasher);
+}
+
+LONGBOW_TEST_CASE(Core, hasher_WYHashVectors)
+{
+    // The reference vectors hash the i-th message with seed i
+    const char *messages[] = { "", "a", "abc", "message digest" };
+    uint64_t expected[] = { 0x0409638ee2bde459ULL, 0xa8412d091b5fe0a9ULL, 0x32dd92e4b2915153ULL, 0x8619124089a3a16bULL };
+
+    for (int i = 0; i < 4; i++) {
+        WYHasher *hasher = wyhasher_Create(i);
+        uint64_t hash = wyhasher_Hash64(hasher, strlen(messages[i]), (const uint8_t *) messages[i]);
+        assertTrue(hash == expected[i], "Expected %016" PRIx64 ", got %016" PRIx64, expected[i], hash);
+        wyhasher_Destroy(&hasher);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, hasher_CRC32CVectors)
+{
+    CRC32CHasher *hasher = crc32chasher_Create(0);
+    assertTrue(crc32chasher_Hash32(hasher, 9, (const uint8_t *) "123456789") == 0xe3069283, "Expected the CRC32C check value");
+    crc32chasher_Destroy(&hasher);
+}
+
+LONGBOW_TEST_CASE(Core, hasher_CreateNamed)
+{
+    uint8_t input[] = "ccnx:/foo/bar";
+    for (int i = 0; HasherNames[i] != NULL; i++) {
+        Hasher *hasher = hasher_CreateNamed(HasherNames[i]);
+        assertNotNull(hasher, "Expected a %s hasher", HasherNames[i]);
+        assertTrue(hasher_GetDigestLength(hasher) >= 4, "Expected at least a 32-bit %s digest", HasherNames[i]);
+
+        Bitmap *vector = hasher_HashArrayToVector(hasher, sizeof(input), input, 64);
+        assertTrue(bitmap_Count(vector) >= 1, "Expected a %s index to be set", HasherNames[i]);
+        bitmap_Destroy(&vector);
+
+        hasher_Destroy(&hasher);
+    }
+
+    assertNull(hasher_CreateNamed("md5"), "Expected unknown hash names to be rejected");
+}
+
+LONGBOW_TEST_CASE(Core, hasher_NameHashShortDigest)
+{
+    Hasher *hasher = hasher_CreateNamed("crc32c");
+    Name *name = name_CreateFromCString("ccnx:/foo/bar");
+    Name *other = name_CreateFromCString("ccnx:/foo/baz");
+
+    // 32-bit digests are zero-padded to the requested segment size
+    Name *hashed = name_Hash(name, hasher, 8);
+    Name *otherHashed = name_Hash(other, hasher, 8);
+    assertTrue(name_GetSegmentCount(hashed) == 2, "Expected two hashed segments");
+    assertTrue(name_GetSegmentLength(hashed, 1) == 8, "Expected 8-byte segments");
+
+    uint8_t *segment = name_GetSegmentOffset(hashed, 1);
+    assertTrue(segment[4] == 0 && segment[7] == 0, "Expected the digest to be zero-padded");
+    assertTrue(memcmp(name_GetSegmentOffset(hashed, 0), name_GetSegmentOffset(otherHashed, 0), 8) == 0,
+        "Expected equal prefixes to hash alike");
+    assertTrue(memcmp(segment, name_GetSegmentOffset(otherHashed, 1), 8) != 0, "Expected different prefixes to differ");
+
+    name_Destroy(&hashed);
+    name_Destroy(&otherHashed);
+    name_Destroy(&name);
+    name_Destroy(&other);
+    hasher_Destroy(&hasher);
+}
+
+LONGBOW_TEST_CASE(Core, hasher_SipHashMany)
+{
+    uint8_t data[256];
+    uint8_t keys[5][SIPHASH_KEY_LENGTH];
+    srand(42);
+    for (int i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < SIPHASH_KEY_LENGTH; j++) {
+            keys[i][j] = rand();
+        }
+    }
+
+    // Counts that are not a multiple of any lane width, mixed lengths and keys, every lane width
+    for (int count = 1; count <= 19; count += 3) {
+        uint8_t digests[19][SIPHASH_HASH_LENGTH];
+        uint8_t *outputs[19];
+        const uint8_t *inputs[19];
+        uint64_t lengths[19];
+        const uint8_t *inputKeys[19];
+        for (int i = 0; i < count; i++) {
+            outputs[i] = digests[i];
+            inputs[i] = data + rand() % 64;
+            lengths[i] = rand() % 101;
+            inputKeys[i] = keys[rand() % 5];
+        }
+
+        for (int lanes = 1; lanes <= 8; lanes *= 2) {
+            for (int reduced = 0; reduced < 2; reduced++) {
+                int cRounds = reduced ? 1 : 2;
+                int dRounds = reduced ? 3 : 4;
+                siphash_many_lanes(lanes, cRounds, dRounds, count, outputs, inputs, lengths, inputKeys);
+                for (int i = 0; i < count; i++) {
+                    uint8_t expected[SIPHASH_HASH_LENGTH];
+                    siphash_rounds(expected, inputs[i], lengths[i], inputKeys[i], cRounds, dRounds);
+                    assertTrue(memcmp(expected, digests[i], SIPHASH_HASH_LENGTH) == 0,
+                        "Expected lane %d of %d (%d-wide, length %" PRIu64 ") to match the scalar digest",
+                        i, count, lanes, lengths[i]);
+                }
+            }
+        }
+    }
+}
+
+LONGBOW_TEST_CASE(Core, hasher_HashMany)
+{
+    uint8_t data[64];
+    for (int i = 0; i < sizeof(data); i++) {
+        data[i] = i * 7;
+    }
+
+    size_t lengths[11];
+    uint8_t *inputs[11];
+    uint8_t digests[11][12];
+    uint8_t *outputs[11];
+    for (int i = 0; i < 11; i++) {
+        lengths[i] = i * 5;
+        inputs[i] = data + i;
+        outputs[i] = digests[i];
+    }
+
+    // Batched digests equal one-at-a-time digests, for batched and fallback hashers alike
+    for (int h = 0; HasherNames[h] != NULL; h++) {
+        Hasher *hasher = hasher_CreateNamed(HasherNames[h]);
+        for (size_t outputLength = 4; outputLength <= 12; outputLength += 4) {
+            hasher_HashMany(hasher, 11, lengths, inputs, outputs, outputLength);
+            for (int i = 0; i < 11; i++) {
+                PARCBuffer *digest = hasher_HashArray(hasher, lengths[i], inputs[i]);
+                size_t digestLength = parcBuffer_Remaining(digest);
+                size_t compared = digestLength < outputLength ? digestLength : outputLength;
+                assertTrue(memcmp(parcBuffer_Overlay(digest, 0), digests[i], compared) == 0,
+                    "Expected the batched %s digest %d to match", HasherNames[h], i);
+                for (size_t j = compared; j < outputLength; j++) {
+                    assertTrue(digests[i][j] == 0, "Expected the %s digest to be zero-padded", HasherNames[h]);
+                }
+                parcBuffer_Release(&digest);
+            }
+        }
+        hasher_Destroy(&hasher);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, hasher_SHA256Vectors)
+{
+    // FIPS 180-2 examples, including the two-block padding case
+    const char *messages[] = { "", "abc", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq" };
+    const char *expected[] = {
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+    };
+
+    for (SHA256Implementation implementation = SHA256Implementation_Best; implementation <= SHA256Implementation_AVX2; implementation++) {
+        if (!sha256hasher_IsSupported(implementation)) {
+            continue;
+        }
+        for (int i = 0; i < 3; i++) {
+            uint8_t digest[SHA256_HASH_LENGTH];
+            char hex[2 * SHA256_HASH_LENGTH + 1];
+            sha256hasher_Digest(implementation, strlen(messages[i]), (const uint8_t *) messages[i], digest);
+            for (int j = 0; j < SHA256_HASH_LENGTH; j++) {
+                sprintf(hex + 2 * j, "%02x", digest[j]);
+            }
+            assertTrue(strcmp(hex, expected[i]) == 0, "Expected SHA-256 vector %d from implementation %d, got %s",
+                i, implementation, hex);
+        }
+    }
+}
+
+LONGBOW_TEST_CASE(Core, hasher_SHA256Implementations)
+{
+    uint8_t data[300];
+    srand(7);
+    for (int i = 0; i < sizeof(data); i++) {
+        data[i] = rand();
+    }
+
+    // Lengths straddle the one- and two-block padding boundaries; 13 inputs leave a partial AVX2 batch
+    size_t lengths[13];
+    uint8_t *inputs[13];
+    uint8_t expected[13][SHA256_HASH_LENGTH];
+    uint8_t digests[13][SHA256_HASH_LENGTH];
+    uint8_t *outputs[13];
+    for (int i = 0; i < 13; i++) {
+        lengths[i] = (i * 23) % 200;
+        inputs[i] = data + i;
+        outputs[i] = digests[i];
+        sha256hasher_Digest(SHA256Implementation_Generic, lengths[i], inputs[i], expected[i]);
+    }
+
+    for (SHA256Implementation implementation = SHA256Implementation_Best; implementation <= SHA256Implementation_AVX2; implementation++) {
+        if (!sha256hasher_IsSupported(implementation)) {
+            continue;
+        }
+        sha256hasher_DigestMany(implementation, 13, lengths, inputs, outputs, SHA256_HASH_LENGTH);
+        for (int i = 0; i < 13; i++) {
+            assertTrue(memcmp(expected[i], digests[i], SHA256_HASH_LENGTH) == 0,
+                "Expected implementation %d to match the generic digest of %zu bytes", implementation, lengths[i]);
+        }
+    }
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(hasher);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
@@ -28,6 +28,7 @@ LONGBOW_TEST_RUNNER_TEARDOWN(map)
 LONGBOW_TEST_FIXTURE(Core)
 {
     LONGBOW_RUN_TEST_CASE(Core, map_Create);
+    LONGBOW_RUN_TEST_CASE(Core, map_Remove);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -53,6 +54,32 @@ LONGBOW_TEST_CASE(Core, map_Create)
     assertNull(map, "Expected a NULL map after map_Destroy");
 }
 
+LONGBOW_TEST_CASE(Core, map_Remove)
+{
+    Map *map = map_Create(NULL);
+    PARCBuffer *key = parcBuffer_AllocateCString("key");
+    PARCBuffer *other = parcBuffer_AllocateCString("other");
+    int first = 1;
+    int second = 2;
+
+    // Repeats of a key come back out in insertion order
+    map_Insert(map, key, &first);
+    map_Insert(map, key, &second);
+    assertNull(map_Remove(map, other), "Expected nothing under an absent key");
+    assertTrue(map_Remove(map, key) == &first, "Expected the first item to be removed first");
+    assertTrue(map_Get(map, key) == &second, "Expected the repeat to be found after the first is removed");
+    assertTrue(map_Remove(map, key) == &second, "Expected the repeat to be removed next");
+    assertNull(map_Get(map, key), "Expected the key to be gone");
+
+    map_InsertHashed(map, other, &first);
+    assertTrue(map_RemoveHashed(map, other) == &first, "Expected the hashed key to be removed");
+    assertNull(map_GetHashed(map, other), "Expected the hashed key to be gone");
+
+    parcBuffer_Release(&key);
+    parcBuffer_Release(&other);
+    map_Destroy(&map);
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -0,0 +1,194 @@
+#include "../multi_length_table.h"
+#include "../random.h"
+
+#include <stdint.h>
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(multiLengthTable)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(multiLengthTable)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(multiLengthTable)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_Empty);
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_Longest);
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_RepeatedKey);
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_Growth);
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_DeepLengths);
+    LONGBOW_RUN_TEST_CASE(Core, multiLengthTable_Fingerprints);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_Empty)
+{
+    MultiLengthTable *table = multiLengthTable_Create(0, NULL, NULL, NULL);
+    assertNotNull(table, "Expected a non-NULL table to be created");
+    assertTrue(multiLengthTable_GetNumLengths(table) == 0, "Expected no lengths");
+
+    uint64_t fingerprints[] = { 1, 2, 3 };
+    uint32_t value = 0;
+    assertTrue(multiLengthTable_Longest(table, 3, fingerprints, &value) == 0, "Expected nothing to be found");
+
+    multiLengthTable_Destroy(&table);
+    assertNull(table, "Expected a NULL table after multiLengthTable_Destroy");
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_Longest)
+{
+    // The chain a -> ab -> abc -> abcd, with only lengths 1 and 3 stored, and a zero fingerprint
+    int lengths[] = { 1, 3, 2 };
+    uint64_t fingerprints[] = { 0, 0x3333, 0x2222 };
+    uint32_t values[] = { 10, 30, 20 };
+    MultiLengthTable *table = multiLengthTable_Create(3, lengths, fingerprints, values);
+    assertTrue(multiLengthTable_GetNumLengths(table) == 3, "Expected 3 lengths, got %d", multiLengthTable_GetNumLengths(table));
+
+    uint32_t value = 0;
+    uint64_t query[] = { 0, 0x9999, 0x3333, 0x4444 };
+    assertTrue(multiLengthTable_Longest(table, 4, query, &value) == 3 && value == 30, "Expected the length 3 match");
+    assertTrue(multiLengthTable_Longest(table, 2, query, &value) == 1 && value == 10, "Expected the length 1 match below the count");
+
+    // A fingerprint stored at one length is not a match at another
+    uint64_t shifted[] = { 0x2222, 0x3333, 0x9999 };
+    assertTrue(multiLengthTable_Longest(table, 3, shifted, &value) == 0, "Expected no match at the wrong lengths");
+
+    multiLengthTable_Destroy(&table);
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_RepeatedKey)
+{
+    int lengths[] = { 2, 2, 2 };
+    uint64_t fingerprints[] = { 7, 7, 8 };
+    MultiLengthTable *table = multiLengthTable_Create(3, lengths, fingerprints, NULL);
+
+    uint32_t value = 0;
+    uint64_t query[] = { 1, 7 };
+    assertTrue(multiLengthTable_Longest(table, 2, query, &value) == 2, "Expected the repeated key to be found");
+    assertTrue(value == 0, "Expected the first repeat's index, got %u", value);
+
+    multiLengthTable_Destroy(&table);
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_Growth)
+{
+    // Keys sharing their low bits crowd one bucket, which must grow to split them
+    const size_t count = 4096;
+    int *lengths = (int *) malloc(count * sizeof(int));
+    uint64_t *fingerprints = (uint64_t *) malloc(count * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++) {
+        lengths[i] = 1 + (int) (i % 5);
+        fingerprints[i] = (i < 64 ? i << 20 : i * 0x9e3779b97f4a7c15ULL) | 2;
+    }
+
+    MultiLengthTable *table = multiLengthTable_Create(count, lengths, fingerprints, NULL);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t query[5] = { 0, 0, 0, 0, 0 };
+        query[lengths[i] - 1] = fingerprints[i];
+
+        uint32_t value = 0;
+        int length = multiLengthTable_Longest(table, 5, query, &value);
+        assertTrue(length == lengths[i] && value == i, "Expected entry %zu at length %d, got %u at %d", i, lengths[i], value, length);
+    }
+    assertTrue(multiLengthTable_GetSizeInBytes(table) > 0, "Expected a non-empty table");
+
+    multiLengthTable_Destroy(&table);
+    free(fingerprints);
+    free(lengths);
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_DeepLengths)
+{
+    // Lengths past the lanes are probed first, one by one
+    const int depth = 24;
+    int lengths[depth];
+    uint64_t fingerprints[depth];
+    for (int d = 1; d <= depth; d++) {
+        lengths[d - 1] = d;
+        fingerprints[d - 1] = 0x1000 + d;
+    }
+    MultiLengthTable *table = multiLengthTable_Create(depth, lengths, fingerprints, NULL);
+
+    uint32_t value = 0;
+    for (int count = 1; count <= depth; count++) {
+        assertTrue(multiLengthTable_Longest(table, count, fingerprints, &value) == count && value == (uint32_t) count - 1,
+                   "Expected the match of length %d", count);
+    }
+
+    uint64_t query[depth];
+    memcpy(query, fingerprints, sizeof(query));
+    query[depth - 1] = 1;
+    query[depth - 2] = 1;
+    assertTrue(multiLengthTable_Longest(table, depth, query, &value) == depth - 2, "Expected the next longest deep match");
+    for (int d = MultiLengthTableLanes + 1; d <= depth; d++) {
+        query[d - 1] = 1;
+    }
+    assertTrue(multiLengthTable_Longest(table, depth, query, &value) == MultiLengthTableLanes, "Expected the longest lane match");
+
+    multiLengthTable_Destroy(&table);
+}
+
+LONGBOW_TEST_CASE(Core, multiLengthTable_Fingerprints)
+{
+    WYHasher *hasher = wyhasher_Create(42);
+    Name *name = name_CreateFromCString("ccnx:/a/b/c");
+    Name *prefix = name_CreateFromCString("ccnx:/a/b");
+    Name *other = name_CreateFromCString("ccnx:/a/c");
+
+    uint64_t nameFingerprints[3];
+    uint64_t prefixFingerprints[2];
+    uint64_t otherFingerprints[2];
+    multiLengthTable_Fingerprints(hasher, 7, name, 3, nameFingerprints);
+    multiLengthTable_Fingerprints(hasher, 7, prefix, 2, prefixFingerprints);
+    multiLengthTable_Fingerprints(hasher, 7, other, 2, otherFingerprints);
+
+    assertTrue(memcmp(nameFingerprints, prefixFingerprints, sizeof(prefixFingerprints)) == 0, "Expected a prefix to share the fingerprints of its lengths");
+    assertTrue(nameFingerprints[0] == otherFingerprints[0], "Expected the shared first segment to match");
+    assertTrue(nameFingerprints[1] != otherFingerprints[1], "Expected different second segments to differ");
+
+    name_Destroy(&other);
+    name_Destroy(&prefix);
+    name_Destroy(&name);
+    wyhasher_Destroy(&hasher);
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(multiLengthTable);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
@@ -16,6 +16,7 @@
 LONGBOW_TEST_RUNNER(fibNaive)
 {
     LONGBOW_RUN_TEST_FIXTURE(Core);
+    LONGBOW_RUN_TEST_FIXTURE(Bulk);
 }
 
 // The Test Runner calls this function once before any Test Fixtures are run.
@@ -35,6 +36,9 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, fibNaive_Create);
     LONGBOW_RUN_TEST_CASE(Core, fibNaive_LookupSimple);
     LONGBOW_RUN_TEST_CASE(Core, fibNaive_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibNaive_LookupFrozen);
+    LONGBOW_RUN_TEST_CASE(Core, fibNaive_LookupInterned);
+    LONGBOW_RUN_TEST_CASE(Core, fibNaive_LookupMultiLength);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -85,6 +89,140 @@ LONGBOW_TEST_CASE(Core, fibNaive_LookupHashed)
     fib_Destroy(&fib);
 }
 
+LONGBOW_TEST_CASE(Core, fibNaive_LookupFrozen)
+{
+    FIBNaive *native = fibNative_Create();
+    FIB *fib = fib_Create(native, NativeFIBAsFIB);
+
+    test_fib_freeze(fib, (void (*)(void *instance)) fibNaive_Freeze, native);
+    assertTrue(fibNaive_IsFrozen(native), "Expected the FIB to be left frozen");
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibNaive_LookupInterned)
+{
+    ComponentDictionary *dictionary = componentDictionary_Create();
+
+    FIBNaive *native = fibNative_Create();
+    fibNaive_SetDictionary(native, dictionary);
+    FIB *fib = fib_Create(native, NativeFIBAsFIB);
+    test_fib_lookup(fib);
+    fib_Destroy(&fib);
+
+    // Hashed names are interned by their digest components, into the same dictionary
+    native = fibNative_Create();
+    fibNaive_SetDictionary(native, dictionary);
+    fib = fib_Create(native, NativeFIBAsFIB);
+    test_fib_hash_lookup(fib);
+    fib_Destroy(&fib);
+
+    native = fibNative_Create();
+    fibNaive_SetDictionary(native, dictionary);
+    fib = fib_Create(native, NativeFIBAsFIB);
+    test_fib_freeze(fib, (void (*)(void *instance)) fibNaive_Freeze, native);
+    fib_Destroy(&fib);
+
+    componentDictionary_Destroy(&dictionary);
+}
+
+LONGBOW_TEST_CASE(Core, fibNaive_LookupMultiLength)
+{
+    FIBNaive *native = fibNative_Create();
+    fibNaive_SetMultiLength(native);
+    FIB *fib = fib_Create(native, NativeFIBAsFIB);
+
+    test_fib_freeze(fib, (void (*)(void *instance)) fibNaive_Freeze, native);
+    assertTrue(fibNaive_IsFrozen(native), "Expected the FIB to be left frozen");
+    assertTrue(fibNaive_GetFrozenBitsPerKey(native) == 0.0, "Expected no perfect hashes beside the multi-length table");
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_FIXTURE(Bulk)
+{
+    LONGBOW_RUN_TEST_CASE(Bulk, fibNaive_BulkLoad);
+    LONGBOW_RUN_TEST_CASE(Bulk, fibNaive_BulkLoadInterned);
+    LONGBOW_RUN_TEST_CASE(Bulk, fibNaive_BulkLoadMultiLength);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Bulk)
+{
+    return test_fib_bulk_setup();
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Bulk)
+{
+    return test_fib_bulk_teardown(testCase);
+}
+
+LONGBOW_TEST_CASE(Bulk, fibNaive_BulkLoad)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBNaive *native = fibNative_Create();
+        FIB *fib = fib_Create(native, NativeFIBAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+    }
+}
+
+LONGBOW_TEST_CASE(Bulk, fibNaive_BulkLoadInterned)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        ComponentDictionary *dictionary = componentDictionary_Create();
+        FIBNaive *native = fibNative_Create();
+        fibNaive_SetDictionary(native, dictionary);
+        FIB *fib = fib_Create(native, NativeFIBAsFIB);
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+        componentDictionary_Destroy(&dictionary);
+    }
+}
+
+LONGBOW_TEST_CASE(Bulk, fibNaive_BulkLoadMultiLength)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBNaive *native = fibNative_Create();
+        fibNaive_SetMultiLength(native);
+        FIB *fib = fib_Create(native, NativeFIBAsFIB);
+
+        // Repeats within the batch, whose first vector the frozen table must return too
+        const int numNames = 200;
+        Name *names[numNames];
+        Bitmap *vectors[numNames];
+        for (int i = 0; i < numNames; i++) {
+            char uri[128] = "ccnx:";
+            for (int j = 0; j <= i % 20; j++) {
+                sprintf(uri + strlen(uri), "/c%d", (i / 20 + j) % 4);
+            }
+            names[i] = name_CreateFromCString(uri);
+            vectors[i] = bitmap_Create(numNames);
+            bitmap_Set(vectors[i], i);
+        }
+        fib_BulkLoad(fib, names, vectors, numNames, threads);
+
+        Bitmap *expected[numNames];
+        for (int i = 0; i < numNames; i++) {
+            expected[i] = fib_LPM(fib, names[i]);
+        }
+        fibNaive_Freeze(native);
+        for (int i = 0; i < numNames; i++) {
+            assertTrue(fib_LPM(fib, names[i]) == expected[i], "Expected name %d to keep its match when frozen", i);
+        }
+
+        fib_Destroy(&fib);
+        for (int i = 0; i < numNames; i++) {
+            bitmap_Destroy(&vectors[i]);
+            name_Destroy(&names[i]);
+        }
+    }
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -28,6 +28,7 @@ LONGBOW_TEST_RUNNER_TEARDOWN(name)
 LONGBOW_TEST_FIXTURE(Core)
 {
     LONGBOW_RUN_TEST_CASE(Core, name_Create);
+    LONGBOW_RUN_TEST_CASE(Core, name_Intern);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -53,6 +54,30 @@ LONGBOW_TEST_CASE(Core, name_Create)
 //    assertNull(bf, "Expected a NULL name after name_Destroy");
 }
 
+LONGBOW_TEST_CASE(Core, name_Intern)
+{
+    ComponentDictionary *dictionary = componentDictionary_Create();
+    Name *first = name_CreateFromCString("ccnx:/com/cisco/www");
+    Name *second = name_CreateFromCString("ccnx:/com/parc/www");
+    uint32_t firstIDs[3];
+    uint32_t secondIDs[3];
+
+    assertTrue(name_Intern(first, dictionary, false, firstIDs) == 0, "Expected no known components before interning");
+    assertTrue(name_Intern(first, dictionary, true, firstIDs) == 3, "Expected every component to be interned");
+    assertTrue(componentDictionary_GetCount(dictionary) == 3, "Expected 3 distinct components");
+
+    // Only /com is known: the IDs stop at /parc
+    assertTrue(name_Intern(second, dictionary, false, secondIDs) == 1, "Expected the lookup to stop at the first unknown component");
+    assertTrue(secondIDs[0] == firstIDs[0], "Expected /com to share its ID");
+
+    assertTrue(name_Intern(second, dictionary, true, secondIDs) == 3, "Expected every component to be interned");
+    assertTrue(secondIDs[2] == firstIDs[2] && secondIDs[1] != firstIDs[1], "Expected equal components to share IDs, and only them");
+    assertTrue(componentDictionary_GetCount(dictionary) == 4, "Expected 4 distinct components");
+
+    name_Destroy(&first);
+    name_Destroy(&second);
+    componentDictionary_Destroy(&dictionary);
+}
 
 int
 main(int argc, char *argv[argc])
@@ -36,6 +36,7 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, patricia_Insert_Longer);
     LONGBOW_RUN_TEST_CASE(Core, patricia_Insert_Split);
     LONGBOW_RUN_TEST_CASE(Core, patricia_Insert_LongSplit);
+    LONGBOW_RUN_TEST_CASE(Core, patricia_Insert_SplitKeepsChildren);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -98,8 +99,8 @@ LONGBOW_TEST_CASE(Core, patricia_Insert_LongSplit)
 
     patricia_Insert(trie, key1, (void *) value1);
     patricia_Insert(trie, key2, (void *) value2);
-//    patricia_Insert(trie, key3, (void *) value3);
-//    patricia_Insert(trie, key4, (void *) value4);
+    patricia_Insert(trie, key3, (void *) value3);
+    patricia_Insert(trie, key4, (void *) value4);
 
     PARCBuffer *actual1 = (PARCBuffer *) patricia_Get(trie, key1);
     assertNotNull(actual1, "Expected to get something back");
@@ -109,13 +110,13 @@ LONGBOW_TEST_CASE(Core, patricia_Insert_LongSplit)
     assertNotNull(actual2, "Expected to get something back");
     assertTrue(parcBuffer_Equals(actual2, value2), "Expected to get the same value back");
 
-//    PARCBuffer *actual3 = (PARCBuffer *) patricia_Get(trie, key3);
-//    assertNotNull(actual3, "Expected to get something back");
-//    assertTrue(parcBuffer_Equals(actual3, value3), "Expected to get the same value back");
-//
-//    PARCBuffer *actual4 = (PARCBuffer *) patricia_Get(trie, key4);
-//    assertNotNull(actual4, "Expected to get something back");
-//    assertTrue(parcBuffer_Equals(actual4, value4), "Expected to get the same value back");
+    PARCBuffer *actual3 = (PARCBuffer *) patricia_Get(trie, key3);
+    assertNotNull(actual3, "Expected to get something back");
+    assertTrue(parcBuffer_Equals(actual3, value3), "Expected to get the same value back");
+
+    PARCBuffer *actual4 = (PARCBuffer *) patricia_Get(trie, key4);
+    assertNotNull(actual4, "Expected to get something back");
+    assertTrue(parcBuffer_Equals(actual4, value4), "Expected to get the same value back");
 
     parcBuffer_Release(&key1);
     parcBuffer_Release(&value1);
@@ -234,6 +235,46 @@ LONGBOW_TEST_CASE(Core, patricia_Insert_Split)
     patricia_Destroy(&trie);
 }
 
+LONGBOW_TEST_CASE(Core, patricia_Insert_SplitKeepsChildren)
+{
+    Patricia *trie = patricia_Create(NULL);
+
+    PARCBuffer *key1 = parcBuffer_AllocateCString("abcd");
+    PARCBuffer *key2 = parcBuffer_AllocateCString("abcdef");
+    PARCBuffer *key3 = parcBuffer_AllocateCString("abxy");
+    PARCBuffer *key4 = parcBuffer_AllocateCString("ab");
+    PARCBuffer *missing = parcBuffer_AllocateCString("abc");
+    PARCBuffer *longer = parcBuffer_AllocateCString("abcdefgh");
+
+    int value1 = 1;
+    int value2 = 2;
+    int value3 = 3;
+    int value4 = 4;
+
+    // abxy splits the abcd edge, which already has the ef child
+    patricia_Insert(trie, key1, &value1);
+    patricia_Insert(trie, key2, &value2);
+    patricia_Insert(trie, key3, &value3);
+    patricia_Insert(trie, key4, &value4);
+
+    assertTrue(patricia_GetExact(trie, key1) == &value1, "Expected abcd to survive the split");
+    assertTrue(patricia_GetExact(trie, key2) == &value2, "Expected abcdef to survive the split");
+    assertTrue(patricia_GetExact(trie, key3) == &value3, "Expected abxy to be found");
+    assertTrue(patricia_GetExact(trie, key4) == &value4, "Expected ab to be found at the split node");
+
+    assertTrue(patricia_GetExact(trie, missing) == NULL, "Expected no exact match for abc");
+    assertTrue(patricia_Get(trie, missing) == &value4, "Expected ab to be the longest prefix of abc");
+    assertTrue(patricia_Get(trie, longer) == &value2, "Expected abcdef to be the longest prefix of abcdefgh");
+
+    parcBuffer_Release(&key1);
+    parcBuffer_Release(&key2);
+    parcBuffer_Release(&key3);
+    parcBuffer_Release(&key4);
+    parcBuffer_Release(&missing);
+    parcBuffer_Release(&longer);
+    patricia_Destroy(&trie);
+}
+
 int
 main(int argc, char *argv[argc])
 {
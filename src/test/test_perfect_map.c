@@ -0,0 +1,155 @@
+#include "../perfect_map.h"
+
+#include <stdint.h>
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(perfectMap)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(perfectMap)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(perfectMap)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, perfectMap_Empty);
+    LONGBOW_RUN_TEST_CASE(Core, perfectMap_Get);
+    LONGBOW_RUN_TEST_CASE(Core, perfectMap_GetHashed);
+    LONGBOW_RUN_TEST_CASE(Core, perfectMap_RepeatedKey);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+static PARCBuffer *
+_createKey(const char *prefix, int i)
+{
+    char key[64];
+    sprintf(key, "%s%d", prefix, i);
+    PARCBuffer *buffer = parcBuffer_Allocate(strlen(key));
+    parcBuffer_PutArray(buffer, strlen(key), (uint8_t *) key);
+    return parcBuffer_Flip(buffer);
+}
+
+LONGBOW_TEST_CASE(Core, perfectMap_Empty)
+{
+    Map *map = map_Create(NULL);
+    PerfectMap *perfect = perfectMap_CreateFromMap(map, PerfectMapDefaultGamma);
+    assertNotNull(perfect, "Expected a non-NULL perfect map to be created");
+    assertTrue(perfectMap_GetCount(perfect) == 0, "Expected an empty perfect map");
+
+    PARCBuffer *key = _createKey("key", 0);
+    assertNull(perfectMap_Get(perfect, key), "Expected nothing to be found");
+    parcBuffer_Release(&key);
+
+    perfectMap_Destroy(&perfect);
+    assertNull(perfect, "Expected a NULL perfect map after perfectMap_Destroy");
+    map_Destroy(&map);
+}
+
+LONGBOW_TEST_CASE(Core, perfectMap_Get)
+{
+    const int numKeys = 5000;
+    Map *map = map_Create(NULL);
+    for (int i = 0; i < numKeys; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        map_Insert(map, key, (void *) (intptr_t) (i + 1));
+        parcBuffer_Release(&key);
+    }
+
+    PerfectMap *perfect = perfectMap_CreateFromMap(map, PerfectMapDefaultGamma);
+    assertTrue(perfectMap_GetCount(perfect) == numKeys, "Expected %d keys, got %zu", numKeys, perfectMap_GetCount(perfect));
+
+    // BBHash with one bit per key per level needs about e bits per key, plus the rank counters
+    double bitsPerKey = perfectMap_GetBitsPerKey(perfect);
+    assertTrue(bitsPerKey > 2.0 && bitsPerKey < 4.0, "Expected about 3 bits per key, got %f", bitsPerKey);
+
+    for (int i = 0; i < numKeys; i++) {
+        PARCBuffer *key = _createKey("key", i);
+        void *item = perfectMap_Get(perfect, key);
+        assertTrue(item == (void *) (intptr_t) (i + 1), "Expected key %d to map to its own item", i);
+        parcBuffer_Release(&key);
+
+        PARCBuffer *absent = _createKey("absent", i);
+        assertNull(perfectMap_Get(perfect, absent), "Expected absent key %d to be rejected", i);
+        parcBuffer_Release(&absent);
+    }
+
+    perfectMap_Destroy(&perfect);
+    map_Destroy(&map);
+}
+
+LONGBOW_TEST_CASE(Core, perfectMap_GetHashed)
+{
+    const int numKeys = 1000;
+    Map *map = map_Create(NULL);
+    for (int i = 0; i < numKeys; i++) {
+        PARCBuffer *key = _createKey("digest", i);
+        map_InsertHashed(map, key, (void *) (intptr_t) (i + 1));
+        parcBuffer_Release(&key);
+    }
+
+    PerfectMap *perfect = perfectMap_CreateFromMap(map, 2.0);
+    for (int i = 0; i < numKeys; i++) {
+        PARCBuffer *key = _createKey("digest", i);
+        assertTrue(perfectMap_GetHashed(perfect, key) == map_GetHashed(map, key), "Expected key %d to match the map", i);
+        parcBuffer_Release(&key);
+    }
+
+    perfectMap_Destroy(&perfect);
+    map_Destroy(&map);
+}
+
+LONGBOW_TEST_CASE(Core, perfectMap_RepeatedKey)
+{
+    Map *map = map_Create(NULL);
+    PARCBuffer *key = _createKey("key", 1);
+    map_Insert(map, key, (void *) (intptr_t) 1);
+    map_Insert(map, key, (void *) (intptr_t) 2);
+
+    PerfectMap *perfect = perfectMap_CreateFromMap(map, PerfectMapDefaultGamma);
+    assertTrue(perfectMap_GetCount(perfect) == 1, "Expected the repeated key to be stored once");
+    assertTrue(perfectMap_Get(perfect, key) == map_Get(map, key), "Expected the item the map returns");
+
+    parcBuffer_Release(&key);
+    perfectMap_Destroy(&perfect);
+    map_Destroy(&map);
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(perfectMap);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
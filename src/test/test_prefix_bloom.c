@@ -1,4 +1,5 @@
 #include "../prefix_bloom.h"
+#include "../sha256hasher.h"
 
 #include <LongBow/testing.h>
 #include <LongBow/debugging.h>
@@ -30,6 +31,9 @@ LONGBOW_TEST_FIXTURE(Core)
     LONGBOW_RUN_TEST_CASE(Core, prefixBloom_Create);
     LONGBOW_RUN_TEST_CASE(Core, prefixBloom_Add);
     LONGBOW_RUN_TEST_CASE(Core, prefixBloom_AddTest);
+    LONGBOW_RUN_TEST_CASE(Core, prefixBloom_CuckooAddTest);
+    LONGBOW_RUN_TEST_CASE(Core, prefixBloom_CuckooRemove);
+    LONGBOW_RUN_TEST_CASE(Core, prefixBloom_HashedFalsePositiveRate);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -111,6 +115,127 @@ LONGBOW_TEST_CASE(Core, prefixBloom_AddTest)
     prefixBloomFilter_Destroy(&bf);
 }
 
+LONGBOW_TEST_CASE(Core, prefixBloom_CuckooAddTest)
+{
+    PrefixBloomFilter *bf = prefixBloomFilter_CreateOptimalWithFilter(100, 0.01, FilterType_Cuckoo);
+
+    Name *x1 = name_CreateFromCString("ccnx:/foo/barr");
+    Name *x2 = name_CreateFromCString("ccnx:/foob/barr");
+    Name *x4 = name_CreateFromCString("ccnx:/bar/food");
+    Name *y = name_CreateFromCString("ccnx:/foo");
+
+    // Adding a name twice stores it twice, so that each add can be removed
+    prefixBloomFilter_Add(bf, y);
+    prefixBloomFilter_Add(bf, y);
+    prefixBloomFilter_Add(bf, x4);
+
+    int index = prefixBloomFilter_LPM(bf, x4);
+    assertTrue(index == 2, "Expected x to match the full 2 segments, got %d", index);
+
+    index = prefixBloomFilter_LPM(bf, x1);
+    assertTrue(index == 1, "Expected x to match only 1 segment, got %d", index);
+
+    index = prefixBloomFilter_LPM(bf, x2);
+    assertTrue(index == -1, "Expected x to match no segments, got %d", index);
+
+    bool present[2];
+    index = prefixBloomFilter_TestPrefixes(bf, x1, present);
+    assertTrue(index == 1 && present[0] && !present[1], "Expected only the first prefix of x to be present");
+
+    name_Destroy(&x1);
+    name_Destroy(&x2);
+    name_Destroy(&x4);
+    name_Destroy(&y);
+
+    prefixBloomFilter_Destroy(&bf);
+}
+
+LONGBOW_TEST_CASE(Core, prefixBloom_CuckooRemove)
+{
+    PrefixBloomFilter *bf = prefixBloomFilter_CreateOptimalWithFilter(100, 0.01, FilterType_Cuckoo);
+
+    Name *x = name_CreateFromCString("ccnx:/foo/barr");
+    Name *y = name_CreateFromCString("ccnx:/foo");
+    Name *z = name_CreateFromCString("ccnx:/bar/food");
+
+    // A repeated name is stored once, so one remove takes it out
+    for (int i = 0; i < 20; i++) {
+        prefixBloomFilter_Add(bf, y);
+    }
+    prefixBloomFilter_Add(bf, z);
+    assertTrue(prefixBloomFilter_LPM(bf, x) == 1, "Expected y to be present");
+
+    assertTrue(prefixBloomFilter_Remove(bf, y), "Expected y to be removed");
+    assertTrue(prefixBloomFilter_LPM(bf, x) == -1, "Expected y to be gone");
+    assertFalse(prefixBloomFilter_Remove(bf, y), "Expected nothing left to remove");
+    assertTrue(prefixBloomFilter_LPM(bf, z) == 2, "Expected the other name to stay");
+
+    prefixBloomFilter_Destroy(&bf);
+
+    // Bloom blocks cannot forget a name
+    bf = prefixBloomFilter_CreateOptimal(100, 0.01);
+    prefixBloomFilter_Add(bf, y);
+    assertFalse(prefixBloomFilter_Remove(bf, y), "Expected Bloom blocks to refuse removal");
+    assertTrue(prefixBloomFilter_LPM(bf, x) == 1, "Expected y to stay in the Bloom blocks");
+    prefixBloomFilter_Destroy(&bf);
+
+    name_Destroy(&x);
+    name_Destroy(&y);
+    name_Destroy(&z);
+}
+
+LONGBOW_TEST_CASE(Core, prefixBloom_HashedFalsePositiveRate)
+{
+    SHA256Hasher *sha256 = sha256hasher_Create();
+    Hasher *hasher = hasher_Create(sha256, SHA256HashAsHasher);
+
+    int capacity = 1000;
+    int numProbes = 5000;
+    double targetFPR = 0.01;
+    double loads[] = { 0.25, 0.5, 1.0, 2.0 };
+    char nameString[64];
+
+    // The names are fixed, so the measured rates are reproducible from run to run
+    printf("load,fpr\n");
+    for (int l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+        PrefixBloomFilter *bf = prefixBloomFilter_CreateOptimal(capacity, targetFPR);
+        int numEntries = (int) (loads[l] * capacity);
+
+        for (int i = 0; i < numEntries; i++) {
+            sprintf(nameString, "ccnx:/member-%d/data", i);
+            Name *name = name_CreateFromCString(nameString);
+            Name *hashedName = name_Hash(name, hasher, 8);
+            prefixBloomFilter_Add(bf, hashedName);
+            name_Destroy(&hashedName);
+            name_Destroy(&name);
+        }
+
+        // Each probe tests both of its prefixes
+        int falsePositives = 0;
+        for (int i = 0; i < numProbes; i++) {
+            sprintf(nameString, "ccnx:/probe-%d/data", i);
+            Name *name = name_CreateFromCString(nameString);
+            Name *hashedName = name_Hash(name, hasher, 8);
+            if (prefixBloomFilter_LPM(bf, hashedName) != -1) {
+                falsePositives++;
+            }
+            name_Destroy(&hashedName);
+            name_Destroy(&name);
+        }
+
+        double fpr = (double) falsePositives / numProbes;
+        printf("%.2f,%f\n", loads[l], fpr);
+
+        if (loads[l] <= 1.0) {
+            assertTrue(fpr <= 4 * targetFPR, "FPR %f at load %.2f is far above the target %f", fpr, loads[l], targetFPR);
+        }
+
+        prefixBloomFilter_Destroy(&bf);
+    }
+
+    hasher_Destroy(&hasher);
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -0,0 +1,113 @@
+#include "../prefix_length_filter.h"
+
+#include <LongBow/testing.h>
+#include <LongBow/debugging.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+LONGBOW_TEST_RUNNER(prefixLengthFilter)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(prefixLengthFilter)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(prefixLengthFilter)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, prefixLengthFilter_Create);
+    LONGBOW_RUN_TEST_CASE(Core, prefixLengthFilter_Candidates);
+    LONGBOW_RUN_TEST_CASE(Core, prefixLengthFilter_HasCandidate);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_CASE(Core, prefixLengthFilter_Create)
+{
+    PrefixLengthFilter *filter = prefixLengthFilter_Create(128, 3);
+    assertNotNull(filter, "Expected a non-NULL filter to be created");
+    prefixLengthFilter_Destroy(&filter);
+    assertNull(filter, "Expected a NULL filter after prefixLengthFilter_Destroy");
+
+    filter = prefixLengthFilter_CreateOptimal(0.01);
+    assertNotNull(filter, "Expected a non-NULL filter to be created");
+    prefixLengthFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, prefixLengthFilter_Candidates)
+{
+    PrefixLengthFilter *filter = prefixLengthFilter_CreateOptimal(0.0001);
+
+    Name *x = name_CreateFromCString("ccnx:/foo/bar");
+    Name *y = name_CreateFromCString("ccnx:/foo/bar/baz/qux");
+    Name *z = name_CreateFromCString("ccnx:/bar/foo");
+    prefixLengthFilter_Add(filter, x);
+    prefixLengthFilter_Add(filter, y);
+
+    // Prefixes of the query that were added are always candidates
+    Name *query = name_CreateFromCString("ccnx:/foo/bar/baz/qux/quux");
+    uint64_t candidates = prefixLengthFilter_Candidates(filter, query);
+    assertTrue(prefixLengthFilter_IsCandidate(candidates, 2), "Expected /foo/bar to be a candidate");
+    assertTrue(prefixLengthFilter_IsCandidate(candidates, 4), "Expected /foo/bar/baz/qux to be a candidate");
+    assertFalse(prefixLengthFilter_IsCandidate(candidates, 1), "Expected no 1-segment candidate");
+    assertFalse(prefixLengthFilter_IsCandidate(candidates, 5), "Expected no 5-segment candidate");
+    assertTrue(prefixLengthFilter_IsCandidate(candidates, PrefixLengthFilterMaxLength + 1), "Expected unfiltered lengths to be candidates");
+
+    // Prefix hashes depend on the segment order
+    candidates = prefixLengthFilter_Candidates(filter, z);
+    assertTrue(candidates == 0, "Expected no candidates for /bar/foo, got %llx", (unsigned long long) candidates);
+
+    name_Destroy(&x);
+    name_Destroy(&y);
+    name_Destroy(&z);
+    name_Destroy(&query);
+
+    prefixLengthFilter_Destroy(&filter);
+}
+
+LONGBOW_TEST_CASE(Core, prefixLengthFilter_HasCandidate)
+{
+    uint64_t candidates = (1ULL << 1) | (1ULL << 4);
+
+    assertTrue(prefixLengthFilter_HasCandidate(candidates, 1, 2), "Expected length 2 in [1, 2]");
+    assertTrue(prefixLengthFilter_HasCandidate(candidates, 3, 5), "Expected length 5 in [3, 5]");
+    assertFalse(prefixLengthFilter_HasCandidate(candidates, 3, 4), "Expected no candidate in [3, 4]");
+    assertFalse(prefixLengthFilter_HasCandidate(candidates, 6, 64), "Expected no candidate in [6, 64]");
+    assertFalse(prefixLengthFilter_HasCandidate(candidates, 5, 4), "Expected an empty range to have no candidate");
+    assertTrue(prefixLengthFilter_HasCandidate(0, 6, PrefixLengthFilterMaxLength + 1), "Expected unfiltered lengths to be candidates");
+    assertTrue(prefixLengthFilter_HasCandidate(1ULL << 63, 64, 64), "Expected length 64 in [64, 64]");
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(prefixLengthFilter);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
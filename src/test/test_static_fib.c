@@ -0,0 +1,272 @@
+#include "../fib_static.h"
+
+#include <LongBow/testing.h>
+
+#include <parc/algol/parc_Memory.h>
+#include <parc/algol/parc_SafeMemory.h>
+
+#include <parc/testing/parc_MemoryTesting.h>
+
+#include "test_fib.c"
+
+// The shared lookup tests look up right after inserting, so this front-end builds after each insert
+static bool
+_test_fibStatic_InsertAndBuild(void *instance, const Name *name, Bitmap *vector)
+{
+    bool inserted = fibStatic_Insert((FIBStatic *) instance, name, vector);
+    fibStatic_Build((FIBStatic *) instance);
+    return inserted;
+}
+
+static FIBInterface *BuiltStaticFIBAsFIB = &(FIBInterface) {
+        .LPM = (Bitmap *(*)(void *instance, const Name *ccnxName)) fibStatic_LPM,
+        .Insert = _test_fibStatic_InsertAndBuild,
+        .BulkLoad = (bool (*)(void *instance, Name *names[], Bitmap *vectors[], size_t n, int threads)) fibStatic_BulkLoad,
+        .Destroy = (void (*)(void **instance)) fibStatic_Destroy,
+};
+
+LONGBOW_TEST_RUNNER(fibStatic)
+{
+    LONGBOW_RUN_TEST_FIXTURE(Core);
+    LONGBOW_RUN_TEST_FIXTURE(Bulk);
+}
+
+// The Test Runner calls this function once before any Test Fixtures are run.
+LONGBOW_TEST_RUNNER_SETUP(fibStatic)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+// The Test Runner calls this function once after all the Test Fixtures are run.
+LONGBOW_TEST_RUNNER_TEARDOWN(fibStatic)
+{
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE(Core)
+{
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_Create);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_LookupSimple);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_LookupHashed);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_InsertAfterBuild);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_CreateFromNames);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_LookupMultiLength);
+    LONGBOW_RUN_TEST_CASE(Core, fibStatic_MultiLengthDeepNames);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Core)
+{
+    parcMemory_SetInterface(&PARCSafeMemoryAsPARCMemory);
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Core)
+{
+    if (!parcMemoryTesting_ExpectedOutstanding(0, "%s mismanaged memory.", longBowTestCase_GetFullName(testCase))) {
+        return LONGBOW_STATUS_MEMORYLEAK;
+    }
+
+    return LONGBOW_STATUS_SUCCEEDED;
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_Create)
+{
+    FIBStatic *fib = fibStatic_Create();
+    assertNotNull(fib, "Expected a non-NULL fibStatic to be created");
+    fibStatic_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_LookupSimple)
+{
+    FIBStatic *table = fibStatic_Create();
+    assertNotNull(table, "Expected a non-NULL fibStatic to be created");
+
+    FIB *fib = fib_Create(table, BuiltStaticFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_LookupHashed)
+{
+    FIBStatic *table = fibStatic_Create();
+    assertNotNull(table, "Expected a non-NULL fibStatic to be created");
+
+    FIB *fib = fib_Create(table, BuiltStaticFIBAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_hash_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_FIXTURE(Bulk)
+{
+    LONGBOW_RUN_TEST_CASE(Bulk, fibStatic_BulkLoad);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Bulk)
+{
+    return test_fib_bulk_setup();
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Bulk)
+{
+    return test_fib_bulk_teardown(testCase);
+}
+
+LONGBOW_TEST_CASE(Bulk, fibStatic_BulkLoad)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBStatic *table = fibStatic_Create();
+        FIB *fib = fib_Create(table, StaticFIBAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_InsertAfterBuild)
+{
+    FIBStatic *table = fibStatic_Create();
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b");
+    Name *query = name_CreateFromCString("ccnx:/a/b/c");
+
+    Bitmap *shortVector = bitmap_Create(8);
+    bitmap_Set(shortVector, 1);
+    Bitmap *longVector = bitmap_Create(8);
+    bitmap_Set(longVector, 2);
+    Bitmap *repeatVector = bitmap_Create(8);
+    bitmap_Set(repeatVector, 3);
+
+    fibStatic_Insert(table, shortPrefix, shortVector);
+    fibStatic_Build(table);
+    assertTrue(fibStatic_LPM(table, query) == shortVector, "Expected the only prefix to match");
+
+    // Names inserted after a build are compacted into the table by the next one
+    fibStatic_Insert(table, longPrefix, longVector);
+    fibStatic_Insert(table, shortPrefix, repeatVector);
+    fibStatic_Build(table);
+    assertTrue(fibStatic_LPM(table, query) == longVector, "Expected the longer prefix to match");
+    assertTrue(fibStatic_LPM(table, shortPrefix) == shortVector, "Expected the repeat to keep the first vector");
+    assertTrue(bitmap_Get(shortVector, 3), "Expected the repeat to be merged into the first vector");
+    assertTrue(fibStatic_GetNumPrefixes(table) == 2, "Expected 2 distinct prefixes, got %zu", fibStatic_GetNumPrefixes(table));
+
+    Name *miss = name_CreateFromCString("ccnx:/b/a");
+    assertNull(fibStatic_LPM(table, miss), "Expected no prefix of an unrelated name to match");
+
+    fibStatic_Destroy(&table);
+
+    bitmap_Destroy(&shortVector);
+    bitmap_Destroy(&longVector);
+    bitmap_Destroy(&repeatVector);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&query);
+    name_Destroy(&miss);
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_CreateFromNames)
+{
+    // Enough prefixes per length for several levels of the search tree, including partial ones
+    const int numNames = 1000;
+    Name *names[numNames];
+    Bitmap *vectors[numNames];
+    for (int i = 0; i < numNames; i++) {
+        char uri[64];
+        sprintf(uri, "ccnx:/p%d/q%d", i % 7, i);
+        names[i] = name_CreateFromCString(uri);
+        vectors[i] = bitmap_Create(numNames);
+        bitmap_Set(vectors[i], i);
+    }
+
+    FIBStatic *table = fibStatic_CreateFromNames(numNames, names, vectors, 1);
+    assertTrue(fibStatic_GetNumPrefixes(table) == numNames, "Expected %d prefixes, got %zu", numNames, fibStatic_GetNumPrefixes(table));
+    assertTrue(fibStatic_GetSizeInBytes(table) > 0, "Expected a non-empty table");
+
+    for (int i = 0; i < numNames; i++) {
+        assertTrue(fibStatic_LPM(table, names[i]) == vectors[i], "Expected name %d to match itself", i);
+
+        char uri[64];
+        sprintf(uri, "ccnx:/p%d/r%d", i % 7, i);
+        Name *miss = name_CreateFromCString(uri);
+        assertNull(fibStatic_LPM(table, miss), "Expected name %d to miss", i);
+        name_Destroy(&miss);
+    }
+
+    fibStatic_Destroy(&table);
+    for (int i = 0; i < numNames; i++) {
+        bitmap_Destroy(&vectors[i]);
+        name_Destroy(&names[i]);
+    }
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_LookupMultiLength)
+{
+    FIBStatic *table = fibStatic_Create();
+    fibStatic_SetMultiLength(table, true);
+    FIB *fib = fib_Create(table, BuiltStaticFIBAsFIB);
+    test_fib_lookup(fib);
+    fib_Destroy(&fib);
+
+    table = fibStatic_Create();
+    fibStatic_SetMultiLength(table, true);
+    fib = fib_Create(table, BuiltStaticFIBAsFIB);
+    test_fib_hash_lookup(fib);
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibStatic_MultiLengthDeepNames)
+{
+    // Prefixes of every other length up to 23 components, past the 16 probed at once
+    const int depth = 24;
+    Name *names[depth];
+    Bitmap *vectors[depth];
+    char uri[512] = "ccnx:";
+    for (int d = 1; d <= depth; d++) {
+        sprintf(uri + strlen(uri), "/s%d", d);
+        names[d - 1] = name_CreateFromCString(uri);
+        vectors[d - 1] = bitmap_Create(depth);
+        bitmap_Set(vectors[d - 1], d - 1);
+    }
+
+    FIBStatic *table = fibStatic_Create();
+    for (int d = 1; d < depth; d += 2) {
+        fibStatic_Insert(table, names[d - 1], vectors[d - 1]);
+    }
+    fibStatic_Build(table);
+
+    // Enabling the option on a built table buckets it, and disabling it goes back to the search
+    Bitmap *expected[depth];
+    for (int d = 1; d <= depth; d++) {
+        expected[d - 1] = fibStatic_LPM(table, names[d - 1]);
+    }
+    fibStatic_SetMultiLength(table, true);
+    for (int d = 1; d <= depth; d++) {
+        assertTrue(fibStatic_LPM(table, names[d - 1]) == expected[d - 1], "Expected the same match for depth %d", d);
+        assertTrue(expected[d - 1] == vectors[(d % 2 == 1 ? d : d - 1) - 1], "Expected the longest odd prefix for depth %d", d);
+    }
+    fibStatic_SetMultiLength(table, false);
+    assertTrue(fibStatic_LPM(table, names[depth - 1]) == expected[depth - 1], "Expected the same match without the option");
+
+    fibStatic_Destroy(&table);
+    for (int d = 1; d <= depth; d++) {
+        bitmap_Destroy(&vectors[d - 1]);
+        name_Destroy(&names[d - 1]);
+    }
+}
+
+int
+main(int argc, char *argv[argc])
+{
+    LongBowRunner *testRunner = LONGBOW_TEST_RUNNER_CREATE(fibStatic);
+    int exitStatus = longBowMain(argc, argv, testRunner, NULL);
+    longBowTestRunner_Destroy(&testRunner);
+    exit(exitStatus);
+}
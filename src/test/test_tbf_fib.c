@@ -17,6 +17,7 @@
 LONGBOW_TEST_RUNNER(tbf_fib)
 {
     LONGBOW_RUN_TEST_FIXTURE(Core);
+    LONGBOW_RUN_TEST_FIXTURE(Bulk);
 }
 
 // The Test Runner calls this function once before any Test Fixtures are run.
@@ -34,6 +35,10 @@ LONGBOW_TEST_RUNNER_TEARDOWN(tbf_fib)
 LONGBOW_TEST_FIXTURE(Core)
 {
     LONGBOW_RUN_TEST_CASE(Core, fibTBF_LookupSimple);
+    LONGBOW_RUN_TEST_CASE(Core, fibTBF_LookupOptimal);
+    LONGBOW_RUN_TEST_CASE(Core, fibTBF_LookupCuckoo);
+    LONGBOW_RUN_TEST_CASE(Core, fibTBF_LookupFalsePositive);
+    LONGBOW_RUN_TEST_CASE(Core, fibTBF_Remove);
 }
 
 LONGBOW_TEST_FIXTURE_SETUP(Core)
@@ -64,6 +69,178 @@ LONGBOW_TEST_CASE(Core, fibTBF_LookupSimple)
     fib_Destroy(&fib);
 }
 
+LONGBOW_TEST_CASE(Core, fibTBF_LookupOptimal)
+{
+    FIBTBF *filter = fibTBF_CreateOptimal(4, 0.01);
+    assertNotNull(filter, "Expected a non-NULL fibTBF to be created");
+
+    FIB *fib = fib_Create(filter, TBFAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibTBF_LookupCuckoo)
+{
+    FIBTBF *filter = fibTBF_CreateOptimalWithFilter(4, 0.01, FilterType_Cuckoo);
+    assertNotNull(filter, "Expected a non-NULL fibTBF to be created");
+
+    FIB *fib = fib_Create(filter, TBFAsFIB);
+    assertNotNull(fib, "Expected non-NULL FIB");
+
+    test_fib_lookup(fib);
+
+    fib_Destroy(&fib);
+}
+
+static void
+_test_tbf_remove(FIBTBF *fib)
+{
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b/c");
+    Name *longerPrefix = name_CreateFromCString("ccnx:/a/b/c/d");
+    Name *query = name_CreateFromCString("ccnx:/a/b/c/d/e");
+
+    Bitmap *vectors[4];
+    for (int i = 0; i < 4; i++) {
+        vectors[i] = bitmap_Create(8);
+        bitmap_Set(vectors[i], i);
+    }
+
+    fibTBF_Insert(fib, shortPrefix, vectors[0]);
+    fibTBF_Insert(fib, longPrefix, vectors[1]);
+    fibTBF_Insert(fib, longerPrefix, vectors[2]);
+    fibTBF_Insert(fib, longPrefix, vectors[3]);
+    assertTrue(fibTBF_LPM(fib, query) == vectors[2], "Expected the longest prefix to match");
+
+    assertTrue(fibTBF_Remove(fib, longerPrefix), "Expected the longest prefix to be removed");
+    assertTrue(fibTBF_LPM(fib, query) == vectors[1], "Expected the next longest prefix to match");
+    assertTrue(bitmap_Get(vectors[1], 3), "Expected the repeated insert to be merged");
+
+    // Repeats were merged, so one remove takes the name out
+    assertTrue(fibTBF_Remove(fib, longPrefix), "Expected the long prefix to be removed");
+    assertFalse(fibTBF_Remove(fib, longPrefix), "Expected nothing left to remove");
+    assertTrue(fibTBF_LPM(fib, query) == vectors[0], "Expected the short prefix to match");
+
+    assertTrue(fibTBF_Remove(fib, shortPrefix), "Expected the short prefix to be removed");
+    assertNull(fibTBF_LPM(fib, query), "Expected no prefix to match");
+
+    for (int i = 0; i < 4; i++) {
+        bitmap_Destroy(&vectors[i]);
+    }
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&longerPrefix);
+    name_Destroy(&query);
+}
+
+LONGBOW_TEST_CASE(Core, fibTBF_Remove)
+{
+    FIBTBF *fib = fibTBF_CreateOptimal(2, 0.01);
+    _test_tbf_remove(fib);
+    fibTBF_Destroy(&fib);
+
+    fib = fibTBF_CreateOptimalWithFilter(2, 0.01, FilterType_Cuckoo);
+    _test_tbf_remove(fib);
+    fibTBF_Destroy(&fib);
+}
+
+LONGBOW_TEST_CASE(Core, fibTBF_LookupFalsePositive)
+{
+    // A single-bit filter reports every suffix, so every match has to be verified
+    FIBTBF *fib = fibTBF_Create(2, 1, 1);
+
+    Name *shortPrefix = name_CreateFromCString("ccnx:/a");
+    Name *longPrefix = name_CreateFromCString("ccnx:/a/b/c");
+    Name *otherPrefix = name_CreateFromCString("ccnx:/x/y/z");
+    Name *deepMatch = name_CreateFromCString("ccnx:/a/b/c/d");
+    Name *suffixMiss = name_CreateFromCString("ccnx:/a/b/x/y");
+    Name *trieMiss = name_CreateFromCString("ccnx:/a/q/r");
+    Name *otherMiss = name_CreateFromCString("ccnx:/x/y/c");
+
+    Bitmap *vector1 = bitmap_Create(128);
+    bitmap_Set(vector1, 1);
+    Bitmap *vector2 = bitmap_Create(128);
+    bitmap_Set(vector2, 2);
+    Bitmap *vector3 = bitmap_Create(128);
+    bitmap_Set(vector3, 3);
+
+    fibTBF_Insert(fib, shortPrefix, vector1);
+    fibTBF_Insert(fib, longPrefix, vector2);
+    fibTBF_Insert(fib, otherPrefix, vector3);
+
+    Bitmap *result = fibTBF_LPM(fib, deepMatch);
+    assertTrue(result != NULL && bitmap_Equals(result, vector2), "Expected the /a/b/c vector");
+
+    // Lengths 4 and 3 pass the filter but not the exact match, and /a/b is not a prefix
+    result = fibTBF_LPM(fib, suffixMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected the /a vector");
+
+    result = fibTBF_LPM(fib, trieMiss);
+    assertTrue(result != NULL && bitmap_Equals(result, vector1), "Expected the /a vector");
+
+    // The same suffix under another trie prefix is not a match
+    result = fibTBF_LPM(fib, otherMiss);
+    assertTrue(result == NULL, "Expected no match for /x/y/c");
+
+    fibTBF_Destroy(&fib);
+
+    bitmap_Destroy(&vector1);
+    bitmap_Destroy(&vector2);
+    bitmap_Destroy(&vector3);
+    name_Destroy(&shortPrefix);
+    name_Destroy(&longPrefix);
+    name_Destroy(&otherPrefix);
+    name_Destroy(&deepMatch);
+    name_Destroy(&suffixMiss);
+    name_Destroy(&trieMiss);
+    name_Destroy(&otherMiss);
+}
+
+LONGBOW_TEST_FIXTURE(Bulk)
+{
+    LONGBOW_RUN_TEST_CASE(Bulk, fibTBF_BulkLoad);
+    LONGBOW_RUN_TEST_CASE(Bulk, fibTBF_BulkLoadCuckoo);
+}
+
+LONGBOW_TEST_FIXTURE_SETUP(Bulk)
+{
+    return test_fib_bulk_setup();
+}
+
+LONGBOW_TEST_FIXTURE_TEARDOWN(Bulk)
+{
+    return test_fib_bulk_teardown(testCase);
+}
+
+LONGBOW_TEST_CASE(Bulk, fibTBF_BulkLoad)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBTBF *filter = fibTBF_Create(4, 128, 3);
+        FIB *fib = fib_Create(filter, TBFAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+    }
+}
+
+LONGBOW_TEST_CASE(Bulk, fibTBF_BulkLoadCuckoo)
+{
+    for (int threads = 1; threads <= 4; threads += 3) {
+        FIBTBF *filter = fibTBF_CreateOptimalWithFilter(4, 0.01, FilterType_Cuckoo);
+        FIB *fib = fib_Create(filter, TBFAsFIB);
+        assertNotNull(fib, "Expected non-NULL FIB");
+
+        test_fib_bulk_load(fib, threads);
+
+        fib_Destroy(&fib);
+    }
+}
+
 int
 main(int argc, char *argv[argc])
 {
@@ -23,6 +23,6 @@ timerEnd(struct timespec start_time)
 long
 timeDelta(Timestamp start, Timestamp end)
 {
-    long diffInNanos = ((end.tv_sec - start.tv_sec) * 10000000000L) + (end.tv_nsec - start.tv_nsec);
+    long diffInNanos = ((end.tv_sec - start.tv_sec) * 1000000000L) + (end.tv_nsec - start.tv_nsec);
     return diffInNanos;
 }
\ No newline at end of file
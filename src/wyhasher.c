@@ -0,0 +1,149 @@
+#include "wyhasher.h"
+
+#include <string.h>
+
+// wyhash, final version 4 (https://github.com/wangyi-fudan/wyhash)
+static const uint64_t _wyhasher_Secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+};
+
+struct wyhasher {
+    uint64_t seed;
+};
+
+WYHasher *
+wyhasher_Create(uint64_t seed)
+{
+    WYHasher *hasher = (WYHasher *) malloc(sizeof(WYHasher));
+    if (hasher != NULL) {
+        hasher->seed = seed;
+    }
+    return hasher;
+}
+
+void
+wyhasher_Destroy(WYHasher **hasherP)
+{
+    free(*hasherP);
+    *hasherP = NULL;
+}
+
+static void
+_wyhasher_Multiply(uint64_t *a, uint64_t *b)
+{
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+}
+
+static uint64_t
+_wyhasher_Mix(uint64_t a, uint64_t b)
+{
+    _wyhasher_Multiply(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t
+_wyhasher_Read64(const uint8_t *p)
+{
+    uint64_t value = 0;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t
+_wyhasher_Read32(const uint8_t *p)
+{
+    uint32_t value = 0;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t
+_wyhasher_Read3(const uint8_t *p, size_t k)
+{
+    return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+}
+
+uint64_t
+wyhasher_Hash64(WYHasher *hasher, size_t length, const uint8_t input[])
+{
+    const uint64_t *secret = _wyhasher_Secret;
+    const uint8_t *p = input;
+    uint64_t seed = hasher->seed ^ _wyhasher_Mix(hasher->seed ^ secret[0], secret[1]);
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (_wyhasher_Read32(p) << 32) | _wyhasher_Read32(p + ((length >> 3) << 2));
+            b = (_wyhasher_Read32(p + length - 4) << 32) | _wyhasher_Read32(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = _wyhasher_Read3(p, length);
+        }
+    } else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t see1 = seed;
+            uint64_t see2 = seed;
+            do {
+                seed = _wyhasher_Mix(_wyhasher_Read64(p) ^ secret[1], _wyhasher_Read64(p + 8) ^ seed);
+                see1 = _wyhasher_Mix(_wyhasher_Read64(p + 16) ^ secret[2], _wyhasher_Read64(p + 24) ^ see1);
+                see2 = _wyhasher_Mix(_wyhasher_Read64(p + 32) ^ secret[3], _wyhasher_Read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _wyhasher_Mix(_wyhasher_Read64(p) ^ secret[1], _wyhasher_Read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _wyhasher_Read64(p + i - 16);
+        b = _wyhasher_Read64(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    _wyhasher_Multiply(&a, &b);
+    return _wyhasher_Mix(a ^ secret[0] ^ length, b ^ secret[1]);
+}
+
+PARCBuffer *
+wyhasher_HashArray(WYHasher *hasher, size_t length, uint8_t input[])
+{
+    // Network byte order, to match parcBuffer_GetUint64
+    PARCBuffer *hashOutput = parcBuffer_Allocate(WYHASH_HASH_LENGTH);
+    parcBuffer_PutUint64(hashOutput, wyhasher_Hash64(hasher, length, input));
+    return parcBuffer_Flip(hashOutput);
+}
+
+PARCBuffer *
+wyhasher_Hash(WYHasher *hasher, PARCBuffer *input)
+{
+    return wyhasher_HashArray(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0));
+}
+
+Bitmap *
+wyhasher_HashArrayToVector(WYHasher *hasher, size_t length, uint8_t input[], int range)
+{
+    Bitmap *vector = bitmap_Create(range);
+    bitmap_Set(vector, wyhasher_Hash64(hasher, length, input) % range);
+    return vector;
+}
+
+Bitmap *
+wyhasher_HashToVector(WYHasher *hasher, PARCBuffer *input, int range)
+{
+    return wyhasher_HashArrayToVector(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0), range);
+}
+
+HasherInterface *WYHashAsHasher = &(HasherInterface) {
+        .Hash = (PARCBuffer *(*)(void *, PARCBuffer *)) wyhasher_Hash,
+        .HashArray = (PARCBuffer *(*)(void *hasher, size_t length, uint8_t *input)) wyhasher_HashArray,
+        .HashToVector = (Bitmap *(*)(void*hasher, PARCBuffer *input, int range)) wyhasher_HashToVector,
+        .HashArrayToVector = (Bitmap *(*)(void*hasher, size_t length, uint8_t *input, int range)) wyhasher_HashArrayToVector,
+        .Destroy = (void (*)(void **instance)) wyhasher_Destroy,
+};
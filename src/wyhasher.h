@@ -0,0 +1,36 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_WYHASHER_H
+#define FIB_PERF_WYHASHER_H
+
+#include "hasher.h"
+
+#define WYHASH_HASH_LENGTH 8
+
+struct wyhasher;
+typedef struct wyhasher WYHasher;
+
+extern HasherInterface *WYHashAsHasher;
+
+// wyhash with the given seed. Not a PRF: use it only where hash flooding is not a concern.
+WYHasher *wyhasher_Create(uint64_t seed);
+
+void wyhasher_Destroy(WYHasher **hasherP);
+
+uint64_t wyhasher_Hash64(WYHasher *hasher, size_t length, const uint8_t input[]);
+
+PARCBuffer *wyhasher_Hash(WYHasher *hasher, PARCBuffer *input);
+
+PARCBuffer *wyhasher_HashArray(WYHasher *hasher, size_t length, uint8_t input[]);
+
+Bitmap *wyhasher_HashToVector(WYHasher *hasher, PARCBuffer *input, int range);
+
+Bitmap *wyhasher_HashArrayToVector(WYHasher *hasher, size_t length, uint8_t input[], int range);
+
+#endif //FIB_PERF_WYHASHER_H
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,155 @@
+#include "xxhasher.h"
+
+#include <string.h>
+
+// XXH64 (https://github.com/Cyan4973/xxHash)
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+struct xxhasher {
+    uint64_t seed;
+};
+
+XXHasher *
+xxhasher_Create(uint64_t seed)
+{
+    XXHasher *hasher = (XXHasher *) malloc(sizeof(XXHasher));
+    if (hasher != NULL) {
+        hasher->seed = seed;
+    }
+    return hasher;
+}
+
+void
+xxhasher_Destroy(XXHasher **hasherP)
+{
+    free(*hasherP);
+    *hasherP = NULL;
+}
+
+static uint64_t
+_xxhasher_Read64(const uint8_t *p)
+{
+    uint64_t value = 0;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t
+_xxhasher_Read32(const uint8_t *p)
+{
+    uint32_t value = 0;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t
+_xxhasher_Round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME64_2;
+    acc = ROTL64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t
+_xxhasher_MergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= _xxhasher_Round(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t
+xxhasher_Hash64(XXHasher *hasher, size_t length, const uint8_t input[])
+{
+    const uint8_t *p = input;
+    const uint8_t *end = input + length;
+    uint64_t seed = hasher->seed;
+    uint64_t h = 0;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = _xxhasher_Round(v1, _xxhasher_Read64(p));
+            v2 = _xxhasher_Round(v2, _xxhasher_Read64(p + 8));
+            v3 = _xxhasher_Round(v3, _xxhasher_Read64(p + 16));
+            v4 = _xxhasher_Round(v4, _xxhasher_Read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+
+        h = ROTL64(v1, 1) + ROTL64(v2, 7) + ROTL64(v3, 12) + ROTL64(v4, 18);
+        h = _xxhasher_MergeRound(h, v1);
+        h = _xxhasher_MergeRound(h, v2);
+        h = _xxhasher_MergeRound(h, v3);
+        h = _xxhasher_MergeRound(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t) length;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= _xxhasher_Round(0, _xxhasher_Read64(p));
+        h = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t) _xxhasher_Read32(p) * PRIME64_1;
+        h = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * PRIME64_5;
+        h = ROTL64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+PARCBuffer *
+xxhasher_HashArray(XXHasher *hasher, size_t length, uint8_t input[])
+{
+    // Network byte order, to match parcBuffer_GetUint64
+    PARCBuffer *hashOutput = parcBuffer_Allocate(XXHASH_HASH_LENGTH);
+    parcBuffer_PutUint64(hashOutput, xxhasher_Hash64(hasher, length, input));
+    return parcBuffer_Flip(hashOutput);
+}
+
+PARCBuffer *
+xxhasher_Hash(XXHasher *hasher, PARCBuffer *input)
+{
+    return xxhasher_HashArray(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0));
+}
+
+Bitmap *
+xxhasher_HashArrayToVector(XXHasher *hasher, size_t length, uint8_t input[], int range)
+{
+    Bitmap *vector = bitmap_Create(range);
+    bitmap_Set(vector, xxhasher_Hash64(hasher, length, input) % range);
+    return vector;
+}
+
+Bitmap *
+xxhasher_HashToVector(XXHasher *hasher, PARCBuffer *input, int range)
+{
+    return xxhasher_HashArrayToVector(hasher, parcBuffer_Remaining(input), parcBuffer_Overlay(input, 0), range);
+}
+
+HasherInterface *XXHashAsHasher = &(HasherInterface) {
+        .Hash = (PARCBuffer *(*)(void *, PARCBuffer *)) xxhasher_Hash,
+        .HashArray = (PARCBuffer *(*)(void *hasher, size_t length, uint8_t *input)) xxhasher_HashArray,
+        .HashToVector = (Bitmap *(*)(void*hasher, PARCBuffer *input, int range)) xxhasher_HashToVector,
+        .HashArrayToVector = (Bitmap *(*)(void*hasher, size_t length, uint8_t *input, int range)) xxhasher_HashArrayToVector,
+        .Destroy = (void (*)(void **instance)) xxhasher_Destroy,
+};
@@ -0,0 +1,36 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef FIB_PERF_XXHASHER_H
+#define FIB_PERF_XXHASHER_H
+
+#include "hasher.h"
+
+#define XXHASH_HASH_LENGTH 8
+
+struct xxhasher;
+typedef struct xxhasher XXHasher;
+
+extern HasherInterface *XXHashAsHasher;
+
+// XXH64 with the given seed. Not keyed: use it only where hash flooding is not a concern.
+XXHasher *xxhasher_Create(uint64_t seed);
+
+void xxhasher_Destroy(XXHasher **hasherP);
+
+uint64_t xxhasher_Hash64(XXHasher *hasher, size_t length, const uint8_t input[]);
+
+PARCBuffer *xxhasher_Hash(XXHasher *hasher, PARCBuffer *input);
+
+PARCBuffer *xxhasher_HashArray(XXHasher *hasher, size_t length, uint8_t input[]);
+
+Bitmap *xxhasher_HashToVector(XXHasher *hasher, PARCBuffer *input, int range);
+
+Bitmap *xxhasher_HashArrayToVector(XXHasher *hasher, size_t length, uint8_t input[], int range);
+
+#endif //FIB_PERF_XXHASHER_H
+
+#ifdef __cplusplus
+}
+#endif